@@ -0,0 +1,247 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+/*
+  Reader of the write-set dump log written by the server, see
+  sql/wsrep_dump.h for the format.
+*/
+
+#include <my_global.h>
+
+#include "../sql/wsrep_dump.h"
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+
+#define PROGNAME "wsrep_dump_reader"
+
+/* offset of event length in binary log event header */
+#define EVENT_LEN_OFFSET 9
+#define BINLOG_MAGIC     "\xfe\x62\x69\x6e"
+#define BINLOG_MAGIC_LEN 4
+
+static const size_t COPY_BUFFER_SIZE= 1024 * 1024;
+
+static void usage()
+{
+  printf("%s  Ver 1.0 for %s at %s\n", PROGNAME, SYSTEM_TYPE, MACHINE_TYPE);
+  puts("List write-sets saved in write-set dump log or extract a write-set "
+       "as a binary log file that can be read by mysqlbinlog.");
+  printf("Usage: %s dump_log\n"
+         "       %s dump_log seqno output_file\n", PROGNAME, PROGNAME);
+}
+
+static void print_uuid(const uchar* const uuid)
+{
+  for (int i= 0; i < 16; ++i)
+  {
+    printf("%02x", uuid[i]);
+    if (i == 3 || i == 5 || i == 7 || i == 9) putchar('-');
+  }
+}
+
+/* @return format description event read after file header, NULL on error */
+static uchar* read_file_header(FILE* const log, size_t* const fde_len)
+{
+  uchar header[WSREP_DUMP_FILE_HEADER_LEN];
+  if (fread(header, sizeof(header), 1, log) != 1 ||
+      memcmp(header, WSREP_DUMP_MAGIC, WSREP_DUMP_MAGIC_LEN))
+  {
+    fprintf(stderr, PROGNAME ": [Error] Not a write-set dump log.\n");
+    return NULL;
+  }
+
+  if (uint4korr(header + 8) != WSREP_DUMP_VERSION)
+  {
+    fprintf(stderr, PROGNAME ": [Error] Unsupported format version %u.\n",
+            (uint) uint4korr(header + 8));
+    return NULL;
+  }
+
+  uchar event_header[EVENT_LEN_OFFSET + 4];
+  if (fread(event_header, sizeof(event_header), 1, log) != 1)
+  {
+    fprintf(stderr, PROGNAME ": [Error] Truncated format description.\n");
+    return NULL;
+  }
+
+  *fde_len= uint4korr(event_header + EVENT_LEN_OFFSET);
+  if (*fde_len < sizeof(event_header))
+  {
+    fprintf(stderr, PROGNAME ": [Error] Corrupted format description.\n");
+    return NULL;
+  }
+
+  uchar* const fde= static_cast<uchar*>(malloc(*fde_len));
+  if (!fde)
+  {
+    fprintf(stderr, PROGNAME ": [Error] Out of memory.\n");
+    return NULL;
+  }
+
+  memcpy(fde, event_header, sizeof(event_header));
+  if (fread(fde + sizeof(event_header), *fde_len - sizeof(event_header), 1,
+            log) != 1)
+  {
+    fprintf(stderr, PROGNAME ": [Error] Truncated format description.\n");
+    free(fde);
+    return NULL;
+  }
+
+  return fde;
+}
+
+/* @return 1 if record header was read, 0 at end of log, -1 on error */
+static int read_record_header(FILE* const log, uchar* const header)
+{
+  size_t const n= fread(header, 1, WSREP_DUMP_RECORD_HEADER_LEN, log);
+  if (n == 0 && feof(log)) return 0;
+
+  if (n != WSREP_DUMP_RECORD_HEADER_LEN ||
+      uint4korr(header) != WSREP_DUMP_RECORD_MAGIC)
+  {
+    fprintf(stderr, PROGNAME ": [Error] Corrupted record at offset %lld.\n",
+            (long long) (ftell(log) - n));
+    return -1;
+  }
+  return 1;
+}
+
+static int list_records(FILE* const log)
+{
+  printf("%-20s %-36s %6s %12s %10s %-19s %s\n", "seqno", "uuid", "error",
+         "offset", "thread", "time", "length");
+
+  uchar header[WSREP_DUMP_RECORD_HEADER_LEN];
+  long long offset= ftell(log);
+  int rc;
+  while ((rc= read_record_header(log, header)) > 0)
+  {
+    ulonglong const len= uint8korr(header + 48);
+    time_t const when= static_cast<time_t>(uint8korr(header + 40));
+    char when_str[32];
+    struct tm tm_buf;
+    strftime(when_str, sizeof(when_str), "%Y-%m-%d %H:%M:%S",
+             localtime_r(&when, &tm_buf));
+
+    printf("%-20lld ", (long long) uint8korr(header + 8));
+    print_uuid(header + 16);
+    printf(" %6u %12lld %10u %-19s %llu\n", (uint) uint4korr(header + 4),
+           offset, (uint) uint4korr(header + 32), when_str, len);
+
+    if (fseek(log, static_cast<long>(len), SEEK_CUR))
+    {
+      fprintf(stderr, PROGNAME ": [Error] Truncated record at offset %lld.\n",
+              offset);
+      return 1;
+    }
+    offset= ftell(log);
+  }
+
+  return rc < 0;
+}
+
+static int extract_record(FILE* const log, const uchar* const fde,
+                          size_t const fde_len, long long const seqno,
+                          const char* const output_name)
+{
+  uchar header[WSREP_DUMP_RECORD_HEADER_LEN];
+  int rc;
+  while ((rc= read_record_header(log, header)) > 0)
+  {
+    ulonglong const len= uint8korr(header + 48);
+    if (static_cast<long long>(uint8korr(header + 8)) == seqno) break;
+
+    if (fseek(log, static_cast<long>(len), SEEK_CUR))
+    {
+      fprintf(stderr, PROGNAME ": [Error] Truncated record.\n");
+      return 1;
+    }
+  }
+
+  if (rc < 0) return 1;
+  if (rc == 0)
+  {
+    fprintf(stderr, PROGNAME ": [Error] Write-set %lld not found.\n", seqno);
+    return 1;
+  }
+
+  FILE* const output= fopen(output_name, "wb");
+  if (!output)
+  {
+    fprintf(stderr, PROGNAME ": [Error] Cannot create output file.\n");
+    return 1;
+  }
+
+  char* const buffer= new char[COPY_BUFFER_SIZE];
+  ulonglong left= uint8korr(header + 48);
+  bool error= (fwrite(BINLOG_MAGIC, BINLOG_MAGIC_LEN, 1, output) != 1 ||
+               fwrite(fde, fde_len, 1, output) != 1);
+
+  while (!error && left > 0)
+  {
+    size_t const n= static_cast<size_t>(std::min<ulonglong>(left,
+                                                            COPY_BUFFER_SIZE));
+    if (fread(buffer, n, 1, log) != 1)
+    {
+      fprintf(stderr, PROGNAME ": [Error] Truncated record.\n");
+      error= true;
+      break;
+    }
+    error= (fwrite(buffer, n, 1, output) != 1);
+    left-= n;
+  }
+
+  delete[] buffer;
+  if (fclose(output) || error)
+  {
+    fprintf(stderr, PROGNAME ": [Error] Failed to write output file.\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 2 && argc != 4)
+  {
+    usage();
+    exit(1);
+  }
+
+  FILE* const log= fopen(argv[1], "rb");
+  if (log == NULL)
+  {
+    fprintf(stderr, PROGNAME ": [Error] Cannot open input file for reading.\n");
+    exit(1);
+  }
+
+  size_t fde_len= 0;
+  uchar* const fde= read_file_header(log, &fde_len);
+  if (!fde)
+  {
+    fclose(log);
+    exit(1);
+  }
+
+  int const rc= (argc == 2) ?
+    list_records(log) :
+    extract_record(log, fde, fde_len, strtoll(argv[2], NULL, 10), argv[3]);
+
+  free(fde);
+  fclose(log);
+  return rc;
+}
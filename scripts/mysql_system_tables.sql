@@ -2359,6 +2359,61 @@ PREPARE stmt FROM @str;
 EXECUTE stmt;
 DROP PREPARE stmt;
 
+--
+-- TABLE pxc_applier_threads
+--
+
+SET @cmd="CREATE TABLE performance_schema.pxc_applier_threads("
+  "PROCESSLIST_ID BIGINT unsigned not null,"
+  "STATE ENUM('IDLE','APPLYING','COMMIT_ORDER_WAIT') not null,"
+  "WRITE_SETS_APPLIED BIGINT unsigned not null,"
+  "BUSY_TIME BIGINT unsigned not null,"
+  "IDLE_TIME BIGINT unsigned not null,"
+  "COMMIT_ORDER_WAIT_TIME BIGINT unsigned not null"
+  ") ENGINE=PERFORMANCE_SCHEMA;";
+
+SET @str = IF(@have_pfs = 1, @cmd, 'SET @dummy = 0');
+PREPARE stmt FROM @str;
+EXECUTE stmt;
+DROP PREPARE stmt;
+
+--
+-- TABLE pxc_conflicts_by_index
+--
+
+SET @cmd="CREATE TABLE performance_schema.pxc_conflicts_by_index("
+  "OBJECT_SCHEMA VARCHAR(64) not null,"
+  "OBJECT_NAME VARCHAR(64) not null,"
+  "INDEX_NAME VARCHAR(64),"
+  "CERT_FAILURES BIGINT unsigned not null,"
+  "BF_ABORTS BIGINT unsigned not null,"
+  "ROWS_WASTED BIGINT unsigned not null,"
+  "TIME_WASTED BIGINT unsigned not null"
+  ") ENGINE=PERFORMANCE_SCHEMA;";
+
+SET @str = IF(@have_pfs = 1, @cmd, 'SET @dummy = 0');
+PREPARE stmt FROM @str;
+EXECUTE stmt;
+DROP PREPARE stmt;
+
+--
+-- TABLE pxc_conflict_hot_keys
+--
+
+SET @cmd="CREATE TABLE performance_schema.pxc_conflict_hot_keys("
+  "OBJECT_SCHEMA VARCHAR(64) not null,"
+  "OBJECT_NAME VARCHAR(64) not null,"
+  "INDEX_NAME VARCHAR(64),"
+  "KEY_HASH BIGINT unsigned not null,"
+  "CONFLICTS BIGINT unsigned not null,"
+  "CONFLICTS_ERROR BIGINT unsigned not null"
+  ") ENGINE=PERFORMANCE_SCHEMA;";
+
+SET @str = IF(@have_pfs = 1, @cmd, 'SET @dummy = 0');
+PREPARE stmt FROM @str;
+EXECUTE stmt;
+DROP PREPARE stmt;
+
 --
 -- TABLE SESSION_CONNECT_ATTRS
 --
@@ -189,6 +189,7 @@ inline double log2(double x)
 #ifdef WITH_WSREP
 #include "wsrep_mysqld.h"
 #include "wsrep_xid.h"
+#include "wsrep_pool.h"
 #include "../storage/partition/ha_partition.h"
 #endif /* WITH_WSREP */
 
@@ -2554,7 +2555,7 @@ int ha_prepare_low(THD *thd, bool all)
     /* Pre-commit hook will start commit ordering. */
     if (thd->wsrep_ws_handle.opaque &&
         thd->wsrep_conflict_state != REPLAYING)
-      wsrep->applier_pre_commit(wsrep, thd->wsrep_ws_handle.opaque);
+      wsrep_pool_enter_commit_order(thd);
   }
 
 #endif /* WITH_WSREP */
@@ -747,6 +747,55 @@ enum handler_drop_zip_dict_result
 };
 
 class handler;
+
+#ifdef WITH_WSREP
+/*
+  Destination of the files which a storage engine copies for native state
+  snapshot transfer (wsrep_sst_method=native). Paths are those the engine
+  opens the files with, relative to the data directory or absolute.
+  Every stream is used by one thread at a time, different streams may be
+  used concurrently.
+*/
+class Wsrep_sst_sink
+{
+public:
+  virtual ~Wsrep_sst_sink() {}
+
+  /*
+    Called before anything is sent, base_lsn is the LSN the copy is
+    incremental from, 0 if the data files are copied in full
+  */
+  virtual int begin(uint stream, ulonglong base_lsn)= 0;
+
+  /* Create the file unless it exists and extend it to at least size bytes */
+  virtual int file(uint stream, const char *path, ulonglong size)= 0;
+
+  /* Write len bytes of buf at offset of the file */
+  virtual int write(uint stream, const char *path, ulonglong offset,
+                    const uchar *buf, size_t len)= 0;
+};
+
+/*
+  Data files the joiner of native SST already has: they were copied from
+  this server at lsn and the joiner changed them up to joiner_lsn since.
+  The engine may send only the pages changed on either side since lsn.
+*/
+class Wsrep_sst_base
+{
+public:
+  Wsrep_sst_base() : lsn(0), joiner_lsn(0), bitmap_dir(NULL) {}
+  virtual ~Wsrep_sst_base() {}
+
+  /* True if the joiner has the file path of tablespace space_id */
+  virtual bool has_file(const char *path, ulong space_id) const= 0;
+
+  ulonglong   lsn;
+  ulonglong   joiner_lsn;
+  /* changed page bitmaps of the joiner */
+  const char *bitmap_dir;
+};
+#endif /* WITH_WSREP */
+
 /*
   handlerton is a singleton structure - one instance per storage engine -
   to provide access to storage engine functionality that works on the
@@ -924,6 +973,27 @@ struct handlerton
    int (*wsrep_set_checkpoint)(handlerton *hton, const XID* xid);
    int (*wsrep_get_checkpoint)(handlerton *hton, XID* xid);
    void (*wsrep_fake_trx_id)(handlerton *hton, THD *thd);
+   /*
+     Native SST donor side: begin makes a snapshot of the files to copy and
+     starts retaining the log written from then on, copy is called from
+     every data stream concurrently, redo copies the log written so far and
+     end copies what is still missing once the server is locked, or only
+     releases the snapshot if abort is set. base, if not NULL, offers an
+     incremental copy; end returns the LSN the joiner's copy is at.
+   */
+   int (*wsrep_sst_backup_begin)(handlerton *hton, Wsrep_sst_sink *sink,
+                                 uint stream, const Wsrep_sst_base *base);
+   int (*wsrep_sst_backup_copy)(handlerton *hton, Wsrep_sst_sink *sink,
+                                uint stream);
+   int (*wsrep_sst_backup_redo)(handlerton *hton, Wsrep_sst_sink *sink,
+                                uint stream);
+   int (*wsrep_sst_backup_end)(handlerton *hton, Wsrep_sst_sink *sink,
+                               uint stream, bool abort, ulonglong *lsn);
+   /*
+     SST joiner side: warm up the caches from what was received, reading
+     at full speed while high_priority is set. Returns the percentage done.
+   */
+   uint (*wsrep_sst_warmup)(handlerton *hton, bool high_priority);
 #endif /* WITH_WSREP */
 
   /**
@@ -4180,6 +4250,34 @@ public:
   virtual void rpl_before_update_rows() { }
   virtual void rpl_after_update_rows() { }
 
+  /**
+     Hint that the row with the given primary key value is going to be
+     accessed by a row event soon. The engine may start reading the pages
+     needed for it in the background, it must not wait for the reads.
+
+     @param key  primary key value in the format produced by key_copy()
+
+     @return 0 on success
+             HA_ERR_WRONG_COMMAND if the engine does not support prefetch
+   */
+  virtual int rpl_prefetch_row(const uchar *key)
+  { return HA_ERR_WRONG_COMMAND; }
+
+#ifdef WITH_WSREP
+  /**
+     Publish the certification keys of a row which a replicated row event
+     is going to change, so that local transactions changing the row
+     conflict early, see wsrep_conflict.h.
+
+     @param record  row in table->record[0] format
+
+     @return 0 on success
+             HA_ERR_WRONG_COMMAND if the engine does not support it
+   */
+  virtual int wsrep_publish_row_keys(const uchar *record)
+  { return HA_ERR_WRONG_COMMAND; }
+#endif /* WITH_WSREP */
+
   /**
     Callback function that will be called by my_prepare_gcolumn_template
     once the table has been opened.
@@ -54,6 +54,7 @@
 #include <mysql/psi/mysql_statement.h>
 #ifdef WITH_WSREP
 #include "wsrep_mysqld.h"
+#include "wsrep_table_map_cache.h"
 #endif /* WITH_WSREP */
 #include "transaction_info.h"
 #include "sql_class.h"
@@ -10990,6 +10991,74 @@ end:
   DBUG_RETURN(error);
 }
 
+#ifdef WITH_WSREP
+void Rows_log_event::wsrep_prescan_rows(Relay_log_info const *rli,
+                                        bool prefetch, bool publish)
+{
+  DBUG_ENTER("Rows_log_event::wsrep_prescan_rows");
+  DBUG_ASSERT(m_table && m_table->in_use != NULL);
+
+  TABLE *table= m_table;
+  uint const pk= table->s->primary_key;
+  if (pk == MAX_KEY)
+    DBUG_VOID_RETURN;
+
+  /* the first image of every row must contain the whole primary key */
+  KEY *const key_info= table->key_info + pk;
+  for (uint i= 0; i < key_info->user_defined_key_parts; i++)
+  {
+    uint const col= key_info->key_part[i].fieldnr - 1;
+    if (col >= m_cols.n_bits || !bitmap_is_set(&m_cols, col))
+      prefetch= false;
+  }
+
+  /* keys are computed from all columns, as on the node of the write-set */
+  bool const is_update=
+    get_general_type_code() == binary_log::UPDATE_ROWS_EVENT;
+  if (!bitmap_is_set_all(&m_cols) ||
+      (is_update && !bitmap_is_set_all(&m_cols_ai)))
+    publish= false;
+
+  uchar key[MAX_KEY_LENGTH];
+  const uchar *const saved_m_curr_row= m_curr_row;
+  const uchar *const saved_m_curr_row_end= m_curr_row_end;
+
+  while ((prefetch || publish) && m_curr_row != m_rows_end)
+  {
+    prepare_record(table, &m_cols, false);
+    if (unpack_current_row(rli, &m_cols))
+      break;
+
+    if (prefetch)
+    {
+      key_copy(key, table->record[0], key_info, 0);
+      if (table->file->rpl_prefetch_row(key))
+        prefetch= false;
+    }
+
+    if (publish && table->file->wsrep_publish_row_keys(table->record[0]))
+      publish= false;
+
+    m_curr_row= m_curr_row_end;
+
+    if (is_update)
+    {
+      if (unpack_current_row(rli, &m_cols_ai))
+        break;
+
+      if (publish && table->file->wsrep_publish_row_keys(table->record[0]))
+        publish= false;
+
+      m_curr_row= m_curr_row_end;
+    }
+  }
+
+  m_curr_row= saved_m_curr_row;
+  m_curr_row_end= saved_m_curr_row_end;
+  DBUG_VOID_RETURN;
+}
+#endif /* WITH_WSREP */
+
 int Rows_log_event::do_scan_and_update(Relay_log_info const *rli)
 {
   DBUG_ENTER("Rows_log_event::do_scan_and_update");
@@ -11456,12 +11525,22 @@ int Rows_log_event::do_apply_event(Relay_log_info const *rli)
         RPL_TABLE_LIST *ptr= static_cast<RPL_TABLE_LIST*>(table_list_ptr);
         DBUG_ASSERT(ptr->m_tabledef_valid);
         TABLE *conv_table;
+#ifdef WITH_WSREP
+        bool const wsrep_cached= thd->wsrep_applier &&
+          wsrep_table_map_cache_get(thd, ptr, &conv_table);
+#endif /* WITH_WSREP */
         /*
           Use special mem_root 'Log_event::m_event_mem_root' while doing
           compatiblity check (i.e., while creating temporary table)
          */
+#ifdef WITH_WSREP
+        if (!wsrep_cached &&
+            !ptr->m_tabledef.compatible_with(thd, const_cast<Relay_log_info*>(rli),
+                                             ptr->table, &conv_table))
+#else
         if (!ptr->m_tabledef.compatible_with(thd, const_cast<Relay_log_info*>(rli),
                                              ptr->table, &conv_table))
+#endif /* WITH_WSREP */
         {
           DBUG_PRINT("debug", ("Table: %s.%s is not compatible with master",
                                ptr->table->s->db.str,
@@ -11479,6 +11558,11 @@ int Rows_log_event::do_apply_event(Relay_log_info const *rli)
             goto end;
           }
         }
+#ifdef WITH_WSREP
+        if (thd->wsrep_applier && !wsrep_cached)
+          wsrep_table_map_cache_put(thd, const_cast<Relay_log_info*>(rli),
+                                    ptr, &conv_table);
+#endif /* WITH_WSREP */
         DBUG_PRINT("debug", ("Table: %s.%s is compatible with master"
                              " - conv_table: %p",
                              ptr->table->s->db.str,
@@ -11700,6 +11784,20 @@ int Rows_log_event::do_apply_event(Relay_log_info const *rli)
         break;
     }
 
+#ifdef WITH_WSREP
+    if (WSREP(thd) && thd->wsrep_exec_mode == REPL_RECV)
+    {
+      bool const prefetch= wsrep_slave_prefetch &&
+        (m_rows_lookup_algorithm == ROW_LOOKUP_NOT_NEEDED ||
+         (m_rows_lookup_algorithm == ROW_LOOKUP_INDEX_SCAN &&
+          m_key_index == table->s->primary_key));
+      bool const publish= wsrep_early_conflict_check;
+
+      if (prefetch || publish)
+        wsrep_prescan_rows(rli, prefetch, publish);
+    }
+#endif /* WITH_WSREP */
+
     do {
 
       error= (this->*do_apply_row_ptr)(rli);
@@ -3452,6 +3452,25 @@ private:
   */
   int do_hash_row(Relay_log_info const *rli);
 
+#ifdef WITH_WSREP
+  /**
+    Goes through all rows of the event before they are applied one by
+    one, the event position is left unchanged:
+
+    - prefetch asks the storage engine to start reading the pages of the
+      rows in the background, so that the page reads of the rows overlap.
+      Rows are located by primary key.
+    - publish has the storage engine publish the certification keys of the
+      rows, see wsrep_conflict.h.
+
+    @param rli The reference to the relay log info object.
+    @param prefetch Whether to prefetch the rows.
+    @param publish Whether to publish the keys of the rows.
+  */
+  void wsrep_prescan_rows(Relay_log_info const *rli, bool prefetch,
+                          bool publish);
+#endif /* WITH_WSREP */
+
   /**
     This member function scans the table and applies the changes
     that had been previously hashed. As such, m_hash MUST be filled
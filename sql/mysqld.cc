@@ -109,6 +109,12 @@
 #include "wsrep_var.h"
 #include "wsrep_thd.h"
 #include "wsrep_sst.h"
+#include "wsrep_key_batch.h"
+#include "wsrep_dump.h"
+#include "wsrep_pool.h"
+#include "wsrep_conflict.h"
+#include "wsrep_conflict_stats.h"
+#include "wsrep_conflict_log.h"
 #include "sql_thd_internal_api.h"
 #endif /* WITH_WSREP */
 #include "sql_callback.h"
@@ -771,6 +777,13 @@ mysql_mutex_t LOCK_wsrep_replaying;
 mysql_cond_t  COND_wsrep_replaying;
 mysql_mutex_t LOCK_wsrep_slave_threads;
 mysql_mutex_t LOCK_wsrep_desync;
+mysql_mutex_t LOCK_wsrep_causal;
+mysql_cond_t  COND_wsrep_causal;
+mysql_mutex_t LOCK_wsrep_NBO;
+mysql_cond_t  COND_wsrep_NBO;
+mysql_mutex_t LOCK_wsrep_dump;
+mysql_cond_t  COND_wsrep_dump;
+mysql_mutex_t LOCK_wsrep_pool;
 int wsrep_replaying= 0;
 ulong wsrep_running_threads = 0; // # of currently running wsrep threads
 static void wsrep_close_threads(THD* thd);
@@ -1255,6 +1268,35 @@ public:
   }
 };
 
+/*
+  Kills the workers of non-blocking ALTERs applied from the cluster, they
+  wait for the end of the operation, which is not delivered after the
+  provider has disconnected.
+*/
+class Call_wsrep_close_NBO_workers : public Do_THD_Impl
+{
+public:
+  Call_wsrep_close_NBO_workers()
+  {}
+
+  virtual void operator()(THD *thd)
+  {
+    mysql_mutex_lock(&thd->LOCK_thd_data);
+    if (thd->wsrep_applier && thd->wsrep_NBO)
+    {
+      WSREP_DEBUG("Closing NBO worker thread %u", thd->thread_id());
+      thd->killed= THD::KILL_CONNECTION;
+      if (thd->current_cond)
+      {
+        mysql_mutex_lock(thd->current_mutex);
+        mysql_cond_broadcast(thd->current_cond);
+        mysql_mutex_unlock(thd->current_mutex);
+      }
+    }
+    mysql_mutex_unlock(&thd->LOCK_thd_data);
+  }
+};
+
 /**
   This class implements callback function used by close_connections()
   to wait for committing transactions
@@ -1847,6 +1889,17 @@ static void clean_up_mutexes()
   mysql_cond_destroy(&COND_wsrep_replaying);
   mysql_mutex_destroy(&LOCK_wsrep_slave_threads);
   mysql_mutex_destroy(&LOCK_wsrep_desync);
+  mysql_mutex_destroy(&LOCK_wsrep_causal);
+  mysql_cond_destroy(&COND_wsrep_causal);
+  mysql_mutex_destroy(&LOCK_wsrep_NBO);
+  mysql_cond_destroy(&COND_wsrep_NBO);
+  mysql_mutex_destroy(&LOCK_wsrep_dump);
+  mysql_cond_destroy(&COND_wsrep_dump);
+  mysql_mutex_destroy(&LOCK_wsrep_pool);
+  wsrep_conflict_deinit();
+  wsrep_conflict_stats_deinit();
+  wsrep_conflict_log_deinit();
+  wsrep_replay_deinit();
 #endif /* WITH_WSREP */
 }
 
@@ -4095,6 +4148,18 @@ static int init_thread_environment()
                    &LOCK_wsrep_slave_threads, MY_MUTEX_INIT_FAST);
   mysql_mutex_init(key_LOCK_wsrep_desync,
                    &LOCK_wsrep_desync, MY_MUTEX_INIT_FAST);
+  mysql_mutex_init(key_LOCK_wsrep_causal,
+                   &LOCK_wsrep_causal, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_wsrep_causal, &COND_wsrep_causal);
+  mysql_mutex_init(key_LOCK_wsrep_NBO, &LOCK_wsrep_NBO, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_wsrep_NBO, &COND_wsrep_NBO);
+  mysql_mutex_init(key_LOCK_wsrep_dump, &LOCK_wsrep_dump, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_wsrep_dump, &COND_wsrep_dump);
+  mysql_mutex_init(key_LOCK_wsrep_pool, &LOCK_wsrep_pool, MY_MUTEX_INIT_FAST);
+  wsrep_conflict_init();
+  wsrep_conflict_stats_init();
+  wsrep_conflict_log_init();
+  wsrep_replay_init();
 #endif /* WITH_WSREP */
   THR_THD_initialized= true;
   THR_MALLOC_initialized= true;
@@ -7454,6 +7519,10 @@ extern "C" void *start_wsrep_THD(void *arg)
   /* Set applier thread InnoDB priority */
   //set_thd_tx_priority(thd, rli->get_thd_tx_priority());
 
+  /* NBO workers come and go with the operations, they must not be taken
+     for appliers when wsrep_slave_threads changes */
+  thd->wsrep_NBO_worker= (processor == wsrep_NBO_process);
+
   /* wsrep_running_threads counter is managed in thd_manager */
   thd_manager->add_thd(thd);
   thd_added= true;
@@ -7666,9 +7735,16 @@ void wsrep_wait_appliers_close(THD *thd)
   gracefully exit at this stage. This means we will have to mark
   it expliclty below.
 
+  NBO workers are counted as appliers but they would wait for the end
+  of their operation, so they are killed first.
+
   Leaving behind the 1 count for rollback thread */
 
   Global_THD_manager *thd_manager= Global_THD_manager::get_instance();
+
+  Call_wsrep_close_NBO_workers call_wsrep_close_NBO_workers;
+  thd_manager->do_for_all_thd(&call_wsrep_close_NBO_workers);
+
   Count_wsrep_applier_threads count_wsrep_applier_threads;
   thd_manager->wait_till_wsrep_thd_eq(&count_wsrep_applier_threads, 1);
 
@@ -8531,6 +8607,17 @@ SHOW_VAR status_vars[]= {
   {"wsrep_cluster_size",       (char*) &wsrep_cluster_size,      SHOW_LONG_NOFLUSH, SHOW_SCOPE_GLOBAL},
   {"wsrep_local_index",        (char*) &wsrep_local_index,       SHOW_LONG_NOFLUSH, SHOW_SCOPE_GLOBAL},
   {"wsrep_local_bf_aborts",    (char*) &wsrep_show_bf_aborts,    SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_keys_appended",      (char*) &wsrep_show_keys_appended, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_keys_deduplicated",  (char*) &wsrep_show_keys_deduplicated, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_sync_wait_cached",   (char*) &wsrep_show_sync_wait_cached, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_sync_wait_batched",  (char*) &wsrep_show_sync_wait_batched, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_sync_wait_avg_time", (char*) &wsrep_show_sync_wait_avg_time, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_dump_dropped",       (char*) &wsrep_show_dump_dropped, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_applier_threads",    (char*) &wsrep_show_applier_threads, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_early_conflicts",    (char*) &wsrep_show_early_conflicts, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_conflict_log_dropped", (char*) &wsrep_show_conflict_log_dropped, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_replay_avg_time",    (char*) &wsrep_show_replay_avg_time, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
+  {"wsrep_replay_max_time",    (char*) &wsrep_show_replay_max_time, SHOW_FUNC, SHOW_SCOPE_GLOBAL},
   {"wsrep_provider_name",      (char*) &wsrep_provider_name,     SHOW_CHAR_PTR, SHOW_SCOPE_GLOBAL},
   {"wsrep_provider_version",   (char*) &wsrep_provider_version,  SHOW_CHAR_PTR, SHOW_SCOPE_GLOBAL},
   {"wsrep_provider_vendor",    (char*) &wsrep_provider_vendor,   SHOW_CHAR_PTR, SHOW_SCOPE_GLOBAL},
@@ -10314,6 +10401,16 @@ PSI_mutex_key key_LOCK_wsrep_slave_threads, key_LOCK_wsrep_desync;
 
 PSI_mutex_key key_LOCK_wsrep_thd;
 PSI_mutex_key key_LOCK_wsrep_sst_thread;
+PSI_mutex_key key_LOCK_wsrep_decoder;
+PSI_mutex_key key_LOCK_wsrep_causal;
+PSI_mutex_key key_LOCK_wsrep_NBO;
+PSI_mutex_key key_LOCK_wsrep_dump;
+PSI_mutex_key key_LOCK_wsrep_pool;
+PSI_mutex_key key_LOCK_wsrep_conflict;
+PSI_mutex_key key_LOCK_wsrep_conflict_stats;
+PSI_mutex_key key_LOCK_wsrep_load_data;
+PSI_mutex_key key_LOCK_wsrep_conflict_log;
+PSI_mutex_key key_LOCK_wsrep_replay;
 #endif /* WITH_WSREP */
 PSI_mutex_key key_RELAYLOG_LOCK_commit;
 PSI_mutex_key key_RELAYLOG_LOCK_commit_queue;
@@ -10440,9 +10537,21 @@ static PSI_mutex_info all_server_mutexes[]=
 
   { &key_LOCK_wsrep_slave_threads, "LOCK_wsrep_slave_threads", PSI_FLAG_GLOBAL},
   { &key_LOCK_wsrep_desync, "LOCK_wsrep_desync", PSI_FLAG_GLOBAL},
+  { &key_LOCK_wsrep_causal, "LOCK_wsrep_causal", PSI_FLAG_GLOBAL},
+  { &key_LOCK_wsrep_NBO, "LOCK_wsrep_NBO", PSI_FLAG_GLOBAL},
+  { &key_LOCK_wsrep_dump, "LOCK_wsrep_dump", PSI_FLAG_GLOBAL},
+  { &key_LOCK_wsrep_pool, "LOCK_wsrep_pool", PSI_FLAG_GLOBAL},
+  { &key_LOCK_wsrep_conflict, "LOCK_wsrep_conflict", 0},
+  { &key_LOCK_wsrep_conflict_stats, "LOCK_wsrep_conflict_stats",
+    PSI_FLAG_GLOBAL},
+  { &key_LOCK_wsrep_load_data, "LOCK_wsrep_load_data", 0},
+  { &key_LOCK_wsrep_conflict_log, "LOCK_wsrep_conflict_log",
+    PSI_FLAG_GLOBAL},
+  { &key_LOCK_wsrep_replay, "LOCK_wsrep_replay", PSI_FLAG_GLOBAL},
 
   { &key_LOCK_wsrep_thd, "LOCK_wsrep_thd", 0},
   { &key_LOCK_wsrep_sst_thread, "LOCK_wsrep_sst_thread", 0},
+  { &key_LOCK_wsrep_decoder, "Wsrep_event_reader::LOCK_decoder", 0},
 #endif /* WITH_WSREP */
   { &key_thd_timer_mutex, "thd_timer_mutex", 0},
 #ifdef HAVE_REPLICATION
@@ -10513,6 +10622,12 @@ PSI_cond_key key_COND_wsrep_ready, key_COND_wsrep_sst, key_COND_wsrep_sst_init,
 
 PSI_cond_key key_COND_wsrep_thd;
 PSI_cond_key key_COND_wsrep_sst_thread;
+PSI_cond_key key_COND_wsrep_decoder;
+PSI_cond_key key_COND_wsrep_causal;
+PSI_cond_key key_COND_wsrep_NBO;
+PSI_cond_key key_COND_wsrep_dump;
+PSI_cond_key key_COND_wsrep_load_data;
+PSI_cond_key key_COND_wsrep_conflict_log;
 #endif /* WITH_WSREP */
 
 PSI_cond_key key_RELAYLOG_update_cond;
@@ -10555,9 +10670,16 @@ static PSI_cond_info all_server_conds[]=
   { &key_COND_wsrep_sst_init, "COND_wsrep_sst_init", PSI_FLAG_GLOBAL},
   { &key_COND_wsrep_rollback, "COND_wsrep_rollback", PSI_FLAG_GLOBAL},
   { &key_COND_wsrep_replaying, "COND_wsrep_replaying", PSI_FLAG_GLOBAL},
+  { &key_COND_wsrep_causal, "COND_wsrep_causal", PSI_FLAG_GLOBAL},
+  { &key_COND_wsrep_NBO, "COND_wsrep_NBO", PSI_FLAG_GLOBAL},
+  { &key_COND_wsrep_dump, "COND_wsrep_dump", PSI_FLAG_GLOBAL},
+  { &key_COND_wsrep_conflict_log, "COND_wsrep_conflict_log",
+    PSI_FLAG_GLOBAL},
 
   { &key_COND_wsrep_thd, "THD::COND_wsrep_thd", 0},
   { &key_COND_wsrep_sst_thread, "wsrep_sst_thread", 0},
+  { &key_COND_wsrep_decoder, "Wsrep_event_reader::COND_decoder", 0},
+  { &key_COND_wsrep_load_data, "COND_wsrep_load_data", 0},
 #endif /* WITH_WSREP */
   { &key_COND_thr_lock, "COND_thr_lock", 0 },
   { &key_item_func_sleep_cond, "Item_func_sleep::cond", 0},
@@ -10590,7 +10712,10 @@ PSI_thread_key key_thread_bootstrap, key_thread_handle_manager, key_thread_main,
 PSI_thread_key key_thread_timer_notifier;
 #ifdef WITH_WSREP
 PSI_thread_key key_THREAD_wsrep_sst_joiner, key_THREAD_wsrep_sst_donor,
-  key_THREAD_wsrep_applier, key_THREAD_wsrep_rollbacker;
+  key_THREAD_wsrep_applier, key_THREAD_wsrep_rollbacker,
+  key_THREAD_wsrep_decoder, key_THREAD_wsrep_NBO_worker,
+  key_THREAD_wsrep_dump_writer, key_THREAD_wsrep_load_data,
+  key_THREAD_wsrep_conflict_log;
 #endif /* WITH_WSREP */
 
 static PSI_thread_info all_server_threads[]=
@@ -10614,7 +10739,14 @@ static PSI_thread_info all_server_threads[]=
   { &key_THREAD_wsrep_sst_joiner, "THREAD_wsrep_sst_joiner", 0},
   { &key_THREAD_wsrep_sst_donor, "THREAD_wsrep_sst_donor", 0},
   { &key_THREAD_wsrep_applier, "THREAD_wsrep_applier", 0},
-  { &key_THREAD_wsrep_rollbacker, "THREAD_wsrep_rollbacker", 0}
+  { &key_THREAD_wsrep_rollbacker, "THREAD_wsrep_rollbacker", 0},
+  { &key_THREAD_wsrep_decoder, "THREAD_wsrep_decoder", 0},
+  { &key_THREAD_wsrep_NBO_worker, "THREAD_wsrep_NBO_worker", 0},
+  { &key_THREAD_wsrep_dump_writer, "THREAD_wsrep_dump_writer",
+    PSI_FLAG_GLOBAL},
+  { &key_THREAD_wsrep_load_data, "THREAD_wsrep_load_data", 0},
+  { &key_THREAD_wsrep_conflict_log, "THREAD_wsrep_conflict_log",
+    PSI_FLAG_GLOBAL}
 #endif /* WITH_WSREP */
 };
 
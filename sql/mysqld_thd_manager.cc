@@ -208,7 +208,7 @@ void Global_THD_manager::add_thd(THD *thd)
     ++global_thd_count;
   }
 #ifdef WITH_WSREP
-  if (WSREP_ON && thd->wsrep_applier)
+  if (WSREP_ON && thd->wsrep_applier && !thd->wsrep_NBO_worker)
   {
     wsrep_running_threads++;
     WSREP_DEBUG("wsrep running threads now: %lu", wsrep_running_threads);
@@ -242,7 +242,7 @@ void Global_THD_manager::remove_thd(THD *thd)
   // Removing a THD that was never added is an error.
   DBUG_ASSERT(1 == num_erased);
 #ifdef WITH_WSREP
-  if (WSREP_ON && thd->wsrep_applier)
+  if (WSREP_ON && thd->wsrep_applier && !thd->wsrep_NBO_worker)
   {
     wsrep_running_threads--;
     WSREP_DEBUG("wsrep running threads now: %lu", wsrep_running_threads);
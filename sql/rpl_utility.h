@@ -344,6 +344,9 @@ public:
             (1 << (index % 8))) == (1 << (index %8)));
   }
 
+  /* Table flags of the table map */
+  uint16 flags() const { return m_flags; }
+
   /*
     This function returns the field size in raw bytes based on the type
     and the encoded field data from the master's raw data. This method can 
@@ -63,6 +63,11 @@
 #ifdef WITH_WSREP
 #include "wsrep_mysqld.h"
 #include "wsrep_thd.h"
+#include "wsrep_binlog.h"
+#include "wsrep_key_batch.h"
+#include "wsrep_conflict.h"
+#include "wsrep_table_map_cache.h"
+#include "wsrep_applier.h"
 #endif /* WITH_WSREP */
 
 #include "pfs_file_provider.h"
@@ -1427,10 +1432,20 @@ THD::THD(bool enable_plugins)
    wsrep_po_in_trans(FALSE),
    wsrep_apply_format(0),
    wsrep_apply_toi(false),
+   wsrep_TOI_table(false),
+   wsrep_NBO(NULL),
+   wsrep_NBO_worker(false),
    wsrep_sst_donor(false),
    wsrep_void_applier_trx(true),
    wsrep_gtid_event_buf(NULL),
    wsrep_gtid_event_buf_len(0),
+   wsrep_key_batch(NULL),
+   wsrep_applier_stats(NULL),
+   wsrep_published_keys(NULL),
+   wsrep_load_data_chunk(NULL),
+   wsrep_table_map_cache(NULL),
+   wsrep_decoder(NULL),
+   wsrep_ws_maps_used(0),
 #endif /* WITH_WSREP */
    m_parser_state(NULL),
    work_part_info(NULL),
@@ -2390,6 +2405,11 @@ void THD::release_resources()
     rli_slave= NULL;
   }
   wsrep_free_status(this);
+  wsrep_release_ws_maps(this);
+  wsrep_thd_free_keys(this);
+  wsrep_conflict_free(this);
+  wsrep_table_map_cache_free(this);
+  wsrep_decoder_free(this);
 #endif /* WITH_WSREP */
 }
 
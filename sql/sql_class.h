@@ -132,6 +132,8 @@ void thd_exit_cond(void *opaque_thd, const PSI_stage_info *stage,
 #ifdef WITH_WSREP
 namespace wsp {
 
+class key_batch;
+
 /* A class that helps to maintain the THD_STAGE_INFO, when nested */
 class ThreadStageInfoGuard
 {
@@ -3563,12 +3565,30 @@ public:
   rpl_sid                   wsrep_po_sid;
   void*                     wsrep_apply_format;
   bool                      wsrep_apply_toi; /* applier processing in TOI */
+  bool                      wsrep_TOI_table; /* TOI certified on table keys */
+  class Wsrep_NBO*          wsrep_NBO;       /* non-blocking ALTER context */
+  bool                      wsrep_NBO_worker; /* not one of slave threads */
   wsrep_gtid_t              wsrep_sync_wait_gtid;
   ulong                     wsrep_affected_rows;
   bool                      wsrep_sst_donor;
   bool                      wsrep_void_applier_trx;
   void*                     wsrep_gtid_event_buf;
   ulong                     wsrep_gtid_event_buf_len;
+  /* certification keys accumulated for the transaction */
+  wsp::key_batch*           wsrep_key_batch;
+  /* time accounting of applier thread, see wsrep_pool.h */
+  struct wsrep_applier_stats* wsrep_applier_stats;
+  /* keys published by applier thread, see wsrep_conflict.h */
+  struct wsrep_published_keys* wsrep_published_keys;
+  /* part of a file loaded by LOAD DATA worker, see wsrep_load_data.h */
+  struct wsrep_load_data_chunk* wsrep_load_data_chunk;
+  /* table maps checked by applier thread, see wsrep_table_map_cache.h */
+  struct wsrep_table_map_cache* wsrep_table_map_cache;
+  /* decode ahead helper of applier thread, see wsrep_applier.cc */
+  class Wsrep_decoder*      wsrep_decoder;
+  /* binlog cache files referenced by write-set being replicated */
+  wsrep_ws_map_t            wsrep_ws_maps[WSREP_MAX_WS_MAPS];
+  uint                      wsrep_ws_maps_used;
   bool                      wsrep_replicate_GTID;
   bool                      wsrep_skip_wsrep_GTID;
 
@@ -49,6 +49,10 @@
 #include "pfs_file_provider.h"
 #include "mysql/psi/mysql_file.h"
 
+#ifdef WITH_WSREP
+#include "wsrep_load_data.h"
+#endif /* WITH_WSREP */
+
 #include <algorithm>
 
 using std::min;
@@ -131,6 +135,20 @@ public:
   */
   void set_io_cache_arg(void* arg) { cache.arg = arg; }
 
+#ifdef WITH_WSREP
+  /**
+    Read only the part of the file from start to end, which must be
+    called before anything is read.
+  */
+  bool set_range(my_off_t start, my_off_t end)
+  {
+    if (reinit_io_cache(&cache, READ_CACHE, start, 0, 0))
+      return true;
+    cache.end_of_file= end;
+    return false;
+  }
+#endif /* WITH_WSREP */
+
   /**
     skip all data till the eof.
   */
@@ -510,6 +528,20 @@ int mysql_load(THD *thd,sql_exchange *ex,TABLE_LIST *table_list,
       DBUG_RETURN(TRUE);
   }
 
+#ifdef WITH_WSREP
+  if (!read_file_from_client && !is_fifo &&
+      wsrep_load_data_parallel_allowed(thd, ex, table, set_fields,
+                                       handle_duplicates))
+  {
+    int const ret= wsrep_load_data_parallel(thd, file, ex, escape_char);
+    if (ret >= 0)
+    {
+      mysql_file_close(file, MYF(0));
+      DBUG_RETURN(ret);
+    }
+  }
+#endif /* WITH_WSREP */
+
   READ_INFO read_info(file,tot_length,
                       ex->cs ? ex->cs : thd->variables.collation_database,
 		      *field_term,*ex->line.line_start, *ex->line.line_term,
@@ -533,6 +565,21 @@ int mysql_load(THD *thd,sql_exchange *ex,TABLE_LIST *table_list,
   }
 #endif /*!EMBEDDED_LIBRARY*/
 
+#ifdef WITH_WSREP
+  /* a worker of parallel LOAD DATA loads its part of the file, the lines
+     to ignore have been skipped by the session which split it */
+  if (thd->wsrep_load_data_chunk)
+  {
+    if (read_info.set_range(thd->wsrep_load_data_chunk->start,
+                            thd->wsrep_load_data_chunk->end))
+    {
+      mysql_file_close(file, MYF(0));
+      DBUG_RETURN(TRUE);
+    }
+    skip_lines= 0;
+  }
+#endif /* WITH_WSREP */
+
   thd->count_cuted_fields= CHECK_FIELD_WARN;		/* calc cuted fields */
   thd->cuted_fields=0L;
   /* Skip lines if there is a line terminator */
@@ -719,6 +766,17 @@ int mysql_load(THD *thd,sql_exchange *ex,TABLE_LIST *table_list,
   }
 #endif /*!EMBEDDED_LIBRARY*/
 
+#ifdef WITH_WSREP
+  if (thd->wsrep_load_data_chunk)
+  {
+    wsrep_load_data_chunk* const chunk= thd->wsrep_load_data_chunk;
+    chunk->records=  info.stats.records;
+    chunk->copied=   info.stats.copied;
+    chunk->deleted=  info.stats.deleted;
+    chunk->warnings= thd->get_stmt_da()->current_statement_cond_count();
+  }
+#endif /* WITH_WSREP */
+
   /* ok to client sent only after binlog write and engine commit */
   my_ok(thd, info.stats.copied + info.stats.deleted, 0L, name);
 err:
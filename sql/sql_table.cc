@@ -69,6 +69,9 @@
 #include "binlog.h"
 #include "sql_tablespace.h"            // check_tablespace_name())
 #include "item_timefunc.h"             // Item_func_now_local
+#ifdef WITH_WSREP
+#include "wsrep_nbo.h"                 // wsrep_NBO_phase_one_end()
+#endif /* WITH_WSREP */
 
 #include "pfs_file_provider.h"
 #include "mysql/psi/mysql_file.h"
@@ -7946,6 +7949,11 @@ static bool mysql_inplace_alter_table(THD *thd,
   }
 
   DEBUG_SYNC(thd, "alter_table_inplace_after_lock_downgrade");
+#ifdef WITH_WSREP
+  /* Concurrent DML is allowed now, non-blocking ALTER can leave total order */
+  if (table->mdl_ticket->get_type() == MDL_SHARED_UPGRADABLE)
+    wsrep_NBO_phase_one_end(thd);
+#endif /* WITH_WSREP */
   THD_STAGE_INFO(thd, stage_alter_inplace);
 
   if (table->file->ha_inplace_alter_table(altered_table,
@@ -7954,6 +7962,12 @@ static bool mysql_inplace_alter_table(THD *thd,
     goto rollback;
   }
 
+#ifdef WITH_WSREP
+  /* Non-blocking ALTER must be back in total order before it commits */
+  if (wsrep_NBO_phase_two_begin(thd, true))
+    goto rollback;
+#endif /* WITH_WSREP */
+
   // Upgrade to EXCLUSIVE before commit.
   if (wait_while_table_is_used(thd, table, HA_EXTRA_PREPARE_FOR_RENAME))
     goto rollback;
@@ -8077,6 +8091,9 @@ static bool mysql_inplace_alter_table(THD *thd,
   DBUG_RETURN(false);
 
  rollback:
+#ifdef WITH_WSREP
+  (void) wsrep_NBO_phase_two_begin(thd, false);
+#endif /* WITH_WSREP */
   table->file->ha_commit_inplace_alter_table(altered_table,
                                              ha_alter_info,
                                              false);
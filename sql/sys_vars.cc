@@ -6218,7 +6218,10 @@ static Sys_var_tz Sys_time_zone(
 #ifdef WITH_WSREP
 #include "wsrep_var.h"
 #include "wsrep_sst.h"
+#include "wsrep_sst_native.h"
 #include "wsrep_binlog.h"
+#include "wsrep_row_digest.h"
+#include "wsrep_load_data.h"
 
 static PolyLock_mutex PLock_wsrep_slave_threads(&LOCK_wsrep_slave_threads);
 static Sys_var_charptr Sys_wsrep_provider(
@@ -6290,6 +6293,18 @@ static Sys_var_ulong Sys_wsrep_slave_threads(
        ON_CHECK(NULL),
        ON_UPDATE(wsrep_slave_threads_update));
 
+static Sys_var_ulong Sys_wsrep_slave_threads_max(
+       "wsrep_slave_threads_max",
+       "Maximum number of slave appliers. If greater than "
+       "wsrep_slave_threads, the number of appliers is adjusted to the "
+       "observed replication parallelism between the two. "
+       "0 - number of appliers is fixed by wsrep_slave_threads",
+       GLOBAL_VAR(wsrep_slave_threads_max), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 512), DEFAULT(0), BLOCK_SIZE(1),
+       &PLock_wsrep_slave_threads, NOT_IN_BINLOG,
+       ON_CHECK(NULL),
+       ON_UPDATE(wsrep_slave_threads_max_update));
+
 static Sys_var_charptr Sys_wsrep_dbug_option(
        "wsrep_dbug_option", "DBUG options to provider library",
        GLOBAL_VAR(wsrep_dbug_option),CMD_LINE(REQUIRED_ARG),
@@ -6406,6 +6421,36 @@ static Sys_var_mybool Sys_wsrep_sst_donor_rejects_queries(
        GLOBAL_VAR(wsrep_sst_donor_rejects_queries), 
        CMD_LINE(OPT_ARG), DEFAULT(FALSE));
 
+static Sys_var_ulong Sys_wsrep_sst_native_streams(
+       "wsrep_sst_native_streams", "Number of connections the donor "
+       "copies data files over in native state snapshot transfer",
+       GLOBAL_VAR(wsrep_sst_native_streams), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, WSREP_SST_NATIVE_MAX_STREAMS), DEFAULT(4),
+       BLOCK_SIZE(1));
+
+static Sys_var_mybool Sys_wsrep_sst_native_encrypt(
+       "wsrep_sst_native_encrypt", "Encrypt native state snapshot transfer "
+       "with TLS, using the ssl-ca, ssl-cert and ssl-key of the server. "
+       "Implied by pxc_encrypt_cluster_traffic. A donor with encryption on "
+       "does not send to a joiner without it",
+       GLOBAL_VAR(wsrep_sst_native_encrypt), CMD_LINE(OPT_ARG),
+       DEFAULT(FALSE));
+
+static Sys_var_ulong Sys_wsrep_sst_warmup(
+       "wsrep_sst_warmup", "Percentage of the caches to warm up from the "
+       "state received, e.g. of the buffer pool dump sent by the donor, "
+       "before the joiner joins the cluster. 0 joins at once and warms up "
+       "in the background",
+       GLOBAL_VAR(wsrep_sst_warmup), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 100), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_wsrep_sst_warmup_timeout(
+       "wsrep_sst_warmup_timeout", "Maximum time in seconds the joiner "
+       "waits for wsrep_sst_warmup before joining the cluster, 0 for no "
+       "limit",
+       GLOBAL_VAR(wsrep_sst_warmup_timeout), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 86400), DEFAULT(600), BLOCK_SIZE(1));
+
 static Sys_var_mybool Sys_wsrep_on (
        "wsrep_on", "To enable wsrep replication ",
        SESSION_ONLY(wsrep_on),
@@ -6435,6 +6480,34 @@ static Sys_var_ulong Sys_wsrep_max_ws_rows (
        GLOBAL_VAR(wsrep_max_ws_rows), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(0, 1048576), DEFAULT(0), BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_wsrep_key_batch_size (
+       "wsrep_key_batch_size", "Number of distinct certification keys "
+       "to accumulate per transaction before appending them to write set. "
+       "Keys are also appended at the end of every statement. Duplicate "
+       "keys are appended only once per transaction, at the cost of "
+       "keeping every distinct key of the transaction in memory. "
+       "0 - append every key immediately",
+       GLOBAL_VAR(wsrep_key_batch_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 65536), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_wsrep_apply_decode_ahead(
+       "wsrep_apply_decode_ahead",
+       "Minimum size of a write-set (bytes) for its events to be decoded "
+       "by a helper thread ahead of the applier, so that decoding overlaps "
+       "with applying. 0 - always decode events in the applier thread",
+       GLOBAL_VAR(wsrep_apply_decode_ahead), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, WSREP_MAX_WS_SIZE), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_ulong Sys_wsrep_dump_log_size(
+       "wsrep_dump_log_size",
+       "Maximum size of write-set dump log (bytes), where write-sets "
+       "which failed to apply are saved for analysis. A full log is "
+       "renamed to wsrep_dump.log.old, replacing the previous one, and a "
+       "new log is started. Write-sets larger than the log are not saved. "
+       "0 - do not save write-sets",
+       GLOBAL_VAR(wsrep_dump_log_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, ULONG_MAX), DEFAULT(1073741824UL), BLOCK_SIZE(1));
+
 static Sys_var_charptr Sys_wsrep_notify_cmd(
        "wsrep_notify_cmd", "",
        GLOBAL_VAR(wsrep_notify_cmd),CMD_LINE(REQUIRED_ARG),
@@ -6445,6 +6518,19 @@ static Sys_var_mybool Sys_wsrep_certify_nonPK(
        GLOBAL_VAR(wsrep_certify_nonPK), 
        CMD_LINE(OPT_ARG), DEFAULT(TRUE));
 
+static const char *wsrep_row_digest_names[]= { "MD5", "XXHASH", NullS };
+static Sys_var_enum Sys_wsrep_row_digest(
+       "wsrep_row_digest",
+       "Digest used to identify rows of tables without primary key in "
+       "certification keys. Possible values are: "
+       "\"MD5\": compatible with older nodes. "
+       "\"XXHASH\": fast non-cryptographic 128-bit hash. "
+       "All nodes of the cluster must use the same digest.",
+       GLOBAL_VAR(wsrep_row_digest), CMD_LINE(REQUIRED_ARG),
+       wsrep_row_digest_names, DEFAULT(WSREP_ROW_DIGEST_MD5),
+       NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
+       ON_UPDATE(0));
+
 static const char *wsrep_certification_rules_names[]= { "strict", "optimized", NullS };
 static Sys_var_enum Sys_wsrep_certification_rules(
        "wsrep_certification_rules",
@@ -6475,9 +6561,26 @@ static Sys_var_uint Sys_wsrep_sync_wait(
        NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
        ON_UPDATE(wsrep_sync_wait_update));
 
-static const char *wsrep_OSU_method_names[]= { "TOI", "RSU", NullS };
+static Sys_var_ulong Sys_wsrep_sync_wait_max_staleness(
+       "wsrep_sync_wait_max_staleness",
+       "Maximum age (milliseconds) of a completed causal read that a sync "
+       "wait may reuse instead of waiting for a new one. A reused causal "
+       "read guarantees that transactions committed in the cluster before "
+       "it started are visible. 0 - every sync wait waits for a causal read "
+       "started after it",
+       GLOBAL_VAR(wsrep_sync_wait_max_staleness), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 60000), DEFAULT(0), BLOCK_SIZE(1));
+
+static const char *wsrep_OSU_method_names[]=
+  { "TOI", "RSU", "TABLE_TOI", "NBO", NullS };
 static Sys_var_enum Sys_wsrep_OSU_method(
-       "wsrep_OSU_method", "Method for Online Schema Upgrade",
+       "wsrep_OSU_method", "Method for Online Schema Upgrade. TABLE_TOI "
+       "certifies single table ALTER, index and table maintenance "
+       "statements only against the affected tables, so that write-sets "
+       "on other tables keep applying in parallel, their commits still "
+       "wait for the statement. NBO runs online "
+       "in-place ALTER TABLE in total order only while it starts and "
+       "commits; other DDL uses TOI",
        SESSION_VAR(wsrep_OSU_method), CMD_LINE(OPT_ARG),
        wsrep_OSU_method_names, DEFAULT(WSREP_OSU_TOI),
        NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
@@ -6545,6 +6648,16 @@ static Sys_var_mybool Sys_wsrep_load_data_splitting(
        GLOBAL_VAR(wsrep_load_data_splitting), 
        CMD_LINE(OPT_ARG), DEFAULT(TRUE));
 
+static Sys_var_ulong Sys_wsrep_load_data_threads(
+       "wsrep_load_data_threads",
+       "Number of sessions LOAD DATA INFILE parses a file in, each "
+       "replicating its rows as separate transactions. Takes effect with "
+       "wsrep_load_data_splitting. 1 - the file is loaded by the session "
+       "running the statement",
+       GLOBAL_VAR(wsrep_load_data_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, WSREP_LOAD_DATA_MAX_THREADS), DEFAULT(1),
+       BLOCK_SIZE(1));
+
 static Sys_var_mybool Sys_wsrep_slave_FK_checks(
        "wsrep_slave_FK_checks", "Should slave thread do "
        "foreign key constraint checks",
@@ -6557,6 +6670,21 @@ static Sys_var_mybool Sys_wsrep_slave_UK_checks(
        GLOBAL_VAR(wsrep_slave_UK_checks), 
        CMD_LINE(OPT_ARG), DEFAULT(FALSE));
 
+static Sys_var_mybool Sys_wsrep_slave_prefetch(
+       "wsrep_slave_prefetch", "Should slave thread start reading "
+       "the pages of all rows of a row event, located by primary key, "
+       "before applying the rows",
+       GLOBAL_VAR(wsrep_slave_prefetch),
+       CMD_LINE(OPT_ARG), DEFAULT(FALSE));
+
+static Sys_var_mybool Sys_wsrep_early_conflict_check(
+       "wsrep_early_conflict_check", "Should slave threads publish the "
+       "keys of the rows they are going to change, and local transactions "
+       "which change such a row abort at once instead of being BF aborted "
+       "later",
+       GLOBAL_VAR(wsrep_early_conflict_check),
+       CMD_LINE(OPT_ARG), DEFAULT(FALSE));
+
 static Sys_var_mybool Sys_wsrep_restart_slave(
        "wsrep_restart_slave", "Should MySQL slave be restarted automatically, when node joins back to cluster",
        GLOBAL_VAR(wsrep_restart_slave), CMD_LINE(OPT_ARG), DEFAULT(FALSE));
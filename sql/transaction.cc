@@ -31,6 +31,9 @@
 #include "sql_class.h"
 #include "log.h"
 #include "binlog.h"
+#ifdef WITH_WSREP
+#include "wsrep_key_batch.h"
+#endif /* WITH_WSREP */
 
 /**
   Helper: Tell tracker (if any) that transaction ended.
@@ -500,6 +503,12 @@ bool trans_commit_stmt(THD *thd)
   {
 #ifdef WITH_WSREP
     wsrep_register_hton(thd, FALSE);
+    /*
+      Keys batched by the statement reach the provider at its end. If that
+      fails they stay pending and the failure is reported at commit.
+    */
+    if (WSREP(thd) && thd->in_active_multi_stmt_transaction())
+      (void) wsrep_thd_flush_keys(thd);
 #endif /* WITH_WSREP */
     res= ha_commit_trans(thd, FALSE);
     if (! thd->in_active_multi_stmt_transaction())
@@ -18,10 +18,16 @@
 #include "wsrep_priv.h"
 #include "wsrep_binlog.h" // wsrep_dump_rbr_buf()
 #include "wsrep_xid.h"
+#include "wsrep_nbo.h"
+#include "wsrep_pool.h"
+#include "wsrep_conflict.h"
+#include "wsrep_table_map_cache.h"
 
 #include "log_event.h" // class THD, EVENT_LEN_OFFSET, etc.
 #include "debug_sync.h"
 
+#include <new>
+
 /*
   read the first event from (*buf). The size of the (*buf) is (*buf_len).
   At the end (*buf) is shitfed to point to the following event or NULL and
@@ -76,13 +82,323 @@ wsrep_get_apply_format(THD* thd)
   return thd->wsrep_rli->get_rli_description_event();
 }
 
+#define WSREP_DECODE_AHEAD_EVENTS 64
+
+/*
+  Decode ahead helper of an applier thread.
+
+  The helper thread is started for the first write-set of at least
+  wsrep_apply_decode_ahead bytes the applier gets, and is kept until the
+  applier exits. For every such write-set it decodes the events and stays
+  up to WSREP_DECODE_AHEAD_EVENTS events ahead of the applier, so that
+  event parsing and checksum verification overlap with applying of the
+  previous events.
+*/
+class Wsrep_decoder
+{
+public:
+  Wsrep_decoder()
+    : buf_(NULL), buf_len_(0), fd_(NULL), head_(0), count_(0),
+      job_(false), finished_(false), failed_(false), stop_(false),
+      exit_(false), running_(false)
+  {
+    mysql_mutex_init(key_LOCK_wsrep_decoder, &LOCK_decoder,
+                     MY_MUTEX_INIT_FAST);
+    mysql_cond_init(key_COND_wsrep_decoder, &COND_decoder);
+  }
+
+  ~Wsrep_decoder()
+  {
+    if (running_)
+    {
+      mysql_mutex_lock(&LOCK_decoder);
+      exit_= true;
+      mysql_cond_broadcast(&COND_decoder);
+      mysql_mutex_unlock(&LOCK_decoder);
+
+      my_thread_join(&thread_, NULL);
+    }
+
+    mysql_cond_destroy(&COND_decoder);
+    mysql_mutex_destroy(&LOCK_decoder);
+  }
+
+  /* @return thread creation error, 0 on success */
+  int start()
+  {
+    my_thread_attr_t attr;
+    my_thread_attr_init(&attr);
+    my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+    int const err= mysql_thread_create(key_THREAD_wsrep_decoder, &thread_,
+                                       &attr, decoder_thread, this);
+    my_thread_attr_destroy(&attr);
+    running_= (err == 0);
+    return err;
+  }
+
+  /* Start decoding a write-set */
+  void begin(char* buf, size_t buf_len,
+             const Format_description_log_event* fd)
+  {
+    mysql_mutex_lock(&LOCK_decoder);
+    DBUG_ASSERT(!job_ && count_ == 0);
+    buf_= buf;
+    buf_len_= buf_len;
+    fd_= fd;
+    head_= 0;
+    finished_= false;
+    failed_= false;
+    stop_= false;
+    job_= true;
+    mysql_cond_broadcast(&COND_decoder);
+    mysql_mutex_unlock(&LOCK_decoder);
+  }
+
+  /* Stop decoding the write-set and free events which were not applied */
+  void end()
+  {
+    mysql_mutex_lock(&LOCK_decoder);
+    stop_= true;
+    mysql_cond_broadcast(&COND_decoder);
+    while (job_)
+      mysql_cond_wait(&COND_decoder, &LOCK_decoder);
+
+    /* events decoded but not applied due to an error */
+    for (; count_ > 0; --count_)
+    {
+      delete queue_[head_];
+      head_= (head_ + 1) % WSREP_DECODE_AHEAD_EVENTS;
+    }
+    mysql_mutex_unlock(&LOCK_decoder);
+  }
+
+  /* @return true if there is another event or an error to report */
+  bool has_more()
+  {
+    mysql_mutex_lock(&LOCK_decoder);
+    while (count_ == 0 && !finished_)
+      mysql_cond_wait(&COND_decoder, &LOCK_decoder);
+    bool const ret= (count_ > 0 || failed_);
+    mysql_mutex_unlock(&LOCK_decoder);
+    return ret;
+  }
+
+  /* @return next event or NULL if it could not be decoded */
+  Log_event* next()
+  {
+    Log_event* ev= NULL;
+    mysql_mutex_lock(&LOCK_decoder);
+    while (count_ == 0 && !finished_)
+      mysql_cond_wait(&COND_decoder, &LOCK_decoder);
+    if (count_ > 0)
+    {
+      ev= queue_[head_];
+      head_= (head_ + 1) % WSREP_DECODE_AHEAD_EVENTS;
+      if (count_-- == WSREP_DECODE_AHEAD_EVENTS)
+        mysql_cond_broadcast(&COND_decoder);
+    }
+    mysql_mutex_unlock(&LOCK_decoder);
+    return ev;
+  }
+
+  /* bytes of the write-set which were not decoded */
+  size_t remaining()
+  {
+    mysql_mutex_lock(&LOCK_decoder);
+    size_t const ret= buf_len_;
+    mysql_mutex_unlock(&LOCK_decoder);
+    return ret;
+  }
+
+private:
+  static void* decoder_thread(void* arg)
+  {
+    my_thread_init();
+    static_cast<Wsrep_decoder*>(arg)->run();
+    my_thread_end();
+    my_thread_exit(0);
+    return NULL;
+  }
+
+  void run()
+  {
+    mysql_mutex_lock(&LOCK_decoder);
+    for (;;)
+    {
+      while (!job_ && !exit_)
+        mysql_cond_wait(&COND_decoder, &LOCK_decoder);
+      if (!job_) break;
+
+      mysql_mutex_unlock(&LOCK_decoder);
+      decode();
+      mysql_mutex_lock(&LOCK_decoder);
+
+      job_= false;
+      mysql_cond_broadcast(&COND_decoder);
+    }
+    mysql_mutex_unlock(&LOCK_decoder);
+  }
+
+  void decode()
+  {
+    mysql_mutex_lock(&LOCK_decoder);
+    char*  buf= buf_;
+    size_t buf_len= buf_len_;
+    const Format_description_log_event* fd= fd_;
+    mysql_mutex_unlock(&LOCK_decoder);
+
+    while (buf_len > 0)
+    {
+      mysql_mutex_lock(&LOCK_decoder);
+      while (count_ == WSREP_DECODE_AHEAD_EVENTS && !stop_)
+        mysql_cond_wait(&COND_decoder, &LOCK_decoder);
+      bool const stop= stop_;
+      mysql_mutex_unlock(&LOCK_decoder);
+      if (stop) return;
+
+      Log_event* const ev= wsrep_read_log_event(&buf, &buf_len, fd);
+
+      /* the applier installs it as apply format when it gets there, and
+         it does not free the previous one before that */
+      if (ev && ev->get_type_code() == binary_log::FORMAT_DESCRIPTION_EVENT)
+        fd= static_cast<Format_description_log_event*>(ev);
+
+      mysql_mutex_lock(&LOCK_decoder);
+      buf_len_= buf_len;
+      if (ev)
+      {
+        queue_[(head_ + count_) % WSREP_DECODE_AHEAD_EVENTS]= ev;
+        if (count_++ == 0) mysql_cond_broadcast(&COND_decoder);
+      }
+      else
+      {
+        failed_= true;
+        finished_= true;
+        mysql_cond_broadcast(&COND_decoder);
+      }
+      mysql_mutex_unlock(&LOCK_decoder);
+      if (!ev) return;
+    }
+
+    mysql_mutex_lock(&LOCK_decoder);
+    finished_= true;
+    mysql_cond_broadcast(&COND_decoder);
+    mysql_mutex_unlock(&LOCK_decoder);
+  }
+
+  /* write-set being decoded, protected by LOCK_decoder */
+  char*           buf_;
+  size_t          buf_len_; /* left after last decoded event */
+  const Format_description_log_event* fd_;
+  Log_event*      queue_[WSREP_DECODE_AHEAD_EVENTS];
+  uint            head_;
+  uint            count_;
+  bool            job_;      /* write-set given to the thread */
+  bool            finished_;
+  bool            failed_;
+  bool            stop_;
+  bool            exit_;
+
+  bool            running_;
+  my_thread_handle thread_;
+  mysql_mutex_t   LOCK_decoder;
+  mysql_cond_t    COND_decoder;
+
+  Wsrep_decoder(const Wsrep_decoder&);
+  Wsrep_decoder& operator=(const Wsrep_decoder&);
+};
+
+void wsrep_decoder_free(THD* const thd)
+{
+  delete thd->wsrep_decoder;
+  thd->wsrep_decoder= NULL;
+}
+
+/*
+  Provides events of a write-set to the applier. Write-sets of at least
+  wsrep_apply_decode_ahead bytes are decoded by the decode ahead helper of
+  the applier, smaller ones are decoded in place.
+*/
+class Wsrep_event_reader
+{
+public:
+  Wsrep_event_reader(THD* thd, char* buf, size_t buf_len)
+    : thd_(thd), buf_(buf), buf_len_(buf_len), decoder_(NULL)
+  {
+    ulong const threshold= wsrep_apply_decode_ahead;
+    if (threshold == 0 || buf_len < threshold) return;
+
+    if (!thd->wsrep_decoder)
+    {
+      Wsrep_decoder* const decoder= new (std::nothrow) Wsrep_decoder();
+      if (!decoder) return;
+
+      int const err= decoder->start();
+      if (err)
+      {
+        WSREP_WARN("Could not start write-set decoder thread: %d, "
+                   "decoding in place", err);
+        delete decoder;
+        return;
+      }
+      thd->wsrep_decoder= decoder;
+    }
+
+    decoder_= thd->wsrep_decoder;
+    decoder_->begin(buf, buf_len, wsrep_get_apply_format(thd));
+  }
+
+  ~Wsrep_event_reader()
+  {
+    if (decoder_) decoder_->end();
+  }
+
+  /* @return true if there is another event or an error to report */
+  bool has_more()
+  {
+    if (decoder_) return decoder_->has_more();
+    return buf_len_ > 0;
+  }
+
+  /* @return next event or NULL if it could not be decoded */
+  Log_event* next()
+  {
+    if (decoder_) return decoder_->next();
+    return wsrep_read_log_event(&buf_, &buf_len_,
+                                wsrep_get_apply_format(thd_));
+  }
+
+  /* bytes of the write-set which were not decoded */
+  size_t remaining()
+  {
+    if (decoder_) return decoder_->remaining();
+    return buf_len_;
+  }
+
+private:
+  THD* const      thd_;
+  char*           buf_;
+  size_t          buf_len_;
+  Wsrep_decoder*  decoder_;
+
+  Wsrep_event_reader(const Wsrep_event_reader&);
+  Wsrep_event_reader& operator=(const Wsrep_event_reader&);
+};
+
+static bool wsrep_is_table_TOI_marker(const Query_log_event* const ev)
+{
+  return ev->q_len == sizeof(WSREP_TABLE_TOI_MARKER) - 1 &&
+         !memcmp(ev->query, WSREP_TABLE_TOI_MARKER, ev->q_len);
+}
+
 static wsrep_cb_status_t wsrep_apply_events(THD*        thd,
                                             const void* events_buf,
                                             size_t      buf_len)
 {
-  char *buf= (char *)events_buf;
   int rcode= 0;
   int event= 1;
+  bool group_started= false;
+  Query_log_event* nbo_marker= NULL;
 
   DBUG_ENTER("wsrep_apply_events");
 
@@ -107,6 +423,8 @@ static wsrep_cb_status_t wsrep_apply_events(THD*        thd,
     DBUG_RETURN(WSREP_CB_FAILURE);
   }
 
+  wsrep_table_map_cache_check(thd);
+
   mysql_mutex_lock(&thd->LOCK_wsrep_thd);
   thd->wsrep_query_state= QUERY_EXEC;
   if (thd->wsrep_conflict_state!= REPLAYING)
@@ -117,16 +435,17 @@ static wsrep_cb_status_t wsrep_apply_events(THD*        thd,
     WSREP_DEBUG("Empty apply event found while processing write-set: %lld",
                 (long long) wsrep_thd_trx_seqno(thd));
 
-  while(buf_len)
+  Wsrep_event_reader reader(thd, (char *)events_buf, buf_len);
+
+  while(reader.has_more())
   {
     int exec_res;
-    Log_event* ev= wsrep_read_log_event(&buf, &buf_len,
-                                        wsrep_get_apply_format(thd));
+    Log_event* ev= reader.next();
 
     if (!ev)
     {
       WSREP_ERROR("Applier could not read binlog event, seqno: %lld, len: %zu",
-                  (long long)wsrep_thd_trx_seqno(thd), buf_len);
+                  (long long)wsrep_thd_trx_seqno(thd), reader.remaining());
       rcode= 1;
       goto error;
     }
@@ -157,7 +476,54 @@ static wsrep_cb_status_t wsrep_apply_events(THD*        thd,
       assert(event == 1);
       break;
     }
+    case binary_log::QUERY_EVENT:
+      if (thd->wsrep_apply_toi)
+      {
+        Query_log_event* const qev= (Query_log_event*)ev;
+        if (nbo_marker)
+        {
+          /* statement of non-blocking ALTER goes to a worker thread */
+          int const res= wsrep_NBO_apply_begin(thd, nbo_marker, qev);
+          delete nbo_marker;
+          nbo_marker= NULL;
+          if (res >= 0)
+          {
+            rcode= res;
+            if (rcode) goto error;
+            continue;
+          }
+        }
+        else if (wsrep_NBO_is_begin(qev))
+        {
+          nbo_marker= qev;
+          continue;
+        }
+        else if (wsrep_NBO_is_end(qev))
+        {
+          rcode= wsrep_NBO_apply_end(thd, qev);
+          delete ev;
+          if (rcode) goto error;
+          continue;
+        }
+      }
+      /*
+        Table level TOI statements are replicated as ordinary write-sets
+        so that they can be applied in parallel. Such a write-set starts
+        with a marker, apply the statement which follows as TOI.
+      */
+      if (!thd->wsrep_apply_toi && !group_started &&
+          wsrep_is_table_TOI_marker((Query_log_event*)ev))
+      {
+        thd->wsrep_apply_toi= true;
+        thd->variables.option_bits&= ~OPTION_BEGIN;
+        thd->server_status&= ~SERVER_STATUS_IN_TRANS;
+        delete ev;
+        continue;
+      }
+      group_started= true;
+      break;
     default:
+      group_started= true;
       break;
     }
 
@@ -246,6 +612,8 @@ static wsrep_cb_status_t wsrep_apply_events(THD*        thd,
   }
 
  error:
+  delete nbo_marker;
+
   mysql_mutex_lock(&thd->LOCK_wsrep_thd);
   thd->wsrep_query_state= QUERY_IDLE;
   mysql_mutex_unlock(&thd->LOCK_wsrep_thd);
@@ -283,6 +651,8 @@ wsrep_cb_status_t wsrep_apply_cb(void* const             ctx,
 
   thd->wsrep_trx_meta = *meta;
 
+  wsrep_pool_apply_begin(thd, meta);
+
   THD_STAGE_INFO(thd, stage_wsrep_applying_writeset);
   snprintf(thd->wsrep_info, sizeof(thd->wsrep_info),
            "wsrep: applying write-set (%lld)",
@@ -312,6 +682,10 @@ wsrep_cb_status_t wsrep_apply_cb(void* const             ctx,
   }
   wsrep_cb_status_t rcode(wsrep_apply_events(thd, buf, buf_len));
 
+  /* schema of the tables may have changed, also by a table level TOI
+     write-set, which sets wsrep_apply_toi at its marker */
+  if (thd->wsrep_apply_toi) wsrep_table_map_cache_invalidate();
+
   THD_STAGE_INFO(thd, stage_wsrep_applied_writeset);
   snprintf(thd->wsrep_info, sizeof(thd->wsrep_info),
            "wsrep: %s write set (%lld)",
@@ -347,6 +721,10 @@ static wsrep_cb_status_t wsrep_commit(THD* const thd)
   WSREP_DEBUG("%s", thd->wsrep_info);
   thd_proc_info(thd, thd->wsrep_info);
 
+  /* local transactions waiting for the row locks get them only after
+  the commit, the keys need not be published any longer */
+  wsrep_conflict_withdraw(thd);
+
   if (!thd->get_transaction()->is_empty(Transaction_ctx::STMT))
   {
     WSREP_INFO("Applier statement commit needed");
@@ -389,6 +767,8 @@ static wsrep_cb_status_t wsrep_rollback(THD* const thd)
   WSREP_DEBUG("%s", thd->wsrep_info);
   thd_proc_info(thd, thd->wsrep_info);
 
+  wsrep_conflict_withdraw(thd);
+
   if (!thd->get_transaction()->is_empty(Transaction_ctx::STMT))
   {
     WSREP_INFO("Applier statement rollback needed");
@@ -480,8 +860,13 @@ wsrep_cb_status_t wsrep_commit_cb(void*         const     ctx,
     /* From trans_begin(). Also check the comment at line:134 when/why these bits are unset. */
     thd->variables.option_bits|= OPTION_BEGIN;
     thd->server_status|= SERVER_STATUS_IN_TRANS;
-    thd->wsrep_apply_toi= false;
   }
+  /* also set by a replayed table level TOI write-set */
+  thd->wsrep_apply_toi= false;
+
+  /* applier may only leave the pool after successful commit */
+  wsrep_pool_apply_end(thd, (commit && WSREP_CB_SUCCESS == rcode) ?
+                            exit : NULL);
 
   return rcode;
 }
@@ -18,6 +18,8 @@
 
 #include "wsrep_api.h"
 
+class THD;
+
 /* wsrep callback prototypes */
 
 wsrep_cb_status_t wsrep_apply_cb(void *ctx,
@@ -36,4 +38,7 @@ wsrep_cb_status_t wsrep_unordered_cb(void*       ctx,
                                      const void* data,
                                      size_t      size);
 
+/* Stop the decode ahead helper thread of applier thd */
+void wsrep_decoder_free(THD* thd);
+
 #endif /* WSREP_APPLIER_H */
@@ -15,6 +15,7 @@
 
 #include "wsrep_binlog.h"
 #include "wsrep_priv.h"
+#include "wsrep_dump.h"
 #include "log_event.h"
 
 /*
@@ -105,27 +106,17 @@ cleanup:
   return ER_ERROR_ON_WRITE;
 }
 
-#define STACK_SIZE 4096 /* 4K - for buffer preallocated on the stack:
-                         * many transactions would fit in there
-                         * so there is no need to reach for the heap */
-
-/* Returns minimum multiple of HEAP_PAGE_SIZE that is >= length */
-static inline size_t
-heap_size(size_t length)
-{
-    return (length + HEAP_PAGE_SIZE - 1)/HEAP_PAGE_SIZE*HEAP_PAGE_SIZE;
-}
-
 /* append data to writeset */
 static inline wsrep_status_t
 wsrep_append_data(wsrep_t*           const wsrep,
                   wsrep_ws_handle_t* const ws,
                   const void*        const data,
-                  size_t             const len)
+                  size_t             const len,
+                  bool               const copy = true)
 {
     struct wsrep_buf const buff = { data, len };
     wsrep_status_t const rc(wsrep->append_data(wsrep, ws, &buff, 1,
-                                               WSREP_DATA_ORDERED, true));
+                                               WSREP_DATA_ORDERED, copy));
     if (rc != WSREP_OK)
     {
         WSREP_WARN("append_data() returned %d", rc);
@@ -134,14 +125,66 @@ wsrep_append_data(wsrep_t*           const wsrep,
     return rc;
 }
 
+/*
+  Map the spill file of a binlog cache into memory, so that its contents
+  can be appended to the write-set by reference. The mapping is owned by
+  thd until wsrep_release_ws_maps() is called.
+
+  @return pointer to the file contents or NULL if the file can not be mapped
+          (encrypted temporary files, mmap() failure) and caller should fall
+          back to copying.
+ */
+static const uchar* wsrep_map_cache_file(THD*      const thd,
+                                         IO_CACHE* const cache,
+                                         size_t    const length)
+{
+    if (cache->file < 0                  ||
+        (cache->myflags & MY_ENCRYPT)    ||
+        thd->wsrep_ws_maps_used >= WSREP_MAX_WS_MAPS)
+        return NULL;
+
+    void* const ptr(my_mmap(0, length, PROT_READ, MAP_SHARED, cache->file, 0));
+    if (ptr == MAP_FAILED)
+    {
+        WSREP_DEBUG("Failed to map binlog cache file, %zu bytes: %d (%s)",
+                    length, errno, strerror(errno));
+        return NULL;
+    }
+#ifdef HAVE_MADVISE
+    (void) madvise(ptr, length, MADV_SEQUENTIAL);
+#endif
+
+    wsrep_ws_map_t& map(thd->wsrep_ws_maps[thd->wsrep_ws_maps_used++]);
+    map.ptr = ptr;
+    map.len = length;
+
+    return static_cast<const uchar*>(ptr);
+}
+
+void wsrep_release_ws_maps(THD* thd)
+{
+    for (uint i= 0; i < thd->wsrep_ws_maps_used; ++i)
+    {
+        my_munmap(thd->wsrep_ws_maps[i].ptr, thd->wsrep_ws_maps[i].len);
+        thd->wsrep_ws_maps[i].ptr = NULL;
+        thd->wsrep_ws_maps[i].len = 0;
+    }
+    thd->wsrep_ws_maps_used= 0;
+}
+
 /*
   Write the contents of a cache to wsrep provider.
 
   This function quite the same as MYSQL_BIN_LOG::write_cache(),
   with the exception that here we write in buffer instead of log file.
 
-  This version reads all of cache into single buffer and then appends to a
-  writeset at once.
+  This version appends cache contents without copying them: the GTID prefix
+  (if any) goes as a separate, copied segment, and the events are handed to
+  the provider as a reference either to the cache buffer (whole cache fits
+  in memory) or to the memory mapped spill file. The referenced memory must
+  stay valid until the write-set is replicated, see wsrep_release_ws_maps().
+  If the spill file can not be mapped, cache contents are appended in chunks
+  as they are read.
  */
 static int wsrep_write_cache_once(wsrep_t*  const wsrep,
                                   THD*      const thd,
@@ -150,22 +193,11 @@ static int wsrep_write_cache_once(wsrep_t*  const wsrep,
 {
     my_off_t const saved_pos(my_b_tell(cache));
 
-    if (reinit_io_cache(cache, READ_CACHE, 0, 0, 0))
-    {
-        WSREP_ERROR("Failed to initialize io-cache");
-        return ER_ERROR_ON_WRITE;
-    }
-
     int err(WSREP_OK);
 
-    size_t total_length(0);
-    uchar  stack_buf[STACK_SIZE]; /* to avoid dynamic allocations for few data*/
-    uchar* heap_buf(NULL);
-    uchar* buf(stack_buf);
-    size_t allocated(sizeof(stack_buf));
-    size_t used(0);
-
-    uint length(my_b_bytes_in_cache(cache));
+    uchar        gtid_buf[Gtid_log_event::MAX_EVENT_LENGTH];
+    const void*  prefix(NULL);
+    size_t       prefix_len(0);
 
     /* If galera node is acting as independent slave then GTID event that is
     captured during processing of relay log should be cached and appended to
@@ -173,39 +205,8 @@ static int wsrep_write_cache_once(wsrep_t*  const wsrep,
     GTID sequence. */
     if (thd->wsrep_gtid_event_buf)
     {
-      if (thd->wsrep_gtid_event_buf_len < (allocated - used))
-      {
-        memcpy(buf + used,
-               thd->wsrep_gtid_event_buf,
-               thd->wsrep_gtid_event_buf_len);
-      }
-      else
-      {
-        size_t const new_size(heap_size(thd->wsrep_gtid_event_buf_len + used));
-        uchar* tmp = (uchar *)my_realloc(key_memory_wsrep, heap_buf,
-                                         new_size, MYF(0));
-        if (!tmp)
-        {
-          WSREP_ERROR("Failed to allocate/reallocate buffer to hold GTID event"
-                      " Existing Size: %zu, Requested Size: %lu",
-                      allocated, thd->wsrep_gtid_event_buf_len);
-          err = WSREP_TRX_SIZE_EXCEEDED;
-          goto cleanup;
-        }
-
-        /* Copy over existing buffer content. */
-        heap_buf = tmp;
-        memcpy(heap_buf, buf, used);
-        buf = heap_buf;
-        allocated = new_size;
-
-        memcpy(buf + used,
-               thd->wsrep_gtid_event_buf,
-               thd->wsrep_gtid_event_buf_len);
-      }
-
-      total_length += thd->wsrep_gtid_event_buf_len;
-      used = total_length;
+      prefix     = thd->wsrep_gtid_event_buf;
+      prefix_len = thd->wsrep_gtid_event_buf_len;
     }
     else if (thd->variables.gtid_next.type != AUTOMATIC_GROUP)
     {
@@ -214,64 +215,71 @@ static int wsrep_write_cache_once(wsrep_t*  const wsrep,
       information. If user has set explict GTID using gtid_next=UUID:seqno
       then such event should be appended to write-set. */
       Gtid_log_event gtid_event(thd, true, 0, 0, false);
-      uchar gtid_buf[Gtid_log_event::MAX_EVENT_LENGTH];
-      uint32 gtid_len = gtid_event.write_to_memory(gtid_buf);
+      prefix     = gtid_buf;
+      prefix_len = gtid_event.write_to_memory(gtid_buf);
+    }
 
-      assert(Gtid_log_event::MAX_EVENT_LENGTH < STACK_SIZE);
+    size_t const total_length(prefix_len + saved_pos);
 
-      memcpy(buf + used, gtid_buf, gtid_len);
-      used += gtid_len;
-      total_length += gtid_len;
+    /*
+      Bail out if write-set grows too large.
+      Not a real limit on a writeset size which includes other things
+      like header and keys.
+    */
+    if (unlikely(total_length > wsrep_max_ws_size))
+    {
+        WSREP_WARN("Transaction/Write-set size limit (%lu) exceeded: %zu",
+                   wsrep_max_ws_size, total_length);
+        err = WSREP_TRX_SIZE_EXCEEDED;
+        goto free_prefix;
     }
 
-    if (unlikely(0 == length)) length = my_b_fill(cache);
+    if (reinit_io_cache(cache, READ_CACHE, 0, 0, 0))
+    {
+        WSREP_ERROR("Failed to initialize io-cache");
+        err = ER_ERROR_ON_WRITE;
+        goto free_prefix;
+    }
 
-    if (likely(length > 0)) do
+    /* GTID event is small and short-lived, let provider copy it. */
+    if (prefix_len > 0 &&
+        WSREP_OK != (err = wsrep_append_data(wsrep, &thd->wsrep_ws_handle,
+                                             prefix, prefix_len)))
+        goto cleanup;
+
+    if (saved_pos > 0)
     {
-        total_length += length;
-        /*
-          Bail out if buffer grows too large.
-          A temporary fix to avoid allocating indefinitely large buffer,
-          not a real limit on a writeset size which includes other things
-          like header and keys.
-        */
-        if (unlikely(total_length > wsrep_max_ws_size))
+        const uchar* mapped;
+
+        if (my_b_bytes_in_cache(cache) == saved_pos)
         {
-            WSREP_WARN("Transaction/Write-set size limit (%lu) exceeded: %zu",
-                       wsrep_max_ws_size, total_length);
-	    err = WSREP_TRX_SIZE_EXCEEDED;
-            goto cleanup;
+            /* whole cache is in memory, reference the cache buffer */
+            err = wsrep_append_data(wsrep, &thd->wsrep_ws_handle,
+                                    cache->read_pos, saved_pos, false);
         }
-
-        if (total_length > allocated)
+        else if ((mapped = wsrep_map_cache_file(thd, cache, saved_pos)))
         {
-            size_t const new_size(heap_size(total_length));
-            uchar* tmp = (uchar *)my_realloc(key_memory_wsrep, heap_buf, new_size, MYF(0));
-            if (!tmp)
-            {
-                WSREP_ERROR("Failed to allocate/reallocate memory to hold"
-                            " write-set for replication."
-                            " Existing Size: %zu, Requested Size: %lu",
-                            allocated, (long unsigned) new_size);
-                err = WSREP_TRX_SIZE_EXCEEDED;
-                goto cleanup;
-            }
-
-            heap_buf = tmp;
-            buf = heap_buf;
-            allocated = new_size;
-
-            if (used <= STACK_SIZE && used > 0) // there's data in stack_buf
-                memcpy(heap_buf, stack_buf, used);
+            /* cache was flushed to spill file by reinit_io_cache() above */
+            err = wsrep_append_data(wsrep, &thd->wsrep_ws_handle,
+                                    mapped, saved_pos, false);
         }
+        else
+        {
+            uint length(my_b_bytes_in_cache(cache));
+            if (unlikely(0 == length)) length = my_b_fill(cache);
 
-        memcpy(buf + used, cache->read_pos, length);
-        used = total_length;
-        cache->read_pos = cache->read_end;
-    } while ((cache->file >= 0) && (length = my_b_fill(cache)));
-
-    if (used > 0)
-        err = wsrep_append_data(wsrep, &thd->wsrep_ws_handle, buf, used);
+            if (likely(length > 0)) do
+            {
+                if (WSREP_OK != (err = wsrep_append_data(wsrep,
+                                                         &thd->wsrep_ws_handle,
+                                                         cache->read_pos,
+                                                         length)))
+                    goto cleanup;
+
+                cache->read_pos = cache->read_end;
+            } while ((cache->file >= 0) && (length = my_b_fill(cache)));
+        }
+    }
 
     if (WSREP_OK == err) *len = total_length;
 
@@ -281,10 +289,13 @@ cleanup:
         WSREP_ERROR("Failed to reinitialize io-cache");
     }
 
-    if (unlikely(WSREP_OK != err)) wsrep_dump_rbr_buf(thd, buf, used);
+free_prefix:
+    /* an oversized transaction is refused before anything is appended,
+       there is nothing to analyze in its events */
+    if (unlikely(WSREP_OK != err && WSREP_TRX_SIZE_EXCEEDED != err))
+        wsrep_dump_rbr_direct(thd, cache);
 
-    my_free(heap_buf);
-    if (thd->wsrep_gtid_event_buf_len < STACK_SIZE) my_free(thd->wsrep_gtid_event_buf);
+    my_free(thd->wsrep_gtid_event_buf);
     thd->wsrep_gtid_event_buf     = NULL;
     thd->wsrep_gtid_event_buf_len = 0;
     return err;
@@ -401,87 +412,36 @@ int wsrep_write_cache(wsrep_t*  const wsrep,
 
 void wsrep_dump_rbr_buf(THD *thd, const void* rbr_buf, size_t buf_len)
 {
-  /* filename is derived from wsrep_data_home_dir (which in turn from
-  mysql_real_data_home that has max length limit of FN_REFLEN */
-  char filename[FN_REFLEN + 64]= {0};
-  int len= snprintf(filename, FN_REFLEN + 64, "%s/GRA_%u_%lld.log",
-                    wsrep_data_home_dir, thd->thread_id(),
-                    (long long)wsrep_thd_trx_seqno(thd));
-  if (len >= (FN_REFLEN + 64))
-  {
-    WSREP_ERROR("RBR dump path too long: %d, skipping dump.", len);
-    return;
-  }
-
-  FILE *of= fopen(filename, "wb");
-  if (of)
-  {
-    fwrite (rbr_buf, buf_len, 1, of);
-    fclose(of);
-  }
-  else
-  {
-    WSREP_ERROR("Failed to open file '%s': %d (%s)",
-                filename, errno, strerror(errno));
-  }
+  wsrep_dump_writeset(thd, rbr_buf, buf_len);
 }
 
+/*
+  The dump log limits are checked before the cache is read, and the cache
+  is read from its spill file straight into the queued record.
+ */
 void wsrep_dump_rbr_direct(THD* thd, IO_CACHE* cache)
 {
-  /* filename is derived from wsrep_data_home_dir (which in turn from
-  mysql_real_data_home that has max length limit of FN_REFLEN */
-  char filename[FN_REFLEN + 64]= {0};
-  int len= snprintf(filename, FN_REFLEN + 64, "%s/GRA_%u_%lld.log",
-                    wsrep_data_home_dir, thd->thread_id(),
-                    (long long)wsrep_thd_trx_seqno(thd));
-  size_t bytes_in_cache = 0;
-  // check path
-  if (len >= (FN_REFLEN + 64))
-  {
-    WSREP_ERROR("RBR dump path too long: %d, skipping dump.", len);
-    return ;
-  }
-  // init cache
   my_off_t const saved_pos(my_b_tell(cache));
-  if (reinit_io_cache(cache, READ_CACHE, 0, 0, 0))
-  {
-    WSREP_ERROR("Failed to initialize io-cache");
-    return ;
-  }
-  // open file
-  FILE* of = fopen(filename, "wb");
-  if (!of)
-  {
-    WSREP_ERROR("Failed to open file '%s': %d (%s)",
-                filename, errno, strerror(errno));
-    goto cleanup;
-  }
-  // ready to write
-  bytes_in_cache= my_b_bytes_in_cache(cache);
-  if (unlikely(bytes_in_cache == 0)) bytes_in_cache = my_b_fill(cache);
-  if (likely(bytes_in_cache > 0)) do
-  {
-    if (my_fwrite(of, cache->read_pos, bytes_in_cache,
-                  MYF(MY_WME | MY_NABP)) == (size_t) -1)
-    {
-      WSREP_ERROR("Failed to write file '%s'", filename);
-      goto cleanup;
-    }
-    cache->read_pos= cache->read_end;
-  } while ((cache->file >= 0) && (bytes_in_cache= my_b_fill(cache)));
-  if(cache->error == -1)
+  if (saved_pos == 0) return;
+
+  uchar* buf(wsrep_dump_reserve(saved_pos));
+  if (!buf) return;
+
+  if (reinit_io_cache(cache, READ_CACHE, 0, 0, 0) ||
+      my_b_read(cache, buf, saved_pos))
   {
-    WSREP_ERROR("RBR inconsistent");
-    goto cleanup;
+    WSREP_WARN("Failed to read binlog cache of %llu bytes to dump",
+               (ulonglong) saved_pos);
+    wsrep_dump_cancel(buf, saved_pos);
+    buf= NULL;
   }
-cleanup:
-  // init back
+
   if (reinit_io_cache(cache, WRITE_CACHE, saved_pos, 0, 0))
   {
     WSREP_ERROR("Failed to reinitialize io-cache");
   }
-  // close file
-  if (of) fclose(of);
+
+  if (buf) wsrep_dump_queue(thd, buf, saved_pos);
 }
 
 extern handlerton *binlog_hton;
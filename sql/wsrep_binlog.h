@@ -43,10 +43,17 @@ int wsrep_write_cache (wsrep_t*  wsrep,
                        IO_CACHE* cache,
                        size_t*   len);
 
-/* Dump replication buffer to disk */
+/*
+  Release memory mappings of binlog cache files which were appended to the
+  write-set by reference. Must be called after the write-set has been
+  replicated or discarded.
+ */
+void wsrep_release_ws_maps(THD* thd);
+
+/* Queue replication buffer for writing to write-set dump log */
 void wsrep_dump_rbr_buf(THD *thd, const void* rbr_buf, size_t buf_len);
 
-/* Dump replication buffer to disk without intermediate buffer */
+/* Queue contents of a cache for writing to write-set dump log */
 void wsrep_dump_rbr_direct(THD* thd, IO_CACHE* cache);
 
 int wsrep_binlog_close_connection(THD* thd);
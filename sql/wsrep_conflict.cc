@@ -0,0 +1,160 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_conflict.h"
+#include "wsrep_priv.h"
+#include "sql_class.h"
+#include "my_atomic.h"
+#include "../extra/lz4/my_xxhash.h"
+
+#include <map>
+#include <new>
+#include <vector>
+
+/* published key hash -> number of appliers which published it */
+typedef std::map<ulonglong, uint> conflict_keys_t;
+
+struct conflict_partition
+{
+  mysql_mutex_t   lock;
+  conflict_keys_t keys;
+};
+
+static conflict_partition conflict_partitions[WSREP_CONFLICT_PARTITIONS];
+
+/* keys published by all appliers, lets local transactions skip the lookup
+   when there are none */
+static int64 conflict_n_published= 0;
+
+static long long wsrep_early_conflicts_counter= 0;
+
+/* value exported to SHOW STATUS */
+static long long wsrep_early_conflicts= 0;
+
+/* keys published by an applier for the write-set being applied */
+struct wsrep_published_keys
+{
+  std::vector<ulonglong> hashes;
+};
+
+static ulonglong conflict_key_hash(const wsrep_key_t* const key)
+{
+  ulonglong hash= key->key_parts_num;
+  for (size_t i= 0; i < key->key_parts_num; ++i)
+    hash= MY_XXH64(key->key_parts[i].ptr, key->key_parts[i].len,
+                   hash ^ key->key_parts[i].len);
+  return hash;
+}
+
+static conflict_partition& conflict_partition_of(ulonglong const hash)
+{
+  return conflict_partitions[hash % WSREP_CONFLICT_PARTITIONS];
+}
+
+void wsrep_conflict_init()
+{
+  for (uint i= 0; i < WSREP_CONFLICT_PARTITIONS; ++i)
+    mysql_mutex_init(key_LOCK_wsrep_conflict, &conflict_partitions[i].lock,
+                     MY_MUTEX_INIT_FAST);
+}
+
+void wsrep_conflict_deinit()
+{
+  for (uint i= 0; i < WSREP_CONFLICT_PARTITIONS; ++i)
+  {
+    conflict_partitions[i].keys.clear();
+    mysql_mutex_destroy(&conflict_partitions[i].lock);
+  }
+}
+
+void wsrep_conflict_publish(THD* const thd, const wsrep_key_t* const key)
+{
+  wsrep_published_keys* keys= thd->wsrep_published_keys;
+  if (!keys)
+    keys= thd->wsrep_published_keys= new (std::nothrow) wsrep_published_keys;
+  if (!keys || keys->hashes.size() >= WSREP_CONFLICT_MAX_KEYS) return;
+
+  ulonglong const hash= conflict_key_hash(key);
+  keys->hashes.push_back(hash);
+
+  conflict_partition& part= conflict_partition_of(hash);
+  mysql_mutex_lock(&part.lock);
+  ++part.keys[hash];
+  mysql_mutex_unlock(&part.lock);
+
+  my_atomic_add64(&conflict_n_published, 1);
+}
+
+void wsrep_conflict_withdraw(THD* const thd)
+{
+  wsrep_published_keys* const keys= thd->wsrep_published_keys;
+  if (!keys || keys->hashes.empty()) return;
+
+  for (size_t i= 0; i < keys->hashes.size(); ++i)
+  {
+    ulonglong const hash= keys->hashes[i];
+    conflict_partition& part= conflict_partition_of(hash);
+
+    mysql_mutex_lock(&part.lock);
+    conflict_keys_t::iterator const it= part.keys.find(hash);
+    DBUG_ASSERT(it != part.keys.end());
+    if (it != part.keys.end() && --it->second == 0)
+      part.keys.erase(it);
+    mysql_mutex_unlock(&part.lock);
+  }
+
+  my_atomic_add64(&conflict_n_published,
+                  -static_cast<int64>(keys->hashes.size()));
+  keys->hashes.clear();
+}
+
+void wsrep_conflict_free(THD* const thd)
+{
+  wsrep_conflict_withdraw(thd);
+  delete thd->wsrep_published_keys;
+  thd->wsrep_published_keys= NULL;
+}
+
+bool wsrep_conflict_check(THD* const thd, const wsrep_key_t* const key)
+{
+  if (my_atomic_load64(&conflict_n_published) == 0) return false;
+
+  ulonglong const hash= conflict_key_hash(key);
+  conflict_partition& part= conflict_partition_of(hash);
+
+  mysql_mutex_lock(&part.lock);
+  bool const published= part.keys.count(hash) != 0;
+  mysql_mutex_unlock(&part.lock);
+
+  if (!published) return false;
+
+  mysql_mutex_lock(&thd->LOCK_wsrep_thd);
+  if (thd->wsrep_conflict_state == NO_CONFLICT)
+    thd->wsrep_conflict_state= MUST_ABORT;
+  mysql_mutex_unlock(&thd->LOCK_wsrep_thd);
+
+  my_atomic_add64(&wsrep_early_conflicts_counter, 1);
+  WSREP_DEBUG("Early conflict with a write-set being applied, thd: %u "
+              "SQL: %s", thd->thread_id(), WSREP_QUERY(thd));
+  return true;
+}
+
+int wsrep_show_early_conflicts(THD* thd, SHOW_VAR* var, char* buff)
+{
+  wsrep_early_conflicts= my_atomic_load64(&wsrep_early_conflicts_counter);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_early_conflicts;
+  return 0;
+}
@@ -0,0 +1,69 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_CONFLICT_H
+#define WSREP_CONFLICT_H
+
+/*
+  Early detection of conflicts with replicated write-sets.
+
+  With wsrep_early_conflict_check, an applier publishes the certification
+  keys of the rows of each row event before it applies the rows, computed
+  the same way as for a local transaction changing them, and withdraws
+  them when it commits the write-set.
+
+  A local transaction appends a key after it has changed the row, so it
+  holds the row lock. If the key is published, the applier has not got to
+  the row yet and is going to BF abort the transaction when it does. The
+  transaction is aborted right away instead, as if it was BF aborted, so
+  that an autocommit statement is retried per wsrep_retry_autocommit
+  without doing the rest of its work first. A retried statement is not
+  checked again, it takes its chances with the applier.
+
+  Keys are published in WSREP_CONFLICT_PARTITIONS hash tables of 64-bit
+  key hashes, at most WSREP_CONFLICT_MAX_KEYS per write-set.
+*/
+
+#include "my_global.h"
+#include "wsrep_api.h"
+
+class THD;
+typedef struct st_mysql_show_var SHOW_VAR;
+
+#define WSREP_CONFLICT_PARTITIONS 64
+#define WSREP_CONFLICT_MAX_KEYS   65536
+
+void wsrep_conflict_init();
+void wsrep_conflict_deinit();
+
+/* Publish key of a row the applier thd is going to change */
+void wsrep_conflict_publish(THD* thd, const wsrep_key_t* key);
+
+/* Withdraw the keys published by the applier thd */
+void wsrep_conflict_withdraw(THD* thd);
+
+/* Withdraw the keys and free the published key list of thd */
+void wsrep_conflict_free(THD* thd);
+
+/*
+  Check key appended by local transaction of thd against the published
+  keys. On conflict the transaction is marked for abort.
+  @return true if the transaction must abort
+*/
+bool wsrep_conflict_check(THD* thd, const wsrep_key_t* key);
+
+int  wsrep_show_early_conflicts(THD* thd, SHOW_VAR* var, char* buff);
+
+#endif /* WSREP_CONFLICT_H */
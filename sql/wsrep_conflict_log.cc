@@ -0,0 +1,160 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_conflict_log.h"
+#include "wsrep_mysqld.h"
+#include "mysqld.h"
+#include "my_atomic.h"
+
+struct conflict_log_rec
+{
+  conflict_log_rec* next;
+  size_t            len;
+  /* text follows */
+};
+
+/* queue of reports to write, protected by LOCK_wsrep_conflict_log */
+static mysql_mutex_t      LOCK_wsrep_conflict_log;
+static mysql_cond_t       COND_wsrep_conflict_log;
+static conflict_log_rec*  log_head    = NULL;
+static conflict_log_rec** log_tail    = &log_head;
+static size_t             log_queued  = 0;     /* text bytes */
+static bool               log_running = false; /* writer thread started */
+static bool               log_stop    = false;
+static my_thread_handle   log_thread;
+
+static long long wsrep_conflict_log_dropped_counter= 0;
+
+/* value exported to SHOW STATUS */
+static long long wsrep_conflict_log_dropped= 0;
+
+static void* wsrep_conflict_log_writer(void*)
+{
+  my_thread_init();
+
+  mysql_mutex_lock(&LOCK_wsrep_conflict_log);
+  for (;;)
+  {
+    while (!log_head && !log_stop)
+      mysql_cond_wait(&COND_wsrep_conflict_log, &LOCK_wsrep_conflict_log);
+
+    conflict_log_rec* const rec= log_head;
+    if (!rec) break;
+
+    log_head= rec->next;
+    if (!log_head) log_tail= &log_head;
+    mysql_mutex_unlock(&LOCK_wsrep_conflict_log);
+
+    fwrite(rec + 1, 1, rec->len, stderr);
+    fflush(stderr);
+
+    mysql_mutex_lock(&LOCK_wsrep_conflict_log);
+    log_queued-= rec->len;
+    my_free(rec);
+  }
+  mysql_mutex_unlock(&LOCK_wsrep_conflict_log);
+
+  my_thread_end();
+  my_thread_exit(0);
+  return NULL;
+}
+
+void wsrep_conflict_log_init()
+{
+  mysql_mutex_init(key_LOCK_wsrep_conflict_log, &LOCK_wsrep_conflict_log,
+                   MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_wsrep_conflict_log, &COND_wsrep_conflict_log);
+
+  /* not on demand: reports are queued under engine mutexes */
+  log_stop= false;
+
+  my_thread_attr_t attr;
+  my_thread_attr_init(&attr);
+  my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+  int const err= mysql_thread_create(key_THREAD_wsrep_conflict_log,
+                                     &log_thread, &attr,
+                                     wsrep_conflict_log_writer, NULL);
+  my_thread_attr_destroy(&attr);
+
+  if (err)
+    WSREP_WARN("Could not start conflict log thread: %d, conflicts are "
+               "written to the error log directly", err);
+  else
+    log_running= true;
+}
+
+void wsrep_conflict_log_deinit()
+{
+  mysql_mutex_lock(&LOCK_wsrep_conflict_log);
+  log_stop= true;
+  mysql_cond_signal(&COND_wsrep_conflict_log);
+  mysql_mutex_unlock(&LOCK_wsrep_conflict_log);
+
+  /* writer exits once the queue is empty */
+  if (log_running) my_thread_join(&log_thread, NULL);
+  log_running= false;
+
+  mysql_mutex_destroy(&LOCK_wsrep_conflict_log);
+  mysql_cond_destroy(&COND_wsrep_conflict_log);
+}
+
+void wsrep_conflict_log(const char* const text, size_t const len)
+{
+  if (len == 0) return;
+
+  conflict_log_rec* const rec= static_cast<conflict_log_rec*>(
+    my_malloc(key_memory_wsrep, sizeof(conflict_log_rec) + len, MYF(0)));
+  if (!rec)
+  {
+    my_atomic_add64(&wsrep_conflict_log_dropped_counter, 1);
+    return;
+  }
+
+  rec->next= NULL;
+  rec->len=  len;
+  memcpy(rec + 1, text, len);
+
+  mysql_mutex_lock(&LOCK_wsrep_conflict_log);
+  if (log_queued > 0 && log_queued + len > WSREP_CONFLICT_LOG_QUEUE_MAX)
+  {
+    mysql_mutex_unlock(&LOCK_wsrep_conflict_log);
+    my_free(rec);
+    my_atomic_add64(&wsrep_conflict_log_dropped_counter, 1);
+    return;
+  }
+
+  if (!log_running)
+  {
+    mysql_mutex_unlock(&LOCK_wsrep_conflict_log);
+    fwrite(text, 1, len, stderr);
+    my_free(rec);
+    return;
+  }
+
+  log_queued+= len;
+  *log_tail= rec;
+  log_tail= &rec->next;
+  mysql_cond_signal(&COND_wsrep_conflict_log);
+  mysql_mutex_unlock(&LOCK_wsrep_conflict_log);
+}
+
+int wsrep_show_conflict_log_dropped(THD* thd, SHOW_VAR* var, char* buff)
+{
+  wsrep_conflict_log_dropped=
+    my_atomic_load64(&wsrep_conflict_log_dropped_counter);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_conflict_log_dropped;
+  return 0;
+}
@@ -0,0 +1,50 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_CONFLICT_LOG_H
+#define WSREP_CONFLICT_LOG_H
+
+/*
+  Conflict reports of wsrep_log_conflicts.
+
+  The storage engine prints the locks of a BF conflict while it holds its
+  lock system mutex. The report is printed to memory and queued here, and
+  a background thread writes it to the error log, so that appliers and
+  local transactions waiting for the mutex do not wait for the error log.
+  Reports which arrive while WSREP_CONFLICT_LOG_QUEUE_MAX bytes are already
+  waiting to be written are dropped and counted in
+  wsrep_conflict_log_dropped status variable.
+*/
+
+#include "my_global.h"
+
+class THD;
+typedef struct st_mysql_show_var SHOW_VAR;
+
+/* bytes of reports waiting to be written at most, unless none are */
+#define WSREP_CONFLICT_LOG_QUEUE_MAX (4 << 20)
+
+/* Start the writer */
+void wsrep_conflict_log_init();
+
+/* Write queued reports and stop the writer */
+void wsrep_conflict_log_deinit();
+
+/* Queue text for writing to the error log */
+void wsrep_conflict_log(const char* text, size_t len);
+
+int  wsrep_show_conflict_log_dropped(THD* thd, SHOW_VAR* var, char* buff);
+
+#endif /* WSREP_CONFLICT_LOG_H */
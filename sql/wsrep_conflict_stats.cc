@@ -0,0 +1,198 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_conflict_stats.h"
+#include "wsrep_priv.h"
+#include "m_string.h"
+
+#include <map>
+#include <string>
+
+struct conflict_object
+{
+  wsrep_conflict_object_row row;
+};
+
+struct conflict_key
+{
+  size_t    object;     /* index in stats_objects */
+  ulonglong key_hash;
+  ulonglong conflicts;
+  ulonglong error;      /* conflicts of the key it replaced */
+};
+
+/* "db\0table\0index" -> index in stats_objects */
+typedef std::map<std::string, size_t> conflict_object_map_t;
+
+/* all protected by LOCK_wsrep_conflict_stats */
+static mysql_mutex_t         LOCK_wsrep_conflict_stats;
+static conflict_object       stats_objects[WSREP_CONFLICT_STATS_OBJECTS];
+static size_t                stats_n_objects= 0;
+static conflict_object_map_t stats_object_map;
+static conflict_key          stats_keys[WSREP_CONFLICT_STATS_KEYS];
+static size_t                stats_n_keys= 0;
+
+void wsrep_conflict_stats_init()
+{
+  mysql_mutex_init(key_LOCK_wsrep_conflict_stats, &LOCK_wsrep_conflict_stats,
+                   MY_MUTEX_INIT_FAST);
+}
+
+void wsrep_conflict_stats_deinit()
+{
+  stats_object_map.clear();
+  mysql_mutex_destroy(&LOCK_wsrep_conflict_stats);
+}
+
+/* @return index of the object in stats_objects, or
+   WSREP_CONFLICT_STATS_OBJECTS if it is not there and there is no room */
+static size_t stats_find_object(const char* db, const char* table,
+                                const char* index)
+{
+  std::string name(db);
+  name.push_back('\0');
+  name.append(table);
+  name.push_back('\0');
+  name.append(index);
+
+  conflict_object_map_t::const_iterator const it=
+    stats_object_map.find(name);
+  if (it != stats_object_map.end()) return it->second;
+
+  if (stats_n_objects == WSREP_CONFLICT_STATS_OBJECTS)
+    return WSREP_CONFLICT_STATS_OBJECTS;
+
+  size_t const pos= stats_n_objects++;
+  wsrep_conflict_object_row& row= stats_objects[pos].row;
+  memset(&row, 0, sizeof(row));
+  strmake(row.db, db, sizeof(row.db) - 1);
+  strmake(row.table, table, sizeof(row.table) - 1);
+  strmake(row.index, index, sizeof(row.index) - 1);
+  stats_object_map.insert(std::make_pair(name, pos));
+  return pos;
+}
+
+/* Space saving: count the key, or replace the key with fewest conflicts */
+static void stats_add_key(size_t const object, ulonglong const key_hash)
+{
+  size_t min= 0;
+
+  for (size_t i= 0; i < stats_n_keys; ++i)
+  {
+    conflict_key& k= stats_keys[i];
+    if (k.key_hash == key_hash && k.object == object)
+    {
+      ++k.conflicts;
+      return;
+    }
+    if (k.conflicts < stats_keys[min].conflicts) min= i;
+  }
+
+  if (stats_n_keys < WSREP_CONFLICT_STATS_KEYS)
+  {
+    conflict_key& k= stats_keys[stats_n_keys++];
+    k.object= object;
+    k.key_hash= key_hash;
+    k.conflicts= 1;
+    k.error= 0;
+    return;
+  }
+
+  conflict_key& k= stats_keys[min];
+  k.object= object;
+  k.key_hash= key_hash;
+  k.error= k.conflicts;
+  ++k.conflicts;
+}
+
+void wsrep_conflict_stats_add(const char* const db, const char* const table,
+                              const char* const index,
+                              wsrep_conflict_kind const kind,
+                              ulonglong const key_hash,
+                              ulonglong const rows, ulonglong const time)
+{
+  mysql_mutex_lock(&LOCK_wsrep_conflict_stats);
+
+  size_t const object= stats_find_object(db, table, index ? index : "");
+  if (object < WSREP_CONFLICT_STATS_OBJECTS)
+  {
+    wsrep_conflict_object_row& row= stats_objects[object].row;
+    if (kind == WSREP_CONFLICT_BF_ABORT)
+      ++row.bf_aborts;
+    else
+      ++row.cert_failures;
+    row.rows_wasted+= rows;
+    row.time_wasted+= time;
+
+    if (key_hash) stats_add_key(object, key_hash);
+  }
+
+  mysql_mutex_unlock(&LOCK_wsrep_conflict_stats);
+}
+
+bool wsrep_conflict_stats_object(size_t const pos,
+                                 wsrep_conflict_object_row* const row)
+{
+  mysql_mutex_lock(&LOCK_wsrep_conflict_stats);
+  bool const exists= pos < stats_n_objects;
+  if (exists) *row= stats_objects[pos].row;
+  mysql_mutex_unlock(&LOCK_wsrep_conflict_stats);
+  return exists;
+}
+
+bool wsrep_conflict_stats_key(size_t const pos,
+                              wsrep_conflict_key_row* const row)
+{
+  mysql_mutex_lock(&LOCK_wsrep_conflict_stats);
+  bool const exists= pos < stats_n_keys;
+  if (exists)
+  {
+    const conflict_key& k= stats_keys[pos];
+    const wsrep_conflict_object_row& object= stats_objects[k.object].row;
+    memcpy(row->db, object.db, sizeof(row->db));
+    memcpy(row->table, object.table, sizeof(row->table));
+    memcpy(row->index, object.index, sizeof(row->index));
+    row->key_hash= k.key_hash;
+    row->conflicts= k.conflicts;
+    row->error= k.error;
+  }
+  mysql_mutex_unlock(&LOCK_wsrep_conflict_stats);
+  return exists;
+}
+
+size_t wsrep_conflict_stats_object_count()
+{
+  mysql_mutex_lock(&LOCK_wsrep_conflict_stats);
+  size_t const n= stats_n_objects;
+  mysql_mutex_unlock(&LOCK_wsrep_conflict_stats);
+  return n;
+}
+
+size_t wsrep_conflict_stats_key_count()
+{
+  mysql_mutex_lock(&LOCK_wsrep_conflict_stats);
+  size_t const n= stats_n_keys;
+  mysql_mutex_unlock(&LOCK_wsrep_conflict_stats);
+  return n;
+}
+
+void wsrep_conflict_stats_reset()
+{
+  mysql_mutex_lock(&LOCK_wsrep_conflict_stats);
+  stats_object_map.clear();
+  stats_n_objects= 0;
+  stats_n_keys= 0;
+  mysql_mutex_unlock(&LOCK_wsrep_conflict_stats);
+}
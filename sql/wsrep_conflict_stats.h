@@ -0,0 +1,107 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_CONFLICT_STATS_H
+#define WSREP_CONFLICT_STATS_H
+
+/*
+  Statistics of the conflicts local transactions lose, shown in
+  performance_schema.pxc_conflicts_by_index and pxc_conflict_hot_keys.
+
+  The storage engine accounts every conflict to an index of a table when
+the victim rolls back:
+
+  - a BF abort to the index of the lock the applier or replaying
+    transaction waits for, with a hash of the key of the locked record,
+  - a certification failure to every table the transaction changed, with
+    no index and key, as the provider does not tell which key failed.
+
+  With it go the rows the victim changed and the time since it started,
+  which are lost with its rollback.
+
+  Statistics are kept for the first WSREP_CONFLICT_STATS_OBJECTS indexes,
+  conflicts of any others are dropped. Hot keys are the
+  WSREP_CONFLICT_STATS_KEYS keys with the most BF aborts, found with the
+  space saving algorithm: a key which is not in the list when it is full
+  replaces the one with the fewest conflicts and counts on from there, so
+  CONFLICTS may overestimate by up to CONFLICTS_ERROR.
+
+  TRUNCATE TABLE of either table resets both.
+*/
+
+#include "my_global.h"
+#include "mysql_com.h"
+
+class THD;
+
+#define WSREP_CONFLICT_STATS_OBJECTS 1024
+#define WSREP_CONFLICT_STATS_KEYS    64
+
+enum wsrep_conflict_kind
+{
+  WSREP_CONFLICT_CERT_FAILURE,
+  WSREP_CONFLICT_BF_ABORT
+};
+
+struct wsrep_conflict_object_row
+{
+  char      db[NAME_LEN + 1];
+  char      table[NAME_LEN + 1];
+  char      index[NAME_LEN + 1];  /* empty for the table */
+  ulonglong cert_failures;
+  ulonglong bf_aborts;
+  ulonglong rows_wasted;
+  ulonglong time_wasted;          /* microseconds */
+};
+
+struct wsrep_conflict_key_row
+{
+  char      db[NAME_LEN + 1];
+  char      table[NAME_LEN + 1];
+  char      index[NAME_LEN + 1];
+  ulonglong key_hash;
+  ulonglong conflicts;
+  ulonglong error;
+};
+
+void wsrep_conflict_stats_init();
+void wsrep_conflict_stats_deinit();
+
+/*
+  Account a conflict lost by a local transaction.
+  @param index     index name, NULL if not known
+  @param key_hash  hash of the conflicting key, 0 if not known
+  @param rows      rows the transaction changed
+  @param time      microseconds since the transaction started
+*/
+void wsrep_conflict_stats_add(const char* db, const char* table,
+                              const char* index, wsrep_conflict_kind kind,
+                              ulonglong key_hash, ulonglong rows,
+                              ulonglong time);
+
+/*
+  Copy row pos of the statistics. Rows are only added, until the
+  statistics are reset.
+  @return false if there is no such row
+*/
+bool wsrep_conflict_stats_object(size_t pos, wsrep_conflict_object_row* row);
+bool wsrep_conflict_stats_key(size_t pos, wsrep_conflict_key_row* row);
+
+size_t wsrep_conflict_stats_object_count();
+size_t wsrep_conflict_stats_key_count();
+
+void wsrep_conflict_stats_reset();
+
+#endif /* WSREP_CONFLICT_STATS_H */
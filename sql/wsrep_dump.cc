@@ -0,0 +1,403 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_dump.h"
+#include "wsrep_mysqld.h"
+#include "sql_class.h"
+#include "log_event.h"
+#include "my_atomic.h"
+
+#include <time.h>
+
+struct wsrep_dump_rec
+{
+  wsrep_dump_rec* next;
+  uchar*          data;
+  size_t          len;
+  wsrep_seqno_t   seqno;
+  wsrep_uuid_t    uuid;
+  uint32          error;
+  uint32          thread_id;
+  ulonglong       when;
+};
+
+/* queue of records to write, protected by LOCK_wsrep_dump */
+static wsrep_dump_rec*  dump_head    = NULL;
+static wsrep_dump_rec** dump_tail    = &dump_head;
+static size_t           dump_queued  = 0;     /* payload bytes */
+static bool             dump_running = false; /* writer thread started */
+static bool             dump_stop    = false;
+static my_thread_handle dump_thread;
+
+/* files, accessed only by the writer thread */
+static File             dump_log     = -1;
+static File             dump_index   = -1;
+static my_off_t         dump_log_end = 0;
+static my_off_t         dump_index_end = 0;
+
+static long long wsrep_dump_dropped_counter = 0;
+static int32     wsrep_dump_drop_reported   = 0;
+
+/* value exported to SHOW STATUS */
+static long long wsrep_dump_dropped = 0;
+
+static void wsrep_dump_drop(size_t const len, const char* const reason)
+{
+  my_atomic_add64(&wsrep_dump_dropped_counter, 1);
+
+  /* report once, dropped write-sets are counted in status */
+  int32 reported= 0;
+  if (my_atomic_cas32(&wsrep_dump_drop_reported, &reported, 1))
+  {
+    WSREP_WARN("Write-set of %zu bytes was not dumped: %s. "
+               "Further dropped write-sets are counted in "
+               "wsrep_dump_dropped.", len, reason);
+  }
+}
+
+static void wsrep_dump_close_files()
+{
+  if (dump_log >= 0)   my_close(dump_log, MYF(0));
+  if (dump_index >= 0) my_close(dump_index, MYF(0));
+  dump_log=   -1;
+  dump_index= -1;
+}
+
+/* File header and format description event for the payload events */
+static bool wsrep_dump_write_header()
+{
+  uchar header[WSREP_DUMP_FILE_HEADER_LEN];
+  memcpy(header, WSREP_DUMP_MAGIC, WSREP_DUMP_MAGIC_LEN);
+  int4store(header + 8, WSREP_DUMP_VERSION);
+  int4store(header + 12, 0);
+
+  IO_CACHE cache;
+  if (init_io_cache(&cache, dump_log, IO_SIZE, WRITE_CACHE, 0, 0,
+                    MYF(MY_WME)))
+    return true;
+
+  Format_description_log_event fde(BINLOG_VERSION);
+  fde.common_footer->checksum_alg=
+    static_cast<enum_binlog_checksum_alg>(binlog_checksum_options);
+
+  bool const err= (my_b_write(&cache, header, sizeof(header)) ||
+                   fde.write(&cache));
+  dump_log_end= my_b_tell(&cache);
+
+  return (end_io_cache(&cache) || err);
+}
+
+static void wsrep_dump_file_name(char* const buf, size_t const buf_len,
+                                 const char* const name,
+                                 const char* const suffix)
+{
+  snprintf(buf, buf_len, "%s/%s%s", wsrep_data_home_dir, name, suffix);
+}
+
+static bool wsrep_dump_open_files()
+{
+  char log_name[FN_REFLEN + 64];
+  char index_name[FN_REFLEN + 64];
+  wsrep_dump_file_name(log_name, sizeof(log_name), WSREP_DUMP_LOG_NAME, "");
+  wsrep_dump_file_name(index_name, sizeof(index_name),
+                       WSREP_DUMP_INDEX_NAME, "");
+
+  dump_log= my_open(log_name, O_CREAT | O_WRONLY | O_APPEND | O_BINARY,
+                    MYF(MY_WME));
+  if (dump_log < 0) return true;
+
+  dump_log_end= my_seek(dump_log, 0, MY_SEEK_END, MYF(0));
+  if (dump_log_end == MY_FILEPOS_ERROR ||
+      (dump_log_end == 0 && wsrep_dump_write_header()))
+  {
+    WSREP_ERROR("Failed to initialize write-set dump log '%s'", log_name);
+    wsrep_dump_close_files();
+    return true;
+  }
+
+  dump_index= my_open(index_name, O_CREAT | O_WRONLY | O_APPEND | O_BINARY,
+                      MYF(MY_WME));
+  if (dump_index < 0 ||
+      (dump_index_end= my_seek(dump_index, 0, MY_SEEK_END, MYF(0))) ==
+      MY_FILEPOS_ERROR)
+  {
+    wsrep_dump_close_files();
+    return true;
+  }
+
+  return false;
+}
+
+/* Keep the full log as the old one and start a new log */
+static bool wsrep_dump_rotate()
+{
+  wsrep_dump_close_files();
+
+  const char* const names[]= { WSREP_DUMP_LOG_NAME, WSREP_DUMP_INDEX_NAME };
+  for (size_t i= 0; i < array_elements(names); ++i)
+  {
+    char name[FN_REFLEN + 64];
+    char old_name[FN_REFLEN + 64];
+    wsrep_dump_file_name(name, sizeof(name), names[i], "");
+    wsrep_dump_file_name(old_name, sizeof(old_name), names[i],
+                         WSREP_DUMP_OLD_SUFFIX);
+
+    (void) my_delete(old_name, MYF(0));
+    if (my_rename(name, old_name, MYF(MY_WME))) return true;
+  }
+
+  WSREP_INFO("Write-set dump log reached wsrep_dump_log_size, "
+             "previous records were moved to %s%s",
+             WSREP_DUMP_LOG_NAME, WSREP_DUMP_OLD_SUFFIX);
+
+  return wsrep_dump_open_files();
+}
+
+/* Cut off a partially written record, so that the log stays readable */
+static void wsrep_dump_truncate()
+{
+  if (my_chsize(dump_log, dump_log_end, 0, MYF(MY_WME)) ||
+      my_chsize(dump_index, dump_index_end, 0, MYF(MY_WME)))
+  {
+    /* start over at the actual end of file */
+    wsrep_dump_close_files();
+  }
+}
+
+static bool wsrep_dump_fits(size_t const len)
+{
+  return (dump_log_end + WSREP_DUMP_RECORD_HEADER_LEN + len <=
+          wsrep_dump_log_size);
+}
+
+static void wsrep_dump_write(const wsrep_dump_rec* const rec)
+{
+  if (dump_log < 0 && wsrep_dump_open_files())
+  {
+    wsrep_dump_drop(rec->len, "dump log could not be opened");
+    return;
+  }
+
+  /* a new log would not hold the write-set either if this one has no
+     records yet */
+  if (!wsrep_dump_fits(rec->len) && dump_index_end > 0 &&
+      wsrep_dump_rotate())
+  {
+    wsrep_dump_drop(rec->len, "dump log could not be rotated");
+    return;
+  }
+
+  if (!wsrep_dump_fits(rec->len))
+  {
+    wsrep_dump_drop(rec->len, "larger than wsrep_dump_log_size");
+    return;
+  }
+
+  uchar header[WSREP_DUMP_RECORD_HEADER_LEN];
+  int4store(header,      WSREP_DUMP_RECORD_MAGIC);
+  int4store(header + 4,  rec->error);
+  int8store(header + 8,  rec->seqno);
+  memcpy   (header + 16, rec->uuid.data, sizeof(rec->uuid.data));
+  int4store(header + 32, rec->thread_id);
+  int4store(header + 36, 0);
+  int8store(header + 40, rec->when);
+  int8store(header + 48, rec->len);
+
+  uchar entry[WSREP_DUMP_INDEX_ENTRY_LEN];
+  int8store(entry,       rec->seqno);
+  memcpy   (entry + 8,   rec->uuid.data, sizeof(rec->uuid.data));
+  int4store(entry + 24,  rec->error);
+  int4store(entry + 28,  0);
+  int8store(entry + 32,  dump_log_end);
+
+  if (my_write(dump_log, header, sizeof(header), MYF(MY_WME | MY_NABP)) ||
+      my_write(dump_log, rec->data, rec->len, MYF(MY_WME | MY_NABP)) ||
+      my_write(dump_index, entry, sizeof(entry), MYF(MY_WME | MY_NABP)))
+  {
+    wsrep_dump_drop(rec->len, "write to dump log failed");
+    wsrep_dump_truncate();
+    return;
+  }
+
+  WSREP_DEBUG("Dumped write-set %lld, %zu bytes at offset %llu",
+              (long long)rec->seqno, rec->len, (ulonglong)dump_log_end);
+  dump_log_end+= sizeof(header) + rec->len;
+  dump_index_end+= sizeof(entry);
+}
+
+static void* wsrep_dump_writer(void*)
+{
+  my_thread_init();
+
+  mysql_mutex_lock(&LOCK_wsrep_dump);
+  for (;;)
+  {
+    while (!dump_head && !dump_stop)
+      mysql_cond_wait(&COND_wsrep_dump, &LOCK_wsrep_dump);
+
+    wsrep_dump_rec* const rec= dump_head;
+    if (!rec) break;
+
+    dump_head= rec->next;
+    if (!dump_head) dump_tail= &dump_head;
+    mysql_mutex_unlock(&LOCK_wsrep_dump);
+
+    wsrep_dump_write(rec);
+    my_free(rec->data);
+
+    mysql_mutex_lock(&LOCK_wsrep_dump);
+    dump_queued-= rec->len;
+    my_free(rec);
+  }
+  mysql_mutex_unlock(&LOCK_wsrep_dump);
+
+  wsrep_dump_close_files();
+
+  my_thread_end();
+  my_thread_exit(0);
+  return NULL;
+}
+
+uchar* wsrep_dump_reserve(size_t const len)
+{
+  if (wsrep_dump_log_size == 0) return NULL;
+
+  /* would not fit in an empty log either */
+  if (WSREP_DUMP_FILE_HEADER_LEN + WSREP_DUMP_RECORD_HEADER_LEN + len >
+      wsrep_dump_log_size)
+  {
+    wsrep_dump_drop(len, "larger than wsrep_dump_log_size");
+    return NULL;
+  }
+
+  /* a storm of failures must not pay for copies which are going to be
+     dropped */
+  mysql_mutex_lock(&LOCK_wsrep_dump);
+  bool const full= (dump_queued > 0 &&
+                    dump_queued + len > WSREP_DUMP_QUEUE_MAX);
+  if (!full) dump_queued+= len;
+  mysql_mutex_unlock(&LOCK_wsrep_dump);
+
+  if (full)
+  {
+    wsrep_dump_drop(len, "dump queue is full");
+    return NULL;
+  }
+
+  uchar* const buf= static_cast<uchar*>(my_malloc(key_memory_wsrep, len,
+                                                  MYF(0)));
+  if (!buf)
+  {
+    mysql_mutex_lock(&LOCK_wsrep_dump);
+    dump_queued-= len;
+    mysql_mutex_unlock(&LOCK_wsrep_dump);
+    wsrep_dump_drop(len, "out of memory");
+  }
+  return buf;
+}
+
+void wsrep_dump_cancel(uchar* const buf, size_t const len)
+{
+  mysql_mutex_lock(&LOCK_wsrep_dump);
+  dump_queued-= len;
+  mysql_mutex_unlock(&LOCK_wsrep_dump);
+  my_free(buf);
+}
+
+void wsrep_dump_queue(THD* const thd, uchar* const buf, size_t const len)
+{
+  wsrep_dump_rec* const rec= static_cast<wsrep_dump_rec*>(
+    my_malloc(key_memory_wsrep, sizeof(wsrep_dump_rec), MYF(0)));
+  if (!rec)
+  {
+    wsrep_dump_cancel(buf, len);
+    wsrep_dump_drop(len, "out of memory");
+    return;
+  }
+
+  rec->next=      NULL;
+  rec->data=      buf;
+  rec->len=       len;
+  rec->seqno=     wsrep_thd_trx_seqno(thd);
+  rec->uuid=      thd->wsrep_trx_meta.gtid.uuid;
+  rec->error=     thd->get_stmt_da()->is_error() ?
+                  thd->get_stmt_da()->mysql_errno() : 0;
+  rec->thread_id= thd->thread_id();
+  rec->when=      time(NULL);
+
+  mysql_mutex_lock(&LOCK_wsrep_dump);
+  if (!dump_running)
+  {
+    my_thread_attr_t attr;
+    my_thread_attr_init(&attr);
+    my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+    int const err= mysql_thread_create(key_THREAD_wsrep_dump_writer,
+                                       &dump_thread, &attr,
+                                       wsrep_dump_writer, NULL);
+    my_thread_attr_destroy(&attr);
+
+    if (err)
+    {
+      dump_queued-= len;
+      mysql_mutex_unlock(&LOCK_wsrep_dump);
+      WSREP_ERROR("Could not start write-set dump thread: %d", err);
+      my_free(buf);
+      my_free(rec);
+      wsrep_dump_drop(len, "dump thread could not be started");
+      return;
+    }
+    dump_running= true;
+  }
+
+  *dump_tail= rec;
+  dump_tail= &rec->next;
+  mysql_cond_signal(&COND_wsrep_dump);
+  mysql_mutex_unlock(&LOCK_wsrep_dump);
+}
+
+void wsrep_dump_writeset(THD* const thd, const void* const buf,
+                         size_t const len)
+{
+  uchar* const data= wsrep_dump_reserve(len);
+  if (!data) return;
+
+  memcpy(data, buf, len);
+  wsrep_dump_queue(thd, data, len);
+}
+
+void wsrep_dump_log_close()
+{
+  mysql_mutex_lock(&LOCK_wsrep_dump);
+  bool const running= dump_running;
+  dump_stop= true;
+  mysql_cond_signal(&COND_wsrep_dump);
+  mysql_mutex_unlock(&LOCK_wsrep_dump);
+
+  /* writer exits once the queue is empty */
+  if (running) my_thread_join(&dump_thread, NULL);
+
+  mysql_mutex_lock(&LOCK_wsrep_dump);
+  dump_running= false;
+  dump_stop= false;
+  mysql_mutex_unlock(&LOCK_wsrep_dump);
+}
+
+int wsrep_show_dump_dropped(THD* thd, SHOW_VAR* var, char* buff)
+{
+  wsrep_dump_dropped= my_atomic_load64(&wsrep_dump_dropped_counter);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_dump_dropped;
+  return 0;
+}
@@ -0,0 +1,107 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_DUMP_H
+#define WSREP_DUMP_H
+
+/*
+  Write-set dump log.
+
+  Write-sets which failed to apply or to replicate are appended to a log
+  in wsrep_data_home_dir by a background thread, so that the thread which
+  hit the failure only pays for a memory copy. When a write-set does not
+  fit in wsrep_dump_log_size bytes, the log and its index are renamed with
+  WSREP_DUMP_OLD_SUFFIX, replacing the previous ones, and a new log is
+  started, so the most recent write-sets are kept. Write-sets larger than
+  the whole log or which arrive while WSREP_DUMP_QUEUE_MAX bytes are
+  already waiting to be written are dropped and counted in
+  wsrep_dump_dropped status variable.
+
+  All integers are stored little-endian.
+
+  Log file (WSREP_DUMP_LOG_NAME):
+    file header, WSREP_DUMP_FILE_HEADER_LEN bytes
+      0   8  WSREP_DUMP_MAGIC
+      8   4  format version, WSREP_DUMP_VERSION
+      12  4  reserved
+    format description event of the server which wrote the log, as it is
+    written in a binary log (its length is in its event header)
+    records, each of WSREP_DUMP_RECORD_HEADER_LEN bytes header and payload:
+      0   4  WSREP_DUMP_RECORD_MAGIC
+      4   4  error code, 0 if unknown
+      8   8  seqno, -1 if the write-set was not ordered
+      16  16 cluster state UUID
+      32  4  id of the thread which dumped the write-set
+      36  4  reserved
+      40  8  time of the dump, seconds since epoch
+      48  8  payload length
+      56     payload: binary log events of the write-set
+
+  Index file (WSREP_DUMP_INDEX_NAME), one WSREP_DUMP_INDEX_ENTRY_LEN bytes
+  entry per record:
+      0   8  seqno
+      8   16 cluster state UUID
+      24  4  error code
+      28  4  reserved
+      32  8  offset of the record in log file
+
+  extra/wsrep_dump_reader lists the records and extracts a record as
+  a binary log file that mysqlbinlog can read.
+*/
+
+#define WSREP_DUMP_LOG_NAME   "wsrep_dump.log"
+#define WSREP_DUMP_INDEX_NAME "wsrep_dump.index"
+#define WSREP_DUMP_OLD_SUFFIX ".old"
+
+#define WSREP_DUMP_MAGIC            "WSREPDMP"
+#define WSREP_DUMP_MAGIC_LEN        8
+#define WSREP_DUMP_VERSION          1
+#define WSREP_DUMP_FILE_HEADER_LEN  16
+#define WSREP_DUMP_RECORD_MAGIC     0x44525357 /* "WSRD" */
+#define WSREP_DUMP_RECORD_HEADER_LEN 56
+#define WSREP_DUMP_INDEX_ENTRY_LEN  40
+
+#ifdef MYSQL_SERVER
+
+#include "my_global.h"
+
+class THD;
+typedef struct st_mysql_show_var SHOW_VAR;
+
+/* bytes of write-sets waiting to be written at most, unless none are */
+#define WSREP_DUMP_QUEUE_MAX (64 << 20)
+
+/* Queue a copy of write-set for writing to the dump log */
+void wsrep_dump_writeset(THD* thd, const void* buf, size_t len);
+
+/*
+  Reserve room for a write-set of len bytes in the dump queue, so that it
+  can be read in place. The limits are checked before anything is read.
+
+  @return buffer of len bytes to pass to wsrep_dump_queue() once filled
+          or to wsrep_dump_cancel(), NULL if the write-set is dropped
+*/
+uchar* wsrep_dump_reserve(size_t len);
+void   wsrep_dump_queue(THD* thd, uchar* buf, size_t len);
+void   wsrep_dump_cancel(uchar* buf, size_t len);
+
+/* Write queued write-sets and stop the dump log writer */
+void wsrep_dump_log_close();
+
+int  wsrep_show_dump_dropped(THD* thd, SHOW_VAR* var, char* buff);
+
+#endif /* MYSQL_SERVER */
+
+#endif /* WSREP_DUMP_H */
@@ -20,6 +20,8 @@
 #include <sql_class.h>
 #include "wsrep_mysqld.h"
 #include "wsrep_binlog.h"
+#include "wsrep_key_batch.h"
+#include "wsrep_pool.h"
 #include "wsrep_xid.h"
 #include <cstdio>
 #include <cstdlib>
@@ -55,6 +57,8 @@ void wsrep_cleanup_transaction(THD *thd)
   thd->wsrep_void_applier_trx= true;
   thd->wsrep_skip_wsrep_GTID= false;
   thd->wsrep_skip_SE_checkpoint= false;
+  wsrep_release_ws_maps(thd);
+  wsrep_thd_discard_keys(thd);
   return;
 }
 
@@ -257,7 +261,7 @@ void wsrep_post_commit(THD* thd, bool all)
          thd->wsrep_ws_handle.opaque &&
          thd->wsrep_conflict_state != REPLAYING &&
          thd->wsrep_applier)
-       wsrep->applier_pre_commit(wsrep, thd->wsrep_ws_handle.opaque);
+       wsrep_pool_enter_commit_order(thd);
 
      if (thd->wsrep_ws_handle.opaque &&
          thd->wsrep_conflict_state != REPLAYING)
@@ -570,6 +574,12 @@ wsrep_run_wsrep_commit(THD *thd, handlerton *hton, bool all)
   thd->wsrep_query_state = QUERY_COMMITTING;
   mysql_mutex_unlock(&thd->LOCK_wsrep_thd);
 
+  if (WSREP_OK != wsrep_thd_flush_keys(thd))
+  {
+    thd->wsrep_query_state= QUERY_EXEC;
+    DBUG_RETURN(WSREP_TRX_ERROR);
+  }
+
   rcode = 0;
   if ((thd->lex->sql_command == SQLCOM_CREATE_TABLE) &&
       !thd->wsrep_applier                            &&
@@ -655,6 +665,8 @@ wsrep_run_wsrep_commit(THD *thd, handlerton *hton, bool all)
                                  0ULL : WSREP_FLAG_PA_UNSAFE),
                                 &thd->wsrep_trx_meta);
 
+      /* write-set is in provider's hands now */
+      wsrep_release_ws_maps(thd);
     }
 
     if (rcode == WSREP_TRX_MISSING) {
@@ -899,6 +911,12 @@ enum wsrep_trx_status wsrep_replicate(THD *thd)
   thd->wsrep_query_state = QUERY_COMMITTING;
   mysql_mutex_unlock(&thd->LOCK_wsrep_thd);
 
+  if (WSREP_OK != wsrep_thd_flush_keys(thd))
+  {
+    thd->wsrep_query_state= QUERY_EXEC;
+    DBUG_RETURN(WSREP_TRX_ERROR);
+  }
+
   rcode = 0;
   if ((thd->lex->sql_command == SQLCOM_CREATE_TABLE) &&
       !thd->wsrep_applier                            &&
@@ -982,6 +1000,8 @@ enum wsrep_trx_status wsrep_replicate(THD *thd)
                                 0ULL : WSREP_FLAG_PA_UNSAFE),
                                &thd->wsrep_trx_meta);
 
+      /* write-set is in provider's hands now */
+      wsrep_release_ws_maps(thd);
     }
 
     if (rcode == WSREP_TRX_MISSING) {
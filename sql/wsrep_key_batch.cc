@@ -0,0 +1,340 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_key_batch.h"
+#include "wsrep_conflict.h"
+#include "wsrep_priv.h"
+#include "sql_class.h"
+#include "my_atomic.h"
+#include "prealloced_array.h"
+#include "../extra/lz4/my_xxhash.h"
+
+#include <new>
+
+#define KEY_BATCH_MIN_ARENA 4096
+#define KEY_BATCH_MIN_SLOTS 256
+
+static long long wsrep_keys_appended_counter     = 0;
+static long long wsrep_keys_deduplicated_counter = 0;
+
+/* values exported to SHOW STATUS */
+static long long wsrep_keys_appended     = 0;
+static long long wsrep_keys_deduplicated = 0;
+
+namespace wsp {
+
+key_batch::key_batch()
+  : arena_(NULL), arena_size_(0), arena_used_(0),
+    slots_(NULL), n_slots_(0), n_keys_(0), n_flushed_(0), flushed_(0),
+    n_dups_(0)
+{}
+
+key_batch::~key_batch()
+{
+  my_free(arena_);
+  my_free(slots_);
+}
+
+bool key_batch::reserve_arena(size_t const len)
+{
+  if (arena_used_ + len <= arena_size_) return false;
+
+  size_t new_size= arena_size_ ? arena_size_ : KEY_BATCH_MIN_ARENA;
+  while (new_size < arena_used_ + len) new_size*= 2;
+
+  uchar* const tmp= static_cast<uchar*>(my_realloc(key_memory_wsrep, arena_,
+                                                   new_size, MYF(0)));
+  if (!tmp)
+  {
+    WSREP_ERROR("Failed to allocate %zu bytes for write-set keys", new_size);
+    return true;
+  }
+  arena_= tmp;
+  arena_size_= new_size;
+  return false;
+}
+
+/* Keep load factor below 1/2, rehash from the arena entries' hashes. */
+bool key_batch::grow_slots()
+{
+  size_t const new_n_slots= n_slots_ ? n_slots_ * 2 : KEY_BATCH_MIN_SLOTS;
+  slot* const new_slots= static_cast<slot*>(
+    my_malloc(key_memory_wsrep, new_n_slots * sizeof(slot), MYF(MY_ZEROFILL)));
+  if (!new_slots)
+  {
+    WSREP_ERROR("Failed to allocate %zu write-set key slots", new_n_slots);
+    return true;
+  }
+
+  for (size_t i= 0; i < n_slots_; ++i)
+  {
+    if (!slots_[i].offset) continue;
+    size_t pos= slots_[i].hash & (new_n_slots - 1);
+    while (new_slots[pos].offset) pos= (pos + 1) & (new_n_slots - 1);
+    new_slots[pos]= slots_[i];
+  }
+
+  my_free(slots_);
+  slots_= new_slots;
+  n_slots_= new_n_slots;
+  return false;
+}
+
+/* @return slot holding identical entry or free slot for it */
+key_batch::slot*
+key_batch::find_slot(ulonglong const hash, const uchar* const entry,
+                     size_t const len)
+{
+  size_t pos= hash & (n_slots_ - 1);
+  for (;;)
+  {
+    slot* const s= slots_ + pos;
+    if (!s->offset) return s;
+    if (s->hash == hash)
+    {
+      const uchar* const other= arena_ + s->offset - 1;
+      /* entries are self-delimiting, so it is safe to compare len bytes
+         as long as they are within the arena */
+      if (other + len <= arena_ + arena_used_ && !memcmp(other, entry, len))
+        return s;
+    }
+    pos= (pos + 1) & (n_slots_ - 1);
+  }
+}
+
+int key_batch::append(const wsrep_key_t* const key, wsrep_key_type const type)
+{
+  size_t len= 2;
+  for (size_t i= 0; i < key->key_parts_num; ++i)
+    len+= 2 + key->key_parts[i].len;
+
+  if (arena_used_ + len > KEY_BATCH_MAX_ARENA) return -1;
+  if (reserve_arena(len)) return 1;
+  if ((n_keys_ + 1) * 2 > n_slots_ && grow_slots()) return 1;
+
+  /* serialize the key at the arena tail, it is committed only if unique */
+  uchar* const entry= arena_ + arena_used_;
+  uchar* p= entry;
+  *p++= static_cast<uchar>(type);
+  *p++= static_cast<uchar>(key->key_parts_num);
+  for (size_t i= 0; i < key->key_parts_num; ++i)
+  {
+    DBUG_ASSERT(key->key_parts[i].len <= 0xffff);
+    int2store(p, static_cast<uint16>(key->key_parts[i].len));
+    p+= 2;
+    memcpy(p, key->key_parts[i].ptr, key->key_parts[i].len);
+    p+= key->key_parts[i].len;
+  }
+
+  ulonglong const hash= MY_XXH64(entry, len, 0);
+  slot* const s= find_slot(hash, entry, len);
+  if (s->offset)
+  {
+    ++n_dups_;
+    return 0;
+  }
+
+  s->hash= hash;
+  s->offset= static_cast<uint32>(arena_used_ + 1);
+  arena_used_+= len;
+  ++n_keys_;
+  return 0;
+}
+
+int key_batch::flush(wsrep_t* const wsrep, wsrep_ws_handle_t* const ws)
+{
+  int rcode= WSREP_OK;
+
+  if (!empty())
+  {
+    Prealloced_array<wsrep_key_t, 16> keys(key_memory_wsrep);
+    Prealloced_array<wsrep_buf_t, 48> parts(key_memory_wsrep);
+
+    /* provider accepts a single key type per call */
+    for (int type= WSREP_KEY_SHARED;
+         rcode == WSREP_OK && type <= WSREP_KEY_EXCLUSIVE; ++type)
+    {
+      keys.clear();
+      parts.clear();
+
+      for (const uchar* p= arena_ + flushed_; p < arena_ + arena_used_; )
+      {
+        bool const match= (*p == type);
+        size_t const n_parts= p[1];
+        p+= 2;
+
+        if (match)
+        {
+          wsrep_key_t const k= { NULL, n_parts };
+          keys.push_back(k);
+        }
+        for (size_t i= 0; i < n_parts; ++i)
+        {
+          size_t const part_len= uint2korr(p);
+          p+= 2;
+          if (match)
+          {
+            wsrep_buf_t const b= { p, part_len };
+            parts.push_back(b);
+          }
+          p+= part_len;
+        }
+      }
+
+      if (keys.empty()) continue;
+
+      /* parts array is final now, point keys to their parts */
+      size_t part= 0;
+      for (size_t i= 0; i < keys.size(); ++i)
+      {
+        keys[i].key_parts= &parts[part];
+        part+= keys[i].key_parts_num;
+      }
+
+      rcode= wsrep->append_key(wsrep, ws, keys.begin(), keys.size(),
+                               static_cast<wsrep_key_type>(type), true);
+    }
+
+    if (rcode == WSREP_OK)
+    {
+      my_atomic_add64(&wsrep_keys_appended_counter, n_keys_ - n_flushed_);
+      n_flushed_= n_keys_;
+      flushed_= arena_used_;
+    }
+  }
+
+  if (n_dups_)
+  {
+    my_atomic_add64(&wsrep_keys_deduplicated_counter, n_dups_);
+    n_dups_= 0;
+  }
+  return rcode;
+}
+
+void key_batch::clear()
+{
+  if (n_dups_)
+    my_atomic_add64(&wsrep_keys_deduplicated_counter, n_dups_);
+
+  if (n_keys_)
+    memset(slots_, 0, n_slots_ * sizeof(slot));
+
+  arena_used_= 0;
+  n_keys_= 0;
+  n_flushed_= 0;
+  flushed_= 0;
+  n_dups_= 0;
+}
+
+} /* namespace wsp */
+
+static int wsrep_append_key_direct(wsrep_ws_handle_t* const ws,
+                                   const wsrep_key_t* const key,
+                                   wsrep_key_type const type)
+{
+  int const rcode= wsrep->append_key(wsrep, ws, key, 1, type, true);
+  if (rcode == WSREP_OK)
+    my_atomic_add64(&wsrep_keys_appended_counter, 1);
+  return rcode;
+}
+
+int wsrep_thd_append_key(THD* const thd, wsrep_ws_handle_t* const ws,
+                         const wsrep_key_t* const key,
+                         wsrep_key_type const type)
+{
+  if (wsrep_early_conflict_check)
+  {
+    if (thd->wsrep_exec_mode == REPL_RECV)
+    {
+      wsrep_conflict_publish(thd, key);
+      return WSREP_OK;
+    }
+
+    if (thd->wsrep_retry_counter == 0 && wsrep_conflict_check(thd, key))
+      return WSREP_TRX_FAIL;
+  }
+
+  ulong const batch_size= wsrep_key_batch_size;
+  wsp::key_batch* batch= thd->wsrep_key_batch;
+
+  if (batch_size == 0)
+  {
+    if (batch)
+    {
+      /* batching was switched off */
+      int const rcode= batch->flush(wsrep, ws);
+      if (rcode != WSREP_OK) return rcode;
+      wsrep_thd_free_keys(thd);
+    }
+    return wsrep_append_key_direct(ws, key, type);
+  }
+
+  if (!batch)
+  {
+    batch= thd->wsrep_key_batch= new (std::nothrow) wsp::key_batch();
+    if (!batch)
+    {
+      WSREP_ERROR("Failed to allocate write-set key batch");
+      return WSREP_TRX_FAIL;
+    }
+  }
+
+  int const res= batch->append(key, type);
+  /* arena is full, keys already in it are still deduplicated */
+  if (res < 0) return wsrep_append_key_direct(ws, key, type);
+  if (res) return WSREP_TRX_FAIL;
+
+  return (batch->size() >= batch_size) ? batch->flush(wsrep, ws) : WSREP_OK;
+}
+
+int wsrep_thd_flush_keys(THD* const thd)
+{
+  if (!thd->wsrep_key_batch || thd->wsrep_key_batch->empty()) return WSREP_OK;
+
+  int const rcode= thd->wsrep_key_batch->flush(wsrep, &thd->wsrep_ws_handle);
+  if (rcode != WSREP_OK)
+  {
+    WSREP_WARN("Appending batched keys failed: %d, thd: %u, SQL: %s",
+               rcode, thd->thread_id(), WSREP_QUERY(thd));
+  }
+  return rcode;
+}
+
+void wsrep_thd_discard_keys(THD* const thd)
+{
+  if (thd->wsrep_key_batch) thd->wsrep_key_batch->clear();
+}
+
+void wsrep_thd_free_keys(THD* const thd)
+{
+  delete thd->wsrep_key_batch;
+  thd->wsrep_key_batch= NULL;
+}
+
+int wsrep_show_keys_appended(THD* thd, SHOW_VAR* var, char* buff)
+{
+  wsrep_keys_appended= my_atomic_load64(&wsrep_keys_appended_counter);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_keys_appended;
+  return 0;
+}
+
+int wsrep_show_keys_deduplicated(THD* thd, SHOW_VAR* var, char* buff)
+{
+  wsrep_keys_deduplicated= my_atomic_load64(&wsrep_keys_deduplicated_counter);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_keys_deduplicated;
+  return 0;
+}
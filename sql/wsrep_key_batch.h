@@ -0,0 +1,125 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_KEY_BATCH_H
+#define WSREP_KEY_BATCH_H
+
+#include "my_global.h"
+#include "wsrep_api.h"
+
+class THD;
+typedef struct st_mysql_show_var SHOW_VAR;
+
+#define KEY_BATCH_MAX_ARENA (1UL << 30)
+
+namespace wsp {
+
+/*
+  Per-transaction accumulator of certification keys.
+
+  Keys are serialized into a compact arena and deduplicated, so that a key
+  which is appended for many rows (typically a parent key of a foreign key
+  constraint) reaches the provider only once per transaction. Pending keys
+  are handed to the provider with one append_key() call per key type; keys
+  already flushed stay in the arena so that their duplicates are still
+  recognized.
+
+  Arena entry layout:
+    1 byte  key type
+    1 byte  number of key parts
+    for each key part: 2 bytes length, key part bytes
+
+  The arena is limited to KEY_BATCH_MAX_ARENA bytes, so that its offsets
+  fit in 32 bits. Keys which do not fit are appended to provider directly.
+*/
+class key_batch
+{
+public:
+  key_batch();
+  ~key_batch();
+
+  /* @return 0 on success, 1 on out of memory, -1 if the key would not
+             fit in KEY_BATCH_MAX_ARENA and was not added */
+  int    append(const wsrep_key_t* key, wsrep_key_type type);
+
+  /* Append pending keys to provider, they stay pending if it fails.
+     @return provider status */
+  int    flush(wsrep_t* wsrep, wsrep_ws_handle_t* ws);
+
+  /* Forget all keys of the transaction without appending pending ones */
+  void   clear();
+
+  /* number of pending keys */
+  size_t size() const  { return n_keys_ - n_flushed_; }
+  bool   empty() const { return n_keys_ == n_flushed_; }
+
+private:
+  struct slot
+  {
+    ulonglong hash;
+    uint32    offset; /* arena offset + 1, 0 marks free slot */
+  };
+
+  bool   reserve_arena(size_t len);
+  bool   grow_slots();
+  slot*  find_slot(ulonglong hash, const uchar* entry, size_t len);
+
+  uchar* arena_;
+  size_t arena_size_;
+  size_t arena_used_;
+  slot*  slots_;
+  size_t n_slots_;     /* power of 2 */
+  size_t n_keys_;
+  size_t n_flushed_;   /* keys appended to provider */
+  size_t flushed_;     /* arena offset of the first pending key */
+  size_t n_dups_;      /* deduplicated since last flush/clear */
+
+  key_batch(const key_batch&);
+  key_batch& operator=(const key_batch&);
+};
+
+} /* namespace wsp */
+
+/*
+  Append certification key for transaction of thd.
+
+  Depending on wsrep_key_batch_size the key is either accumulated in the
+  transaction key batch or appended to provider right away. The batch is
+  flushed when it reaches wsrep_key_batch_size pending keys, at the end of
+  every statement and before replication. If batching is switched off,
+  the batch is flushed and freed with the next key.
+
+  With wsrep_early_conflict_check, keys of appliers are published instead,
+  and keys of local transactions are checked against them first, see
+  wsrep_conflict.h.
+
+  @return provider status
+*/
+int  wsrep_thd_append_key(THD* thd, wsrep_ws_handle_t* ws,
+                          const wsrep_key_t* key, wsrep_key_type type);
+
+/* Append keys accumulated for transaction of thd to provider */
+int  wsrep_thd_flush_keys(THD* thd);
+
+/* Discard keys accumulated for transaction of thd */
+void wsrep_thd_discard_keys(THD* thd);
+
+/* Free transaction key batch of thd */
+void wsrep_thd_free_keys(THD* thd);
+
+int  wsrep_show_keys_appended(THD* thd, SHOW_VAR* var, char* buff);
+int  wsrep_show_keys_deduplicated(THD* thd, SHOW_VAR* var, char* buff);
+
+#endif /* WSREP_KEY_BATCH_H */
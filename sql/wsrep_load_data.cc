@@ -0,0 +1,367 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_load_data.h"
+#include "wsrep_priv.h"
+#include "sql_class.h"
+#include "sql_parse.h"
+#include "sql_lex.h"
+#include "derror.h"
+#include "binlog.h"
+#include "mysqld_thd_manager.h"
+#include "mysql/psi/mysql_file.h"
+#include "mysql/psi/mysql_thread.h"
+#include "my_dir.h"
+
+#include <algorithm>
+
+/* LOAD DATA split between worker sessions */
+struct load_data_job
+{
+  mysql_mutex_t lock;
+  mysql_cond_t  cond;
+  THD*          parent;
+  LEX_CSTRING   query;
+  uint          running;   /* workers not done yet */
+};
+
+struct load_data_worker
+{
+  load_data_job*        job;
+  wsrep_load_data_chunk chunk;
+  THD*                  thd;      /* while running, protected by job lock */
+  my_thread_handle      thread;
+};
+
+bool wsrep_load_data_parallel_allowed(THD* const thd,
+                                      const sql_exchange* const ex,
+                                      const TABLE* const table,
+                                      const List<Item>& set_fields,
+                                      enum_duplicates const handle_duplicates)
+{
+  if (wsrep_load_data_threads < 2 || !wsrep_load_data_splitting ||
+      !WSREP(thd) || thd->wsrep_load_data_chunk ||
+      thd->in_multi_stmt_transaction_mode() ||
+      thd->locked_tables_mode != LTM_NONE ||
+      (mysql_bin_log.is_open() && !thd->is_current_stmt_binlog_format_row()))
+    return false;
+
+  /* the table stays open in thd while the workers write it, which only
+     InnoDB lets them do */
+  if (table->file->ht->db_type != DB_TYPE_INNODB)
+    return false;
+
+  if (set_fields.elements || handle_duplicates == DUP_REPLACE)
+    return false;
+
+  const String* const line_term= ex->line.line_term;
+  const String* const field_term= ex->field.field_term;
+  const CHARSET_INFO* const cs=
+    ex->cs ? ex->cs : thd->variables.collation_database;
+
+  return ex->filetype != FILETYPE_XML &&
+         ex->field.enclosed->length() == 0 &&
+         line_term->length() > 0 &&
+         !(field_term->length() == line_term->length() &&
+           !memcmp(field_term->ptr(), line_term->ptr(), line_term->length())) &&
+         cs->mbminlen == 1;
+}
+
+/*
+  Find the end of the line at pos or after it: the position after the
+  first line terminator at pos or after it not preceded by the escape
+  character. An escape character before a terminator may itself be
+  escaped, that terminator is then passed over, which only makes the part
+  ending at the next one longer.
+
+  @return position after the terminator, size if there is none or on error
+*/
+static my_off_t load_data_line_end(File const file, my_off_t pos,
+                                   my_off_t const size, const String& term,
+                                   int const escape_char)
+{
+  uchar buf[16 * IO_SIZE];
+  size_t const term_len= term.length();
+
+  while (pos < size)
+  {
+    /* read the byte before pos as well, to tell if a terminator at pos
+       is escaped */
+    my_off_t const from= pos > 0 ? pos - 1 : 0;
+    size_t const len= static_cast<size_t>(
+      std::min<my_off_t>(sizeof(buf), size - from));
+
+    if (mysql_file_pread(file, buf, len, from, MYF(MY_WME | MY_NABP)))
+      return size;
+
+    for (size_t i= static_cast<size_t>(pos - from); i + term_len <= len; ++i)
+    {
+      if (memcmp(buf + i, term.ptr(), term_len)) continue;
+      if (i > 0 && buf[i - 1] == escape_char) continue;
+      return from + i + term_len;
+    }
+
+    if (from + len == size) break;
+
+    /* a terminator may span the end of the buffer */
+    pos= from + len - (term_len - 1);
+  }
+
+  return size;
+}
+
+static void load_data_copy_session(THD* const thd, THD* const parent)
+{
+  *thd->security_context()= *parent->security_context();
+  thd->set_db(parent->db());
+
+  thd->variables.sql_mode=                parent->variables.sql_mode;
+  thd->variables.option_bits=             parent->variables.option_bits;
+  thd->variables.character_set_client=    parent->variables.character_set_client;
+  thd->variables.character_set_results=   parent->variables.character_set_results;
+  thd->variables.character_set_filesystem=
+    parent->variables.character_set_filesystem;
+  thd->variables.collation_connection=    parent->variables.collation_connection;
+  thd->variables.collation_database=      parent->variables.collation_database;
+  thd->variables.time_zone=               parent->variables.time_zone;
+  thd->variables.binlog_format=           parent->variables.binlog_format;
+  thd->variables.lock_wait_timeout=       parent->variables.lock_wait_timeout;
+  thd->variables.wsrep_retry_autocommit=  parent->variables.wsrep_retry_autocommit;
+  thd->update_charset();
+}
+
+static void* load_data_worker_thread(void* const arg)
+{
+  load_data_worker* const worker= static_cast<load_data_worker*>(arg);
+  load_data_job* const job= worker->job;
+
+  my_thread_init();
+
+  THD* thd= new THD;
+  thd->thread_stack= (char*) &thd;
+#ifdef HAVE_PSI_INTERFACE
+  thd->set_psi(PSI_THREAD_CALL(get_thread)());
+#endif /* HAVE_PSI_INTERFACE */
+  thd->set_new_thread_id();
+  thd->store_globals();
+  thd->real_id= my_thread_self();
+  thd->init_for_queries();
+  lex_start(thd);
+
+  load_data_copy_session(thd, job->parent);
+  thd->wsrep_client_thread= 1;
+  thd->wsrep_load_data_chunk= &worker->chunk;
+
+  Global_THD_manager* const thd_manager= Global_THD_manager::get_instance();
+  thd_manager->add_thd(thd);
+
+  mysql_mutex_lock(&job->lock);
+  worker->thd= thd;
+  mysql_mutex_unlock(&job->lock);
+
+  COM_DATA com_data;
+  com_data.com_query.query= job->query.str;
+  com_data.com_query.length= static_cast<uint>(job->query.length);
+  dispatch_command(thd, &com_data, COM_QUERY);
+
+  if (thd->get_stmt_da()->is_error())
+  {
+    worker->chunk.sql_errno= thd->get_stmt_da()->mysql_errno();
+    strmake(worker->chunk.message, thd->get_stmt_da()->message_text(),
+            sizeof(worker->chunk.message) - 1);
+  }
+  else if (thd->killed)
+  {
+    worker->chunk.sql_errno= ER_QUERY_INTERRUPTED;
+    strmake(worker->chunk.message, ER_DEFAULT(ER_QUERY_INTERRUPTED),
+            sizeof(worker->chunk.message) - 1);
+  }
+
+  /* warnings and notes of the part go to the parent, which does not use
+     its diagnostics area before all workers are done, its error is
+     raised by the parent from the chunk */
+  mysql_mutex_lock(&job->lock);
+  job->parent->get_stmt_da()->copy_non_errors_from_da(job->parent,
+                                                      thd->get_stmt_da());
+  worker->thd= NULL;
+  --job->running;
+  mysql_cond_signal(&job->cond);
+  mysql_mutex_unlock(&job->lock);
+
+  thd->wsrep_load_data_chunk= NULL;
+  thd->release_resources();
+  thd_manager->remove_thd(thd);
+  delete thd;
+
+  my_thread_end();
+  return NULL;
+}
+
+/* Wait for the workers, passing a kill of the parent on to them */
+static void load_data_wait(load_data_job* const job,
+                           load_data_worker* const workers, uint const n)
+{
+  bool killed= false;
+
+  mysql_mutex_lock(&job->lock);
+  while (job->running)
+  {
+    struct timespec abstime;
+    set_timespec(&abstime, 1);
+    mysql_cond_timedwait(&job->cond, &job->lock, &abstime);
+
+    if (!killed && job->parent->killed)
+    {
+      killed= true;
+      for (uint i= 0; i < n; ++i)
+      {
+        THD* const thd= workers[i].thd;
+        if (!thd) continue;
+        mysql_mutex_lock(&thd->LOCK_thd_data);
+        thd->awake(THD::KILL_QUERY);
+        mysql_mutex_unlock(&thd->LOCK_thd_data);
+      }
+    }
+  }
+  mysql_mutex_unlock(&job->lock);
+
+  for (uint i= 0; i < n; ++i)
+    my_thread_join(&workers[i].thread, NULL);
+}
+
+int wsrep_load_data_parallel(THD* const thd, File const file,
+                             const sql_exchange* const ex,
+                             int const escape_char)
+{
+  MY_STAT stat_info;
+  if (my_fstat(file, &stat_info, MYF(0))) return -1;
+
+  my_off_t const size= stat_info.st_size;
+  const String& term= *ex->line.line_term;
+
+  /* the lines to ignore are skipped here, workers load whole parts */
+  my_off_t start= 0;
+  for (ulong i= 0; i < ex->skip_lines && start < size; ++i)
+    start= load_data_line_end(file, start, size, term, escape_char);
+
+  ulonglong const n_max= (size - start) / WSREP_LOAD_DATA_MIN_CHUNK;
+  uint n= static_cast<uint>(std::min<ulonglong>(wsrep_load_data_threads,
+                                                n_max));
+  if (n < 2) return -1;
+
+  load_data_worker* const workers= static_cast<load_data_worker*>(
+    my_malloc(key_memory_wsrep, n * sizeof(load_data_worker),
+              MYF(MY_WME | MY_ZEROFILL)));
+  if (!workers) return 1;
+
+  load_data_job job;
+  mysql_mutex_init(key_LOCK_wsrep_load_data, &job.lock, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_wsrep_load_data, &job.cond);
+  job.parent= thd;
+  job.query= thd->query();
+  job.running= 0;
+
+  /* the parts end at the first line end after an n-th of the file */
+  uint parts= 0;
+  for (my_off_t pos= start; parts < n && pos < size; ++parts)
+  {
+    my_off_t const split= start + (size - start) * (parts + 1) / n;
+    wsrep_load_data_chunk& chunk= workers[parts].chunk;
+    chunk.start= pos;
+    chunk.end= parts + 1 == n ? size :
+      load_data_line_end(file, std::max(split, pos), size, term, escape_char);
+    pos= chunk.end;
+  }
+
+  WSREP_DEBUG("LOAD DATA of %llu bytes in %u sessions: %s",
+              (ulonglong) (size - start), parts, WSREP_QUERY(thd));
+
+  uint started= 0;
+  for (; started < parts; ++started)
+  {
+    load_data_worker& worker= workers[started];
+    worker.job= &job;
+
+    mysql_mutex_lock(&job.lock);
+    ++job.running;
+    mysql_mutex_unlock(&job.lock);
+
+    my_thread_attr_t attr;
+    my_thread_attr_init(&attr);
+    my_thread_attr_setdetachstate(&attr, MY_THREAD_CREATE_JOINABLE);
+    int const err= mysql_thread_create(key_THREAD_wsrep_load_data,
+                                       &worker.thread, &attr,
+                                       load_data_worker_thread, &worker);
+    my_thread_attr_destroy(&attr);
+
+    if (err)
+    {
+      mysql_mutex_lock(&job.lock);
+      --job.running;
+      mysql_mutex_unlock(&job.lock);
+      WSREP_ERROR("Could not start LOAD DATA worker: %d", err);
+      worker.chunk.sql_errno= ER_CANT_CREATE_THREAD;
+      my_snprintf(worker.chunk.message, sizeof(worker.chunk.message),
+                  ER_DEFAULT(ER_CANT_CREATE_THREAD), err);
+      break;
+    }
+  }
+
+  load_data_wait(&job, workers, started);
+
+  mysql_cond_destroy(&job.cond);
+  mysql_mutex_destroy(&job.lock);
+
+  ulonglong records= 0, copied= 0, deleted= 0, warnings= 0;
+  const wsrep_load_data_chunk* failed= NULL;
+
+  for (uint i= 0; i < parts; ++i)
+  {
+    const wsrep_load_data_chunk& chunk= workers[i].chunk;
+    records+=  chunk.records;
+    copied+=   chunk.copied;
+    deleted+=  chunk.deleted;
+    warnings+= chunk.warnings;
+    if (!chunk.sql_errno) continue;
+
+    /* the first error is the error of the statement, the errors of
+       other parts are kept as conditions, up to max_error_count */
+    if (!failed)
+      failed= &chunk;
+    else
+      thd->get_stmt_da()->push_warning(thd, chunk.sql_errno,
+                                       mysql_errno_to_sqlstate(chunk.sql_errno),
+                                       Sql_condition::SL_ERROR,
+                                       chunk.message);
+  }
+
+  int ret= 0;
+  if (failed)
+  {
+    my_message(failed->sql_errno, failed->message, MYF(0));
+    ret= 1;
+  }
+  else
+  {
+    char msg[MYSQL_ERRMSG_SIZE];
+    my_snprintf(msg, sizeof(msg), ER(ER_LOAD_INFO),
+                (long) records, (long) deleted, (long) (records - copied),
+                (long) warnings);
+    my_ok(thd, copied + deleted, 0L, msg);
+  }
+
+  my_free(workers);
+  return ret;
+}
@@ -0,0 +1,88 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_LOAD_DATA_H
+#define WSREP_LOAD_DATA_H
+
+/*
+  Parallel LOAD DATA INFILE.
+
+  With wsrep_load_data_threads > 1 and wsrep_load_data_splitting, LOAD DATA
+  of a server side file into an InnoDB table is split into parts which end
+  at line terminators, at least WSREP_LOAD_DATA_MIN_CHUNK bytes each, and
+  each part is loaded by a worker session running the same statement. A
+  worker parses and writes the rows of its part and commits them every 10K
+  rows, like any LOAD DATA with splitting. Transactions of different
+  workers do not depend on each other, so other nodes apply them in
+  parallel.
+
+  The session running the statement waits for the workers and reports
+  the rows and the number of warnings of all of them as one result, or
+  the first error of a worker. The warnings and notes of the workers, and
+  the errors of the other workers, are copied to its diagnostics area, up
+  to max_error_count of them as usual.
+  Parts committed before an error stay, as they do with splitting.
+
+  A part must end where a line does, so the file may only have line
+  terminators which end a line unless escaped: there may be no ENCLOSED BY,
+  the lines may not be terminated by the field terminator and the file
+  may not be XML. Statements with SET or REPLACE, which depend on the order
+  of the rows or on the session, are not split. Any other statement loads
+  the file in the session as before.
+*/
+
+#include "my_global.h"
+#include "mysql_com.h"
+#include "sql_data_change.h"
+
+class THD;
+class Item;
+class sql_exchange;
+struct TABLE;
+template <class T> class List;
+
+#define WSREP_LOAD_DATA_MAX_THREADS 64
+#define WSREP_LOAD_DATA_MIN_CHUNK   (4 * 1024 * 1024)
+
+/* part of the file loaded by a worker session */
+struct wsrep_load_data_chunk
+{
+  my_off_t  start;
+  my_off_t  end;
+  /* set by the worker */
+  ulonglong records;
+  ulonglong copied;
+  ulonglong deleted;
+  ulonglong warnings;
+  uint      sql_errno;
+  char      message[MYSQL_ERRMSG_SIZE];
+};
+
+/* @return true if LOAD DATA may be split between worker sessions */
+bool wsrep_load_data_parallel_allowed(THD* thd, const sql_exchange* ex,
+                                      const TABLE* table,
+                                      const List<Item>& set_fields,
+                                      enum_duplicates handle_duplicates);
+
+/*
+  Load file, opened by LOAD DATA of thd, in worker sessions.
+  @return -1 if the file is too small to split, thd is to load it,
+           0 if loaded, the result is set in thd,
+           1 on error, set in thd
+*/
+int wsrep_load_data_parallel(THD* thd, File file, const sql_exchange* ex,
+                             int escape_char);
+
+#endif /* WSREP_LOAD_DATA_H */
@@ -27,6 +27,11 @@
 #include "wsrep_applier.h"
 #include <binlog.h>
 #include "wsrep_xid.h"
+#include "wsrep_row_digest.h"
+#include "wsrep_nbo.h"
+#include "wsrep_dump.h"
+#include "wsrep_conflict_log.h"
+#include "wsrep_table_map_cache.h"
 #include <cstdio>
 #include <cstdlib>
 #include "log_event.h"
@@ -69,8 +74,17 @@ my_bool wsrep_drupal_282555_workaround = 1; // retry autoinc insert after dupkey
 my_bool wsrep_incremental_data_collection = 0; // incremental data collection
 ulong   wsrep_max_ws_size              = 1073741824UL;//max ws (RBR buffer) size
 ulong   wsrep_max_ws_rows              = 65536; // max number of rows in ws
+ulong   wsrep_key_batch_size           = 0; // # of keys to accumulate
+                                            // before appending to ws
+ulong   wsrep_apply_decode_ahead       = 0; // min ws size to decode events
+                                            // in a helper thread
+ulong   wsrep_dump_log_size            = 1073741824UL; // write-set dump
+                                                       // log size limit
+ulong   wsrep_slave_threads_max        = 0; // upper bound of adaptive
+                                            // applier pool
 int     wsrep_to_isolation             = 0; // # of active TO isolation threads
 my_bool wsrep_certify_nonPK            = 1; // certify, even when no primary key
+ulong   wsrep_row_digest               = WSREP_ROW_DIGEST_MD5; // no PK row key
 ulong   wsrep_certification_rules      = WSREP_CERTIFICATION_RULES_STRICT;
 long    wsrep_max_protocol_version     = 3; // maximum protocol version to use
 ulong   wsrep_forced_binlog_format     = BINLOG_FORMAT_UNSPEC;
@@ -79,12 +93,17 @@ my_bool wsrep_log_conflicts            = 0;
 my_bool wsrep_desync                   = 0; // desynchronize the node from the
                                             // cluster
 my_bool wsrep_load_data_splitting      = 1; // commit load data every 10K intervals
+ulong   wsrep_load_data_threads        = 1; // sessions to load data file in
 my_bool wsrep_restart_slave            = 0; // should mysql slave thread be
                                             // restarted, if node joins back
 my_bool wsrep_restart_slave_activated  = 0; // node has dropped, and slave
                                             // restart will be needed
 my_bool wsrep_slave_UK_checks          = 0; // slave thread does UK checks
 my_bool wsrep_slave_FK_checks          = 0; // slave thread does FK checks
+my_bool wsrep_slave_prefetch           = 0; // slave thread prefetches rows
+my_bool wsrep_early_conflict_check     = 0; // abort local trx touching rows
+                                            // being applied
+ulong   wsrep_sync_wait_max_staleness  = 0; // ms, reuse causal read result
 ulong   wsrep_RSU_commit_timeout       = 5000; // wait for x micr-secs
                                                // to allow active connection to
                                                // commit before starting RSU.
@@ -637,6 +656,8 @@ wsrep_view_handler_cb (void*                    app_ctx,
 
   wsrep_member_status_t new_status= local_status.get();
 
+  wsrep_causal_reset();
+
   if (memcmp(&cluster_uuid, &view->state_id.uuid, sizeof(wsrep_uuid_t)))
   {
     memcpy(&cluster_uuid, &view->state_id.uuid, sizeof(cluster_uuid));
@@ -1242,6 +1263,7 @@ void wsrep_init_startup (bool first)
 
 void wsrep_deinit()
 {
+  wsrep_dump_log_close();
   wsrep_unload(wsrep);
   wsrep= 0;
   provider_name[0]=    '\0';
@@ -1398,6 +1420,120 @@ bool wsrep_must_sync_wait (THD* thd, uint mask)
     thd->wsrep_sync_wait_gtid.seqno == WSREP_SEQNO_UNDEFINED;
 }
 
+/*
+  Causal read round trips are shared by concurrent sync waits: only one
+  causal_read() call is in flight at a time and every waiter uses the result
+  of the first call started after it arrived. All below is protected by
+  LOCK_wsrep_causal.
+*/
+static ulonglong      causal_started     = 0; // # of causal reads started
+static ulonglong      causal_completed   = 0; // # of causal reads completed
+static wsrep_status_t causal_status      = WSREP_OK; // last completed result
+static ulonglong      causal_valid_since = 0; // start time (us) of the last
+                                              // successful causal read, 0 if
+                                              // it can not be reused
+static long long      causal_cached      = 0; // waits served by cached result
+static long long      causal_batched     = 0; // waits served by a causal read
+                                              // started by another thread
+static long long      causal_waits       = 0; // waits not served from cache
+static long long      causal_wait_time   = 0; // total time (us) of the above
+
+/* values exported to SHOW STATUS */
+static long long      wsrep_sync_wait_cached   = 0;
+static long long      wsrep_sync_wait_batched  = 0;
+static long long      wsrep_sync_wait_avg_time = 0;
+
+static wsrep_status_t wsrep_causal_wait()
+{
+  ulonglong const start= my_micro_time();
+  ulonglong const max_staleness= wsrep_sync_wait_max_staleness * 1000ULL;
+  bool batched= false;
+
+  mysql_mutex_lock(&LOCK_wsrep_causal);
+
+  if (max_staleness && causal_valid_since &&
+      start < causal_valid_since + max_staleness)
+  {
+    /* the node has already applied everything that was committed in the
+       cluster before causal_valid_since */
+    causal_cached++;
+    mysql_mutex_unlock(&LOCK_wsrep_causal);
+    return WSREP_OK;
+  }
+
+  ulonglong const target= causal_started + 1;
+
+  while (causal_completed < target)
+  {
+    if (causal_started == causal_completed)
+    {
+      ulonglong const rt_start= my_micro_time();
+      causal_started++;
+      mysql_mutex_unlock(&LOCK_wsrep_causal);
+
+      wsrep_gtid_t   gtid;
+      wsrep_status_t const ret= wsrep->causal_read(wsrep, &gtid);
+
+      mysql_mutex_lock(&LOCK_wsrep_causal);
+      causal_completed= causal_started;
+      causal_status= ret;
+      causal_valid_since= (ret == WSREP_OK ? rt_start : 0);
+      mysql_cond_broadcast(&COND_wsrep_causal);
+    }
+    else
+    {
+      batched= true;
+      mysql_cond_wait(&COND_wsrep_causal, &LOCK_wsrep_causal);
+    }
+  }
+
+  wsrep_status_t const ret= causal_status;
+  if (batched) causal_batched++;
+  causal_waits++;
+  causal_wait_time+= my_micro_time() - start;
+
+  mysql_mutex_unlock(&LOCK_wsrep_causal);
+  return ret;
+}
+
+/* Cached causal read result must not survive configuration changes */
+static void wsrep_causal_reset()
+{
+  mysql_mutex_lock(&LOCK_wsrep_causal);
+  causal_valid_since= 0;
+  mysql_mutex_unlock(&LOCK_wsrep_causal);
+}
+
+int wsrep_show_sync_wait_cached(THD *thd, SHOW_VAR *var, char *buff)
+{
+  mysql_mutex_lock(&LOCK_wsrep_causal);
+  wsrep_sync_wait_cached= causal_cached;
+  mysql_mutex_unlock(&LOCK_wsrep_causal);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_sync_wait_cached;
+  return 0;
+}
+
+int wsrep_show_sync_wait_batched(THD *thd, SHOW_VAR *var, char *buff)
+{
+  mysql_mutex_lock(&LOCK_wsrep_causal);
+  wsrep_sync_wait_batched= causal_batched;
+  mysql_mutex_unlock(&LOCK_wsrep_causal);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_sync_wait_batched;
+  return 0;
+}
+
+int wsrep_show_sync_wait_avg_time(THD *thd, SHOW_VAR *var, char *buff)
+{
+  mysql_mutex_lock(&LOCK_wsrep_causal);
+  wsrep_sync_wait_avg_time= causal_waits ? causal_wait_time / causal_waits : 0;
+  mysql_mutex_unlock(&LOCK_wsrep_causal);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_sync_wait_avg_time;
+  return 0;
+}
+
 bool wsrep_sync_wait (THD* thd, uint mask)
 {
   if (wsrep_must_sync_wait(thd, mask))
@@ -1406,8 +1542,7 @@ bool wsrep_sync_wait (THD* thd, uint mask)
     //            thd->variables.wsrep_sync_wait, mask, WSREP_QUERY(thd));
     // This allows autocommit SELECTs and a first SELECT after SET AUTOCOMMIT=0
     // TODO: modify to check if thd has locked any rows.
-    wsrep_gtid_t  gtid;
-    wsrep_status_t ret= wsrep->causal_read (wsrep, &gtid);
+    wsrep_status_t ret= wsrep_causal_wait();
 
     if (unlikely(WSREP_OK != ret))
     {
@@ -1953,6 +2088,106 @@ static bool wsrep_can_run_in_toi(THD *thd, const char *db, const char *table,
   }
 }
 
+/*
+  Decide if statement can be certified against table keys only.
+
+  This holds for statements which change a single existing table without
+  touching anything outside of it: the keys prepared for isolation must all
+  be table level keys, as any write-set modifying those tables references
+  them and is ordered after the statement by certification.
+ */
+static bool wsrep_can_run_in_table_toi(THD *thd, const wsrep_key_arr_t *ka)
+{
+  switch (thd->lex->sql_command)
+  {
+  case SQLCOM_ALTER_TABLE:
+    if (thd->lex->alter_info.flags & (Alter_info::ALTER_RENAME |
+                                      Alter_info::ALTER_EXCHANGE_PARTITION))
+      return false;
+    break;
+  case SQLCOM_CREATE_INDEX:
+  case SQLCOM_DROP_INDEX:
+  case SQLCOM_OPTIMIZE:
+  case SQLCOM_ANALYZE:
+  case SQLCOM_REPAIR:
+    break;
+  default:
+    return false;
+  }
+
+  if (ka->keys_len == 0) return false;
+
+  for (size_t i= 0; i < ka->keys_len; ++i)
+  {
+    if (ka->keys[i].key_parts_num != 2) return false;
+  }
+
+  return true;
+}
+
+/*
+  Replicate TOI statement as an ordinary write-set with exclusive table
+  keys. Unlike to_execute_start() it does not wait for all preceding
+  write-sets to commit, and the following ones that do not conflict with
+  the keys are certified and applied meanwhile. The commit monitor is
+  released before the statement runs, so that commits on this node do not
+  wait for it; they may move the SE checkpoint past the statement, which
+  therefore does not set it. Other nodes apply the write-set in parallel,
+  but the provider still commits it in order there.
+
+  A write-set BF aborted after certification must be applied on this node
+  too: the statement is skipped and the write-set replayed, which runs it
+  as an applier in TOI order.
+ */
+static wsrep_status_t wsrep_table_TOI_replicate(THD *thd,
+                                                const wsrep_key_arr_t *ka,
+                                                const struct wsrep_buf *buff)
+{
+  (void)wsrep_ws_handle_for_trx(&thd->wsrep_ws_handle, thd->query_id);
+
+  wsrep_status_t ret= wsrep->append_key(wsrep, &thd->wsrep_ws_handle,
+                                        ka->keys, ka->keys_len,
+                                        WSREP_KEY_EXCLUSIVE, true);
+  if (ret == WSREP_OK)
+    ret= wsrep->append_data(wsrep, &thd->wsrep_ws_handle, buff, 1,
+                            WSREP_DATA_ORDERED, true);
+  if (ret == WSREP_OK)
+    ret= wsrep->replicate_pre_commit(wsrep, (wsrep_conn_id_t)thd->thread_id(),
+                                     &thd->wsrep_ws_handle, WSREP_FLAG_COMMIT,
+                                     &thd->wsrep_trx_meta);
+
+  /* post_commit() in wsrep_TOI_end() releases the rest */
+  if (ret == WSREP_OK &&
+      wsrep->interim_commit(wsrep, &thd->wsrep_ws_handle))
+    WSREP_WARN("interim_commit failed for table level TOI write-set (%lld): "
+               "%s", (long long)wsrep_thd_trx_seqno(thd), WSREP_QUERY(thd));
+
+  if (ret == WSREP_BF_ABORT)
+  {
+    WSREP_DEBUG("Table level TOI write-set (%lld) was BF aborted, will "
+                "replay: %s", (long long)wsrep_thd_trx_seqno(thd),
+                WSREP_QUERY(thd));
+    mysql_mutex_lock(&thd->LOCK_wsrep_thd);
+    thd->wsrep_conflict_state= MUST_REPLAY;
+    DBUG_ASSERT(wsrep_thd_trx_seqno(thd) > 0);
+    mysql_mutex_unlock(&thd->LOCK_wsrep_thd);
+    mysql_mutex_lock(&LOCK_wsrep_replaying);
+    wsrep_replaying++;
+    mysql_mutex_unlock(&LOCK_wsrep_replaying);
+  }
+  else if (ret != WSREP_OK)
+  {
+    /* not certified, give up the write-set */
+    WSREP_DEBUG("Table level TOI replication failed: %d, seqno: %lld, sql: %s",
+                ret, (long long)wsrep_thd_trx_seqno(thd), WSREP_QUERY(thd));
+    if (wsrep->post_rollback(wsrep, &thd->wsrep_ws_handle))
+      WSREP_WARN("post_rollback failed for table level TOI: %s",
+                 WSREP_QUERY(thd));
+  }
+
+  return ret;
+}
+
 /*
   returns: 
    0: statement was replicated as TOI
@@ -1962,12 +2197,20 @@ static bool wsrep_can_run_in_toi(THD *thd, const char *db, const char *table,
 
 static int wsrep_TOI_begin(THD *thd, const char *db_, const char *table_,
                            const TABLE_LIST* table_list,
-                           Alter_info* alter_info)
+                           Alter_info* alter_info, ulong method)
 {
   wsrep_status_t ret(WSREP_WARNING);
   uchar* buf(0);
   size_t buf_len(0);
   int buf_err;
+  bool const nbo= (method == WSREP_OSU_NBO && wsrep_NBO_eligible(thd));
+  const char* const nbo_db= table_list ? table_list->db : db_;
+  const char* const nbo_table= table_list ? table_list->table_name : table_;
+  char nbo_marker[sizeof(WSREP_NBO_BEGIN_MARKER) + 2 * NAME_LEN + 2];
+  String nbo_marker_str;
+  String table_marker_str(C_STRING_WITH_LEN(WSREP_TABLE_TOI_MARKER),
+                          &my_charset_bin);
+  wsrep_key_arr_t key_arr= {0, 0};
 
   thd->wsrep_skip_wsrep_hton= true;
   if (wsrep_can_run_in_toi(thd, db_, table_, table_list) == false)
@@ -1982,6 +2225,27 @@ static int wsrep_TOI_begin(THD *thd, const char *db_, const char *table_,
               (long long)wsrep_thd_trx_seqno(thd),
               wsrep_get_exec_mode(thd->wsrep_exec_mode));
 
+  if (nbo)
+  {
+    /* tells the other nodes to run the statement as NBO */
+    nbo_marker_str.set(nbo_marker,
+                       wsrep_NBO_begin_marker(nbo_db, nbo_table, nbo_marker,
+                                              sizeof(nbo_marker)),
+                       &my_charset_bin);
+    thd->wsrep_TOI_pre_queries.push_back(&nbo_marker_str);
+  }
+
+  bool const keys_err= wsrep_prepare_keys_for_isolation(thd, db_, table_,
+                                                        table_list,
+                                                        alter_info, &key_arr);
+  thd->wsrep_TOI_table= method == WSREP_OSU_TABLE_TOI && !keys_err &&
+                        wsrep_can_run_in_table_toi(thd, &key_arr);
+  if (thd->wsrep_TOI_table)
+  {
+    /* tells the appliers that the write-set is a TOI statement */
+    thd->wsrep_TOI_pre_queries.push_back(&table_marker_str);
+  }
+
   switch (thd->lex->sql_command)
   {
   case SQLCOM_CREATE_VIEW:
@@ -2009,6 +2273,8 @@ static int wsrep_TOI_begin(THD *thd, const char *db_, const char *table_,
     break;
   }
 
+  if (nbo || thd->wsrep_TOI_table) thd->wsrep_TOI_pre_queries.pop_back();
+
   if (buf_err == 1) {
     /* Given the existing error handling setup, all errors with write-set
     are classified under single error code. It would be good to have a proper
@@ -2017,20 +2283,23 @@ static int wsrep_TOI_begin(THD *thd, const char *db_, const char *table_,
 		"issues (including memory allocation) or hitting a configured "
                 "limit viz. write set size, etc.");
     my_error(ER_ERROR_DURING_COMMIT, MYF(0), WSREP_SIZE_EXCEEDED);
+    thd->wsrep_TOI_table= false;
+    wsrep_keys_free(&key_arr);
     return -1;
   }
 
-  wsrep_key_arr_t key_arr= {0, 0};
   struct wsrep_buf buff = { buf, buf_len };
 
-  if (!buf_err                                                                &&
-      !wsrep_prepare_keys_for_isolation(thd, db_, table_,
-                                        table_list, alter_info, &key_arr)     &&
-      key_arr.keys_len > 0                                                    &&
-      WSREP_OK == (ret = wsrep->to_execute_start(wsrep, (ulong)thd->thread_id(),
-                                                 key_arr.keys, key_arr.keys_len,
-                                                 &buff, 1,
-                                                 &thd->wsrep_trx_meta)))
+  if (!buf_err && !keys_err && key_arr.keys_len > 0)
+  {
+    ret= thd->wsrep_TOI_table ?
+         wsrep_table_TOI_replicate(thd, &key_arr, &buff) :
+         wsrep->to_execute_start(wsrep, (ulong)thd->thread_id(),
+                                 key_arr.keys, key_arr.keys_len,
+                                 &buff, 1, &thd->wsrep_trx_meta);
+  }
+
+  if (WSREP_OK == ret)
   {
     thd->wsrep_exec_mode= TOTAL_ORDER;
     wsrep_to_isolation++;
@@ -2044,13 +2313,18 @@ static int wsrep_TOI_begin(THD *thd, const char *db_, const char *table_,
     /* thd->wsrep_gtid_event_buf was free'ed above, just set to NULL */
     thd->wsrep_gtid_event_buf_len = 0;
     thd->wsrep_gtid_event_buf     = NULL;
-    wsrep_keys_free(&key_arr);
+    if (nbo)
+      wsrep_NBO_begin(thd, nbo_db, nbo_table, &key_arr);
+    else
+      wsrep_keys_free(&key_arr);
 
     WSREP_DEBUG("Query (%s) with write-set (%lld) and exec_mode: %s"
-                " replicated in TO Isolation mode",
+                " replicated in %s TO Isolation mode",
                 WSREP_QUERY(thd),
                 (long long)wsrep_thd_trx_seqno(thd),
-                wsrep_get_exec_mode(thd->wsrep_exec_mode));
+                wsrep_get_exec_mode(thd->wsrep_exec_mode),
+                thd->wsrep_TOI_table ? "table level" :
+                (thd->wsrep_NBO ? "non-blocking" : "global"));
 
     THD_STAGE_INFO(thd, stage_wsrep_preparing_for_TO_isolation);
     snprintf(thd->wsrep_info, sizeof(thd->wsrep_info),
@@ -2059,7 +2333,21 @@ static int wsrep_TOI_begin(THD *thd, const char *db_, const char *table_,
     WSREP_DEBUG("%s", thd->wsrep_info);
     thd_proc_info(thd, thd->wsrep_info);
   }
-  else if (key_arr.keys_len > 0) {
+  else if (ret == WSREP_BF_ABORT && thd->wsrep_TOI_table) {
+    /* skip the statement, wsrep_replay_transaction() runs it at the end of
+       the command, see wsrep_table_TOI_replicate() */
+    my_error(ER_LOCK_DEADLOCK, MYF(0), "WSREP replication aborted, the "
+             "statement is replayed.");
+
+    thd->wsrep_TOI_table= false;
+    if (buf) my_free(buf);
+    /* thd->wsrep_gtid_event_buf was free'ed above, just set to NULL */
+    thd->wsrep_gtid_event_buf_len = 0;
+    thd->wsrep_gtid_event_buf     = NULL;
+    wsrep_keys_free(&key_arr);
+    return -1;
+  }
+  else if (!buf_err && key_arr.keys_len > 0) {
     /* jump to error handler in mysql_execute_command() */
     WSREP_WARN("TO isolation failed for: %d, schema: %s, sql: %s. Check wsrep "
                "connection state and retry the query.",
@@ -2069,6 +2357,7 @@ static int wsrep_TOI_begin(THD *thd, const char *db_, const char *table_,
     my_error(ER_LOCK_DEADLOCK, MYF(0), "WSREP replication failed. Check "
              "your wsrep connection state and retry the query.");
 
+    thd->wsrep_TOI_table= false;
     if (buf) my_free(buf);
     /* thd->wsrep_gtid_event_buf was free'ed above, just set to NULL */
     thd->wsrep_gtid_event_buf_len = 0;
@@ -2101,6 +2390,7 @@ static void wsrep_TOI_end(THD *thd)
 {
   wsrep_status_t ret;
   wsrep_to_isolation--;
+  wsrep_table_map_cache_invalidate();
 
 #ifdef SKIP_INNODB_HP
   /* set priority back to normal */
@@ -2114,7 +2404,19 @@ static void wsrep_TOI_end(THD *thd)
   WSREP_DEBUG("%s", thd->wsrep_info);
   thd_proc_info(thd, thd->wsrep_info);
 
-  if (!thd->wsrep_skip_SE_checkpoint) {
+  if (thd->wsrep_NBO && !wsrep_NBO_end(thd)) {
+    WSREP_DEBUG("NBO statement (%s) ended out of total order (%lld)",
+                WSREP_QUERY(thd),
+                (long long)wsrep_thd_trx_seqno(thd));
+    return;
+  }
+
+  if (thd->wsrep_TOI_table) {
+    /* later commits did not wait for the statement */
+    WSREP_DEBUG("Skip SE checkpoint for table level TOI statement (%s) (%lld)",
+                WSREP_QUERY(thd),
+                (long long)wsrep_thd_trx_seqno(thd));
+  } else if (!thd->wsrep_skip_SE_checkpoint) {
     wsrep_set_SE_checkpoint(thd->wsrep_trx_meta.gtid.uuid,
                             thd->wsrep_trx_meta.gtid.seqno);
   } else {
@@ -2123,7 +2425,17 @@ static void wsrep_TOI_end(THD *thd)
                 (long long)wsrep_thd_trx_seqno(thd));
   }
   
-  if (WSREP_OK == (ret = wsrep->to_execute_end(wsrep, (ulong)thd->thread_id()))) {
+  if (thd->wsrep_TOI_table)
+  {
+    ret= wsrep->post_commit(wsrep, &thd->wsrep_ws_handle);
+    thd->wsrep_TOI_table= false;
+  }
+  else
+  {
+    ret= wsrep->to_execute_end(wsrep, (ulong)thd->thread_id());
+  }
+
+  if (WSREP_OK == ret) {
     WSREP_DEBUG("Completed query (%s) replication with write-set (%lld) and"
                 " exec_mode: %s in TO Isolation mode",
                 WSREP_QUERY(thd),
@@ -2210,6 +2522,8 @@ static void wsrep_RSU_end(THD *thd)
   WSREP_DEBUG("Initiating RSU_end for write-set: %lld",
               (long long)wsrep_thd_trx_seqno(thd));
 
+  wsrep_table_map_cache_invalidate();
+
   mysql_mutex_lock(&LOCK_wsrep_replaying);
   wsrep_replaying--;
   mysql_mutex_unlock(&LOCK_wsrep_replaying);
@@ -2248,7 +2562,13 @@ int wsrep_to_isolation_begin(THD *thd, const char *db_, const char *table_,
   /*
     No isolation for applier or replaying threads.
    */
-  if (thd->wsrep_exec_mode == REPL_RECV) return 0;
+  if (thd->wsrep_exec_mode == REPL_RECV)
+  {
+    /* rejected on the originating node as well */
+    if (thd->wsrep_apply_toi && wsrep_NBO_busy(thd, db_, table_, table_list))
+      return -1;
+    return 0;
+  }
 
   /* Generally if node enters non-primary state then execution of DDL+DML
   is blocked on such node but there are some asynchronous pre-register
@@ -2320,7 +2640,10 @@ int wsrep_to_isolation_begin(THD *thd, const char *db_, const char *table_,
   {
     switch (thd->variables.wsrep_OSU_method) {
     case WSREP_OSU_TOI:
-      ret= wsrep_TOI_begin(thd, db_, table_, table_list, alter_info);
+    case WSREP_OSU_TABLE_TOI:
+    case WSREP_OSU_NBO:
+      ret= wsrep_TOI_begin(thd, db_, table_, table_list, alter_info,
+                           thd->variables.wsrep_OSU_method);
       break;
     case WSREP_OSU_RSU:
       ret= wsrep_RSU_begin(thd, db_, table_);
@@ -2332,7 +2655,13 @@ int wsrep_to_isolation_begin(THD *thd, const char *db_, const char *table_,
       break;
     }
     switch (ret) {
-    case 0:  thd->wsrep_exec_mode= TOTAL_ORDER; break;
+    case 0:
+      thd->wsrep_exec_mode= TOTAL_ORDER;
+      /* total order is released at the end of the failed statement */
+      if (thd->variables.wsrep_OSU_method != WSREP_OSU_RSU &&
+          wsrep_NBO_busy(thd, db_, table_, table_list))
+        ret= -1;
+      break;
     case 1:
       /* TOI replication skipped, treat as success */
       ret = 0;
@@ -2351,7 +2680,9 @@ void wsrep_to_isolation_end(THD *thd)
   {
     switch(thd->variables.wsrep_OSU_method)
     {
-    case WSREP_OSU_TOI: wsrep_TOI_end(thd); break;
+    case WSREP_OSU_TOI:
+    case WSREP_OSU_TABLE_TOI:
+    case WSREP_OSU_NBO: wsrep_TOI_end(thd); break;
     case WSREP_OSU_RSU: wsrep_RSU_end(thd); break;
     default:
       WSREP_WARN("Unsupported wsrep OSU method at isolation end: %lu",
@@ -99,8 +99,13 @@ extern my_bool     wsrep_incremental_data_collection;
 extern const char* wsrep_start_position;
 extern ulong       wsrep_max_ws_size;
 extern ulong       wsrep_max_ws_rows;
+extern ulong       wsrep_key_batch_size;
+extern ulong       wsrep_apply_decode_ahead;
+extern ulong       wsrep_dump_log_size;
+extern ulong       wsrep_slave_threads_max;
 extern const char* wsrep_notify_cmd;
 extern my_bool     wsrep_certify_nonPK;
+extern ulong       wsrep_row_digest;
 extern ulong       wsrep_certification_rules;
 extern long        wsrep_max_protocol_version;
 extern long        wsrep_protocol_version;
@@ -110,12 +115,16 @@ extern ulong       wsrep_reject_queries;
 extern my_bool     wsrep_recovery;
 extern my_bool     wsrep_log_conflicts;
 extern my_bool     wsrep_load_data_splitting;
+extern ulong       wsrep_load_data_threads;
 extern my_bool     wsrep_restart_slave;
 extern my_bool     wsrep_restart_slave_activated;
 extern my_bool     wsrep_slave_FK_checks;
 extern my_bool     wsrep_slave_UK_checks;
+extern my_bool     wsrep_slave_prefetch;
+extern my_bool     wsrep_early_conflict_check;
 extern ulong       wsrep_running_threads;
 extern ulong       wsrep_RSU_commit_timeout;
+extern ulong       wsrep_sync_wait_max_staleness;
 
 enum enum_wsrep_reject_types {
   WSREP_REJECT_NONE,    /* nothing rejected */
@@ -126,9 +135,14 @@ enum enum_wsrep_reject_types {
 enum enum_wsrep_OSU_method {
     WSREP_OSU_TOI,
     WSREP_OSU_RSU,
+    WSREP_OSU_TABLE_TOI,
+    WSREP_OSU_NBO,
     WSREP_OSU_NONE,
 };
 
+/* first query of a write-set replicated with WSREP_OSU_TABLE_TOI */
+#define WSREP_TABLE_TOI_MARKER "/* wsrep TABLE_TOI */"
+
 enum enum_wsrep_sync_wait {
     WSREP_SYNC_WAIT_NONE = 0x0,
     // select, begin
@@ -172,6 +186,9 @@ extern const char* wsrep_provider_vendor;
 
 int  wsrep_show_status(THD *thd, SHOW_VAR *var, char *buff);
 int  wsrep_show_ready(THD *thd, SHOW_VAR *var, char *buff);
+int  wsrep_show_sync_wait_cached(THD *thd, SHOW_VAR *var, char *buff);
+int  wsrep_show_sync_wait_batched(THD *thd, SHOW_VAR *var, char *buff);
+int  wsrep_show_sync_wait_avg_time(THD *thd, SHOW_VAR *var, char *buff);
 void wsrep_free_status(THD *thd);
 
 /* Filters out --wsrep-new-cluster oprtion from argv[]
@@ -362,6 +379,13 @@ extern mysql_mutex_t LOCK_wsrep_replaying;
 extern mysql_cond_t  COND_wsrep_replaying;
 extern mysql_mutex_t LOCK_wsrep_slave_threads;
 extern mysql_mutex_t LOCK_wsrep_desync;
+extern mysql_mutex_t LOCK_wsrep_causal;
+extern mysql_cond_t  COND_wsrep_causal;
+extern mysql_mutex_t LOCK_wsrep_NBO;
+extern mysql_cond_t  COND_wsrep_NBO;
+extern mysql_mutex_t LOCK_wsrep_dump;
+extern mysql_cond_t  COND_wsrep_dump;
+extern mysql_mutex_t LOCK_wsrep_pool;
 
 extern wsrep_aborting_thd_t wsrep_aborting_thd;
 extern my_bool       wsrep_emulate_bin_log;
@@ -384,6 +408,22 @@ extern PSI_mutex_key key_LOCK_wsrep_replaying;
 extern PSI_cond_key  key_COND_wsrep_replaying;
 extern PSI_mutex_key key_LOCK_wsrep_slave_threads;
 extern PSI_mutex_key key_LOCK_wsrep_desync;
+extern PSI_mutex_key key_LOCK_wsrep_decoder;
+extern PSI_mutex_key key_LOCK_wsrep_causal;
+extern PSI_cond_key  key_COND_wsrep_causal;
+extern PSI_mutex_key key_LOCK_wsrep_NBO;
+extern PSI_cond_key  key_COND_wsrep_NBO;
+extern PSI_mutex_key key_LOCK_wsrep_dump;
+extern PSI_cond_key  key_COND_wsrep_dump;
+extern PSI_mutex_key key_LOCK_wsrep_pool;
+extern PSI_mutex_key key_LOCK_wsrep_conflict;
+extern PSI_mutex_key key_LOCK_wsrep_conflict_stats;
+extern PSI_mutex_key key_LOCK_wsrep_load_data;
+extern PSI_mutex_key key_LOCK_wsrep_conflict_log;
+extern PSI_mutex_key key_LOCK_wsrep_replay;
+extern PSI_cond_key  key_COND_wsrep_decoder;
+extern PSI_cond_key  key_COND_wsrep_load_data;
+extern PSI_cond_key  key_COND_wsrep_conflict_log;
 
 extern PSI_mutex_key key_LOCK_wsrep_sst_thread;
 extern PSI_cond_key  key_COND_wsrep_sst_thread;
@@ -392,6 +432,11 @@ extern PSI_thread_key key_THREAD_wsrep_sst_joiner;
 extern PSI_thread_key key_THREAD_wsrep_sst_donor;
 extern PSI_thread_key key_THREAD_wsrep_applier;
 extern PSI_thread_key key_THREAD_wsrep_rollbacker;
+extern PSI_thread_key key_THREAD_wsrep_decoder;
+extern PSI_thread_key key_THREAD_wsrep_NBO_worker;
+extern PSI_thread_key key_THREAD_wsrep_dump_writer;
+extern PSI_thread_key key_THREAD_wsrep_load_data;
+extern PSI_thread_key key_THREAD_wsrep_conflict_log;
 #endif /* HAVE_PSI_INTERFACE */
 struct TABLE_LIST;
 class Alter_info;
@@ -414,6 +459,16 @@ bool wsrep_node_is_donor();
 bool wsrep_node_is_synced();
 bool wsrep_replicate_GTID(THD* thd);
 
+/* Spill file of a binlog cache mapped into memory and referenced by a
+   write-set which is being replicated */
+typedef struct wsrep_ws_map
+{
+    void*  ptr;
+    size_t len;
+} wsrep_ws_map_t;
+/* statement cache (CTAS) and transaction cache */
+#define WSREP_MAX_WS_MAPS 2
+
 typedef struct wsrep_key_arr
 {
     wsrep_key_t* keys;
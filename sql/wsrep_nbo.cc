@@ -0,0 +1,606 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_nbo.h"
+#include "wsrep_priv.h"
+#include "wsrep_thd.h"
+#include "wsrep_xid.h"
+#include "sql_class.h"
+#include "sql_alter.h"
+#include "table.h"
+#include "log_event.h"
+#include "rpl_rli.h"
+#include "transaction.h"
+
+#include <new>
+
+/* time to wait between checks for the end of NBO, seconds */
+#define NBO_WAIT_CHECK_INTERVAL 1
+
+class Wsrep_NBO
+{
+public:
+  Wsrep_NBO(const char* db, const char* table)
+    : state(WSREP_NBO_PHASE_ONE), local(false), ev(NULL), claimed(false),
+      end_received(false), commit(false), finished(false), result(0),
+      next(NULL)
+  {
+    strmake(db_, db ? db : "", sizeof(db_) - 1);
+    strmake(table_, table ? table : "", sizeof(table_) - 1);
+    keys.keys= NULL;
+    keys.keys_len= 0;
+    memset(&meta, 0, sizeof(meta));
+  }
+
+  ~Wsrep_NBO()
+  {
+    wsrep_keys_free(&keys);
+    delete ev;
+  }
+
+  bool matches(const char* db, const char* table) const
+  {
+    return !strcmp(db_, db) && !strcmp(table_, table);
+  }
+
+  char                 db_[NAME_LEN + 1];
+  char                 table_[NAME_LEN + 1];
+  enum wsrep_NBO_state state;
+
+  /* originating node only */
+  bool                 local;
+  wsrep_key_arr_t      keys;
+
+  /* protected by LOCK_wsrep_NBO */
+  wsrep_trx_meta_t     meta;         /* of the current total order section */
+  bool                 end_received; /* end has been ordered */
+
+  /* other nodes only, protected by LOCK_wsrep_NBO */
+  Query_log_event*     ev;           /* statement to execute */
+  bool                 claimed;      /* worker has started */
+  bool                 commit;
+  bool                 finished;     /* statement has been executed */
+  int                  result;
+  Wsrep_NBO*           next;
+};
+
+/*
+  operations in progress, protected by LOCK_wsrep_NBO: those applied from
+  the cluster and, until their end is ordered, those started on this node
+*/
+static Wsrep_NBO* nbo_list= NULL;
+
+static void nbo_unlink(Wsrep_NBO* const nbo)
+{
+  mysql_mutex_assert_owner(&LOCK_wsrep_NBO);
+  for (Wsrep_NBO** p= &nbo_list; *p; p= &(*p)->next)
+  {
+    if (*p == nbo)
+    {
+      *p= nbo->next;
+      return;
+    }
+  }
+}
+
+bool wsrep_NBO_eligible(THD* const thd)
+{
+  switch (thd->lex->sql_command)
+  {
+  case SQLCOM_ALTER_TABLE:
+    return !(thd->lex->alter_info.flags &
+             (Alter_info::ALTER_RENAME | Alter_info::ALTER_EXCHANGE_PARTITION));
+  case SQLCOM_CREATE_INDEX:
+  case SQLCOM_DROP_INDEX:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static size_t nbo_marker(const char* const marker, char outcome,
+                         const char* const db, const char* const table,
+                         char* const buf, size_t const buf_len)
+{
+  size_t const marker_len= strlen(marker);
+  size_t const db_len= strlen(db);
+  size_t const table_len= strlen(table);
+  size_t const len= marker_len + 1 + (outcome ? 1 : 0) +
+                    db_len + 1 + table_len;
+
+  if (len > buf_len) return 0;
+
+  char* p= buf;
+  memcpy(p, marker, marker_len + 1);
+  p+= marker_len + 1;
+  if (outcome) *p++= outcome;
+  memcpy(p, db, db_len + 1);
+  p+= db_len + 1;
+  memcpy(p, table, table_len);
+  return len;
+}
+
+/* @return false if query is a well formed marker */
+static bool nbo_parse_marker(const char* const marker, bool const has_outcome,
+                             const char* query, size_t len,
+                             char* const outcome, char* const db,
+                             char* const table)
+{
+  size_t const marker_len= strlen(marker);
+  if (len < marker_len + 1 || memcmp(query, marker, marker_len + 1))
+    return true;
+  query+= marker_len + 1;
+  len-= marker_len + 1;
+
+  if (has_outcome)
+  {
+    if (len < 1) return true;
+    *outcome= *query++;
+    --len;
+  }
+
+  const char* const sep= static_cast<const char*>(memchr(query, '\0', len));
+  if (!sep || size_t(sep - query) > NAME_LEN ||
+      len - (sep - query) - 1 > NAME_LEN)
+    return true;
+
+  memcpy(db, query, sep - query + 1);
+  memcpy(table, sep + 1, len - (sep - query) - 1);
+  table[len - (sep - query) - 1]= '\0';
+  return false;
+}
+
+size_t wsrep_NBO_begin_marker(const char* const db, const char* const table,
+                              char* const buf, size_t const buf_len)
+{
+  return nbo_marker(WSREP_NBO_BEGIN_MARKER, 0, db ? db : "",
+                    table ? table : "", buf, buf_len);
+}
+
+void wsrep_NBO_begin(THD* const thd, const char* const db,
+                     const char* const table, wsrep_key_arr_t* const ka)
+{
+  DBUG_ASSERT(!thd->wsrep_NBO);
+
+  Wsrep_NBO* const nbo= new (std::nothrow) Wsrep_NBO(db, table);
+  if (!nbo)
+  {
+    /* statement stays in total order to the end, like with TOI */
+    WSREP_WARN("Failed to allocate NBO context, running %s in TOI",
+               WSREP_QUERY(thd));
+    wsrep_keys_free(ka);
+    return;
+  }
+
+  nbo->keys= *ka;
+  ka->keys= NULL;
+  ka->keys_len= 0;
+  nbo->local= true;
+  nbo->claimed= true;
+  nbo->meta= thd->wsrep_trx_meta;
+  thd->wsrep_NBO= nbo;
+
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+  nbo->next= nbo_list;
+  nbo_list= nbo;
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+}
+
+static bool nbo_holds(const Wsrep_NBO* const nbo, const char* const db,
+                      const char* const table)
+{
+  if (!db) return false;
+  return table ? nbo->matches(db, table) : !strcmp(nbo->db_, db);
+}
+
+bool wsrep_NBO_busy(THD* const thd, const char* const db,
+                    const char* const table,
+                    const TABLE_LIST* const table_list)
+{
+  wsrep_seqno_t const seqno= wsrep_thd_trx_seqno(thd);
+  const Wsrep_NBO* busy= NULL;
+
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+  for (const Wsrep_NBO* nbo= nbo_list; nbo && !busy; nbo= nbo->next)
+  {
+    /* the statement itself or an operation which is already ending */
+    if (nbo->end_received || nbo->meta.gtid.seqno == seqno) continue;
+
+    if (nbo_holds(nbo, db, table))
+      busy= nbo;
+    for (const TABLE_LIST* tl= table_list; tl && !busy; tl= tl->next_global)
+      if (nbo_holds(nbo, tl->db, tl->table_name))
+        busy= nbo;
+  }
+
+  /*
+    An applier skips the statement without an error: a failed table level
+    TOI write-set would stop the node. A worker must fail the operation,
+    so that it is known not to have been executed at its end.
+  */
+  if (busy && thd->wsrep_exec_mode == REPL_RECV && !thd->wsrep_NBO)
+  {
+    WSREP_INFO("Skipping %s, NBO in progress on %s.%s (%lld)",
+               WSREP_QUERY(thd), busy->db_, busy->table_, (long long)seqno);
+  }
+  else if (busy)
+  {
+    WSREP_DEBUG("Rejecting %s, NBO in progress on %s.%s (%lld)",
+                WSREP_QUERY(thd), busy->db_, busy->table_, (long long)seqno);
+    my_printf_error(ER_LOCK_DEADLOCK, "Table '%s.%s' is being altered by a "
+                    "non-blocking operation, retry the statement", MYF(0),
+                    busy->db_, busy->table_);
+  }
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+
+  return busy != NULL;
+}
+
+enum wsrep_NBO_state wsrep_NBO_get_state(const THD* const thd)
+{
+  return thd->wsrep_NBO ? thd->wsrep_NBO->state : WSREP_NBO_DONE;
+}
+
+/* Replicate end marker in total order on originating node */
+static bool nbo_replicate_end(THD* const thd, Wsrep_NBO* const nbo,
+                              bool const commit)
+{
+  char   marker[sizeof(WSREP_NBO_END_MARKER) + 2 * NAME_LEN + 3];
+  size_t const marker_len= nbo_marker(WSREP_NBO_END_MARKER,
+                                      commit ? 'C' : 'R',
+                                      nbo->db_, nbo->table_,
+                                      marker, sizeof(marker));
+  uchar* buf= NULL;
+  size_t buf_len= 0;
+
+  DBUG_ASSERT(marker_len > 0);
+  DBUG_ASSERT(!thd->wsrep_gtid_event_buf);
+
+  wsrep_status_t ret= WSREP_WARNING;
+  if (!wsrep_to_buf_helper(thd, marker, marker_len, &buf, &buf_len))
+  {
+    struct wsrep_buf buff= { buf, buf_len };
+    ret= wsrep->to_execute_start(wsrep, (ulong)thd->thread_id(),
+                                 nbo->keys.keys, nbo->keys.keys_len,
+                                 &buff, 1, &thd->wsrep_trx_meta);
+  }
+
+  /* buf is owned by gtid event buffer, see wsrep_to_buf_helper() */
+  my_free(thd->wsrep_gtid_event_buf);
+  thd->wsrep_gtid_event_buf_len= 0;
+  thd->wsrep_gtid_event_buf= NULL;
+
+  /* the table is free for other TOI statements from here on */
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+  nbo->end_received= true;
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+
+  if (ret != WSREP_OK)
+  {
+    WSREP_WARN("Failed to replicate NBO end for %s.%s: %d, sql: %s",
+               nbo->db_, nbo->table_, ret, WSREP_QUERY(thd));
+    nbo->state= WSREP_NBO_DONE;
+    return true;
+  }
+
+  WSREP_DEBUG("NBO end for %s.%s replicated with write-set (%lld)",
+              nbo->db_, nbo->table_, (long long)wsrep_thd_trx_seqno(thd));
+  nbo->state= WSREP_NBO_PHASE_TWO;
+  return false;
+}
+
+bool wsrep_NBO_end(THD* const thd)
+{
+  Wsrep_NBO* const nbo= thd->wsrep_NBO;
+  DBUG_ASSERT(nbo);
+  thd->wsrep_NBO= NULL;
+
+  bool in_total_order= true;
+
+  switch (nbo->state)
+  {
+  case WSREP_NBO_PHASE_ONE:
+    /*
+      Statement did not leave the first section, e.g. it was not executed
+      in place or failed early. Other nodes may have, so they still
+      have to be told how the operation ended.
+    */
+    if (wsrep->to_execute_end(wsrep, (ulong)thd->thread_id()))
+    {
+      WSREP_WARN("TO isolation end failed for NBO: %s", WSREP_QUERY(thd));
+    }
+    in_total_order= !nbo_replicate_end(thd, nbo, !thd->is_error());
+    break;
+  case WSREP_NBO_RUNNING:
+    in_total_order= !nbo_replicate_end(thd, nbo, false);
+    break;
+  case WSREP_NBO_PHASE_TWO:
+    break;
+  case WSREP_NBO_DONE:
+    in_total_order= false;
+    break;
+  }
+
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+  nbo_unlink(nbo);
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+
+  delete nbo;
+  return in_total_order;
+}
+
+void wsrep_NBO_phase_one_end(THD* const thd)
+{
+  Wsrep_NBO* const nbo= thd->wsrep_NBO;
+  if (!nbo || nbo->state != WSREP_NBO_PHASE_ONE) return;
+
+  if (thd->wsrep_exec_mode == TOTAL_ORDER)
+  {
+    wsrep_set_SE_checkpoint(thd->wsrep_trx_meta.gtid.uuid,
+                            thd->wsrep_trx_meta.gtid.seqno);
+    if (wsrep->to_execute_end(wsrep, (ulong)thd->thread_id()))
+    {
+      WSREP_WARN("TO isolation end failed for NBO: %s", WSREP_QUERY(thd));
+    }
+    nbo->state= WSREP_NBO_RUNNING;
+    WSREP_DEBUG("NBO on %s.%s left total order (%lld)",
+                nbo->db_, nbo->table_, (long long)wsrep_thd_trx_seqno(thd));
+  }
+  else
+  {
+    mysql_mutex_lock(&LOCK_wsrep_NBO);
+    nbo->state= WSREP_NBO_RUNNING;
+    mysql_cond_broadcast(&COND_wsrep_NBO);
+    mysql_mutex_unlock(&LOCK_wsrep_NBO);
+  }
+}
+
+bool wsrep_NBO_phase_two_begin(THD* const thd, bool const commit)
+{
+  Wsrep_NBO* const nbo= thd->wsrep_NBO;
+  if (!nbo || nbo->state != WSREP_NBO_RUNNING) return false;
+
+  if (thd->wsrep_exec_mode == TOTAL_ORDER)
+  {
+    if (nbo_replicate_end(thd, nbo, commit))
+    {
+      if (commit)
+        my_error(ER_LOCK_DEADLOCK, MYF(0), "WSREP replication failed. Check "
+                 "your wsrep connection state and retry the query.");
+      return true;
+    }
+    return !commit;
+  }
+
+  snprintf(thd->wsrep_info, sizeof(thd->wsrep_info),
+           "wsrep: waiting for NBO end on %s.%s", nbo->db_, nbo->table_);
+  thd_proc_info(thd, thd->wsrep_info);
+
+  /* the end is not delivered any more once the provider disconnected */
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+  while (!nbo->end_received && !thd->killed && wsrep_connected)
+  {
+    struct timespec abstime;
+    set_timespec(&abstime, NBO_WAIT_CHECK_INTERVAL);
+    mysql_cond_timedwait(&COND_wsrep_NBO, &LOCK_wsrep_NBO, &abstime);
+  }
+
+  bool rollback;
+  if (nbo->end_received)
+  {
+    thd->wsrep_trx_meta= nbo->meta;
+    nbo->state= WSREP_NBO_PHASE_TWO;
+    rollback= !nbo->commit;
+  }
+  else
+  {
+    WSREP_WARN("NBO worker %s while waiting for end of %s.%s",
+               thd->killed ? "killed" : "disconnected",
+               nbo->db_, nbo->table_);
+    nbo->state= WSREP_NBO_DONE;
+    rollback= true;
+  }
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+
+  return rollback || !commit;
+}
+
+bool wsrep_NBO_is_begin(const Query_log_event* const ev)
+{
+  size_t const len= sizeof(WSREP_NBO_BEGIN_MARKER);
+  return ev->q_len > len && !memcmp(ev->query, WSREP_NBO_BEGIN_MARKER, len);
+}
+
+bool wsrep_NBO_is_end(const Query_log_event* const ev)
+{
+  size_t const len= sizeof(WSREP_NBO_END_MARKER);
+  return ev->q_len > len && !memcmp(ev->query, WSREP_NBO_END_MARKER, len);
+}
+
+int wsrep_NBO_apply_begin(THD* const thd, const Query_log_event* const marker,
+                          Query_log_event* const ev)
+{
+  char db[NAME_LEN + 1];
+  char table[NAME_LEN + 1];
+
+  if (nbo_parse_marker(WSREP_NBO_BEGIN_MARKER, false, marker->query,
+                       marker->q_len, NULL, db, table))
+  {
+    WSREP_WARN("Malformed NBO begin marker in write-set (%lld)",
+               (long long)wsrep_thd_trx_seqno(thd));
+    return -1;
+  }
+
+  Wsrep_NBO* const nbo= new (std::nothrow) Wsrep_NBO(db, table);
+  if (!nbo) return -1;
+
+  nbo->ev= ev;
+  nbo->meta= thd->wsrep_trx_meta;
+
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+  nbo->next= nbo_list;
+  nbo_list= nbo;
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+
+  if (wsrep_create_NBO_worker())
+  {
+    WSREP_WARN("Could not start NBO worker, applying %s.%s in TOI",
+               db, table);
+    /* keep the operation for its end marker, the applier reports
+       the result of the statement */
+    mysql_mutex_lock(&LOCK_wsrep_NBO);
+    nbo->ev= NULL;
+    nbo->claimed= true;
+    nbo->finished= true;
+    mysql_mutex_unlock(&LOCK_wsrep_NBO);
+    return -1;
+  }
+
+  WSREP_DEBUG("NBO on %s.%s handed over to worker (%lld)",
+              db, table, (long long)wsrep_thd_trx_seqno(thd));
+
+  int result= 0;
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+  while (nbo->state == WSREP_NBO_PHASE_ONE && !nbo->finished)
+    mysql_cond_wait(&COND_wsrep_NBO, &LOCK_wsrep_NBO);
+
+  /* if the statement was not executed as NBO on this node, the operation
+     stays listed until its end marker */
+  if (nbo->finished)
+    result= nbo->result;
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+
+  return result;
+}
+
+int wsrep_NBO_apply_end(THD* const thd, const Query_log_event* const marker)
+{
+  char outcome;
+  char db[NAME_LEN + 1];
+  char table[NAME_LEN + 1];
+
+  if (nbo_parse_marker(WSREP_NBO_END_MARKER, true, marker->query,
+                       marker->q_len, &outcome, db, table))
+  {
+    WSREP_ERROR("Malformed NBO end marker in write-set (%lld)",
+                (long long)wsrep_thd_trx_seqno(thd));
+    return 1;
+  }
+
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+
+  Wsrep_NBO* nbo= nbo_list;
+  while (nbo && (nbo->local || nbo->end_received || !nbo->matches(db, table)))
+    nbo= nbo->next;
+
+  if (!nbo)
+  {
+    /* the operation never started here, the table would be left
+       without the change the cluster committed */
+    mysql_mutex_unlock(&LOCK_wsrep_NBO);
+    WSREP_ERROR("No NBO in progress on %s.%s to %s, write-set (%lld)",
+                db, table, outcome == 'C' ? "commit" : "roll back",
+                (long long)wsrep_thd_trx_seqno(thd));
+    return 1;
+  }
+
+  /* statement was executed in the first section on this node */
+  bool const in_place= nbo->finished;
+
+  nbo->meta= thd->wsrep_trx_meta;
+  nbo->commit= (outcome == 'C');
+  nbo->end_received= true;
+  mysql_cond_broadcast(&COND_wsrep_NBO);
+
+  while (!nbo->finished)
+    mysql_cond_wait(&COND_wsrep_NBO, &LOCK_wsrep_NBO);
+
+  int result= nbo->commit ? nbo->result : 0;
+  if (in_place && !nbo->commit && !nbo->result)
+  {
+    WSREP_ERROR("NBO on %s.%s was rolled back on the originating node "
+                "but committed here, write-set (%lld)", db, table,
+                (long long)wsrep_thd_trx_seqno(thd));
+    result= 1;
+  }
+  nbo_unlink(nbo);
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+
+  WSREP_DEBUG("NBO on %s.%s %s: %d (%lld)", db, table,
+              outcome == 'C' ? "committed" : "rolled back", result,
+              (long long)wsrep_thd_trx_seqno(thd));
+  delete nbo;
+  return result;
+}
+
+void wsrep_NBO_worker(THD* const thd)
+{
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+  Wsrep_NBO* nbo= nbo_list;
+  while (nbo && nbo->claimed) nbo= nbo->next;
+  if (nbo) nbo->claimed= true;
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+
+  if (!nbo) return;
+
+  Query_log_event* const ev= nbo->ev;
+
+  thd->wsrep_NBO= nbo;
+  thd->wsrep_trx_meta= nbo->meta;
+  thd->wsrep_apply_toi= true;
+  thd->variables.option_bits&= ~OPTION_BEGIN;
+  thd->server_status&= ~SERVER_STATUS_IN_TRANS;
+
+  snprintf(thd->wsrep_info, sizeof(thd->wsrep_info),
+           "wsrep: applying NBO on %s.%s (%lld)", nbo->db_, nbo->table_,
+           (long long)wsrep_thd_trx_seqno(thd));
+  WSREP_DEBUG("%s", thd->wsrep_info);
+  thd_proc_info(thd, thd->wsrep_info);
+
+  thd->server_id= ev->server_id;
+  thd->unmasked_server_id= ev->common_header->unmasked_server_id;
+  thd->set_time();
+  wsrep_xid_init(thd->get_transaction()->xid_state()->get_xid(),
+                 thd->wsrep_trx_meta.gtid.uuid,
+                 thd->wsrep_trx_meta.gtid.seqno);
+  thd->lex->set_current_select(NULL);
+  ev->thd= thd;
+
+  int rcode= ev->apply_event(thd->wsrep_rli);
+  if (rcode)
+  {
+    WSREP_WARN("NBO on %s.%s failed to apply: %d, %lld", nbo->db_,
+               nbo->table_, rcode, (long long)wsrep_thd_trx_seqno(thd));
+    trans_rollback_stmt(thd);
+    trans_rollback(thd);
+  }
+  else if (trans_commit_stmt(thd) || trans_commit(thd))
+  {
+    rcode= 1;
+  }
+  thd->wsrep_rli->cleanup_context(thd, rcode != 0);
+  thd->mdl_context.release_transactional_locks();
+
+  thd->wsrep_NBO= NULL;
+  thd->wsrep_apply_toi= false;
+
+  mysql_mutex_lock(&LOCK_wsrep_NBO);
+  delete nbo->ev;
+  nbo->ev= NULL;
+  nbo->result= rcode;
+  nbo->finished= true;
+  mysql_cond_broadcast(&COND_wsrep_NBO);
+  mysql_mutex_unlock(&LOCK_wsrep_NBO);
+}
@@ -0,0 +1,128 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_NBO_H
+#define WSREP_NBO_H
+
+/*
+  Non-blocking schema upgrade (wsrep_OSU_method=NBO).
+
+  An online in-place ALTER TABLE is replicated in two short total order
+  sections instead of one which lasts for the whole statement:
+
+  1. The statement is replicated in TOI, preceded by a begin marker. Every
+     node starts the ALTER and stays in total order only until the storage
+     engine has prepared the operation and the metadata lock is downgraded
+     (InnoDB starts logging concurrent DML into row_log by then).
+
+  2. The main phase runs outside of total order, concurrently with the
+     replicated DML on the table. When it is done on the originating node,
+     an end marker is replicated in TOI and every node upgrades the
+     metadata lock and commits the new table definition in that section.
+
+  On other nodes the statement is executed by a dedicated worker thread,
+  so that the applier which delivered the begin marker is released as
+  soon as the ALTER leaves the first total order section.
+*/
+
+#include "wsrep_mysqld.h"
+
+class THD;
+class Query_log_event;
+class Wsrep_NBO;
+struct TABLE_LIST;
+
+#define WSREP_NBO_BEGIN_MARKER "/* wsrep NBO begin */"
+#define WSREP_NBO_END_MARKER   "/* wsrep NBO end */"
+
+enum wsrep_NBO_state {
+  WSREP_NBO_PHASE_ONE, /* in total order, preparing the operation */
+  WSREP_NBO_RUNNING,   /* out of total order, main phase */
+  WSREP_NBO_PHASE_TWO, /* in total order, committing the operation */
+  WSREP_NBO_DONE       /* out of total order, operation ended */
+};
+
+/* Statements that can run as NBO */
+bool wsrep_NBO_eligible(THD* thd);
+
+/*
+  Marker query replicated in front of the statement:
+  WSREP_NBO_BEGIN_MARKER, '\0', db, '\0', table.
+  @return marker length, 0 if it did not fit
+*/
+size_t wsrep_NBO_begin_marker(const char* db, const char* table,
+                              char* buf, size_t buf_len);
+
+/*
+  Start NBO on originating node after the statement has been replicated
+  in total order. Takes ownership of the isolation keys.
+*/
+void wsrep_NBO_begin(THD* thd, const char* db, const char* table,
+                     wsrep_key_arr_t* ka);
+
+/*
+  Finish NBO on originating node at the end of the statement.
+  @return true if total order is still held by the statement
+*/
+bool wsrep_NBO_end(THD* thd);
+
+enum wsrep_NBO_state wsrep_NBO_get_state(const THD* thd);
+
+/*
+  Until its end is ordered, an operation keeps the table locked on every
+  node, while the ordinary TOI statements which follow it in total order
+  would be granted the lock as BF. Such statements are rejected instead,
+  at the same position of total order everywhere.
+  @return true if an operation other than that of the statement is in
+          progress on one of the tables, the error is set unless an
+          applier is to skip the statement
+*/
+bool wsrep_NBO_busy(THD* thd, const char* db, const char* table,
+                    const TABLE_LIST* table_list);
+
+/* Called by in-place ALTER TABLE once the engine prepared the operation and
+   the metadata lock has been downgraded */
+void wsrep_NBO_phase_one_end(THD* thd);
+
+/*
+  Called by in-place ALTER TABLE before it upgrades the metadata lock to
+  commit (commit == true) or roll back (commit == false) the operation.
+  @return true if the operation must be rolled back
+*/
+bool wsrep_NBO_phase_two_begin(THD* thd, bool commit);
+
+/* Applier side */
+bool wsrep_NBO_is_begin(const Query_log_event* ev);
+bool wsrep_NBO_is_end(const Query_log_event* ev);
+
+/*
+  Hand the statement which follows a begin marker over to a worker thread
+  and wait until it leaves the first total order section.
+  Takes ownership of ev unless the worker could not be started.
+  @return -1 if the statement must be applied in place, otherwise
+          the result of the first phase
+*/
+int  wsrep_NBO_apply_begin(THD* thd, const Query_log_event* marker,
+                           Query_log_event* ev);
+
+/* Let the worker of the operation commit or roll back and wait for it.
+   @return result of the operation, non-zero also if the marker is
+           malformed or the operation was not started on this node */
+int  wsrep_NBO_apply_end(THD* thd, const Query_log_event* marker);
+
+/* Body of the worker thread */
+void wsrep_NBO_worker(THD* thd);
+
+#endif /* WSREP_NBO_H */
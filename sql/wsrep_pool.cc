@@ -0,0 +1,310 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_pool.h"
+#include "wsrep_mysqld.h"
+#include "wsrep_thd.h"
+#include "sql_class.h"
+#include "my_atomic.h"
+
+#include <algorithm>
+
+struct wsrep_applier_stats
+{
+  wsrep_applier_stats* next; /* protected by LOCK_wsrep_pool */
+  my_thread_id         thread_id;
+  /* written by the owner thread only, read by anyone */
+  int32                state;
+  long long            mark;  /* start of current state */
+  long long            busy_time;
+  long long            idle_time;
+  long long            commit_wait_time;
+  long long            applied;
+};
+
+/* registered appliers, protected by LOCK_wsrep_pool */
+static wsrep_applier_stats* pool_head     = NULL;
+static ulong                pool_appliers = 0;
+
+/* totals of all appliers since startup */
+static long long pool_busy_total        = 0;
+static long long pool_idle_total        = 0;
+static long long pool_commit_wait_total = 0;
+
+/* totals at the last adjustment, protected by LOCK_wsrep_pool */
+static long long pool_busy_last        = 0;
+static long long pool_idle_last        = 0;
+static long long pool_commit_wait_last = 0;
+
+/* dependency distance of write-sets applied since the last adjustment */
+static long long pool_dist_sum   = 0;
+static long long pool_dist_count = 0;
+
+static long long pool_last_adjust = 0;
+
+/* value exported to SHOW STATUS */
+static long wsrep_applier_threads = 0;
+
+/* Close the current state of the applier and enter a new one */
+static void wsrep_pool_account(wsrep_applier_stats* const s,
+                               wsrep_applier_state const new_state)
+{
+  long long const now= my_micro_time();
+  long long const elapsed= now - s->mark;
+
+  switch (s->state)
+  {
+  case WSREP_APPLIER_IDLE:
+    my_atomic_add64(&s->idle_time, elapsed);
+    my_atomic_add64(&pool_idle_total, elapsed);
+    break;
+  case WSREP_APPLIER_BUSY:
+    my_atomic_add64(&s->busy_time, elapsed);
+    my_atomic_add64(&pool_busy_total, elapsed);
+    break;
+  case WSREP_APPLIER_COMMIT_WAIT:
+    my_atomic_add64(&s->commit_wait_time, elapsed);
+    my_atomic_add64(&pool_commit_wait_total, elapsed);
+    break;
+  }
+
+  my_atomic_store64(&s->mark, now);
+  my_atomic_store32(&s->state, new_state);
+}
+
+void wsrep_pool_applier_start(THD* const thd)
+{
+  wsrep_applier_stats* const s= static_cast<wsrep_applier_stats*>(
+    my_malloc(key_memory_wsrep, sizeof(wsrep_applier_stats),
+              MYF(MY_ZEROFILL)));
+  if (!s)
+  {
+    WSREP_WARN("Failed to allocate applier statistics, thd: %u",
+               thd->thread_id());
+    return;
+  }
+
+  s->thread_id= thd->thread_id();
+  s->state= WSREP_APPLIER_IDLE;
+  s->mark= my_micro_time();
+
+  mysql_mutex_lock(&LOCK_wsrep_pool);
+  s->next= pool_head;
+  pool_head= s;
+  ++pool_appliers;
+  mysql_mutex_unlock(&LOCK_wsrep_pool);
+
+  thd->wsrep_applier_stats= s;
+}
+
+void wsrep_pool_applier_end(THD* const thd)
+{
+  wsrep_applier_stats* const s= thd->wsrep_applier_stats;
+  if (!s) return;
+
+  mysql_mutex_lock(&LOCK_wsrep_pool);
+  for (wsrep_applier_stats** p= &pool_head; *p; p= &(*p)->next)
+  {
+    if (*p == s)
+    {
+      *p= s->next;
+      break;
+    }
+  }
+  --pool_appliers;
+  mysql_mutex_unlock(&LOCK_wsrep_pool);
+
+  thd->wsrep_applier_stats= NULL;
+  my_free(s);
+}
+
+void wsrep_pool_apply_begin(THD* const thd, const wsrep_trx_meta_t* const meta)
+{
+  wsrep_applier_stats* const s= thd->wsrep_applier_stats;
+  if (!s) return;
+
+  wsrep_pool_account(s, WSREP_APPLIER_BUSY);
+
+  if (meta->depends_on >= 0 && meta->gtid.seqno > meta->depends_on)
+  {
+    my_atomic_add64(&pool_dist_sum, meta->gtid.seqno - meta->depends_on);
+    my_atomic_add64(&pool_dist_count, 1);
+  }
+}
+
+void wsrep_pool_enter_commit_order(THD* const thd)
+{
+  wsrep_applier_stats* const s= thd->wsrep_applier_stats;
+
+  if (s) wsrep_pool_account(s, WSREP_APPLIER_COMMIT_WAIT);
+  wsrep->applier_pre_commit(wsrep, thd->wsrep_ws_handle.opaque);
+  if (s) wsrep_pool_account(s, WSREP_APPLIER_BUSY);
+}
+
+static long long wsrep_pool_recv_queue()
+{
+  long long len= 0;
+  struct wsrep_stats_var* const stats= wsrep->stats_get(wsrep);
+
+  for (struct wsrep_stats_var* v= stats; v && v->name; ++v)
+  {
+    if (v->type == WSREP_VAR_INT64 && !strcmp(v->name, "local_recv_queue"))
+    {
+      len= v->value._int64;
+      break;
+    }
+  }
+
+  if (stats) wsrep->stats_free(wsrep, stats);
+  return len;
+}
+
+/*
+  Decide the pool size from what was observed since the last adjustment.
+  Growing is allowed to double the pool at once, shrinking goes one thread
+  at a time, so that a short lull does not tear down the pool.
+*/
+static void wsrep_pool_adjust(wsrep_bool_t* const exit)
+{
+  ulong const pool_min= static_cast<ulong>(wsrep_slave_threads);
+  ulong const pool_max= wsrep_slave_threads_max;
+  if (pool_max <= pool_min) return;
+
+  long long const now= my_micro_time();
+  long long last= my_atomic_load64(&pool_last_adjust);
+  if (now < last + (long long)WSREP_POOL_ADJUST_INTERVAL ||
+      !my_atomic_cas64(&pool_last_adjust, &last, now))
+    return;
+
+  long long const recv_queue= wsrep_pool_recv_queue();
+
+  mysql_mutex_lock(&LOCK_wsrep_pool);
+  long long const busy_total= my_atomic_load64(&pool_busy_total);
+  long long const idle_total= my_atomic_load64(&pool_idle_total);
+  long long const wait_total= my_atomic_load64(&pool_commit_wait_total);
+  long long const busy= busy_total - pool_busy_last;
+  long long const idle= idle_total - pool_idle_last;
+  long long const wait= wait_total - pool_commit_wait_last;
+  pool_busy_last= busy_total;
+  pool_idle_last= idle_total;
+  pool_commit_wait_last= wait_total;
+
+  long long const dist_sum= my_atomic_load64(&pool_dist_sum);
+  long long const dist_count= my_atomic_load64(&pool_dist_count);
+  my_atomic_add64(&pool_dist_sum, -dist_sum);
+  my_atomic_add64(&pool_dist_count, -dist_count);
+
+  ulong const size= pool_appliers;
+  mysql_mutex_unlock(&LOCK_wsrep_pool);
+
+  long long const total= busy + idle + wait;
+  if (total <= 0 || size == 0) return;
+
+  double const idle_ratio= double(idle) / total;
+  double const wait_ratio= double(wait) / total;
+  double const dist= dist_count ? double(dist_sum) / dist_count : 0;
+
+  ulong target= size;
+  if (recv_queue > (long long)size && dist > size &&
+      idle_ratio < 0.1 && wait_ratio < 0.5)
+  {
+    /* backlog which more appliers can take in parallel */
+    ulong const wanted= static_cast<ulong>(dist + 0.5);
+    target= std::min(std::min(wanted, size * 2), pool_max);
+  }
+  else if (size > pool_max || idle_ratio > 0.5 ||
+           (recv_queue == 0 && dist < size - 1))
+  {
+    target= size - 1;
+  }
+
+  target= std::max(target, pool_min);
+  if (target == size) return;
+
+  mysql_mutex_lock(&LOCK_wsrep_slave_threads);
+  /* leave the pool alone while wsrep_slave_threads change is in progress */
+  if (wsrep_slave_count_change == 0)
+  {
+    WSREP_DEBUG("Resizing applier pool %lu -> %lu: recv queue %lld, "
+                "dependency distance %.1f, idle %.2f, commit wait %.2f",
+                size, target, recv_queue, dist, idle_ratio, wait_ratio);
+    if (target > size)
+      wsrep_create_appliers(target - size);
+    else if (exit)
+      *exit= true;
+  }
+  mysql_mutex_unlock(&LOCK_wsrep_slave_threads);
+}
+
+void wsrep_pool_apply_end(THD* const thd, wsrep_bool_t* const exit)
+{
+  wsrep_applier_stats* const s= thd->wsrep_applier_stats;
+  if (!s) return;
+
+  wsrep_pool_account(s, WSREP_APPLIER_IDLE);
+  my_atomic_add64(&s->applied, 1);
+
+  if (exit && *exit) return;
+
+  wsrep_pool_adjust(exit);
+}
+
+size_t wsrep_pool_applier_stats(wsrep_applier_stats_row* const rows,
+                                size_t const max_rows)
+{
+  long long const now= my_micro_time();
+  size_t n= 0;
+
+  mysql_mutex_lock(&LOCK_wsrep_pool);
+  for (wsrep_applier_stats* s= pool_head; s && n < max_rows; s= s->next, ++n)
+  {
+    wsrep_applier_stats_row& row= rows[n];
+    row.thread_id= s->thread_id;
+    row.state= static_cast<wsrep_applier_state>(my_atomic_load32(&s->state));
+    row.busy_time= my_atomic_load64(&s->busy_time);
+    row.idle_time= my_atomic_load64(&s->idle_time);
+    row.commit_wait_time= my_atomic_load64(&s->commit_wait_time);
+    row.applied= my_atomic_load64(&s->applied);
+
+    /* include the part of the current state elapsed so far */
+    long long const mark= my_atomic_load64(&s->mark);
+    ulonglong const elapsed= now > mark ? now - mark : 0;
+    switch (row.state)
+    {
+    case WSREP_APPLIER_IDLE:        row.idle_time+= elapsed;        break;
+    case WSREP_APPLIER_BUSY:        row.busy_time+= elapsed;        break;
+    case WSREP_APPLIER_COMMIT_WAIT: row.commit_wait_time+= elapsed; break;
+    }
+  }
+  mysql_mutex_unlock(&LOCK_wsrep_pool);
+
+  return n;
+}
+
+ulong wsrep_pool_size()
+{
+  mysql_mutex_lock(&LOCK_wsrep_pool);
+  ulong const size= pool_appliers;
+  mysql_mutex_unlock(&LOCK_wsrep_pool);
+  return size;
+}
+
+int wsrep_show_applier_threads(THD* thd, SHOW_VAR* var, char* buff)
+{
+  wsrep_applier_threads= wsrep_pool_size();
+  var->type= SHOW_LONG;
+  var->value= (char*)&wsrep_applier_threads;
+  return 0;
+}
@@ -0,0 +1,95 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_POOL_H
+#define WSREP_POOL_H
+
+/*
+  Applier thread accounting and adaptive applier pool.
+
+  Every applier thread accounts the time it spends waiting for write-sets
+  (idle), applying and committing them (busy) and waiting for its turn to
+  commit (commit order wait). The totals are shown per applier in
+  performance_schema.pxc_applier_threads.
+
+  If wsrep_slave_threads_max is greater than wsrep_slave_threads, the pool
+  is resized between the two bounds at most once per
+  WSREP_POOL_ADJUST_INTERVAL by the applier which commits first after the
+  interval has elapsed:
+
+  - it grows towards the average certification dependency distance while
+    write-sets queue up in the receive queue and appliers are mostly busy
+    applying rather than waiting for commit order,
+  - it shrinks by one thread while appliers are mostly idle, or there is
+    no backlog and write-sets can not be applied in parallel by as many.
+*/
+
+#include "my_global.h"
+#include "my_thread_local.h"
+#include "wsrep_api.h"
+
+class THD;
+typedef struct st_mysql_show_var SHOW_VAR;
+
+/* microseconds */
+#define WSREP_POOL_ADJUST_INTERVAL 1000000ULL
+
+enum wsrep_applier_state {
+  WSREP_APPLIER_IDLE,        /* waiting for a write-set */
+  WSREP_APPLIER_BUSY,        /* applying or committing a write-set */
+  WSREP_APPLIER_COMMIT_WAIT  /* waiting for commit order */
+};
+
+/* Snapshot of one applier thread accounting, times in microseconds */
+struct wsrep_applier_stats_row
+{
+  my_thread_id             thread_id;
+  enum wsrep_applier_state state;
+  ulonglong                busy_time;
+  ulonglong                idle_time;
+  ulonglong                commit_wait_time;
+  ulonglong                applied;
+};
+
+/* Register applier thread before it starts receiving write-sets */
+void wsrep_pool_applier_start(THD* thd);
+void wsrep_pool_applier_end(THD* thd);
+
+/* Write-set delivered to the applier */
+void wsrep_pool_apply_begin(THD* thd, const wsrep_trx_meta_t* meta);
+
+/* Enter commit order of applied write-set, accounts for the wait */
+void wsrep_pool_enter_commit_order(THD* thd);
+
+/*
+  Write-set committed or rolled back by the applier. Resizes the pool
+  if it is due.
+  @param exit  set to true if the applier should exit to shrink the pool
+*/
+void wsrep_pool_apply_end(THD* thd, wsrep_bool_t* exit);
+
+/*
+  Copy accounting of at most max_rows applier threads to rows.
+  @return number of rows copied
+*/
+size_t wsrep_pool_applier_stats(wsrep_applier_stats_row* rows,
+                                size_t max_rows);
+
+/* Number of registered applier threads */
+ulong wsrep_pool_size();
+
+int  wsrep_show_applier_threads(THD* thd, SHOW_VAR* var, char* buff);
+
+#endif /* WSREP_POOL_H */
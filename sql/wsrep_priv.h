@@ -45,6 +45,13 @@ void wsrep_sst_received(wsrep_t*, const wsrep_uuid_t&, wsrep_seqno_t,
                         const void*, size_t);
 /*! SST thread signals init thread about sst completion */
 void wsrep_sst_complete(const wsrep_uuid_t*, wsrep_seqno_t, bool);
+/*! Parse "uuid:seqno" reported by SST */
+int sst_scan_uuid_seqno(const char* str, wsrep_uuid_t* uuid,
+                        wsrep_seqno_t* seqno);
+/*! Run SQL statement on behalf of SST donor */
+int run_sql_command(THD* thd, const char* query);
+/*! FLUSH TABLES WITH READ LOCK, sets wsrep_locked_seqno */
+int sst_flush_tables(THD* thd);
 
 void wsrep_notify_status (wsrep_member_status_t new_status,
                           const wsrep_view_info_t* view = 0);
@@ -0,0 +1,163 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_row_digest.h"
+#include "my_md5.h"
+#include "my_byteorder.h"
+
+#define ROW_DIGEST_SEED_LO 0ULL
+#define ROW_DIGEST_SEED_HI 0x9E3779B97F4A7C15ULL
+
+namespace wsp {
+
+row_digest::row_digest(ulong const algorithm)
+  : algorithm_(algorithm), md5_(NULL), n_flags_(0),
+    run_start_(NULL), run_end_(NULL), run_fields_(0)
+{
+  if (algorithm_ == WSREP_ROW_DIGEST_MD5)
+  {
+    md5_= wsrep_md5_init();
+  }
+  else
+  {
+    XXH64_reset(&lane_[0], ROW_DIGEST_SEED_LO);
+    XXH64_reset(&lane_[1], ROW_DIGEST_SEED_HI);
+  }
+}
+
+row_digest::~row_digest()
+{
+  /* final() releases MD5 context, this is for digests never finalized */
+  if (md5_)
+  {
+    uchar unused[WSREP_ROW_DIGEST_LEN];
+    wsrep_compute_md5_hash((char*)unused, md5_);
+  }
+}
+
+void row_digest::update(const void* const ptr, size_t const len)
+{
+  XXH64_update(&lane_[0], ptr, len);
+  XXH64_update(&lane_[1], ptr, len);
+}
+
+void row_digest::add_flag(uchar const flag)
+{
+  if (n_flags_ == sizeof(flags_))
+  {
+    update(flags_, n_flags_);
+    n_flags_= 0;
+  }
+  flags_[n_flags_++]= flag;
+}
+
+void row_digest::update_field(const void* const ptr, size_t const len)
+{
+  if (algorithm_ == WSREP_ROW_DIGEST_MD5)
+  {
+    /* must stay byte compatible with the original row hash */
+    char null_byte= 0;
+    char true_byte= 1;
+
+    if (!ptr)
+    {
+      wsrep_md5_update(md5_, &null_byte, 1);
+    }
+    else
+    {
+      wsrep_md5_update(md5_, &true_byte, 1);
+      wsrep_md5_update(md5_, (char*)ptr, static_cast<int>(len));
+    }
+    return;
+  }
+
+  if (!ptr)
+  {
+    add_flag(0);
+    return;
+  }
+
+  /* variable length values are prefixed with their length, so that
+     adjacent values can not be confused */
+  uchar len_buf[4];
+  int4store(len_buf, static_cast<uint32>(len));
+  add_flag(1);
+  update(len_buf, sizeof(len_buf));
+  update(ptr, len);
+}
+
+void row_digest::update_run()
+{
+  DBUG_ASSERT(algorithm_ == WSREP_ROW_DIGEST_XXHASH);
+
+  for (uint i= 0; i < run_fields_; ++i) add_flag(1);
+  update(run_start_, run_end_ - run_start_);
+  run_fields_= 0;
+}
+
+void row_digest::add_field(const void* const ptr, size_t const len,
+                           bool const fixed)
+{
+  if (algorithm_ == WSREP_ROW_DIGEST_MD5)
+  {
+    update_field(ptr, len);
+    return;
+  }
+
+  const uchar* const value= static_cast<const uchar*>(ptr);
+
+  if (fixed && value)
+  {
+    /* extend the current run if the value is adjacent to it, record
+       format stores fields in order */
+    if (run_fields_ > 0 && value == run_end_)
+    {
+      run_end_+= len;
+      run_fields_++;
+      return;
+    }
+
+    if (run_fields_ > 0) update_run();
+
+    run_start_= value;
+    run_end_= value + len;
+    run_fields_= 1;
+    return;
+  }
+
+  if (run_fields_ > 0) update_run();
+
+  update_field(ptr, len);
+}
+
+void row_digest::final(uchar* const digest)
+{
+  if (algorithm_ == WSREP_ROW_DIGEST_MD5)
+  {
+    wsrep_compute_md5_hash((char*)digest, md5_);
+    md5_= NULL;
+    return;
+  }
+
+  if (run_fields_ > 0) update_run();
+
+  if (n_flags_) update(flags_, n_flags_);
+  n_flags_= 0;
+
+  int8store(digest,     XXH64_digest(&lane_[0]));
+  int8store(digest + 8, XXH64_digest(&lane_[1]));
+}
+
+} /* namespace wsp */
@@ -0,0 +1,98 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_ROW_DIGEST_H
+#define WSREP_ROW_DIGEST_H
+
+#include "my_global.h"
+#include "../extra/lz4/my_xxhash.h"
+
+/*
+  Algorithms for the digest which identifies a row of a table without
+  primary key in certification keys, selected with wsrep_row_digest.
+
+  The digest becomes part of certification keys, so all nodes of the cluster
+  must use the same algorithm, otherwise conflicts on such tables are missed.
+*/
+enum enum_wsrep_row_digest {
+    WSREP_ROW_DIGEST_MD5,       /* MD5 of the field by field row image */
+    WSREP_ROW_DIGEST_XXHASH     /* two lane XXH64, fixed width fields hashed
+                                   in contiguous runs */
+};
+
+#define WSREP_ROW_DIGEST_LEN 16
+
+namespace wsp {
+
+/*
+  Streaming 128-bit row digest.
+
+  The fields of the row are passed to add_field() in record order.
+
+  MD5 mode hashes every field as a NULL flag byte followed by the value,
+  which keeps digests compatible with older nodes. XXHASH mode is a fast
+  non-cryptographic hash: two XXH64 lanes with different seeds are fed the
+  same input and their results are concatenated. Per-field NULL flags are
+  collected separately and hashed in bulk in final(), so that runs of
+  adjacent non-NULL fixed width fields are hashed as a single block.
+*/
+class row_digest
+{
+public:
+  explicit row_digest(ulong algorithm);
+  ~row_digest();
+
+  ulong algorithm() const { return algorithm_; }
+
+  /*
+    Hash the value of the next field of the row.
+    @param ptr    value, NULL for SQL NULL
+    @param fixed  value is stored in place in the record, so that it may
+                  be adjacent to the previous field
+  */
+  void add_field(const void* ptr, size_t len, bool fixed);
+
+  /* Store WSREP_ROW_DIGEST_LEN bytes of digest */
+  void final(uchar* digest);
+
+private:
+  /* Hash field value, NULL for SQL NULL */
+  void update_field(const void* ptr, size_t len);
+
+  /* Hash the run of non-NULL fixed width fields not hashed yet.
+     Only valid in XXHASH mode. */
+  void update_run();
+
+  void update(const void* ptr, size_t len);
+  void add_flag(uchar flag);
+
+  ulong         algorithm_;
+  void*         md5_;
+  XXH64_state_t lane_[2];
+  uchar         flags_[64];
+  uint          n_flags_;
+
+  /* run of adjacent non-NULL fixed width fields not hashed yet */
+  const uchar*  run_start_;
+  const uchar*  run_end_;
+  uint          run_fields_;
+
+  row_digest(const row_digest&);
+  row_digest& operator=(const row_digest&);
+};
+
+} /* namespace wsp */
+
+#endif /* WSREP_ROW_DIGEST_H */
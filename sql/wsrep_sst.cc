@@ -22,11 +22,13 @@
 #include "wsrep_priv.h"
 #include "wsrep_thd.h"
 #include "wsrep_sst.h"
+#include "wsrep_sst_native.h"
 #include "wsrep_utils.h"
 #include "wsrep_var.h"
 #include "wsrep_binlog.h"
 #include "wsrep_applier.h"
 #include "wsrep_xid.h"
+#include "sql_plugin.h"
 #include <cstdio>
 #include <cstdlib>
 #include "log_event.h"
@@ -64,6 +66,7 @@ extern const char wsrep_defaults_group_suffix[];
 #define WSREP_SST_SKIP            "skip"
 #define WSREP_SST_XTRABACKUP      "xtrabackup"
 #define WSREP_SST_XTRABACKUP_V2   "xtrabackup-v2"
+#define WSREP_SST_NATIVE          "native"
 #define WSREP_SST_DEFAULT      WSREP_SST_XTRABACKUP_V2
 #define WSREP_SST_ADDRESS_AUTO "AUTO"
 #define WSREP_SST_AUTH_MASK    "********"
@@ -76,6 +79,10 @@ const char* wsrep_sst_donor           = "";
 // container for real auth string
 static const char* sst_auth_real      = NULL;
 my_bool wsrep_sst_donor_rejects_queries = FALSE;
+ulong   wsrep_sst_native_streams        = 4;
+my_bool wsrep_sst_native_encrypt        = FALSE;
+ulong   wsrep_sst_warmup                = 0;
+ulong   wsrep_sst_warmup_timeout        = 600;
 
 /* Function checks if the new value for sst_method is valid.
 @return false if no error encountered with check else return true. */
@@ -348,11 +355,90 @@ void wsrep_sst_received (wsrep_t*            const wsrep,
     }
 }
 
+struct sst_warmup_arg
+{
+  bool high_priority;
+  uint done;          // lowest percentage of the storage engines
+};
+
+static my_bool sst_warmup_SE(THD* unused, plugin_ref plugin, void* arg)
+{
+  sst_warmup_arg* const a= reinterpret_cast<sst_warmup_arg*>(arg);
+  handlerton* const hton= plugin_data<handlerton*>(plugin);
+
+  if (hton->wsrep_sst_warmup)
+  {
+    uint const done= hton->wsrep_sst_warmup(hton, a->high_priority);
+    if (done < a->done) a->done= done;
+  }
+
+  return FALSE;
+}
+
+static uint sst_warmup_SE_all(bool high_priority)
+{
+  sst_warmup_arg arg= { high_priority, 100 };
+  plugin_foreach(NULL, sst_warmup_SE, MYSQL_STORAGE_ENGINE_PLUGIN, &arg);
+  return arg.done;
+}
+
+/*
+  Warm up the storage engine caches from the state received, e.g. load the
+  buffer pool dump of the donor, and hold the node until wsrep_sst_warmup
+  percent of it is done. The node is still a JOINER here: the cluster keeps
+  committing and this node only queues the write-sets, so a cold cache does
+  not slow down applying them once it is SYNCED.
+*/
+static void sst_warmup()
+{
+  if (!wsrep_sst_warmup)
+  {
+    // load in the background at normal priority
+    sst_warmup_SE_all(false);
+    return;
+  }
+
+  WSREP_INFO("Warming up caches to %lu%% before joining the cluster.",
+             wsrep_sst_warmup);
+
+  time_t const start= time(NULL);
+  time_t       last_report= start;
+  uint         done;
+
+  while ((done= sst_warmup_SE_all(true)) < wsrep_sst_warmup && !abort_loop)
+  {
+    time_t const now= time(NULL);
+
+    if (wsrep_sst_warmup_timeout &&
+        now - start >= (time_t)wsrep_sst_warmup_timeout)
+    {
+      WSREP_WARN("Cache warm-up timed out at %u%% after %lu seconds, "
+                 "joining the cluster.", done, wsrep_sst_warmup_timeout);
+      break;
+    }
+
+    if (now - last_report >= 10)
+    {
+      WSREP_INFO("Cache warm-up %u%% done.", done);
+      last_report= now;
+    }
+
+    my_sleep(100000);
+  }
+
+  // the rest is loaded in the background, yielding to the workload
+  done= sst_warmup_SE_all(false);
+  WSREP_INFO("Cache warm-up %u%% done in %ld seconds.",
+             done, (long)(time(NULL) - start));
+}
+
 // Let applier threads to continue
 void wsrep_sst_continue ()
 {
   if (sst_needed)
   {
+    sst_warmup();
+
     WSREP_INFO("Signalling provider to continue on SST completion.");
     // local_uuid and local_seqno are global variables and are volatile
     wsrep_uuid_t  const sst_uuid  = local_uuid;
@@ -386,8 +472,8 @@ struct sst_thread_arg
   }
 };
 
-static int sst_scan_uuid_seqno (const char* str,
-                                wsrep_uuid_t* uuid, wsrep_seqno_t* seqno)
+int sst_scan_uuid_seqno (const char* str,
+                         wsrep_uuid_t* uuid, wsrep_seqno_t* seqno)
 {
   int offt = wsrep_uuid_scan (str, strlen(str), uuid);
   if (offt > 0 && strlen(str) > (unsigned int)offt && ':' == str[offt])
@@ -469,6 +555,7 @@ void wsrep_sst_cancel (bool call_wsrep_cb)
       sst_process->terminate();
       sst_process = NULL;
     }
+    wsrep_sst_native_cancel();
     /*
       If this is a normal shutdown, then we need to notify
       the wsrep provider about completion of the SST, to
@@ -597,6 +684,9 @@ static void* sst_joiner_thread (void* a)
     proc.wait();
     err= EINVAL;
 
+    // data files are no longer the ones native SST copied
+    wsrep_sst_native_forget();
+
     if (!tmp || proc.error())
     {
       WSREP_ERROR("Failed to read uuid:seqno from joiner script.");
@@ -867,8 +957,11 @@ ssize_t wsrep_sst_prepare (void** msg, THD* thd)
       return 0;
     }
 
-    addr_len = sst_prepare_other (wsrep_sst_method, sst_auth_real,
-                                  addr_in, &addr_out);
+    if (!strcmp(wsrep_sst_method, WSREP_SST_NATIVE))
+      addr_len = wsrep_sst_native_prepare (addr_in, &addr_out);
+    else
+      addr_len = sst_prepare_other (wsrep_sst_method, sst_auth_real,
+                                    addr_in, &addr_out);
     if (addr_len < 0)
     {
       WSREP_ERROR("Failed to prepare for '%s' SST. Unrecoverable.",
@@ -1015,7 +1108,7 @@ static int sst_donate_mysqldump (const char*         addr,
 
 wsrep_seqno_t wsrep_locked_seqno= WSREP_SEQNO_UNDEFINED;
 
-static int run_sql_command(THD *thd, const char *query)
+int run_sql_command(THD *thd, const char *query)
 {
   thd->set_query((char *)query, strlen(query));
 
@@ -1040,7 +1133,7 @@ static int run_sql_command(THD *thd, const char *query)
   return 0;
 }
 
-static int sst_flush_tables(THD* thd)
+int sst_flush_tables(THD* thd)
 {
   WSREP_INFO("Flushing tables for SST...");
 
@@ -1371,6 +1464,11 @@ wsrep_cb_status_t wsrep_sst_donate_cb (void* app_ctx, void* recv_ctx,
     ret = sst_donate_mysqldump(data, &current_gtid->uuid, uuid_str,
                                current_gtid->seqno, bypass, env());
   }
+  else if (!strcmp (WSREP_SST_NATIVE, method))
+  {
+    if (!bypass && wsrep_sst_donor_rejects_queries) sst_reject_queries(FALSE);
+    ret = wsrep_sst_native_donate(data, current_gtid, bypass);
+  }
   else
   {
     ret = sst_donate_other(method, data, uuid_str,
@@ -31,6 +31,10 @@ extern const char* wsrep_sst_receive_address;
 extern const char* wsrep_sst_donor;
 extern       char* wsrep_sst_auth;
 extern    my_bool  wsrep_sst_donor_rejects_queries;
+extern      ulong  wsrep_sst_native_streams;
+extern    my_bool  wsrep_sst_native_encrypt;
+extern      ulong  wsrep_sst_warmup;
+extern      ulong  wsrep_sst_warmup_timeout;
 
 /*! Synchronizes applier thread start with init thread */
 extern void wsrep_sst_grab();
@@ -0,0 +1,1767 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_sst_native.h"
+#include "wsrep_priv.h"
+#include "wsrep_sst.h"
+#include "wsrep_thd.h"
+#include "wsrep_utils.h"
+#include "sql_class.h"
+#include "handler.h"
+#include "my_atomic.h"
+#include "my_dir.h"
+#include "my_rnd.h"
+#include "myisampack.h"
+#include "violite.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/* InnoDB file layout the joiner reads to offer its data files */
+#define NATIVE_LOG_CHECKPOINT_1   512   /* LOG_CHECKPOINT_1 */
+#define NATIVE_LOG_CHECKPOINT_2   1536  /* LOG_CHECKPOINT_2 */
+#define NATIVE_LOG_CHECKPOINT_LSN 8     /* LOG_CHECKPOINT_LSN */
+#define NATIVE_FILE_FLUSH_LSN     26    /* FIL_PAGE_FILE_FLUSH_LSN */
+#define NATIVE_PAGE_SPACE_ID      34    /* FIL_PAGE_SPACE_ID */
+#define NATIVE_BITMAP_PREFIX      "ib_modified_log_"
+
+/* seconds a connection to the joiner has for the TLS handshake and hello */
+#define NATIVE_HELLO_TIMEOUT      10
+
+typedef std::set<std::string>            native_paths;
+typedef std::map<std::string, ulonglong> native_sizes;
+
+/* sockets of native SST in progress, protected by LOCK_wsrep_sst */
+static int  native_fds[WSREP_SST_NATIVE_MAX_STREAMS + 1];
+static uint native_n_fds= 0;
+
+static void native_register(int const fd)
+{
+  if (mysql_mutex_lock(&LOCK_wsrep_sst)) abort();
+  DBUG_ASSERT(native_n_fds < array_elements(native_fds));
+  native_fds[native_n_fds++]= fd;
+  mysql_mutex_unlock(&LOCK_wsrep_sst);
+}
+
+static void native_unregister(int const fd)
+{
+  if (mysql_mutex_lock(&LOCK_wsrep_sst)) abort();
+  for (uint i= 0; i < native_n_fds; ++i)
+  {
+    if (native_fds[i] == fd)
+    {
+      native_fds[i]= native_fds[--native_n_fds];
+      break;
+    }
+  }
+  mysql_mutex_unlock(&LOCK_wsrep_sst);
+}
+
+static void native_close(int const fd)
+{
+  if (fd < 0) return;
+
+  native_unregister(fd);
+  close(fd);
+}
+
+/* Close a connection, vio_delete() closes its socket */
+static void native_close(Vio* const vio)
+{
+  if (!vio) return;
+
+  native_unregister(vio_fd(vio));
+  vio_delete(vio);
+}
+
+void wsrep_sst_native_cancel()
+{
+  mysql_mutex_assert_owner(&LOCK_wsrep_sst);
+
+  for (uint i= 0; i < native_n_fds; ++i)
+    shutdown(native_fds[i], SHUT_RDWR);
+}
+
+static int native_send(Vio* const vio, const void* const buf,
+                       size_t const len)
+{
+  const uchar* ptr= static_cast<const uchar*>(buf);
+  size_t left= len;
+
+  while (left > 0)
+  {
+    errno= 0;
+    size_t const n= vio_write(vio, ptr, left);
+    if (n == size_t(-1) || n == 0)
+    {
+      if (errno == EINTR) continue;
+      return errno ? errno : ECONNRESET;
+    }
+    ptr+= n;
+    left-= n;
+  }
+  return 0;
+}
+
+/*
+  @return 0, ENODATA if the connection was closed before the first byte,
+          or error
+*/
+static int native_recv(Vio* const vio, void* const buf, size_t const len)
+{
+  uchar* ptr= static_cast<uchar*>(buf);
+  size_t left= len;
+
+  while (left > 0)
+  {
+    errno= 0;
+    size_t const n= vio_read(vio, ptr, left);
+    if (n == size_t(-1))
+    {
+      if (errno == EINTR) continue;
+      return errno ? errno : EIO;
+    }
+    if (n == 0) return (left == len ? ENODATA : ECONNRESET);
+    ptr+= n;
+    left-= n;
+  }
+  return 0;
+}
+
+static int native_send_message(Vio* const vio, char const type,
+                               const char* const path, ulonglong const offset,
+                               const void* const data, size_t const len)
+{
+  size_t const path_len= strlen(path);
+  DBUG_ASSERT(path_len < FN_REFLEN);
+  DBUG_ASSERT(len <= WSREP_SST_NATIVE_MAX_DATA);
+
+  uchar header[WSREP_SST_NATIVE_HEADER_LEN];
+  header[0]= type;
+  header[1]= 0;
+  int2store(header + 2, path_len);
+  int4store(header + 4, len);
+  int8store(header + 8, offset);
+
+  int err;
+  if ((err= native_send(vio, header, sizeof(header))) ||
+      (err= native_send(vio, path, path_len)) ||
+      (len && (err= native_send(vio, data, len))))
+    return err;
+  return 0;
+}
+
+struct native_message
+{
+  uchar     type;
+  size_t    data_len;
+  ulonglong offset;
+  char      path[FN_REFLEN];
+};
+
+/*
+  Receive a message, the data into buf of WSREP_SST_NATIVE_MAX_DATA bytes
+  @return 0, ENODATA if the connection was closed before the message,
+          or error
+*/
+static int native_recv_message(Vio* const vio, native_message* const m,
+                               uchar* const buf)
+{
+  uchar header[WSREP_SST_NATIVE_HEADER_LEN];
+  int err= native_recv(vio, header, sizeof(header));
+  if (err) return err;
+
+  size_t const path_len= uint2korr(header + 2);
+  m->type=     header[0];
+  m->data_len= uint4korr(header + 4);
+  m->offset=   uint8korr(header + 8);
+
+  if (path_len >= sizeof(m->path) || m->data_len > WSREP_SST_NATIVE_MAX_DATA)
+    return EPROTO;
+  if ((err= native_recv(vio, m->path, path_len)) ||
+      (err= native_recv(vio, buf, m->data_len)))
+    return err;
+  m->path[path_len]= '\0';
+
+  return 0;
+}
+
+/*
+  Split "host:port" or "[v6host]:port", port is optional
+  @param rest  set to what follows, "" or "/secret..."
+*/
+static int native_parse_addr(const char* const addr, char* const host,
+                             size_t const host_max, char* const port,
+                             size_t const port_max, const char** const rest)
+{
+  /* the secret of the joiner follows the port */
+  size_t const addr_len= strcspn(addr, "/");
+  size_t const host_len= std::min(wsrep_host_len(addr, addr_len), addr_len);
+  const char*  host_ptr= addr;
+  size_t       host_cpy= host_len;
+
+  if (host_len >= 2 && addr[0] == '[' && addr[host_len - 1] == ']')
+  {
+    ++host_ptr;
+    host_cpy-= 2;
+  }
+
+  if (host_cpy == 0 || host_cpy >= host_max) return EINVAL;
+  memcpy(host, host_ptr, host_cpy);
+  host[host_cpy]= '\0';
+
+  if (host_len < addr_len)
+  {
+    size_t const port_len= addr_len - host_len - 1;
+    if (addr[host_len] != ':' || port_len == 0 || port_len >= port_max)
+      return EINVAL;
+    memcpy(port, addr + host_len + 1, port_len);
+    port[port_len]= '\0';
+  }
+  else
+  {
+    snprintf(port, port_max, "%d", WSREP_SST_NATIVE_PORT);
+  }
+
+  *rest= addr + addr_len;
+  return 0;
+}
+
+int wsrep_sst_native_parse_addr(const char* const addr, char* const host,
+                                size_t const host_max, char* const port,
+                                size_t const port_max, char* const secret,
+                                bool* const ssl)
+{
+  const char* rest;
+  if (native_parse_addr(addr, host, host_max, port, port_max, &rest) ||
+      rest[0] != '/')
+    return EINVAL;
+
+  size_t const secret_len= strcspn(++rest, "/");
+  if (secret_len != WSREP_SST_NATIVE_SECRET_LEN) return EINVAL;
+  memcpy(secret, rest, secret_len);
+  secret[secret_len]= '\0';
+  rest+= secret_len;
+
+  *ssl= !strcmp(rest, "/" WSREP_SST_NATIVE_SSL);
+  return (*ssl || !rest[0]) ? 0 : EINVAL;
+}
+
+void wsrep_sst_native_make_hello(uchar* const hello, const char* const secret,
+                                 uint const no, uint const n_streams,
+                                 uint const flags)
+{
+  uchar* ptr= hello;
+  memcpy(ptr, WSREP_SST_NATIVE_MAGIC, 4);
+  int2store(ptr + 4, WSREP_SST_NATIVE_VERSION);
+  ptr+= 6;
+  memcpy(ptr, secret, WSREP_SST_NATIVE_SECRET_LEN);
+  ptr+= WSREP_SST_NATIVE_SECRET_LEN;
+  int2store(ptr,     no);
+  int2store(ptr + 2, n_streams);
+  int2store(ptr + 4, flags);
+}
+
+int wsrep_sst_native_check_hello(const uchar* const hello,
+                                 const char* const secret, uint* const no,
+                                 uint* const n_streams, uint* const flags)
+{
+  if (memcmp(hello, WSREP_SST_NATIVE_MAGIC, 4) ||
+      uint2korr(hello + 4) != WSREP_SST_NATIVE_VERSION)
+    return EACCES;
+
+  /* compare all of the secret, the time taken tells nothing about it */
+  const uchar* ptr= hello + 6;
+  uchar diff= 0;
+  for (uint i= 0; i < WSREP_SST_NATIVE_SECRET_LEN; ++i)
+    diff|= ptr[i] ^ static_cast<uchar>(secret[i]);
+  if (diff) return EACCES;
+  ptr+= WSREP_SST_NATIVE_SECRET_LEN;
+
+  *no=        uint2korr(ptr);
+  *n_streams= uint2korr(ptr + 2);
+  *flags=     uint2korr(ptr + 4);
+
+  if (*n_streams == 0 || *n_streams > WSREP_SST_NATIVE_MAX_STREAMS + 1 ||
+      *no >= *n_streams)
+    return EPROTO;
+  return 0;
+}
+
+/* TLS is required by this server */
+static bool native_encrypt()
+{
+  return wsrep_sst_native_encrypt || pxc_encrypt_cluster_traffic;
+}
+
+/*
+  TLS context with the ssl-* settings of the server
+  @return context to free with free_vio_ssl_acceptor_fd() or NULL on error
+*/
+static st_VioSSLFd* native_ssl_fd(bool const acceptor)
+{
+#ifdef HAVE_OPENSSL
+  enum enum_ssl_init_error err= SSL_INITERR_NOERROR;
+  long const ssl_ctx_flags= process_tls_version(opt_tls_version);
+  st_VioSSLFd* const ssl_fd= acceptor ?
+    new_VioSSLAcceptorFd(opt_ssl_key, opt_ssl_cert, opt_ssl_ca,
+                         opt_ssl_capath, opt_ssl_cipher, &err,
+                         opt_ssl_crl, opt_ssl_crlpath, ssl_ctx_flags) :
+    new_VioSSLConnectorFd(opt_ssl_key, opt_ssl_cert, opt_ssl_ca,
+                          opt_ssl_capath, opt_ssl_cipher, &err,
+                          opt_ssl_crl, opt_ssl_crlpath, ssl_ctx_flags);
+  if (!ssl_fd)
+    WSREP_ERROR("Native SST: failed to set up TLS: %s",
+                sslGetErrString(err));
+  return ssl_fd;
+#else
+  WSREP_ERROR("Native SST: this server is built without TLS");
+  return NULL;
+#endif /* HAVE_OPENSSL */
+}
+
+static void native_free_ssl_fd(st_VioSSLFd* const ssl_fd)
+{
+#ifdef HAVE_OPENSSL
+  if (ssl_fd) free_vio_ssl_acceptor_fd(ssl_fd);
+#endif /* HAVE_OPENSSL */
+}
+
+/*
+  TLS handshake on a connection, as the joiner if acceptor is set
+  @return 0 or ECONNREFUSED
+*/
+static int native_ssl_handshake(st_VioSSLFd* const ssl_fd, Vio* const vio,
+                                bool const acceptor)
+{
+#ifdef HAVE_OPENSSL
+  unsigned long ssl_err= 0;
+  if (!(acceptor ? sslaccept(ssl_fd, vio, NATIVE_HELLO_TIMEOUT, &ssl_err) :
+                   sslconnect(ssl_fd, vio, NATIVE_HELLO_TIMEOUT, &ssl_err)))
+    return 0;
+
+  char buf[256]= "";
+  ERR_error_string_n(ssl_err, buf, sizeof(buf));
+  WSREP_WARN("Native SST: TLS handshake failed: %s", buf);
+#endif /* HAVE_OPENSSL */
+  return ECONNREFUSED;
+}
+
+static int native_socket(const char* const host, const char* const port,
+                         bool const listening)
+{
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family=   AF_UNSPEC;
+  hints.ai_socktype= SOCK_STREAM;
+  hints.ai_flags=    listening ? AI_PASSIVE : 0;
+
+  struct addrinfo* res= NULL;
+  int const gai_err= getaddrinfo(host, port, &hints, &res);
+  if (gai_err)
+  {
+    WSREP_ERROR("Failed to resolve native SST address '%s:%s': %s",
+                host, port, gai_strerror(gai_err));
+    return -EINVAL;
+  }
+
+  int err= 0;
+  int fd= -1;
+  for (struct addrinfo* ai= res; ai; ai= ai->ai_next)
+  {
+    fd= socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0)
+    {
+      err= errno;
+      continue;
+    }
+
+    if (listening)
+    {
+      int const on= 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+      if (!bind(fd, ai->ai_addr, ai->ai_addrlen) &&
+          !listen(fd, WSREP_SST_NATIVE_MAX_STREAMS + 1))
+        break;
+    }
+    else if (!connect(fd, ai->ai_addr, ai->ai_addrlen))
+    {
+      break;
+    }
+
+    err= errno;
+    close(fd);
+    fd= -1;
+  }
+  freeaddrinfo(res);
+
+  if (fd < 0)
+  {
+    WSREP_ERROR("Failed to %s native SST address '%s:%s': %d (%s)",
+                listening ? "listen at" : "connect to", host, port,
+                err, strerror(err));
+    return -err;
+  }
+
+  return fd;
+}
+
+/* Path relative to data directory, or NULL if the file is outside of it */
+static const char* native_relative_path(const char* path)
+{
+  size_t const home_len= strlen(mysql_real_data_home);
+
+  if (path[0] == '.' && path[1] == FN_LIBCHAR)
+    path+= 2;
+  else if (!strncmp(path, mysql_real_data_home, home_len))
+    path+= home_len;
+  else if (path[0] == FN_LIBCHAR)
+    return NULL;
+
+  while (path[0] == FN_LIBCHAR) ++path;
+
+  return path;
+}
+
+/* Path received from the donor must stay inside the data directory */
+static bool native_path_valid(const char* const path)
+{
+  if (!path[0] || path[0] == FN_LIBCHAR) return false;
+
+  for (const char* p= path; p; p= strchr(p, FN_LIBCHAR))
+  {
+    if (*p == FN_LIBCHAR) ++p;
+    if (p[0] == '.' && p[1] == '.' && (p[2] == FN_LIBCHAR || !p[2]))
+      return false;
+  }
+  return true;
+}
+
+/* Remove directory with everything in it */
+static void native_remove_dir(const char* const path)
+{
+  MY_DIR* const dir= my_dir(path, MYF(MY_WANT_STAT));
+  if (dir)
+  {
+    for (uint i= 0; i < dir->number_off_files; ++i)
+    {
+      const FILEINFO& f= dir->dir_entry[i];
+      if (!strcmp(f.name, ".") || !strcmp(f.name, "..")) continue;
+
+      char file_path[FN_REFLEN];
+      snprintf(file_path, sizeof(file_path), "%s/%s", path, f.name);
+      if (MY_S_ISDIR(f.mystat->st_mode))
+        native_remove_dir(file_path);
+      else
+        my_delete(file_path, MYF(MY_WME));
+    }
+    my_dirend(dir);
+  }
+  rmdir(path);
+}
+
+/* Big-endian integer of len bytes at offset of a file in the data directory,
+   0 if it can not be read */
+static ulonglong native_read_int(const char* const name, my_off_t const offset,
+                                 size_t const len)
+{
+  char path[FN_REFLEN];
+  snprintf(path, sizeof(path), "%s%s", mysql_real_data_home, name);
+
+  File const fd= my_open(path, O_RDONLY | O_BINARY, MYF(0));
+  if (fd < 0) return 0;
+
+  uchar buf[8];
+  DBUG_ASSERT(len == 4 || len == 8);
+  bool const failed= my_pread(fd, buf, len, offset, MYF(MY_NABP));
+  my_close(fd, MYF(0));
+
+  if (failed) return 0;
+  return len == 8 ? mi_uint8korr(buf) : mi_uint4korr(buf);
+}
+
+/*
+  Donor side
+*/
+
+/* Data files the joiner offers for an incremental copy */
+class Native_base : public Wsrep_sst_base
+{
+public:
+  Native_base()
+  {
+    snprintf(dir, sizeof(dir), "%s%s", mysql_real_data_home,
+             WSREP_SST_NATIVE_BITMAP_DIR);
+    bitmap_dir= dir;
+  }
+
+  bool has_file(const char* path, ulong space_id) const
+  {
+    const char* const rel= native_relative_path(path);
+    if (!rel) return false;
+
+    std::map<std::string, ulong>::const_iterator const it= files.find(rel);
+    return it != files.end() && it->second == space_id;
+  }
+
+  /* tablespace id of every data file */
+  std::map<std::string, ulong> files;
+  char dir[FN_REFLEN];
+};
+
+/*
+  Receive the offer of the joiner, its changed page bitmaps are written to
+  the bitmap directory.
+  @param use_base  set if the joiner has an earlier copy from this server
+*/
+static int native_recv_offer(Vio* const vio, Native_base* const base,
+                             uchar* const buf, bool* const use_base)
+{
+  native_remove_dir(base->dir);
+  if (my_mkdir(base->dir, 0777, MYF(MY_WME))) return EIO;
+
+  native_message m;
+  bool have_base= false;
+  File file= -1;
+  char file_name[FN_REFLEN]= "";
+  int  err;
+
+  while (!(err= native_recv_message(vio, &m, buf)) &&
+         m.type != WSREP_SST_NATIVE_END)
+  {
+    switch (m.type)
+    {
+    case WSREP_SST_NATIVE_BASE:
+      have_base= m.data_len == strlen(server_uuid) &&
+                 !memcmp(buf, server_uuid, m.data_len);
+      base->lsn= m.offset;
+      break;
+    case WSREP_SST_NATIVE_SPACE:
+      base->files[m.path]= static_cast<ulong>(m.offset);
+      break;
+    case WSREP_SST_NATIVE_WRITE:
+      if (strchr(m.path, FN_LIBCHAR) ||
+          !is_prefix(m.path, NATIVE_BITMAP_PREFIX))
+      {
+        err= EPROTO;
+        break;
+      }
+      if (strcmp(file_name, m.path))
+      {
+        if (file >= 0) my_close(file, MYF(0));
+
+        char path[FN_REFLEN * 2];
+        snprintf(path, sizeof(path), "%s/%s", base->dir, m.path);
+        file= my_open(path, O_CREAT | O_WRONLY | O_BINARY, MYF(MY_WME));
+        if (file < 0)
+        {
+          err= my_errno() ? my_errno() : EIO;
+          break;
+        }
+        strcpy(file_name, m.path);
+      }
+      if (my_pwrite(file, buf, m.data_len, m.offset, MYF(MY_WME | MY_NABP)))
+        err= EIO;
+      break;
+    default:
+      err= EPROTO;
+    }
+    if (err) break;
+  }
+
+  if (file >= 0) my_close(file, MYF(0));
+
+  if (err)
+  {
+    WSREP_ERROR("Native SST: failed to receive the offer of the joiner: "
+                "%d (%s)", err, strerror(err));
+    return err;
+  }
+
+  base->joiner_lsn= m.offset;
+  *use_base= have_base && base->lsn > 0;
+
+  if (have_base)
+    WSREP_INFO("Native SST: joiner has data files copied at LSN %llu, "
+               "changed up to LSN %llu, %zu tablespace files",
+               base->lsn, base->joiner_lsn, base->files.size());
+  return 0;
+}
+
+class Native_sink : public Wsrep_sst_sink
+{
+public:
+  Native_sink(Vio* const* vios) : m_vios(vios) {}
+
+  int begin(uint stream, ulonglong base_lsn)
+  {
+    return send(stream, WSREP_SST_NATIVE_INCREMENTAL, "", base_lsn,
+                reinterpret_cast<const uchar*>(server_uuid),
+                strlen(server_uuid));
+  }
+
+  int file(uint stream, const char* path, ulonglong size)
+  {
+    const char* const rel= relative(path);
+    if (!rel) return EINVAL;
+
+    return send(stream, WSREP_SST_NATIVE_FILE, rel, size, NULL, 0);
+  }
+
+  int write(uint stream, const char* path, ulonglong offset,
+            const uchar* buf, size_t len)
+  {
+    const char* const rel= relative(path);
+    if (!rel) return EINVAL;
+
+    while (len > 0)
+    {
+      size_t const n= std::min(len, size_t(WSREP_SST_NATIVE_MAX_DATA));
+      int const err= send(stream, WSREP_SST_NATIVE_WRITE, rel, offset, buf, n);
+      if (err) return err;
+      offset+= n;
+      buf+= n;
+      len-= n;
+    }
+    return 0;
+  }
+
+  int send(uint const stream, char const type, const char* const path,
+           ulonglong const offset, const uchar* const data, size_t const len)
+  {
+    int const err= native_send_message(m_vios[stream], type, path, offset,
+                                       data, len);
+    if (err)
+    {
+      WSREP_ERROR("Native SST: failed to send '%s' on stream %u: %d (%s)",
+                  path, stream, err, strerror(err));
+    }
+    return err;
+  }
+
+private:
+  const char* relative(const char* const path)
+  {
+    const char* const rel= native_relative_path(path);
+    if (!rel || strlen(rel) >= FN_REFLEN)
+      WSREP_ERROR("Native SST: file '%s' is not in the data directory",
+                  path);
+    return rel;
+  }
+
+  Vio* const* const m_vios;
+};
+
+struct native_donor
+{
+  wsrep_gtid_t gtid;
+  bool         bypass;
+  uint         n_streams;
+  st_VioSSLFd* ssl_fd;     /* TLS if set */
+  Vio*         vios[WSREP_SST_NATIVE_MAX_STREAMS + 1];
+};
+
+struct native_copy
+{
+  handlerton*  hton;
+  Native_sink* sink;
+  uint         stream;
+  int          err;
+  int32*       running;
+  pthread_t    thread;
+};
+
+static void* native_copy_thread(void* a)
+{
+  native_copy* const c= static_cast<native_copy*>(a);
+
+  my_thread_init();
+  c->err= c->hton->wsrep_sst_backup_copy(c->hton, c->sink, c->stream) ?
+    EIO : 0;
+  my_atomic_add32(c->running, -1);
+  my_thread_end();
+
+  return NULL;
+}
+
+/* Send the files of the database directories which are not InnoDB's */
+static int native_send_databases(Native_sink* const sink, uchar* const buf)
+{
+  MY_DIR* const home= my_dir(mysql_real_data_home, MYF(MY_WANT_STAT));
+  if (!home) return errno ? errno : EIO;
+
+  int err= 0;
+  for (uint i= 0; !err && i < home->number_off_files; ++i)
+  {
+    const FILEINFO& db= home->dir_entry[i];
+    if (!MY_S_ISDIR(db.mystat->st_mode) || db.name[0] == '.' ||
+        db.name[0] == '#')
+      continue;
+
+    char db_path[FN_REFLEN];
+    snprintf(db_path, sizeof(db_path), "%s%s", mysql_real_data_home,
+             db.name);
+
+    MY_DIR* const dir= my_dir(db_path, MYF(MY_WANT_STAT));
+    if (!dir)
+    {
+      err= errno ? errno : EIO;
+      break;
+    }
+
+    for (uint j= 0; !err && j < dir->number_off_files; ++j)
+    {
+      const FILEINFO& f= dir->dir_entry[j];
+      const char* const ext= fn_ext(f.name);
+      if (!MY_S_ISREG(f.mystat->st_mode) ||
+          !strcmp(ext, ".ibd") || !strcmp(ext, ".isl") ||
+          is_prefix(f.name, tmp_file_prefix))
+        continue;
+
+      char path[FN_REFLEN];
+      snprintf(path, sizeof(path), "%s/%s", db_path, f.name);
+
+      File const fd= my_open(path, O_RDONLY | O_BINARY, MYF(MY_WME));
+      if (fd < 0)
+      {
+        err= my_errno() ? my_errno() : EIO;
+        break;
+      }
+
+      ulonglong const size= f.mystat->st_size;
+      err= sink->file(0, path, size);
+      for (ulonglong offset= 0; !err && offset < size; )
+      {
+        size_t const len= my_pread(fd, buf, WSREP_SST_NATIVE_MAX_DATA,
+                                   offset, MYF(MY_WME));
+        if (len == MY_FILE_ERROR || len == 0) break;
+        err= sink->write(0, path, offset, buf, len);
+        offset+= len;
+      }
+      my_close(fd, MYF(0));
+    }
+    my_dirend(dir);
+  }
+  my_dirend(home);
+
+  return err;
+}
+
+/*
+  Copy InnoDB and the rest of the data directory. Returns with the global
+  read lock held on success.
+  @param lsn  set to the LSN the copy of InnoDB ends at
+*/
+static int native_donate_data(native_donor* const d, THD* const thd,
+                              uchar* const buf, wsrep_seqno_t* const seqno,
+                              ulonglong* const lsn)
+{
+  handlerton* const hton= ha_resolve_by_legacy_type(thd, DB_TYPE_INNODB);
+  if (!hton || !hton->wsrep_sst_backup_begin)
+  {
+    WSREP_ERROR("Native SST requires InnoDB");
+    return ENOTSUP;
+  }
+
+  Native_sink sink(d->vios);
+  Native_base base;
+  native_copy copies[WSREP_SST_NATIVE_MAX_STREAMS];
+  uint  const n_copies= d->n_streams - 1;
+  int32 running= 0;
+  bool  use_base= false;
+  int   err= 0;
+
+  if ((err= native_recv_offer(d->vios[0], &base, buf, &use_base)))
+    return err;
+
+  if (run_sql_command(thd, "LOCK TABLES FOR BACKUP")) return ECANCELED;
+
+  if (hton->wsrep_sst_backup_begin(hton, &sink, 0, use_base ? &base : NULL))
+  {
+    run_sql_command(thd, "UNLOCK TABLES");
+    native_remove_dir(base.dir);
+    return EIO;
+  }
+  /* the bitmaps are read by begin */
+  native_remove_dir(base.dir);
+
+  uint started= 0;
+  for (; started < n_copies; ++started)
+  {
+    native_copy& c= copies[started];
+    c.hton=    hton;
+    c.sink=    &sink;
+    c.stream=  started + 1;
+    c.err=     0;
+    c.running= &running;
+
+    my_atomic_add32(&running, 1);
+    if ((err= pthread_create(&c.thread, NULL, native_copy_thread, &c)))
+    {
+      my_atomic_add32(&running, -1);
+      WSREP_ERROR("Native SST: pthread_create() failed: %d (%s)",
+                  err, strerror(err));
+      break;
+    }
+  }
+
+  /* keep copying the redo log while the data streams copy the pages,
+     so that the log does not wrap around before it is copied */
+  while (my_atomic_load32(&running) > 0)
+  {
+    if (!err && hton->wsrep_sst_backup_redo(hton, &sink, 0)) err= EIO;
+    my_sleep(100000);
+  }
+
+  for (uint i= 0; i < started; ++i)
+  {
+    pthread_join(copies[i].thread, NULL);
+    if (!err) err= copies[i].err;
+    /* data stream is complete */
+    native_close(d->vios[i + 1]);
+    d->vios[i + 1]= NULL;
+  }
+
+  run_sql_command(thd, "UNLOCK TABLES");
+
+  if (!err) err= sst_flush_tables(thd);
+
+  if (hton->wsrep_sst_backup_end(hton, &sink, 0, err != 0, lsn) && !err)
+    err= EIO;
+
+  if (!err) err= native_send_databases(&sink, buf);
+
+  *seqno= wsrep_locked_seqno;
+
+  return err;
+}
+
+static void native_donor_close(native_donor* const d)
+{
+  for (uint i= 0; i < d->n_streams; ++i)
+  {
+    native_close(d->vios[i]);
+    d->vios[i]= NULL;
+  }
+  native_free_ssl_fd(d->ssl_fd);
+  d->ssl_fd= NULL;
+}
+
+static void* native_donor_thread(void* a)
+{
+  native_donor* const d= static_cast<native_donor*>(a);
+
+#ifdef HAVE_PSI_INTERFACE
+  wsrep_pfs_register_thread(key_THREAD_wsrep_sst_donor);
+#endif /* HAVE_PSI_INTERFACE */
+
+  WSREP_INFO("Initiating native SST/IST transfer on DONOR side "
+             "(%u data streams%s)", d->n_streams - 1,
+             d->bypass ? ", bypass" : "");
+
+  wsp::thd thd(FALSE); // wsrep_on off, to operate with wsrep_ready == OFF
+  thd.ptr->wsrep_sst_donor= true;
+
+  wsrep_seqno_t seqno= d->gtid.seqno;
+  ulonglong lsn= 0;
+  int err= 0;
+
+  if (!d->bypass)
+  {
+    uchar* const buf= static_cast<uchar*>(
+      my_malloc(key_memory_wsrep, WSREP_SST_NATIVE_MAX_DATA, MYF(0)));
+    err= buf ? native_donate_data(d, thd.ptr, buf, &seqno, &lsn) : ENOMEM;
+    my_free(buf);
+  }
+
+  if (thd.ptr->global_read_lock.is_acquired())
+    thd.ptr->global_read_lock.unlock_global_read_lock(thd.ptr);
+
+  if (!err)
+  {
+    char gtid[64];
+    wsrep_uuid_print(&d->gtid.uuid, gtid, sizeof(gtid));
+    snprintf(gtid + strlen(gtid), sizeof(gtid) - strlen(gtid), ":%lld",
+             (long long)seqno);
+
+    Native_sink sink(d->vios);
+    err= sink.send(0, WSREP_SST_NATIVE_END, "", lsn,
+                   reinterpret_cast<uchar*>(gtid), strlen(gtid) + 1);
+  }
+
+  native_donor_close(d);
+
+  if (err)
+    WSREP_ERROR("Native SST failed on DONOR side: %d (%s)",
+                err, strerror(err));
+  else
+    WSREP_INFO("Native SST completed on DONOR side, seqno %lld",
+               (long long)seqno);
+
+  struct wsrep_gtid const state_id= {
+    d->gtid.uuid, err ? WSREP_SEQNO_UNDEFINED : seqno
+  };
+  wsrep->sst_sent(wsrep, &state_id, -err);
+
+  my_free(d);
+
+#ifdef HAVE_PSI_INTERFACE
+  wsrep_pfs_delete_thread();
+#endif /* HAVE_PSI_INTERFACE */
+
+  return NULL;
+}
+
+int wsrep_sst_native_donate(const char* const addr,
+                            const wsrep_gtid_t* const gtid,
+                            bool const bypass)
+{
+  native_donor* const d= static_cast<native_donor*>(
+    my_malloc(key_memory_wsrep, sizeof(native_donor), MYF(0)));
+  if (!d) return -ENOMEM;
+
+  d->gtid=      *gtid;
+  d->bypass=    bypass;
+  d->n_streams= bypass ? 1 : wsrep_sst_native_streams + 1;
+  d->ssl_fd=    NULL;
+  for (uint i= 0; i < array_elements(d->vios); ++i) d->vios[i]= NULL;
+
+  char host[256];
+  char port[16];
+  char secret[WSREP_SST_NATIVE_SECRET_LEN + 1];
+  bool ssl= false;
+  int  err= 0;
+
+  if (wsrep_sst_native_parse_addr(addr, host, sizeof(host), port,
+                                  sizeof(port), secret, &ssl))
+  {
+    WSREP_ERROR("Invalid native SST address of the joiner: '%s'", addr);
+    err= EINVAL;
+  }
+  else if (!ssl && native_encrypt())
+  {
+    WSREP_ERROR("Native SST: the joiner does not encrypt the transfer, "
+                "which wsrep_sst_native_encrypt or "
+                "pxc_encrypt_cluster_traffic of this donor require");
+    err= EPERM;
+  }
+  else if (ssl && !(d->ssl_fd= native_ssl_fd(false)))
+  {
+    err= EINVAL;
+  }
+
+  for (uint i= 0; !err && i < d->n_streams; ++i)
+  {
+    int const fd= native_socket(host, port, false);
+    if (fd < 0)
+    {
+      err= -fd;
+      break;
+    }
+    native_register(fd);
+
+    if (!(d->vios[i]= vio_new(fd, VIO_TYPE_TCPIP, 0)))
+    {
+      native_close(fd);
+      err= ENOMEM;
+      break;
+    }
+
+    if (d->ssl_fd &&
+        (err= native_ssl_handshake(d->ssl_fd, d->vios[i], false)))
+      break;
+
+    uchar hello[WSREP_SST_NATIVE_HELLO_LEN];
+    wsrep_sst_native_make_hello(hello, secret, i, d->n_streams,
+                                bypass ? WSREP_SST_NATIVE_BYPASS : 0);
+    err= native_send(d->vios[i], hello, sizeof(hello));
+  }
+
+  pthread_t tmp;
+  if (!err && (err= pthread_create(&tmp, NULL, native_donor_thread, d)))
+  {
+    WSREP_ERROR("wsrep_sst_native_donate(): pthread_create() failed: "
+                "%d (%s)", err, strerror(err));
+  }
+
+  if (err)
+  {
+    native_donor_close(d);
+    my_free(d);
+    return -err;
+  }
+
+  pthread_detach(tmp);
+  return 0;
+}
+
+/*
+  Joiner side
+*/
+
+struct native_stream
+{
+  uint          no;
+  Vio*          vio;
+  File          file;              /* last file written to */
+  char          path[FN_REFLEN];   /* of file */
+  uchar*        buf;
+  bool          end;
+  wsrep_uuid_t  uuid;
+  wsrep_seqno_t seqno;
+  ulonglong     lsn;               /* LSN the copy of InnoDB ends at */
+  native_paths  received;          /* files written to */
+  native_sizes  sizes;             /* final sizes sent by the donor */
+  int           err;
+  pthread_t     thread;
+};
+
+static int native_open(native_stream* const s, const char* const path)
+{
+  if (s->file >= 0 && !strcmp(s->path, path)) return 0;
+
+  if (s->file >= 0) my_close(s->file, MYF(0));
+  s->file= -1;
+
+  char full[FN_REFLEN * 2];
+  snprintf(full, sizeof(full), "%s%s", mysql_real_data_home, path);
+
+  /* database directories are created by the first file in them */
+  for (char* p= full + strlen(mysql_real_data_home);
+       (p= strchr(p, FN_LIBCHAR)); ++p)
+  {
+    *p= '\0';
+    if (my_mkdir(full, 0777, MYF(0)) && errno != EEXIST)
+    {
+      int const err= errno;
+      WSREP_ERROR("Native SST: failed to create directory '%s': %d (%s)",
+                  full, err, strerror(err));
+      return err;
+    }
+    *p= FN_LIBCHAR;
+  }
+
+  s->file= my_open(full, O_CREAT | O_WRONLY | O_BINARY, MYF(MY_WME));
+  if (s->file < 0) return my_errno() ? my_errno() : EIO;
+
+  strcpy(s->path, path);
+  s->received.insert(path);
+  return 0;
+}
+
+static int native_receive(native_stream* const s)
+{
+  for (;;)
+  {
+    native_message m;
+    int err= native_recv_message(s->vio, &m, s->buf);
+
+    /* data streams end when the donor closes them */
+    if (err == ENODATA && s->no > 0) return 0;
+    if (err) return err;
+
+    switch (m.type)
+    {
+    case WSREP_SST_NATIVE_END:
+    {
+      if (s->no > 0 || m.data_len == 0) return EPROTO;
+      s->buf[m.data_len - 1]= '\0';
+      if ((err= sst_scan_uuid_seqno(reinterpret_cast<char*>(s->buf),
+                                    &s->uuid, &s->seqno)))
+        return err;
+      s->lsn= m.offset;
+      s->end= true;
+      return 0;
+    }
+    case WSREP_SST_NATIVE_FILE:
+    case WSREP_SST_NATIVE_WRITE:
+      if (!native_path_valid(m.path))
+      {
+        WSREP_ERROR("Native SST: invalid file path '%s'", m.path);
+        return EPROTO;
+      }
+      if ((err= native_open(s, m.path))) return err;
+
+      if (m.type == WSREP_SST_NATIVE_FILE)
+      {
+        /* the file is extended now, shrinking waits for the data
+           streams to finish writing */
+        MY_STAT stat;
+        if (my_fstat(s->file, &stat, MYF(MY_WME))) return EIO;
+        if ((ulonglong)stat.st_size < m.offset &&
+            ftruncate(s->file, m.offset))
+          return errno;
+        s->sizes[m.path]= m.offset;
+      }
+      else if (my_pwrite(s->file, s->buf, m.data_len, m.offset,
+                         MYF(MY_WME | MY_NABP)))
+      {
+        return EIO;
+      }
+      break;
+    default:
+      return EPROTO;
+    }
+  }
+}
+
+static void* native_stream_thread(void* a)
+{
+  native_stream* const s= static_cast<native_stream*>(a);
+
+  my_thread_init();
+  s->err= native_receive(s);
+  my_thread_end();
+
+  return NULL;
+}
+
+static bool native_has_prefix(const char* const name,
+                              const char* const* prefixes)
+{
+  for (; *prefixes; ++prefixes)
+    if (is_prefix(name, *prefixes)) return true;
+  return false;
+}
+
+static const char* const native_data_files[]= { "ibdata", "undo", NULL };
+
+/* InnoDB data file at the top of the data directory */
+static bool native_is_data_file(const char* const name)
+{
+  return native_has_prefix(name, native_data_files) ||
+         !strcmp(fn_ext(name), ".ibd");
+}
+
+/*
+  Remove the InnoDB files of the joiner which are not updated in place: the
+  redo log, changed page bitmaps and temporary files, and unless the copy
+  is incremental, the data files and the databases too. Configuration,
+  logs, keys and the provider state are kept.
+*/
+static void native_clean_datadir(bool const full)
+{
+  static const char* const log_files[]=
+    { "ib_logfile", NATIVE_BITMAP_PREFIX, "ibtmp", "ib_buffer_pool",
+      WSREP_SST_NATIVE_BASE_FILE, NULL };
+
+  MY_DIR* const home= my_dir(mysql_real_data_home, MYF(MY_WANT_STAT));
+  if (!home) return;
+
+  for (uint i= 0; i < home->number_off_files; ++i)
+  {
+    const FILEINFO& f= home->dir_entry[i];
+    if (!strcmp(f.name, ".") || !strcmp(f.name, "..")) continue;
+
+    char path[FN_REFLEN];
+    snprintf(path, sizeof(path), "%s%s", mysql_real_data_home, f.name);
+
+    if (MY_S_ISDIR(f.mystat->st_mode))
+    {
+      if (full) native_remove_dir(path);
+      continue;
+    }
+
+    if (native_has_prefix(f.name, log_files) ||
+        (full && native_has_prefix(f.name, native_data_files)))
+      my_delete(path, MYF(MY_WME));
+  }
+  my_dirend(home);
+}
+
+/*
+  Remove the files an incremental copy did not send, they belong to the
+  tables and tablespaces dropped since the earlier copy.
+*/
+static void native_prune_datadir(const native_paths& received)
+{
+  MY_DIR* const home= my_dir(mysql_real_data_home, MYF(MY_WANT_STAT));
+  if (!home) return;
+
+  for (uint i= 0; i < home->number_off_files; ++i)
+  {
+    const FILEINFO& db= home->dir_entry[i];
+    if (db.name[0] == '.' || db.name[0] == '#') continue;
+
+    char path[FN_REFLEN];
+    snprintf(path, sizeof(path), "%s%s", mysql_real_data_home, db.name);
+
+    if (!MY_S_ISDIR(db.mystat->st_mode))
+    {
+      if (native_is_data_file(db.name) && !received.count(db.name))
+        my_delete(path, MYF(MY_WME));
+      continue;
+    }
+
+    MY_DIR* const dir= my_dir(path, MYF(MY_WANT_STAT));
+    if (!dir) continue;
+
+    for (uint j= 0; j < dir->number_off_files; ++j)
+    {
+      const FILEINFO& f= dir->dir_entry[j];
+      if (!MY_S_ISREG(f.mystat->st_mode)) continue;
+
+      char rel[FN_REFLEN];
+      snprintf(rel, sizeof(rel), "%s/%s", db.name, f.name);
+      if (received.count(rel)) continue;
+
+      char file_path[FN_REFLEN * 2];
+      snprintf(file_path, sizeof(file_path), "%s%s", mysql_real_data_home,
+               rel);
+      my_delete(file_path, MYF(MY_WME));
+    }
+    my_dirend(dir);
+
+    /* succeeds only if the database was dropped */
+    rmdir(path);
+  }
+  my_dirend(home);
+}
+
+/* Truncate the files which are larger than the donor sent them */
+static int native_apply_sizes(const native_sizes& sizes)
+{
+  for (native_sizes::const_iterator it= sizes.begin(); it != sizes.end(); ++it)
+  {
+    char path[FN_REFLEN * 2];
+    snprintf(path, sizeof(path), "%s%s", mysql_real_data_home,
+             it->first.c_str());
+
+    MY_STAT stat;
+    if (!my_stat(path, &stat, MYF(0)) || (ulonglong)stat.st_size <= it->second)
+      continue;
+
+    File const fd= my_open(path, O_WRONLY | O_BINARY, MYF(MY_WME));
+    if (fd < 0) return my_errno() ? my_errno() : EIO;
+
+    int err= 0;
+    if (ftruncate(fd, it->second)) err= errno;
+    else if (my_sync(fd, MYF(MY_WME))) err= EIO;
+    my_close(fd, MYF(0));
+    if (err) return err;
+  }
+  return 0;
+}
+
+/* Read the donor and the LSN the data files were copied at */
+static bool native_read_base(char* const uuid, ulonglong* const lsn)
+{
+  char path[FN_REFLEN];
+  snprintf(path, sizeof(path), "%s%s", mysql_real_data_home,
+           WSREP_SST_NATIVE_BASE_FILE);
+
+  File const fd= my_open(path, O_RDONLY | O_BINARY, MYF(0));
+  if (fd < 0) return false;
+
+  char buf[UUID_LENGTH + 32];
+  size_t const len= my_read(fd, (uchar*)buf, sizeof(buf) - 1, MYF(0));
+  my_close(fd, MYF(0));
+  if (len == MY_FILE_ERROR) return false;
+  buf[len]= '\0';
+
+  return sscanf(buf, "%36s %llu", uuid, lsn) == 2 &&
+         strlen(uuid) == UUID_LENGTH;
+}
+
+static int native_write_base(const char* const uuid, ulonglong const lsn)
+{
+  char path[FN_REFLEN];
+  snprintf(path, sizeof(path), "%s%s", mysql_real_data_home,
+           WSREP_SST_NATIVE_BASE_FILE);
+
+  char buf[UUID_LENGTH + 32];
+  size_t const len= snprintf(buf, sizeof(buf), "%s %llu\n", uuid, lsn);
+
+  File const fd= my_create(path, 0660, O_WRONLY | O_TRUNC | O_BINARY,
+                           MYF(MY_WME));
+  if (fd < 0) return my_errno() ? my_errno() : EIO;
+
+  int err= 0;
+  if (my_write(fd, (uchar*)buf, len, MYF(MY_WME | MY_NABP)) ||
+      my_sync(fd, MYF(MY_WME)))
+    err= EIO;
+  my_close(fd, MYF(0));
+  return err;
+}
+
+/* LSN of the latest checkpoint in the redo log, 0 if there is none */
+static ulonglong native_checkpoint_lsn()
+{
+  ulonglong const no1= native_read_int("ib_logfile0", NATIVE_LOG_CHECKPOINT_1,
+                                       8);
+  ulonglong const no2= native_read_int("ib_logfile0", NATIVE_LOG_CHECKPOINT_2,
+                                       8);
+
+  return native_read_int("ib_logfile0",
+                         (no1 >= no2 ? NATIVE_LOG_CHECKPOINT_1
+                                     : NATIVE_LOG_CHECKPOINT_2) +
+                         NATIVE_LOG_CHECKPOINT_LSN, 8);
+}
+
+static int native_send_space(Vio* const vio, const char* const rel)
+{
+  ulonglong const space_id= native_read_int(rel, NATIVE_PAGE_SPACE_ID, 4);
+  return native_send_message(vio, WSREP_SST_NATIVE_SPACE, rel, space_id,
+                             NULL, 0);
+}
+
+/* Offer the tablespace files with their ids */
+static int native_send_spaces(Vio* const vio)
+{
+  MY_DIR* const home= my_dir(mysql_real_data_home, MYF(MY_WANT_STAT));
+  if (!home) return errno ? errno : EIO;
+
+  int err= 0;
+  for (uint i= 0; !err && i < home->number_off_files; ++i)
+  {
+    const FILEINFO& db= home->dir_entry[i];
+    if (db.name[0] == '.' || db.name[0] == '#') continue;
+
+    if (!MY_S_ISDIR(db.mystat->st_mode))
+    {
+      if (native_is_data_file(db.name)) err= native_send_space(vio, db.name);
+      continue;
+    }
+
+    char db_path[FN_REFLEN];
+    snprintf(db_path, sizeof(db_path), "%s%s", mysql_real_data_home,
+             db.name);
+
+    MY_DIR* const dir= my_dir(db_path, MYF(MY_WANT_STAT));
+    if (!dir) continue;
+
+    for (uint j= 0; !err && j < dir->number_off_files; ++j)
+    {
+      const FILEINFO& f= dir->dir_entry[j];
+      if (!MY_S_ISREG(f.mystat->st_mode) || strcmp(fn_ext(f.name), ".ibd"))
+        continue;
+
+      char rel[FN_REFLEN];
+      snprintf(rel, sizeof(rel), "%s/%s", db.name, f.name);
+      err= native_send_space(vio, rel);
+    }
+    my_dirend(dir);
+  }
+  my_dirend(home);
+
+  return err;
+}
+
+struct native_bitmap_file
+{
+  ulong       seq;
+  ulonglong   start_lsn;
+  std::string name;
+
+  bool operator<(const native_bitmap_file& other) const
+  { return seq < other.seq; }
+};
+
+/* Offer the changed page bitmap files with the changes since base_lsn */
+static int native_send_bitmaps(Vio* const vio, uchar* const buf,
+                               ulonglong const base_lsn)
+{
+  MY_DIR* const home= my_dir(mysql_real_data_home, MYF(0));
+  if (!home) return errno ? errno : EIO;
+
+  std::vector<native_bitmap_file> files;
+  for (uint i= 0; i < home->number_off_files; ++i)
+  {
+    native_bitmap_file file;
+    if (sscanf(home->dir_entry[i].name, NATIVE_BITMAP_PREFIX "%lu_%llu.xdb",
+               &file.seq, &file.start_lsn) == 2)
+    {
+      file.name= home->dir_entry[i].name;
+      files.push_back(file);
+    }
+  }
+  my_dirend(home);
+
+  std::sort(files.begin(), files.end());
+
+  int err= 0;
+  for (size_t i= 0; !err && i < files.size(); ++i)
+  {
+    /* the next file starts before the base, this one has no changes */
+    if (i + 1 < files.size() && files[i + 1].start_lsn <= base_lsn) continue;
+
+    char path[FN_REFLEN];
+    snprintf(path, sizeof(path), "%s%s", mysql_real_data_home,
+             files[i].name.c_str());
+
+    File const file= my_open(path, O_RDONLY | O_BINARY, MYF(MY_WME));
+    if (file < 0)
+    {
+      err= my_errno() ? my_errno() : EIO;
+      break;
+    }
+
+    for (my_off_t offset= 0; !err; )
+    {
+      size_t const len= my_pread(file, buf, WSREP_SST_NATIVE_MAX_DATA,
+                                 offset, MYF(MY_WME));
+      if (len == MY_FILE_ERROR) err= EIO;
+      if (len == MY_FILE_ERROR || len == 0) break;
+      err= native_send_message(vio, WSREP_SST_NATIVE_WRITE,
+                               files[i].name.c_str(), offset, buf, len);
+      offset+= len;
+    }
+    my_close(file, MYF(0));
+  }
+
+  return err;
+}
+
+/*
+  Offer the data files of an earlier native SST to the donor: which donor
+  they were copied from at which LSN, the tablespace files and the changed
+  page bitmaps since. The offer ends with the LSN InnoDB was shut down at,
+  there is no offer if it was not shut down cleanly, the data files can be
+  ahead of the bitmaps then.
+*/
+static int native_send_offer(Vio* const vio, uchar* const buf)
+{
+  char      uuid[UUID_LENGTH + 1];
+  ulonglong base_lsn;
+
+  if (!native_read_base(uuid, &base_lsn))
+    return native_send_message(vio, WSREP_SST_NATIVE_END, "", 0, NULL, 0);
+
+  ulonglong const lsn= native_checkpoint_lsn();
+  if (!lsn || lsn != native_read_int("ibdata1", NATIVE_FILE_FLUSH_LSN, 8))
+  {
+    WSREP_INFO("Native SST: InnoDB was not shut down cleanly, "
+               "requesting a full copy");
+    return native_send_message(vio, WSREP_SST_NATIVE_END, "", 0, NULL, 0);
+  }
+
+  int err;
+  if ((err= native_send_message(vio, WSREP_SST_NATIVE_BASE, "", base_lsn,
+                                uuid, strlen(uuid))) ||
+      (err= native_send_spaces(vio)) ||
+      (err= native_send_bitmaps(vio, buf, base_lsn)) ||
+      (err= native_send_message(vio, WSREP_SST_NATIVE_END, "", lsn, NULL,
+                                0)))
+  {
+    WSREP_ERROR("Native SST: failed to send the offer: %d (%s)",
+                err, strerror(err));
+    return err;
+  }
+  return 0;
+}
+
+/* Receive whether the copy is incremental and the donor's server uuid */
+static int native_recv_incremental(native_stream* const s,
+                                   ulonglong* const base_lsn,
+                                   char* const uuid)
+{
+  native_message m;
+  int const err= native_recv_message(s->vio, &m, s->buf);
+  if (err) return err;
+
+  if (m.type != WSREP_SST_NATIVE_INCREMENTAL || m.data_len != UUID_LENGTH)
+    return EPROTO;
+
+  memcpy(uuid, s->buf, UUID_LENGTH);
+  uuid[UUID_LENGTH]= '\0';
+  *base_lsn= m.offset;
+  return 0;
+}
+
+struct native_joiner
+{
+  int          listener;
+  st_VioSSLFd* ssl_fd;     /* TLS if set */
+  char         secret[WSREP_SST_NATIVE_SECRET_LEN + 1];
+};
+
+/*
+  Accept the connections of the donor. Connections which do not present the
+  secret of this transfer in time are closed, the joiner keeps listening.
+*/
+static int native_accept(const native_joiner* const j,
+                         native_stream* const streams, uint* const n_streams,
+                         uint* const flags)
+{
+  for (uint accepted= 0; accepted < (*n_streams ? *n_streams : 1); )
+  {
+    int const fd= accept(j->listener, NULL, NULL);
+    if (fd < 0)
+    {
+      if (errno == EINTR) continue;
+      return errno;
+    }
+    native_register(fd);
+
+    Vio* const vio= vio_new(fd, VIO_TYPE_TCPIP, 0);
+    if (!vio)
+    {
+      native_close(fd);
+      return ENOMEM;
+    }
+
+    uchar hello[WSREP_SST_NATIVE_HELLO_LEN];
+    uint  no= 0, n= 0, f= 0;
+    int   err= 0;
+
+    vio_timeout(vio, 0, NATIVE_HELLO_TIMEOUT);
+    if (j->ssl_fd) err= native_ssl_handshake(j->ssl_fd, vio, true);
+    if (!err) err= native_recv(vio, hello, sizeof(hello));
+    if (!err) err= wsrep_sst_native_check_hello(hello, j->secret, &no, &n, &f);
+    if (!err && ((*n_streams && n != *n_streams) || streams[no].vio))
+      err= EPROTO;
+
+    if (err == EPROTO)
+    {
+      WSREP_ERROR("Native SST: unexpected stream %u of %u from the donor",
+                  no, n);
+      native_close(vio);
+      return err;
+    }
+    if (err)
+    {
+      WSREP_WARN("Native SST: closed a connection which is not from the "
+                 "donor: %d (%s)", err, strerror(err));
+      native_close(vio);
+      continue;
+    }
+
+    vio_timeout(vio, 0, -1);
+    streams[no].vio= vio;
+    *n_streams= n;
+    *flags= f;
+    ++accepted;
+  }
+  return 0;
+}
+
+static void* native_joiner_thread(void* a)
+{
+  native_joiner* const j= static_cast<native_joiner*>(a);
+
+#ifdef HAVE_PSI_INTERFACE
+  wsrep_pfs_register_thread(key_THREAD_wsrep_sst_joiner);
+#endif /* HAVE_PSI_INTERFACE */
+
+  my_thread_init();
+
+  native_stream streams[WSREP_SST_NATIVE_MAX_STREAMS + 1];
+  for (uint i= 0; i < array_elements(streams); ++i)
+  {
+    native_stream& s= streams[i];
+    s.no=    i;
+    s.vio=   NULL;
+    s.file=  -1;
+    s.buf=   NULL;
+    s.end=   false;
+    s.uuid=  WSREP_UUID_UNDEFINED;
+    s.seqno= WSREP_SEQNO_UNDEFINED;
+    s.lsn=   0;
+    s.err=   0;
+  }
+
+  uint n_streams= 0;
+  uint flags= 0;
+  uint started= 0;
+  ulonglong base_lsn= 0;
+  char donor_uuid[UUID_LENGTH + 1]= "";
+
+  int err= native_accept(j, streams, &n_streams, &flags);
+  native_close(j->listener);
+
+  bool const bypass= (flags & WSREP_SST_NATIVE_BYPASS) != 0;
+
+  for (uint i= 0; !err && i < n_streams; ++i)
+  {
+    streams[i].buf= static_cast<uchar*>(
+      my_malloc(key_memory_wsrep, WSREP_SST_NATIVE_MAX_DATA, MYF(0)));
+    if (!streams[i].buf) err= ENOMEM;
+  }
+
+  if (!err && !bypass &&
+      !(err= native_send_offer(streams[0].vio, streams[0].buf)) &&
+      !(err= native_recv_incremental(&streams[0], &base_lsn, donor_uuid)))
+  {
+    /* the donor sends no data before this reply */
+    native_clean_datadir(base_lsn == 0);
+  }
+
+  if (!err)
+  {
+    WSREP_INFO("Initiating native SST/IST transfer on JOINER side "
+               "(%u data streams%s%s)", n_streams - 1,
+               bypass ? ", bypass" :
+               base_lsn ? ", incremental" : "",
+               j->ssl_fd ? ", TLS" : "");
+
+    for (; !err && started + 1 < n_streams; ++started)
+    {
+      native_stream& s= streams[started + 1];
+      if ((err= pthread_create(&s.thread, NULL, native_stream_thread, &s)))
+        WSREP_ERROR("Native SST: pthread_create() failed: %d (%s)",
+                    err, strerror(err));
+    }
+
+    if (!err) err= native_receive(&streams[0]);
+  }
+
+  /* the data streams are done before the end message, unless the
+     donor failed: do not wait for them then */
+  if (err)
+  {
+    for (uint i= 0; i < n_streams; ++i)
+      if (streams[i].vio) shutdown(vio_fd(streams[i].vio), SHUT_RDWR);
+  }
+
+  for (uint i= 0; i < started; ++i)
+  {
+    pthread_join(streams[i + 1].thread, NULL);
+    if (!err) err= streams[i + 1].err;
+  }
+
+  if (!err && !streams[0].end) err= ECONNRESET;
+
+  native_paths received;
+  for (uint i= 0; i < n_streams; ++i)
+  {
+    native_stream& s= streams[i];
+    if (s.file >= 0 && my_sync(s.file, MYF(MY_WME)) && !err) err= EIO;
+    if (s.file >= 0) my_close(s.file, MYF(0));
+    native_close(s.vio);
+    my_free(s.buf);
+    received.insert(s.received.begin(), s.received.end());
+  }
+
+  if (!err && !bypass)
+  {
+    err= native_apply_sizes(streams[0].sizes);
+    if (!err && base_lsn) native_prune_datadir(received);
+    /* the next SST from the same donor can be incremental */
+    if (!err) err= native_write_base(donor_uuid, streams[0].lsn);
+  }
+
+  wsrep_uuid_t  ret_uuid=  streams[0].uuid;
+  wsrep_seqno_t ret_seqno= streams[0].seqno;
+
+  if (err)
+  {
+    WSREP_ERROR("Native SST failed on JOINER side: %d (%s)",
+                err, strerror(err));
+    ret_uuid=  WSREP_UUID_UNDEFINED;
+    ret_seqno= -err;
+  }
+
+  native_free_ssl_fd(j->ssl_fd);
+  my_free(j);
+
+  // Tell initializer thread that SST is complete
+  wsrep_sst_complete(&ret_uuid, ret_seqno, true);
+
+  my_thread_end();
+
+#ifdef HAVE_PSI_INTERFACE
+  wsrep_pfs_delete_thread();
+#endif /* HAVE_PSI_INTERFACE */
+
+  return NULL;
+}
+
+void wsrep_sst_native_forget()
+{
+  char path[FN_REFLEN];
+  snprintf(path, sizeof(path), "%s%s", mysql_real_data_home,
+           WSREP_SST_NATIVE_BASE_FILE);
+  my_delete(path, MYF(0));
+}
+
+ssize_t wsrep_sst_native_prepare(const char* const addr_in,
+                                 const char** const addr_out)
+{
+  char host[256];
+  char port[16];
+  const char* rest;
+  if (native_parse_addr(addr_in, host, sizeof(host), port, sizeof(port),
+                        &rest) || rest[0])
+  {
+    WSREP_ERROR("Invalid native SST address: '%s'", addr_in);
+    return -EINVAL;
+  }
+
+  native_joiner* const j= static_cast<native_joiner*>(
+    my_malloc(key_memory_wsrep, sizeof(native_joiner), MYF(0)));
+  if (!j) return -ENOMEM;
+
+  /* only the donor learns the secret, from the state transfer request */
+  uchar rnd[WSREP_SST_NATIVE_SECRET_LEN / 2];
+  if (my_rand_buffer(rnd, sizeof(rnd)))
+  {
+    WSREP_ERROR("Native SST: failed to generate the secret");
+    my_free(j);
+    return -EIO;
+  }
+  for (uint i= 0; i < sizeof(rnd); ++i)
+    snprintf(j->secret + 2 * i, 3, "%02x", rnd[i]);
+
+  j->ssl_fd= NULL;
+  if (native_encrypt() && !(j->ssl_fd= native_ssl_fd(true)))
+  {
+    my_free(j);
+    return -EINVAL;
+  }
+
+  size_t const host_len= wsrep_host_len(addr_in, strlen(addr_in));
+  size_t const addr_max= host_len + strlen(port) + sizeof(j->secret) +
+                         sizeof(WSREP_SST_NATIVE_SSL) + 3;
+  char* const addr= static_cast<char*>(malloc(addr_max));
+
+  j->listener= addr ? native_socket(host, port, true) : -ENOMEM;
+  if (j->listener < 0)
+  {
+    int const err= j->listener;
+    free(addr);
+    native_free_ssl_fd(j->ssl_fd);
+    my_free(j);
+    return err;
+  }
+  native_register(j->listener);
+
+  snprintf(addr, addr_max, "%.*s:%s/%s%s", int(host_len), addr_in, port,
+           j->secret, j->ssl_fd ? "/" WSREP_SST_NATIVE_SSL : "");
+  *addr_out= addr;
+
+  pthread_t tmp;
+  int const err= pthread_create(&tmp, NULL, native_joiner_thread, j);
+  if (err)
+  {
+    WSREP_ERROR("wsrep_sst_native_prepare(): pthread_create() failed: "
+                "%d (%s)", err, strerror(err));
+    native_close(j->listener);
+    native_free_ssl_fd(j->ssl_fd);
+    my_free(j);
+    free(addr);
+    *addr_out= NULL;
+    return -err;
+  }
+  pthread_detach(tmp);
+
+  return strlen(*addr_out);
+}
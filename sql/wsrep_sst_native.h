@@ -0,0 +1,151 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_SST_NATIVE_H
+#define WSREP_SST_NATIVE_H
+
+/*
+  Native state snapshot transfer.
+
+  The donor server streams its data directory to the joiner itself, without
+  an external script or backup tool:
+
+  - LOCK TABLES FOR BACKUP blocks DDL and non-transactional writes,
+  - InnoDB copies its tablespaces page by page over wsrep_sst_native_streams
+    data connections, while the redo log written meanwhile is copied over
+    the control connection,
+  - FLUSH TABLES WITH READ LOCK pauses the provider, which gives the seqno
+    of the snapshot, InnoDB copies the rest of the redo log and the files
+    of other engines are sent,
+  - the joiner writes the files into its data directory and InnoDB crash
+    recovery applies the copied redo log when the server starts.
+
+  The donor also sends a fresh innodb_buffer_pool_filename dump, which the
+  joiner loads before it joins the cluster, see wsrep_sst_warmup.
+
+  A joiner which got its data files from the same donor by native SST
+  before, and shut down cleanly since, offers them to the donor: the donor
+  then copies only the pages changed since on either node, as tracked by
+  innodb_track_changed_pages on both, and the tablespace files the joiner
+  does not have. The copy is incremental from the LSN the earlier copy
+  ended at, which the joiner keeps in WSREP_SST_NATIVE_BASE_FILE.
+
+  The joiner listens at "host:port/secret" for the donor, the address it
+  sends in the state transfer request, with "/ssl" appended if it requires
+  TLS. The secret is random for every transfer and only the donor learns
+  it, connections which do not present it are closed. With
+  wsrep_sst_native_encrypt or pxc_encrypt_cluster_traffic every connection
+  is TLS with the ssl-* settings of the server, the donor verifies the
+  certificate of the joiner against ssl-ca.
+
+  Every connection starts with a hello of WSREP_SST_NATIVE_HELLO_LEN bytes:
+
+    magic "WSST" (4), version (2), secret (WSREP_SST_NATIVE_SECRET_LEN),
+    stream number (2), number of streams (2), flags (2)
+
+  followed by messages of WSREP_SST_NATIVE_HEADER_LEN bytes header:
+
+    type (1), reserved (1), path length (2), data length (4), offset (8)
+
+  the path relative to the data directory and the data. Integers are
+  little-endian. Stream 0 is the control connection. Unless bypass is set,
+  it starts with the offer of the joiner: base, space and write messages
+  with its changed page bitmaps, ended with an end message carrying the
+  LSN InnoDB was shut down at, and the incremental message of the donor in
+  reply. It ends with the end message carrying "uuid:seqno" of the
+  snapshot and the LSN the copy of InnoDB ends at.
+*/
+
+#include "my_global.h"
+#include "wsrep_api.h"
+
+#define WSREP_SST_NATIVE_PORT        4444
+#define WSREP_SST_NATIVE_MAGIC       "WSST"
+#define WSREP_SST_NATIVE_VERSION     3
+#define WSREP_SST_NATIVE_SECRET_LEN  32
+#define WSREP_SST_NATIVE_HELLO_LEN   (12 + WSREP_SST_NATIVE_SECRET_LEN)
+#define WSREP_SST_NATIVE_HEADER_LEN  16
+#define WSREP_SST_NATIVE_MAX_STREAMS 64
+#define WSREP_SST_NATIVE_MAX_DATA    (1024 * 1024)
+
+/* joiner: donor and LSN its data files were copied at */
+#define WSREP_SST_NATIVE_BASE_FILE   "wsrep_sst_native.base"
+/* donor: changed page bitmaps received from the joiner */
+#define WSREP_SST_NATIVE_BITMAP_DIR  "#wsrep_sst_bitmaps"
+
+/* suffix of the joiner address if it requires TLS */
+#define WSREP_SST_NATIVE_SSL         "ssl"
+
+/* hello flags */
+#define WSREP_SST_NATIVE_BYPASS      1
+
+/* message types */
+#define WSREP_SST_NATIVE_FILE        'F' /* create file, extend to offset */
+#define WSREP_SST_NATIVE_WRITE       'W' /* write data at offset */
+#define WSREP_SST_NATIVE_END         'E' /* end of transfer, data is gtid */
+#define WSREP_SST_NATIVE_BASE        'B' /* data files were copied from
+                                            uuid in data at offset LSN */
+#define WSREP_SST_NATIVE_SPACE       'S' /* joiner has file of tablespace
+                                            id offset */
+#define WSREP_SST_NATIVE_INCREMENTAL 'I' /* copy is incremental from offset
+                                            LSN, 0 if full, data is uuid */
+
+/*
+  Start listening for the donor at addr_in, with WSREP_SST_NATIVE_PORT
+  if it has no port.
+  @param addr_out  malloc'ed address to send in the state transfer request
+  @return length of addr_out or negative error
+*/
+ssize_t wsrep_sst_native_prepare(const char* addr_in, const char** addr_out);
+
+/*
+  Connect to the joiner at addr and start donating in the background.
+  @return 0 or negative error
+*/
+int wsrep_sst_native_donate(const char* addr, const wsrep_gtid_t* gtid,
+                            bool bypass);
+
+/* Shut down the connections of native SST. Called under LOCK_wsrep_sst. */
+void wsrep_sst_native_cancel();
+
+/*
+  Forget the donor of the data files, so that the next native SST copies
+  them in full. Called when other SST methods replace the data files.
+*/
+void wsrep_sst_native_forget();
+
+/*
+  Split the address of the joiner, "host[:port]/secret[/ssl]".
+  @param secret  WSREP_SST_NATIVE_SECRET_LEN + 1 bytes
+  @param ssl     set if the joiner requires TLS
+  @return 0 or EINVAL
+*/
+int wsrep_sst_native_parse_addr(const char* addr, char* host, size_t host_max,
+                                char* port, size_t port_max, char* secret,
+                                bool* ssl);
+
+/* Fill the hello of stream no of n_streams */
+void wsrep_sst_native_make_hello(uchar* hello, const char* secret, uint no,
+                                 uint n_streams, uint flags);
+
+/*
+  Check the hello of a connection against the secret of this transfer.
+  @return 0, EACCES if it is not from the donor or EPROTO if its stream
+          numbers are invalid
+*/
+int wsrep_sst_native_check_hello(const uchar* hello, const char* secret,
+                                 uint* no, uint* n_streams, uint* flags);
+
+#endif /* WSREP_SST_NATIVE_H */
@@ -0,0 +1,169 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "wsrep_table_map_cache.h"
+#include "wsrep_mysqld.h"
+#include "mysqld.h"    // slave_type_conversions_options
+#include "sql_class.h"
+#include "rpl_utility.h"
+#include "my_atomic.h"
+
+#include <map>
+#include <new>
+#include <string>
+
+struct table_map_entry
+{
+  ulonglong table_map_id;  /* of the table share it was checked with */
+  ulonglong conversions;   /* slave_type_conversions it was checked with */
+  TABLE*    conv_table;
+};
+
+/* "db\0table\0" flags, type, metadata, nullability of each column ->
+   result */
+typedef std::map<std::string, table_map_entry> table_map_entries_t;
+
+struct wsrep_table_map_cache
+{
+  table_map_entries_t entries;
+  MEM_ROOT            mem_root;   /* conversion tables */
+  int64               generation; /* table_map_generation when cleared */
+};
+
+/* changed by every schema change */
+static int64 table_map_generation= 0;
+
+static void table_map_key(const RPL_TABLE_LIST* const ptr,
+                          std::string* const key)
+{
+  const table_def& def= ptr->m_tabledef;
+  uint16 const flags= def.flags();
+
+  key->assign(ptr->db);
+  key->push_back('\0');
+  key->append(ptr->table_name);
+  key->push_back('\0');
+  key->append(reinterpret_cast<const char*>(&flags), sizeof(flags));
+
+  for (ulong i= 0; i < def.size(); ++i)
+  {
+    uint16 const metadata= def.field_metadata(i);
+    key->push_back(static_cast<char>(def.binlog_type(i)));
+    key->append(reinterpret_cast<const char*>(&metadata), sizeof(metadata));
+    key->push_back(def.maybe_null(i) ? 1 : 0);
+  }
+}
+
+static void table_map_cache_clear(wsrep_table_map_cache* const cache)
+{
+  for (table_map_entries_t::iterator it= cache->entries.begin();
+       it != cache->entries.end(); ++it)
+  {
+    if (it->second.conv_table) free_blobs(it->second.conv_table);
+  }
+  cache->entries.clear();
+  free_root(&cache->mem_root, MYF(MY_MARK_BLOCKS_FREE));
+}
+
+void wsrep_table_map_cache_check(THD* const thd)
+{
+  wsrep_table_map_cache* const cache= thd->wsrep_table_map_cache;
+  if (!cache) return;
+
+  int64 const generation= my_atomic_load64(&table_map_generation);
+  if (cache->generation != generation ||
+      cache->entries.size() >= WSREP_TABLE_MAP_CACHE_MAX)
+  {
+    table_map_cache_clear(cache);
+    cache->generation= generation;
+  }
+}
+
+bool wsrep_table_map_cache_get(THD* const thd,
+                               const RPL_TABLE_LIST* const ptr,
+                               TABLE** const conv_table)
+{
+  wsrep_table_map_cache* const cache= thd->wsrep_table_map_cache;
+  if (!cache || cache->entries.empty()) return false;
+
+  std::string key;
+  table_map_key(ptr, &key);
+
+  table_map_entries_t::const_iterator const it= cache->entries.find(key);
+  if (it == cache->entries.end() ||
+      it->second.table_map_id != ptr->table->s->table_map_id.id() ||
+      it->second.conversions != slave_type_conversions_options)
+    return false;
+
+  *conv_table= it->second.conv_table;
+  return true;
+}
+
+void wsrep_table_map_cache_put(THD* const thd, Relay_log_info* const rli,
+                               RPL_TABLE_LIST* const ptr,
+                               TABLE** const conv_table)
+{
+  wsrep_table_map_cache* cache= thd->wsrep_table_map_cache;
+  if (!cache)
+  {
+    cache= new (std::nothrow) wsrep_table_map_cache;
+    if (!cache) return;
+    init_sql_alloc(key_memory_wsrep, &cache->mem_root, 4096, 0);
+    cache->generation= my_atomic_load64(&table_map_generation);
+    thd->wsrep_table_map_cache= cache;
+  }
+
+  /* cleared by the next write-set, entries in use must stay until then */
+  if (cache->entries.size() >= WSREP_TABLE_MAP_CACHE_MAX) return;
+
+  table_map_entry entry;
+  entry.table_map_id= ptr->table->s->table_map_id.id();
+  entry.conversions=  slave_type_conversions_options;
+  entry.conv_table=   NULL;
+
+  if (*conv_table)
+  {
+    /* conversion table of the statement is on its mem_root, create one
+       on the mem_root of the cache */
+    MEM_ROOT* const mem_root= thd->mem_root;
+    thd->mem_root= &cache->mem_root;
+    bool const compatible= ptr->m_tabledef.compatible_with(
+      thd, rli, ptr->table, &entry.conv_table);
+    thd->mem_root= mem_root;
+
+    if (!compatible || !entry.conv_table) return;
+    *conv_table= entry.conv_table;
+  }
+
+  std::string key;
+  table_map_key(ptr, &key);
+  cache->entries[key]= entry;
+}
+
+void wsrep_table_map_cache_invalidate()
+{
+  my_atomic_add64(&table_map_generation, 1);
+}
+
+void wsrep_table_map_cache_free(THD* const thd)
+{
+  wsrep_table_map_cache* const cache= thd->wsrep_table_map_cache;
+  if (!cache) return;
+
+  table_map_cache_clear(cache);
+  free_root(&cache->mem_root, MYF(0));
+  delete cache;
+  thd->wsrep_table_map_cache= NULL;
+}
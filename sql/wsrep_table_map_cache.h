@@ -0,0 +1,71 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef WSREP_TABLE_MAP_CACHE_H
+#define WSREP_TABLE_MAP_CACHE_H
+
+/*
+  Table map cache of applier threads.
+
+  Before applying the rows of a table, the applier checks that the columns
+  of the table map can be converted to the columns of the table, and
+  creates a conversion table when they are of different types. Write-sets
+  mostly change the same few tables, so an applier thread remembers the
+  result for each table map it has seen, with the conversion table if
+  there is one, and the next row event of the same table map skips the
+  check.
+
+  A result is used only for the same instance of the table share, so any
+  change of the table definition makes it stale. Additionally every
+  schema change in total order or rolling schema upgrade clears the caches
+  of all appliers. A stale cache, or one which has
+  WSREP_TABLE_MAP_CACHE_MAX table maps, is cleared before the next
+  write-set is applied.
+*/
+
+#include "my_global.h"
+
+class THD;
+struct TABLE;
+class Relay_log_info;
+struct RPL_TABLE_LIST;
+
+#define WSREP_TABLE_MAP_CACHE_MAX 256
+
+/* Clear the cache of applier thd if it is stale or full */
+void wsrep_table_map_cache_check(THD* thd);
+
+/*
+  Look up the table map of ptr for its opened table.
+  @param conv_table  set to the conversion table, NULL if none is needed
+  @return true if found
+*/
+bool wsrep_table_map_cache_get(THD* thd, const RPL_TABLE_LIST* ptr,
+                               TABLE** conv_table);
+
+/*
+  Remember that the table map of ptr is compatible with its opened table.
+  If a conversion table is needed, it is created again to stay in the
+  cache, and conv_table is set to it.
+*/
+void wsrep_table_map_cache_put(THD* thd, Relay_log_info* rli,
+                               RPL_TABLE_LIST* ptr, TABLE** conv_table);
+
+/* Make the caches of all appliers stale, after a schema change */
+void wsrep_table_map_cache_invalidate();
+
+void wsrep_table_map_cache_free(THD* thd);
+
+#endif /* WSREP_TABLE_MAP_CACHE_H */
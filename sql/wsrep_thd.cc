@@ -14,6 +14,8 @@
    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
 
 #include "wsrep_thd.h"
+#include "wsrep_nbo.h"
+#include "wsrep_pool.h"
 
 #include "transaction.h"
 #include "rpl_rli.h"
@@ -103,7 +105,103 @@ static Relay_log_info* wsrep_relay_log_init(const char* log_fname)
   return (rli);
 }
 
-static void wsrep_prepare_bf_thd(THD *thd, struct wsrep_thd_shadow* shadow)
+static void wsrep_relay_log_free(Relay_log_info* rli)
+{
+  delete rli->current_mts_submode;
+  rli->current_mts_submode= 0;
+  delete rli;
+}
+
+/*
+  Relay log infos of replaying threads. Creating one allocates its
+  repository, description event and locks, so a replaying thread borrows
+  one from the pool and returns it when done. Up to
+  WSREP_REPLAY_RLI_POOL_MAX of them are kept between replays.
+*/
+#define WSREP_REPLAY_RLI_POOL_MAX 16
+
+/* all protected by LOCK_wsrep_replay */
+static mysql_mutex_t   LOCK_wsrep_replay;
+static Relay_log_info* replay_rli_pool[WSREP_REPLAY_RLI_POOL_MAX];
+static uint            replay_rli_pooled= 0;
+static ulonglong       replay_count= 0;
+static ulonglong       replay_time= 0;     /* microseconds */
+static ulonglong       replay_max_time= 0;
+
+/* values exported to SHOW STATUS */
+static long long wsrep_replay_avg_time= 0;
+static long long wsrep_replay_max_time= 0;
+
+void wsrep_replay_init()
+{
+  mysql_mutex_init(key_LOCK_wsrep_replay, &LOCK_wsrep_replay,
+                   MY_MUTEX_INIT_FAST);
+}
+
+void wsrep_replay_deinit()
+{
+  while (replay_rli_pooled)
+    wsrep_relay_log_free(replay_rli_pool[--replay_rli_pooled]);
+  mysql_mutex_destroy(&LOCK_wsrep_replay);
+}
+
+static Relay_log_info* wsrep_replay_rli_get()
+{
+  Relay_log_info* rli= NULL;
+  mysql_mutex_lock(&LOCK_wsrep_replay);
+  if (replay_rli_pooled) rli= replay_rli_pool[--replay_rli_pooled];
+  mysql_mutex_unlock(&LOCK_wsrep_replay);
+
+  return rli ? rli : wsrep_relay_log_init("wsrep_relay");
+}
+
+static void wsrep_replay_rli_put(Relay_log_info* rli)
+{
+  rli->cleanup_after_session();
+  rli->info_thd= NULL;
+
+  mysql_mutex_lock(&LOCK_wsrep_replay);
+  bool const pooled= replay_rli_pooled < WSREP_REPLAY_RLI_POOL_MAX;
+  if (pooled) replay_rli_pool[replay_rli_pooled++]= rli;
+  mysql_mutex_unlock(&LOCK_wsrep_replay);
+
+  if (!pooled) wsrep_relay_log_free(rli);
+}
+
+static void wsrep_replay_account(ulonglong const start)
+{
+  ulonglong const now= my_micro_time();
+  ulonglong const time= now > start ? now - start : 0;
+
+  mysql_mutex_lock(&LOCK_wsrep_replay);
+  replay_count++;
+  replay_time+= time;
+  if (time > replay_max_time) replay_max_time= time;
+  mysql_mutex_unlock(&LOCK_wsrep_replay);
+}
+
+int wsrep_show_replay_avg_time(THD *thd, SHOW_VAR *var, char *buff)
+{
+  mysql_mutex_lock(&LOCK_wsrep_replay);
+  wsrep_replay_avg_time= replay_count ? replay_time / replay_count : 0;
+  mysql_mutex_unlock(&LOCK_wsrep_replay);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_replay_avg_time;
+  return 0;
+}
+
+int wsrep_show_replay_max_time(THD *thd, SHOW_VAR *var, char *buff)
+{
+  mysql_mutex_lock(&LOCK_wsrep_replay);
+  wsrep_replay_max_time= replay_max_time;
+  mysql_mutex_unlock(&LOCK_wsrep_replay);
+  var->type= SHOW_LONGLONG;
+  var->value= (char*)&wsrep_replay_max_time;
+  return 0;
+}
+
+static void wsrep_prepare_bf_thd(THD *thd, struct wsrep_thd_shadow* shadow,
+                                 bool replay= false)
 {
   shadow->options       = thd->variables.option_bits;
   shadow->server_status = thd->server_status;
@@ -129,7 +227,8 @@ static void wsrep_prepare_bf_thd(THD *thd, struct wsrep_thd_shadow* shadow)
 
   if (!thd->wsrep_rli)
   {
-    thd->wsrep_rli = wsrep_relay_log_init("wsrep_relay");
+    thd->wsrep_rli = replay ? wsrep_replay_rli_get()
+                            : wsrep_relay_log_init("wsrep_relay");
     assert(!thd->rli_slave);
     thd->rli_slave = thd->wsrep_rli;
     thd->wsrep_rli->info_thd= thd;
@@ -152,7 +251,8 @@ static void wsrep_prepare_bf_thd(THD *thd, struct wsrep_thd_shadow* shadow)
   shadow->row_count_func= thd->get_row_count_func();
 }
 
-static void wsrep_return_from_bf_mode(THD *thd, struct wsrep_thd_shadow* shadow)
+static void wsrep_return_from_bf_mode(THD *thd, struct wsrep_thd_shadow* shadow,
+                                      bool replay= false)
 {
   thd->variables.option_bits  = shadow->options;
   thd->server_status          = shadow->server_status;
@@ -165,9 +265,10 @@ static void wsrep_return_from_bf_mode(THD *thd, struct wsrep_thd_shadow* shadow)
   assert(thd->rli_slave == thd->wsrep_rli);
   thd->rli_slave = NULL;
 
-  delete thd->wsrep_rli->current_mts_submode;
-  thd->wsrep_rli->current_mts_submode = 0;
-  delete thd->wsrep_rli;
+  if (replay)
+    wsrep_replay_rli_put(thd->wsrep_rli);
+  else
+    wsrep_relay_log_free(thd->wsrep_rli);
   thd->wsrep_rli = 0;
 #ifdef GALERA
   thd->slave_thread = FALSE;
@@ -193,11 +294,13 @@ void wsrep_replay_sp_transaction(THD* thd)
   }
   thd->mdl_context.release_transactional_locks();
 
+  ulonglong const replay_start= my_micro_time();
+
   THD *replay_thd= new THD(true, true);
   replay_thd->thread_stack= thd->thread_stack;
 
   struct wsrep_thd_shadow shadow;
-  wsrep_prepare_bf_thd(replay_thd, &shadow);
+  wsrep_prepare_bf_thd(replay_thd, &shadow, true);
   replay_thd->wsrep_trx_meta= thd->wsrep_trx_meta;
   replay_thd->wsrep_ws_handle= thd->wsrep_ws_handle;
   replay_thd->wsrep_ws_handle.trx_id= WSREP_UNDEFINED_TRX_ID;
@@ -214,10 +317,12 @@ void wsrep_replay_sp_transaction(THD* thd)
                                           &replay_thd->wsrep_ws_handle,
                                           (void*) replay_thd);
 
-  wsrep_return_from_bf_mode(replay_thd, &shadow);
+  wsrep_return_from_bf_mode(replay_thd, &shadow, true);
   replay_thd->restore_globals();
   delete replay_thd;
 
+  wsrep_replay_account(replay_start);
+
   mysql_mutex_lock(&thd->LOCK_wsrep_thd);
 
   thd->store_globals();
@@ -356,8 +461,10 @@ void wsrep_replay_transaction(THD *thd)
                   WSREP_QUERY(thd),
                   (long long)wsrep_thd_trx_seqno(thd));
 
+      ulonglong const replay_start= my_micro_time();
+
       struct wsrep_thd_shadow shadow;
-      wsrep_prepare_bf_thd(thd, &shadow);
+      wsrep_prepare_bf_thd(thd, &shadow, true);
 
       /* From trans_begin() */
       thd->variables.option_bits|= OPTION_BEGIN;
@@ -367,7 +474,8 @@ void wsrep_replay_transaction(THD *thd)
                                     &thd->wsrep_ws_handle,
                                     (void *)thd);
 
-      wsrep_return_from_bf_mode(thd, &shadow);
+      wsrep_return_from_bf_mode(thd, &shadow, true);
+      wsrep_replay_account(replay_start);
       if (thd->wsrep_conflict_state != REPLAYING)
         WSREP_WARN("Lost replaying mode: %d", thd->wsrep_conflict_state );
 
@@ -467,7 +575,11 @@ static void wsrep_replication_process(THD *thd)
   thd->variables.option_bits|= OPTION_BEGIN;
   thd->server_status|= SERVER_STATUS_IN_TRANS;
 
+  wsrep_pool_applier_start(thd);
+
   rcode = wsrep->recv(wsrep, (void *)thd);
+
+  wsrep_pool_applier_end(thd);
   DBUG_PRINT("wsrep",("wsrep_repl returned: %d", rcode));
 
   WSREP_INFO("applier thread exiting (code:%d)", rcode);
@@ -663,6 +775,26 @@ static void wsrep_rollback_process(THD *thd)
   DBUG_VOID_RETURN;
 }
 
+/* Executes a non-blocking ALTER received from the cluster, see wsrep_nbo.h */
+void wsrep_NBO_process(THD *thd)
+{
+  DBUG_ENTER("wsrep_NBO_process");
+
+  struct wsrep_thd_shadow shadow;
+  wsrep_prepare_bf_thd(thd, &shadow);
+  wsrep_NBO_worker(thd);
+  wsrep_return_from_bf_mode(thd, &shadow);
+
+  DBUG_VOID_RETURN;
+}
+
+bool wsrep_create_NBO_worker()
+{
+  /* the end of the operation is not delivered after disconnecting */
+  if (!wsrep_connected) return true;
+  return create_wsrep_THD(key_THREAD_wsrep_NBO_worker, wsrep_NBO_process);
+}
+
 void wsrep_create_rollbacker()
 {
   if (wsrep_provider && strcasecmp(wsrep_provider, "none"))
@@ -99,8 +99,14 @@ int wsrep_show_bf_aborts (THD *thd, SHOW_VAR *var, char *buff);
 void wsrep_client_rollback(THD *thd);
 void wsrep_replay_sp_transaction(THD* thd);
 void wsrep_replay_transaction(THD *thd);
+void wsrep_replay_init();
+void wsrep_replay_deinit();
+int  wsrep_show_replay_avg_time(THD *thd, SHOW_VAR *var, char *buff);
+int  wsrep_show_replay_max_time(THD *thd, SHOW_VAR *var, char *buff);
 void wsrep_create_appliers(long threads);
 void wsrep_create_rollbacker();
+bool wsrep_create_NBO_worker();
+void wsrep_NBO_process(THD *thd);
 
 int  wsrep_abort_thd(void *bf_thd_ptr, void *victim_thd_ptr,
                                 my_bool signal);
@@ -619,6 +619,15 @@ bool wsrep_slave_threads_update (sys_var *self, THD* thd, enum_var_type type)
   return false;
 }
 
+bool wsrep_slave_threads_max_update (sys_var *self, THD* thd,
+                                     enum_var_type type)
+{
+  /* adaptive pool disabled, return to wsrep_slave_threads appliers */
+  if (wsrep_slave_threads_max <= (ulong) wsrep_slave_threads)
+    return wsrep_slave_threads_update(self, thd, type);
+  return false;
+}
+
 bool wsrep_desync_check (sys_var *self, THD* thd, set_var* var)
 {
   bool new_wsrep_desync = var->save_result.ulonglong_value;
@@ -82,6 +82,7 @@ extern bool wsrep_sst_donor_update           UPDATE_ARGS;
 
 extern bool wsrep_slave_threads_check        CHECK_ARGS;
 extern bool wsrep_slave_threads_update       UPDATE_ARGS;
+extern bool wsrep_slave_threads_max_update   UPDATE_ARGS;
 
 extern bool wsrep_desync_check               CHECK_ARGS;
 extern bool wsrep_desync_update              UPDATE_ARGS;
@@ -66,6 +66,7 @@ Created 10/16/1994 Heikki Tuuri
 #include "buf0lru.h"
 #include "btr0btr.h"
 #include "btr0sea.h"
+#include "buf0rea.h"
 #include "row0log.h"
 #include "row0purge.h"
 #include "row0upd.h"
@@ -6229,6 +6230,93 @@ btr_estimate_n_rows_in_range(
 	return(ret);
 }
 
+/** Starts an asynchronous read of the leaf page where a search for the
+tuple would end, unless the page is already in the buffer pool. Only pages
+which already are in the buffer pool are searched: if a non-leaf page on
+the path is missing, the read of that page is started instead. The caller
+never waits for a page read.
+@param[in]	index	index
+@param[in]	tuple	search tuple
+@return true if a page read was started */
+bool
+btr_cur_prefetch_leaf(
+	dict_index_t*	index,
+	const dtuple_t*	tuple)
+{
+	mtr_t		mtr;
+	page_cur_t	page_cursor;
+	mem_heap_t*	heap		= NULL;
+	ulint		offsets_[REC_OFFS_NORMAL_SIZE];
+	ulint*		offsets		= offsets_;
+	bool		read		= false;
+
+	rec_offs_init(offsets_);
+
+	ut_ad(!dict_index_is_spatial(index));
+	ut_ad(!(index->type & DICT_FTS));
+
+	if (index->page == FIL_NULL) {
+		return(false);
+	}
+
+	const page_size_t	page_size(dict_table_page_size(index->table));
+	page_id_t		page_id(dict_index_get_space(index),
+					dict_index_get_page(index));
+
+	mtr_start(&mtr);
+
+	/* Same latching as in a BTR_SEARCH_LEAF descent */
+	mtr_s_lock(dict_index_get_lock(index), &mtr);
+
+	for (;;) {
+		buf_block_t*	block = buf_page_get_gen(
+			page_id, page_size, RW_S_LATCH, NULL,
+			BUF_GET_IF_IN_POOL, __FILE__, __LINE__, &mtr);
+
+		if (block == NULL) {
+			read = true;
+			break;
+		}
+
+		const page_t*	page = buf_block_get_frame(block);
+
+		if (page_is_leaf(page)) {
+			break;
+		}
+
+		ulint	up_match = 0;
+		ulint	low_match = 0;
+
+		page_cur_search_with_match(
+			block, index, tuple, PAGE_CUR_LE,
+			&up_match, &low_match, &page_cursor, NULL);
+
+		const rec_t*	node_ptr = page_cur_get_rec(&page_cursor);
+
+		if (!page_rec_is_user_rec(node_ptr)) {
+			break;
+		}
+
+		offsets = rec_get_offsets(node_ptr, index, offsets,
+					  ULINT_UNDEFINED, &heap);
+
+		page_id.set_page_no(
+			btr_node_ptr_get_child_page_no(node_ptr, offsets));
+	}
+
+	mtr_commit(&mtr);
+
+	if (heap != NULL) {
+		mem_heap_free(heap);
+	}
+
+	if (read) {
+		buf_read_page_background(page_id, page_size, false);
+	}
+
+	return(read);
+}
+
 /*******************************************************************//**
 Record the number of non_null key values in a given index for
 each n-column prefix of the index where 1 <= n <= dict_index_get_n_unique(index).
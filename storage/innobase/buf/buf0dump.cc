@@ -70,6 +70,16 @@ static ibool	buf_load_should_start = FALSE;
 
 static ibool	buf_load_abort_flag = FALSE;
 
+/* Progress of the buffer pool load, see buf_load_warmup(). A load is
+pending from the request until the dump/load thread has done it. */
+static bool		buf_load_requested = false;
+static bool		buf_load_pending = false;
+static volatile ulint	buf_load_n_total = 0;
+static volatile ulint	buf_load_n_issued = 0;
+
+/* Read the pages at full speed, without yielding to other activity */
+static bool		buf_load_high_priority = false;
+
 /* Used to temporary store dump info in order to avoid IO while holding
 buffer pool LRU list mutex during dump and also to sort the contents of the
 dump before reading the pages from disk during load.
@@ -103,6 +113,8 @@ void
 buf_load_start()
 /*============*/
 {
+	buf_load_requested = true;
+	buf_load_pending = true;
 	buf_load_should_start = TRUE;
 	os_event_set(srv_buf_dump_event);
 }
@@ -266,13 +278,18 @@ Perform a buffer pool dump into the file specified by
 innodb_buffer_pool_filename. If any errors occur then the value of
 innodb_buffer_pool_dump_status will be set accordingly, see buf_dump_status().
 The dump filename can be specified by (relative to srv_data_home):
-SET GLOBAL innodb_buffer_pool_filename='filename'; */
+SET GLOBAL innodb_buffer_pool_filename='filename';
+@return whether the dump was written */
 static
-void
+bool
 buf_dump(
 /*=====*/
-	ibool	obey_shutdown)	/*!< in: quit if we are in a shutting down
-				state */
+	ibool		obey_shutdown,	/*!< in: quit if we are in a shutting
+					down state */
+	const char*	suffix = NULL,	/*!< in: appended to the name of
+					the dump file, or NULL */
+	char*		path = NULL)	/*!< out: name of the file written,
+					OS_FILE_MAX_PATH bytes, or NULL */
 {
 #define SHOULD_QUIT()	(SHUTTING_DOWN() && obey_shutdown)
 
@@ -285,6 +302,17 @@ buf_dump(
 
 	buf_dump_generate_path(full_filename, sizeof(full_filename));
 
+	if (suffix != NULL) {
+		size_t	len = strlen(full_filename);
+
+		ut_snprintf(full_filename + len, sizeof(full_filename) - len,
+			    "%s", suffix);
+	}
+
+	if (path != NULL) {
+		ut_snprintf(path, OS_FILE_MAX_PATH, "%s", full_filename);
+	}
+
 	ut_snprintf(tmp_filename, sizeof(tmp_filename),
 		    "%s.incomplete", full_filename);
 
@@ -296,7 +324,7 @@ buf_dump(
 		buf_dump_status(STATUS_ERR,
 				"Cannot open '%s' for writing: %s",
 				tmp_filename, strerror(errno));
-		return;
+		return(false);
 	}
 	/* else */
 
@@ -343,7 +371,7 @@ buf_dump(
 					(ulint) (n_pages * sizeof(*dump)),
 					strerror(errno));
 			/* leave tmp_filename to exist */
-			return;
+			return(false);
 		}
 
 		for (bpage = UT_LIST_GET_FIRST(buf_pool->LRU), j = 0;
@@ -371,7 +399,7 @@ buf_dump(
 						"Cannot write to '%s': %s",
 						tmp_filename, strerror(errno));
 				/* leave tmp_filename to exist */
-				return;
+				return(false);
 			}
 
 			if (j % 128 == 0) {
@@ -393,7 +421,7 @@ buf_dump(
 		buf_dump_status(STATUS_ERR,
 				"Cannot close '%s': %s",
 				tmp_filename, strerror(errno));
-		return;
+		return(false);
 	}
 	/* else */
 
@@ -403,7 +431,7 @@ buf_dump(
 				"Cannot delete '%s': %s",
 				full_filename, strerror(errno));
 		/* leave tmp_filename to exist */
-		return;
+		return(false);
 	}
 	/* else */
 
@@ -414,7 +442,7 @@ buf_dump(
 				tmp_filename, full_filename,
 				strerror(errno));
 		/* leave tmp_filename to exist */
-		return;
+		return(false);
 	}
 	/* else */
 
@@ -424,6 +452,8 @@ buf_dump(
 
 	buf_dump_status(STATUS_INFO,
 			"Buffer pool(s) dump completed at %s", now);
+
+	return(true);
 }
 
 /** Artificially delay the buffer pool loading if necessary. The idea of this
@@ -444,7 +474,8 @@ buf_load_throttle_if_needed(
 	ulint*			last_activity_count,
 	ulint 			n_io)
 {
-	if (n_io % srv_io_capacity < srv_io_capacity - 1) {
+	if (buf_load_high_priority
+	    || n_io % srv_io_capacity < srv_io_capacity - 1) {
 		return;
 	}
 
@@ -518,6 +549,8 @@ buf_load()
 
 	/* Ignore any leftovers from before */
 	buf_load_abort_flag = FALSE;
+	buf_load_n_total = 0;
+	buf_load_n_issued = 0;
 
 	buf_dump_generate_path(full_filename, sizeof(full_filename));
 
@@ -663,8 +696,12 @@ buf_load()
 	mysql_stage_set_work_estimated(pfs_stage_progress, dump_n);
 	mysql_stage_set_work_completed(pfs_stage_progress, 0);
 
+	buf_load_n_total = dump_n;
+
 	for (i = 0; i < dump_n && !SHUTTING_DOWN(); i++) {
 
+		buf_load_n_issued = i;
+
 		/* space_id for this iteration of the loop */
 		const ulint	this_space_id = BUF_DUMP_SPACE(dump[i]);
 
@@ -687,9 +724,11 @@ buf_load()
 			continue;
 		}
 
+		/* at high priority the reads are asynchronous, so that many
+		of them are in flight at once */
 		buf_read_page_background(
 			page_id_t(this_space_id, BUF_DUMP_PAGE(dump[i])),
-			page_size, true);
+			page_size, !buf_load_high_priority);
 
 		if (i % 64 == 63) {
 			os_aio_simulated_wake_handler_threads();
@@ -714,6 +753,7 @@ buf_load()
 				fil_space_release(space);
 			}
 			buf_load_abort_flag = FALSE;
+			buf_load_n_total = 0;
 			ut_free(dump);
 			buf_load_status(
 				STATUS_INFO,
@@ -736,6 +776,8 @@ buf_load()
 		fil_space_release(space);
 	}
 
+	buf_load_n_issued = i;
+
 	ut_free(dump);
 
 	ut_sprintf_timestamp(now);
@@ -762,6 +804,55 @@ buf_load_abort()
 	buf_load_abort_flag = TRUE;
 }
 
+/** Dump the buffer pool now, in the calling thread, into a file named
+after the dump file with a suffix.
+@param[in]	suffix	appended to the name of the dump file
+@param[out]	path	name of the file written, OS_FILE_MAX_PATH bytes
+@return whether the dump was written */
+bool
+buf_dump_to_file(
+	const char*	suffix,
+	char*		path)
+{
+	return(buf_dump(TRUE, suffix, path));
+}
+
+/** Warm up the buffer pool from the dump file: start a load unless one was
+requested since startup, and let the load read the pages at full speed
+while high_priority is set.
+@param[in]	high_priority	whether to read without throttling
+@return percentage of the pages in the dump file which are read in, 100
+if there is nothing to load */
+ulint
+buf_load_warmup(
+	bool	high_priority)
+{
+	if (!srv_buf_dump_thread_active) {
+		/* read-only mode or shutdown: nothing will be loaded */
+		return(100);
+	}
+
+	buf_load_high_priority = high_priority;
+
+	if (high_priority && !buf_load_requested) {
+		buf_load_start();
+	}
+
+	const ulint	total = buf_load_n_total;
+
+	if (total == 0) {
+		return(buf_load_pending ? 0 : 100);
+	}
+
+	/* the pages issued are in the buffer pool once their reads are
+	done */
+	const ulint	issued = buf_load_n_issued;
+	const ulint	pending = buf_get_n_pending_read_ios();
+	const ulint	read = issued > pending ? issued - pending : 0;
+
+	return(ut_min(read * 100 / total, static_cast<ulint>(100)));
+}
+
 /*****************************************************************//**
 This is the main thread for buffer pool dump/load. It waits for an
 event and when waked up either performs a dump or load and sleeps
@@ -786,15 +877,8 @@ DECLARE_THREAD(buf_dump_thread)(
 	buf_dump_status(STATUS_VERBOSE, "Dumping of buffer pool not started");
 	buf_load_status(STATUS_VERBOSE, "Loading of buffer pool not started");
 
-	if (srv_buffer_pool_load_at_startup) {
-#ifdef WITH_WSREP
-		if (!wsrep_recovery) {
-#endif /* WITH_WSREP */
-		buf_load();
-#ifdef WITH_WSREP
-		}
-#endif /* WITH_WSREP */
-	}
+	/* The load at startup is requested by buf_load_start() before the
+	thread is created, so that it is pending from the start. */
 
 	while (!SHUTTING_DOWN()) {
 
@@ -808,6 +892,7 @@ DECLARE_THREAD(buf_dump_thread)(
 		if (buf_load_should_start) {
 			buf_load_should_start = FALSE;
 			buf_load();
+			buf_load_pending = false;
 		}
 
 		os_event_reset(srv_buf_dump_event);
@@ -109,6 +109,7 @@ this program; if not, write to the Free Software Foundation, Inc.,
 #include "row0upd.h"
 #include "srv0mon.h"
 #include "srv0srv.h"
+#include "srv0sst.h"
 #include "srv0start.h"
 #ifdef UNIV_DEBUG
 #include "trx0purge.h"
@@ -137,6 +138,8 @@ enum_tx_isolation thd_get_trx_isolation(const THD* thd);
 #include "../storage/innobase/include/ut0byte.h"
 #include "wsrep_api.h"
 #include <wsrep_mysqld.h>
+#include <wsrep_key_batch.h>
+#include <wsrep_row_digest.h>
 #include <my_md5.h>
 extern my_bool wsrep_certify_nonPK;
 class  binlog_trx_data;
@@ -1168,8 +1171,18 @@ static SHOW_VAR innodb_status_variables[]= {
   (char*) &export_vars.innodb_ibuf_free_list,		  SHOW_LONG, SHOW_SCOPE_GLOBAL},
   {"ibuf_segment_size",
   (char*) &export_vars.innodb_ibuf_segment_size,	  SHOW_LONG, SHOW_SCOPE_GLOBAL},
+  {"log_flush_batch_bytes",
+  (char*) &export_vars.innodb_log_flush_batch_bytes,	  SHOW_LONGLONG, SHOW_SCOPE_GLOBAL},
+  {"log_flush_batches",
+  (char*) &export_vars.innodb_log_flush_batches,	  SHOW_LONG, SHOW_SCOPE_GLOBAL},
+  {"log_waiter_sleeps",
+  (char*) &export_vars.innodb_log_waiter_sleeps,	  SHOW_LONG, SHOW_SCOPE_GLOBAL},
   {"log_waits",
   (char*) &export_vars.innodb_log_waits,		  SHOW_LONG, SHOW_SCOPE_GLOBAL},
+  {"log_write_batch_bytes",
+  (char*) &export_vars.innodb_log_write_batch_bytes,	  SHOW_LONGLONG, SHOW_SCOPE_GLOBAL},
+  {"log_write_batches",
+  (char*) &export_vars.innodb_log_write_batches,	  SHOW_LONG, SHOW_SCOPE_GLOBAL},
   {"log_write_requests",
   (char*) &export_vars.innodb_log_write_requests,	  SHOW_LONG, SHOW_SCOPE_GLOBAL},
   {"log_writes",
@@ -1214,6 +1227,10 @@ static SHOW_VAR innodb_status_variables[]= {
   (char*) &export_vars.innodb_purge_trx_id,		  SHOW_LONGLONG, SHOW_SCOPE_GLOBAL},
   {"purge_undo_no",
   (char*) &export_vars.innodb_purge_undo_no,		  SHOW_LONGLONG, SHOW_SCOPE_GLOBAL},
+  {"recovery_apply_time",
+  (char*) &export_vars.innodb_recovery_apply_time,	  SHOW_LONG, SHOW_SCOPE_GLOBAL},
+  {"recovery_pages_applied",
+  (char*) &export_vars.innodb_recovery_pages_applied,	  SHOW_LONG, SHOW_SCOPE_GLOBAL},
   {"row_lock_current_waits",
   (char*) &export_vars.innodb_row_lock_current_waits,	  SHOW_LONG, SHOW_SCOPE_GLOBAL},
   {"row_lock_time",
@@ -2321,6 +2338,17 @@ static void
 wsrep_fake_trx_id(handlerton* hton, THD *thd);
 static int innobase_wsrep_set_checkpoint(handlerton* hton, const XID* xid);
 static int innobase_wsrep_get_checkpoint(handlerton* hton, XID* xid);
+static int innobase_wsrep_sst_backup_begin(handlerton* hton,
+					   Wsrep_sst_sink* sink, uint stream,
+					   const Wsrep_sst_base* base);
+static int innobase_wsrep_sst_backup_copy(handlerton* hton,
+					  Wsrep_sst_sink* sink, uint stream);
+static int innobase_wsrep_sst_backup_redo(handlerton* hton,
+					  Wsrep_sst_sink* sink, uint stream);
+static int innobase_wsrep_sst_backup_end(handlerton* hton,
+					 Wsrep_sst_sink* sink, uint stream,
+					 bool abort, ulonglong* lsn);
+static uint innobase_wsrep_sst_warmup(handlerton* hton, bool high_priority);
 #endif /* WITH_WSREP */
 
 /********************************************************************//**
@@ -4339,6 +4367,12 @@ innobase_init(
         innobase_hton->wsrep_set_checkpoint = innobase_wsrep_set_checkpoint;
         innobase_hton->wsrep_get_checkpoint = innobase_wsrep_get_checkpoint;
         innobase_hton->wsrep_fake_trx_id = wsrep_fake_trx_id;
+        innobase_hton->wsrep_sst_backup_begin =
+		innobase_wsrep_sst_backup_begin;
+        innobase_hton->wsrep_sst_backup_copy = innobase_wsrep_sst_backup_copy;
+        innobase_hton->wsrep_sst_backup_redo = innobase_wsrep_sst_backup_redo;
+        innobase_hton->wsrep_sst_backup_end = innobase_wsrep_sst_backup_end;
+        innobase_hton->wsrep_sst_warmup = innobase_wsrep_sst_warmup;
 #endif /* WITH_WSREP */
 
 	innobase_hton->is_supported_system_table=
@@ -5708,6 +5742,16 @@ innobase_rollback(
 	if (rollback_trx
 	    || !thd_test_options(thd, OPTION_NOT_AUTOCOMMIT | OPTION_BEGIN)) {
 
+#ifdef WITH_WSREP
+		/* the locks keep the tables of the conflict, account it
+		before they are released */
+		if (wsrep_on(thd)) {
+			lock_wsrep_account_conflicts(
+				trx,
+				wsrep_thd_conflict_state(thd) == CERT_FAILURE);
+		}
+#endif /* WITH_WSREP */
+
 		error = trx_rollback_for_mysql(trx);
 
 		if (trx->state == TRX_STATE_FORCED_ROLLBACK) {
@@ -9730,9 +9774,12 @@ report_error:
 		    && sql_command != SQLCOM_LOAD)
 	        || table->file->ht->db_type == DB_TYPE_PARTITION_DB)) {
 
-		if (wsrep_append_keys(m_user_thd, WSREP_KEY_EXCLUSIVE, record, NULL)) {
+		int rcode = wsrep_append_keys(m_user_thd, WSREP_KEY_EXCLUSIVE,
+					      record, NULL);
+		if (rcode) {
  			DBUG_PRINT("wsrep", ("row key failed"));
- 			error_result = HA_ERR_INTERNAL_ERROR;
+ 			error_result = rcode == HA_ERR_LOCK_DEADLOCK
+				? rcode : HA_ERR_INTERNAL_ERROR;
 			goto wsrep_error;
 		}
 	}
@@ -9755,22 +9802,17 @@ func_exit:
 }
 
 #ifdef WITH_WSREP
-#if defined(HAVE_YASSL)
-#include "my_config.h"
-#include "md5.hpp"
-#elif defined(HAVE_OPENSSL)
-#include <openssl/md5.h>
-#endif /* HAVE_YASSL */
-
 static
 int
 wsrep_calc_row_hash(
 /*================*/
-	byte*		digest,		/*!< in/out: md5 sum */
+	byte*		digest,		/*!< out: WSREP_ROW_DIGEST_LEN
+					bytes of row digest */
 	const uchar*	row,		/*!< in: row in MySQL format */
 	TABLE*		table,		/*!< in: table in MySQL data
 					dictionary */
 	row_prebuilt_t*	prebuilt,	/*!< in: InnoDB prebuilt struct */
+	ulong		algorithm,	/*!< in: enum_wsrep_row_digest */
 	THD*		thd)		/*!< in: user thread */
 {
 	Field*		field;
@@ -9780,16 +9822,13 @@ wsrep_calc_row_hash(
 	const byte*	ptr;
 	ulint		col_type;
 	uint		i;
+	bool		fixed;
 
-
-	void *ctx = wsrep_md5_init();
+	wsp::row_digest	ctx(algorithm);
 
 	n_fields = table->s->fields;
 
 	for (i = 0; i < n_fields; i++) {
-		byte null_byte=0;
-		byte true_byte=1;
-
 		field = table->field[i];
 
 		ptr = (const byte*) row + get_field_offset(table, field);
@@ -9802,11 +9841,14 @@ wsrep_calc_row_hash(
 		col_type =
 		    get_innobase_type_from_mysql_type(&unsigned_flag, field);
 
+		fixed = true;
+
 		switch (col_type) {
 
 		case DATA_BLOB:
 			ptr = row_mysql_read_blob_ref(&len, ptr, len,
 				false, 0, 0, prebuilt);
+			fixed = false;
 
 			break;
 
@@ -9822,7 +9864,7 @@ wsrep_calc_row_hash(
 					&len, ptr,
 					(ulint)
 					(((Field_varstring*)field)->length_bytes));
-
+				fixed = false;
 			}
 
 			break;
@@ -9830,14 +9872,11 @@ wsrep_calc_row_hash(
 			;
 		}
 
-		if (field->is_null_in_record(row)) {
-			wsrep_md5_update(ctx, (char*)&null_byte, 1);
-		} else {
-			wsrep_md5_update(ctx, (char*)&true_byte, 1);
-			wsrep_md5_update(ctx, (char*)ptr, len);
-		}
+		ctx.add_field(field->is_null_in_record(row) ? NULL : ptr,
+			      len, fixed);
 	}
-	wsrep_compute_md5_hash((char*)digest, ctx);
+
+	ctx.final(digest);
 	return(0);
 }
 #endif /* WITH_WSREP */
@@ -10512,9 +10551,12 @@ func_exit:
 
 		DBUG_PRINT("wsrep", ("update row key"));
 
-		if (wsrep_append_keys(m_user_thd, WSREP_KEY_EXCLUSIVE, old_row, new_row)) {
+		int rcode = wsrep_append_keys(m_user_thd, WSREP_KEY_EXCLUSIVE,
+					      old_row, new_row);
+		if (rcode) {
 			DBUG_PRINT("wsrep", ("row key failed"));
-			err = HA_ERR_INTERNAL_ERROR;
+			err = rcode == HA_ERR_LOCK_DEADLOCK
+				? rcode : HA_ERR_INTERNAL_ERROR;
 			goto wsrep_error;
 		}
 	}
@@ -10617,9 +10659,12 @@ ha_innobase::delete_row(
 		|| thd_binlog_format(m_user_thd) == BINLOG_FORMAT_STMT
 	        || table->file->ht->db_type == DB_TYPE_PARTITION_DB)) {
 
-		if (wsrep_append_keys(m_user_thd, WSREP_KEY_EXCLUSIVE, record, NULL)) {
+		int rcode = wsrep_append_keys(m_user_thd, WSREP_KEY_EXCLUSIVE,
+					      record, NULL);
+		if (rcode) {
 			DBUG_PRINT("wsrep", ("delete fail"));
-			error = DB_ERROR;
+			error = rcode == HA_ERR_LOCK_DEADLOCK
+				? DB_DEADLOCK : DB_ERROR;
 			goto wsrep_error;
 		}
 	}
@@ -12046,7 +12091,6 @@ wsrep_append_foreign_key(
 	int rcode = 0;
 	char cache_key[513] = {'\0'};
 	int cache_key_len;
-	bool const copy = true;
 	ut_a(trx);
 
 	if (!wsrep_on(trx->mysql_thd) ||
@@ -12187,13 +12231,16 @@ wsrep_append_foreign_key(
 			    wsrep_thd_query(thd) : "void");
 		return DB_ERROR;
 	}
-	rcode = wsrep->append_key(
-		wsrep,
+	rcode = wsrep_thd_append_key(
+		thd,
 		wsrep_ws_handle(thd, trx),
 		&wkey,
-		1,
-		key_type,
-		copy);
+		key_type);
+	if (rcode == WSREP_TRX_FAIL
+	    && wsrep_thd_conflict_state(thd) == MUST_ABORT) {
+		/* early conflict with a write-set being applied */
+		return DB_DEADLOCK;
+	}
 	if (rcode) {
 		DBUG_PRINT("wsrep", ("row key failed: %d", rcode));
 		WSREP_ERROR("Appending cascaded fk row key failed: %s, %d",
@@ -12219,7 +12266,6 @@ wsrep_append_key(
 )
 {
 	DBUG_ENTER("wsrep_append_key");
-	bool const copy = true;
 #ifdef WSREP_DEBUG_PRINT
         if (wsrep_debug) {
 	fprintf(stderr, "%s conn %ld, trx %llu, keylen %d, table %s\n SQL: %s ",
@@ -12246,13 +12292,16 @@ wsrep_append_key(
 		DBUG_RETURN(-1);
 	}
 
-	int rcode = wsrep->append_key(
-				wsrep,
+	int rcode = wsrep_thd_append_key(
+				thd,
 				wsrep_ws_handle(thd, trx),
 				&wkey,
-				1,
-				key_type,
-				copy);
+				key_type);
+	if (rcode == WSREP_TRX_FAIL
+	    && wsrep_thd_conflict_state(thd) == MUST_ABORT) {
+		/* early conflict with a write-set being applied */
+		DBUG_RETURN(HA_ERR_LOCK_DEADLOCK);
+	}
 	if (rcode) {
 		DBUG_PRINT("wsrep", ("row key failed: %d", rcode));
 		WSREP_WARN("Appending row key failed: %s, %d",
@@ -12408,23 +12457,29 @@ ha_innobase::wsrep_append_keys(
 
 	/* if no PK, calculate hash of full row, to be the key value */
 	if (!key_appended && wsrep_certify_nonPK) {
-		uchar digest[16];
+		uchar digest[WSREP_ROW_DIGEST_LEN];
 		int rcode;
+		/* both row images must be hashed the same way */
+		ulong const algorithm = wsrep_row_digest;
 
-		wsrep_calc_row_hash(digest, record0, table, m_prebuilt, thd);
+		wsrep_calc_row_hash(digest, record0, table, m_prebuilt,
+				    algorithm, thd);
 		if ((rcode = wsrep_append_key(thd, trx, table_share, table,
-					      (const char*) digest, 16,
+					      (const char*) digest,
+					      WSREP_ROW_DIGEST_LEN,
 					      key_type))) {
 			DBUG_RETURN(rcode);
 		}
 
 		if (record1) {
 			wsrep_calc_row_hash(
-				digest, record1, table, m_prebuilt, thd);
+				digest, record1, table, m_prebuilt,
+				algorithm, thd);
 			if ((rcode = wsrep_append_key(thd, trx, table_share,
 						      table,
 						      (const char*) digest,
-						      16, key_type))) {
+						      WSREP_ROW_DIGEST_LEN,
+						      key_type))) {
 				DBUG_RETURN(rcode);
 			}
 		}
@@ -16669,6 +16724,83 @@ func_exit:
 	DBUG_RETURN((ha_rows) n_rows);
 }
 
+/** Starts background reads of the clustered index pages needed for a row
+which is going to be accessed by a replicated row event.
+@param[in]	key	primary key value in MySQL key format
+@return 0 or error number */
+
+int
+ha_innobase::rpl_prefetch_row(
+	const uchar*	key)
+{
+	DBUG_ENTER("ha_innobase::rpl_prefetch_row");
+
+	if (table->s->primary_key >= MAX_KEY
+	    || dict_table_is_discarded(m_prebuilt->table)
+	    || m_prebuilt->table->ibd_file_missing) {
+		DBUG_RETURN(HA_ERR_WRONG_COMMAND);
+	}
+
+	const KEY*	key_info = table->key_info + table->s->primary_key;
+	dict_index_t*	index = innobase_get_index(table->s->primary_key);
+
+	if (index == NULL
+	    || !dict_index_is_clust(index)
+	    || dict_index_is_corrupted(index)) {
+		DBUG_RETURN(HA_ERR_WRONG_COMMAND);
+	}
+
+	mem_heap_t*	heap = mem_heap_create(
+		key_info->actual_key_parts * sizeof(dfield_t)
+		+ sizeof(dtuple_t));
+
+	dtuple_t*	tuple = dtuple_create(heap, key_info->actual_key_parts);
+	dict_index_copy_types(tuple, index, key_info->actual_key_parts);
+
+	row_sel_convert_mysql_key_to_innobase(
+		tuple,
+		m_prebuilt->srch_key_val1,
+		m_prebuilt->srch_key_val_len,
+		index,
+		(byte*) key,
+		(ulint) key_info->key_length,
+		m_prebuilt->trx);
+
+	if (dtuple_get_n_fields(tuple) > 0) {
+		btr_cur_prefetch_leaf(index, tuple);
+	}
+
+	mem_heap_free(heap);
+
+	DBUG_RETURN(0);
+}
+
+#ifdef WITH_WSREP
+/** Publishes the certification keys of a row which a replicated row event
+is going to change. The keys are computed as for a local transaction
+changing the row, and published by wsrep_thd_append_key() for appliers.
+@param[in]	record	row in MySQL format
+@return 0 or error number */
+
+int
+ha_innobase::wsrep_publish_row_keys(
+	const uchar*	record)
+{
+	DBUG_ENTER("ha_innobase::wsrep_publish_row_keys");
+
+	/* without a primary key the key would be a digest of the row,
+	which local transactions compute only if wsrep_certify_nonPK */
+	if (table->s->primary_key >= MAX_KEY
+	    || wsrep_thd_exec_mode(m_user_thd) != REPL_RECV) {
+		DBUG_RETURN(HA_ERR_WRONG_COMMAND);
+	}
+
+	DBUG_RETURN(wsrep_append_keys(m_user_thd, WSREP_KEY_EXCLUSIVE,
+				      record, NULL)
+		    ? HA_ERR_INTERNAL_ERROR : 0);
+}
+#endif /* WITH_WSREP */
+
 /*********************************************************************//**
 Gives an UPPER BOUND to the number of rows in a table. This is used in
 filesort.cc.
@@ -23328,9 +23460,11 @@ wsrep_innobase_kill_one_trx(void * const bf_thd_ptr,
 	switch (wsrep_thd_conflict_state(thd)) {
 	case NO_CONFLICT:
 		wsrep_thd_set_conflict_state(thd, false, MUST_ABORT);
+		victim_trx->lock.wsrep_bf_victim = true;
 		break;
         case MUST_ABORT:
 	{
+		victim_trx->lock.wsrep_bf_victim = true;
 		WSREP_DEBUG("Victim Transaction (%llu) in MUST_ABORT state,"
 			" killed_by: %lld",
 			(long long)victim_trx->id,
@@ -23605,6 +23739,42 @@ wsrep_fake_trx_id(
 	(void)wsrep_ws_handle_for_trx(wsrep_thd_ws_handle(thd), trx_id);
 }
 
+static int innobase_wsrep_sst_backup_begin(handlerton* hton,
+					   Wsrep_sst_sink* sink, uint stream,
+					   const Wsrep_sst_base* base)
+{
+	DBUG_ASSERT(hton == innodb_hton_ptr);
+	return(srv_sst_backup_begin(sink, stream, base) != DB_SUCCESS);
+}
+
+static int innobase_wsrep_sst_backup_copy(handlerton* hton,
+					  Wsrep_sst_sink* sink, uint stream)
+{
+	DBUG_ASSERT(hton == innodb_hton_ptr);
+	return(srv_sst_backup_copy(sink, stream) != DB_SUCCESS);
+}
+
+static int innobase_wsrep_sst_backup_redo(handlerton* hton,
+					  Wsrep_sst_sink* sink, uint stream)
+{
+	DBUG_ASSERT(hton == innodb_hton_ptr);
+	return(srv_sst_backup_redo(sink, stream) != DB_SUCCESS);
+}
+
+static int innobase_wsrep_sst_backup_end(handlerton* hton,
+					 Wsrep_sst_sink* sink, uint stream,
+					 bool abort, ulonglong* lsn)
+{
+	DBUG_ASSERT(hton == innodb_hton_ptr);
+	return(srv_sst_backup_end(sink, stream, abort, lsn) != DB_SUCCESS);
+}
+
+static uint innobase_wsrep_sst_warmup(handlerton* hton, bool high_priority)
+{
+	DBUG_ASSERT(hton == innodb_hton_ptr);
+	return(static_cast<uint>(buf_load_warmup(high_priority)));
+}
+
 #endif /* WITH_WSREP */
 /* plugin options */
 
@@ -23738,6 +23908,15 @@ static MYSQL_SYSVAR_ULONG(purge_threads, srv_n_purge_threads,
   1,			/* Minimum value */
   SRV_MAX_N_PURGE_THREADS, 0);		/* Maximum value */
 
+static MYSQL_SYSVAR_ULONG(recovery_apply_threads, srv_recovery_apply_threads,
+  PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
+  "Number of threads applying the redo log in crash recovery, from 1 to 64."
+  " Default is 1, which applies it serially in the calling thread.",
+  NULL, NULL,
+  1,			/* Default setting */
+  1,			/* Minimum value */
+  64, 0);		/* Maximum value */
+
 static MYSQL_SYSVAR_ULONG(sync_array_size, srv_sync_array_size,
   PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
   "Size of the mutex/lock wait array.",
@@ -24323,6 +24502,13 @@ static MYSQL_SYSVAR_ULONG(log_write_ahead_size, srv_log_write_ahead_size,
   DEFAULT_SRV_LOG_WRITE_AHEAD_SIZE, OS_FILE_LOG_BLOCK_SIZE,
   MAX_SRV_LOG_WRITE_AHEAD_SIZE, OS_FILE_LOG_BLOCK_SIZE);
 
+static MYSQL_SYSVAR_BOOL(log_writer_threads, srv_log_writer_threads,
+  PLUGIN_VAR_OPCMDARG | PLUGIN_VAR_READONLY,
+  "Write and flush the redo log in dedicated log writer and flusher threads."
+  " Committing transactions wait for them instead of writing the log"
+  " themselves.",
+  NULL, NULL, FALSE);
+
 static MYSQL_SYSVAR_UINT(old_blocks_pct, innobase_old_blocks_pct,
   PLUGIN_VAR_RQCMDARG,
   "Percentage of the buffer pool to reserve for 'old' blocks.",
@@ -24986,6 +25172,7 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(log_file_size),
   MYSQL_SYSVAR(log_files_in_group),
   MYSQL_SYSVAR(log_write_ahead_size),
+  MYSQL_SYSVAR(log_writer_threads),
   MYSQL_SYSVAR(log_group_home_dir),
   MYSQL_SYSVAR(log_compressed_pages),
   MYSQL_SYSVAR(max_dirty_pages_pct),
@@ -25059,6 +25246,7 @@ static struct st_mysql_sys_var* innobase_system_variables[]= {
   MYSQL_SYSVAR(monitor_reset),
   MYSQL_SYSVAR(monitor_reset_all),
   MYSQL_SYSVAR(purge_threads),
+  MYSQL_SYSVAR(recovery_apply_threads),
   MYSQL_SYSVAR(purge_batch_size),
 #ifdef UNIV_DEBUG
   MYSQL_SYSVAR(background_drop_list_empty),
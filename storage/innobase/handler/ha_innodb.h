@@ -231,6 +231,12 @@ public:
 
 	ha_rows estimate_rows_upper_bound();
 
+	int rpl_prefetch_row(const uchar* key);
+
+#ifdef WITH_WSREP
+	int wsrep_publish_row_keys(const uchar* record);
+#endif /* WITH_WSREP */
+
 	virtual void adjust_create_info_for_frm(HA_CREATE_INFO *create_info);
 	void update_create_info(HA_CREATE_INFO* create_info);
 
@@ -382,6 +382,26 @@ public:
 	ha_rows
 	estimate_rows_upper_bound();
 
+	/** Row prefetch is not supported, the partition of the row
+	is not known from the key alone. */
+	int
+	rpl_prefetch_row(
+		const uchar*	key)
+	{
+		return(HA_ERR_WRONG_COMMAND);
+	}
+
+#ifdef WITH_WSREP
+	/** Keys are not published for partitioned tables, the keys of a
+	row are computed on the partition it is in. */
+	int
+	wsrep_publish_row_keys(
+		const uchar*	record)
+	{
+		return(HA_ERR_WRONG_COMMAND);
+	}
+#endif /* WITH_WSREP */
+
 	uint
 	alter_table_flags(
 		uint	flags);
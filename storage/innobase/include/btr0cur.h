@@ -636,6 +636,17 @@ btr_estimate_n_rows_in_range(
 	const dtuple_t*	tuple2,
 	page_cur_mode_t	mode2);
 
+/** Starts an asynchronous read of the leaf page where a search for the
+tuple would end, unless the page is already in the buffer pool. The caller
+never waits for a page read.
+@param[in]	index	index
+@param[in]	tuple	search tuple
+@return true if a page read was started */
+bool
+btr_cur_prefetch_leaf(
+	dict_index_t*	index,
+	const dtuple_t*	tuple);
+
 /*******************************************************************//**
 Estimates the number of different key values in a given index, for
 each n-column prefix of the index where 1 <= n <= dict_index_get_n_unique(index).
@@ -62,6 +62,26 @@ void
 buf_load_abort();
 /*============*/
 
+/** Dump the buffer pool now, in the calling thread, into a file named
+after the dump file with a suffix.
+@param[in]	suffix	appended to the name of the dump file
+@param[out]	path	name of the file written, OS_FILE_MAX_PATH bytes
+@return whether the dump was written */
+bool
+buf_dump_to_file(
+	const char*	suffix,
+	char*		path);
+
+/** Warm up the buffer pool from the dump file: start a load unless one was
+requested since startup, and let the load read the pages at full speed
+while high_priority is set.
+@param[in]	high_priority	whether to read without throttling
+@return percentage of the pages in the dump file which are read in, 100
+if there is nothing to load */
+ulint
+buf_load_warmup(
+	bool	high_priority);
+
 /*****************************************************************//**
 This is the main thread for buffer pool dump/load. It waits for an
 event and when waked up either performs a dump or load and sleeps
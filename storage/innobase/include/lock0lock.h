@@ -1139,6 +1139,16 @@ void
 lock_cancel_waiting_and_release(
 /*============================*/
 	lock_t*	lock);	/*!< in/out: waiting lock request */
+
+/** Account the conflict a transaction lost before it rolls back, see
+wsrep_conflict_stats.h. A BF abort is recorded under lock_sys->mutex by
+the aborter, and only accounted here.
+@param[in,out]	trx		transaction to roll back
+@param[in]	cert_failure	whether it failed certification */
+void
+lock_wsrep_account_conflicts(
+	trx_t*	trx,
+	bool	cert_failure);
 #endif /* WITH_WSREP */
 
 #ifndef UNIV_NONINL
@@ -146,6 +146,35 @@ log_write_low(
 /*==========*/
 	const byte*	str,		/*!< in: string */
 	ulint		str_len);	/*!< in: string length */
+
+/** Reserve space for a string in the log buffer without copying the string.
+The headers of the log blocks of the space are set up as by log_write_low().
+The caller must copy the string with log_buffer_copy() and then call
+log_buffer_copy_complete(); it may release the log mutex in between, as the
+log buffer is not written to the log files before all copies are complete.
+@param[in]	str_len	string length
+@return offset of the string in log_sys->buf */
+ulint
+log_buffer_reserve(
+	ulint	str_len);
+
+/** Copy a string to the space reserved by log_buffer_reserve().
+@param[in,out]	buf	log_sys->buf when the space was reserved
+@param[in,out]	offset	offset of the string in buf; advanced past it
+@param[in]	str	string
+@param[in]	str_len	string length */
+void
+log_buffer_copy(
+	byte*		buf,
+	ulint*		offset,
+	const byte*	str,
+	ulint		str_len);
+
+/** Note that a string has been copied to the space reserved by
+log_buffer_reserve(). */
+void
+log_buffer_copy_complete();
+
 /************************************************************//**
 Closes the log.
 @return lsn */
@@ -262,6 +291,20 @@ also to be flushed to disk. */
 void
 log_buffer_flush_to_disk(
 	bool sync = true);
+/** Wait until the log has been written, and optionally flushed to disk, up
+to an lsn. With innodb_log_writer_threads the log writer and flusher threads
+do the write and flush while the caller spins briefly and then sleeps until
+the lsn is reached, otherwise the caller does it by log_write_up_to().
+@param[in]	lsn		log sequence number that should be written
+@param[in]	flush_to_disk	whether the written log should also
+be flushed to the file system */
+void
+log_wait_up_to(
+	lsn_t	lsn,
+	bool	flush_to_disk);
+/** Start the log writer and flusher threads. */
+void
+log_writer_threads_start();
 /****************************************************************//**
 This functions writes the log buffer to the log file and if 'flush'
 is set it forces a flush of the log file as well. This is meant to be
@@ -562,6 +605,13 @@ extern log_t*	log_sys;
 /** Whether to generate and require checksums on the redo log pages */
 extern my_bool	innodb_log_checksums;
 
+#ifdef WITH_WSREP
+/** Start of the redo log not yet copied by native SST, 0 if no SST is
+running. The log is not allowed to overwrite it, like the log not yet read
+by changed page tracking. Protected by log_sys->mutex. */
+extern lsn_t	log_sst_lsn;
+#endif /* WITH_WSREP */
+
 /* Values used as flags */
 #define LOG_FLUSH	7652559
 #define LOG_CHECKPOINT	78656949
@@ -571,6 +621,10 @@ extern my_bool	innodb_log_checksums;
 
 #define LOG_BUFFER_SIZE		(srv_log_buffer_size * UNIV_PAGE_SIZE)
 
+/* Number of events the threads waiting in log_wait_up_to() are spread over
+by the log block of the lsn they wait for */
+#define LOG_WAIT_EVENTS		64
+
 /* Offsets of a log block header */
 #define	LOG_BLOCK_HDR_NO	0	/* block number which must be > 0 and
 					is allowed to wrap around at 2G; the
@@ -718,6 +772,14 @@ struct log_t{
 	lsn_t		lsn;		/*!< log sequence number */
 	ulint		buf_free;	/*!< first free offset within the log
 					buffer in use */
+	ulint		n_pending_copies;
+					/*!< number of strings which have
+					space reserved in the log buffer by
+					log_buffer_reserve() but are not
+					copied yet; incremented under the log
+					mutex, decremented atomically without
+					it. The log buffer is written or moved
+					only when this is 0. */
 #ifndef UNIV_HOTBACKUP
 	char		pad2[CACHE_LINE_SIZE];/*!< Padding */
 	LogSysMutex	mutex;		/*!< mutex protecting the log */
@@ -790,6 +852,22 @@ struct log_t{
 					owning the log mutex, but NOTE that
 					to set this event, the
 					thread MUST own the log mutex! */
+	os_event_t	writer_event;	/*!< set to wake up the log writer
+					thread */
+	os_event_t	flusher_event;	/*!< set by the log writer thread to
+					wake up the log flusher thread */
+	volatile bool	flush_requested;/*!< set by a thread waiting in
+					log_wait_up_to() for a flush to disk,
+					cleared by the log writer thread when
+					it wakes up the log flusher thread */
+	os_event_t	write_events[LOG_WAIT_EVENTS];
+					/*!< events of the threads waiting
+					in log_wait_up_to() for write_lsn,
+					set when it passes their lsn */
+	os_event_t	flush_events[LOG_WAIT_EVENTS];
+					/*!< events of the threads waiting
+					in log_wait_up_to() for
+					flushed_to_disk_lsn */
 	ulint		n_log_ios;	/*!< number of log i/os initiated thus
 					far */
 	ulint		n_log_ios_old;	/*!< number of log i/o's at the
@@ -906,6 +984,8 @@ extern ulonglong innodb_scrub_log_speed;
 extern os_event_t log_scrub_event;
 /** Whether log_scrub_thread is active */
 extern bool log_scrub_thread_active;
+/** Number of the log writer and flusher threads running */
+extern ulint log_writer_n_threads;
 
 /** Calculate the offset of an lsn within a log group.
 @param[in]	lsn	log sequence number
@@ -104,8 +104,11 @@ log_online_bitmap_iterator_init(
 	log_bitmap_iterator_t	*i,		/*!<in/out:  iterator */
 	lsn_t			min_lsn,	/*!<in: start LSN for the
 						iterator */
-	lsn_t			max_lsn);	/*!<in: end LSN for the
+	lsn_t			max_lsn,	/*!<in: end LSN for the
 						iterator */
+	const char*		dir = NULL);	/*!<in: directory of the
+						bitmap files, NULL for
+						srv_data_home */
 
 /*********************************************************************//**
 Releases log bitmap iterator. */
@@ -156,6 +159,8 @@ struct log_online_bitmap_file_range_struct {
 /** Struct for an iterator through all bits of changed pages bitmap blocks */
 struct log_bitmap_iterator_struct
 {
+	const char*			dir;		/*!< Directory of the
+							bitmap files */
 	lsn_t				max_lsn;	/*!< End LSN of the
 							range */
 	bool				failed;		/*!< Has the iteration
@@ -429,6 +429,13 @@ struct recv_sys_t{
 	hash_table_t*	addr_hash;/*!< hash table of file addresses of pages */
 	ulint		n_addrs;/*!< number of not processed hashed file
 				addresses in the hash table */
+	ulint		n_apply_parts;
+				/*!< number of the partitions of addr_hash
+				applied in parallel in the current batch */
+	ulint		n_apply_threads;
+				/*!< number of the recovery apply threads
+				of the current batch still running;
+				protected by mutex */
 
 	recv_dblwr_t	dblwr;
 
@@ -488,6 +495,12 @@ use these free frames to read in pages when we start applying the
 log records to the database. */
 extern ulint	recv_n_pool_free_frames;
 
+/** Number of pages the redo log was applied to by recovery */
+extern ulint	recv_n_pages_applied;
+
+/** Time recovery spent applying the redo log, in milliseconds */
+extern ulint	recv_apply_time_ms;
+
 #ifndef UNIV_NONINL
 #include "log0recv.ic"
 #endif
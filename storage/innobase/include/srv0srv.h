@@ -88,6 +88,22 @@ struct srv_stats_t {
 	/** Amount of data padded for log write ahead */
 	ulint_ctr_1_t		log_padded;
 
+	/** Number of times write_lsn advanced */
+	ulint_ctr_1_t		log_write_batches;
+
+	/** Total lsn range write_lsn advanced by */
+	lsn_ctr_1_t		log_write_batch_bytes;
+
+	/** Number of times flushed_to_disk_lsn advanced by a log flush */
+	ulint_ctr_1_t		log_flush_batches;
+
+	/** Total lsn range flushed_to_disk_lsn advanced by */
+	lsn_ctr_1_t		log_flush_batch_bytes;
+
+	/** Number of times a thread in log_wait_up_to() slept waiting for
+	the log writer or flusher thread */
+	ulint_ctr_1_t		log_waiter_sleeps;
+
 	/** Amount of data written to the log files in bytes */
 	lsn_ctr_1_t		os_log_written;
 
@@ -378,6 +394,9 @@ enum { DEFAULT_SRV_LOG_WRITE_AHEAD_SIZE = 8 * 1024L };
 enum { MAX_SRV_LOG_WRITE_AHEAD_SIZE = UNIV_PAGE_SIZE_DEF };
 
 extern ulong	srv_log_write_ahead_size;
+/** Whether to write and flush the redo log in the log writer and flusher
+threads (innodb_log_writer_threads) */
+extern my_bool	srv_log_writer_threads;
 extern char	srv_use_global_flush_log_at_trx_commit;
 extern char	srv_adaptive_flushing;
 extern my_bool	srv_flush_sync;
@@ -617,6 +636,9 @@ extern my_bool srv_master_thread_priority;
 /* the number of purge threads to use from the worker pool (currently 0 or 1) */
 extern ulong srv_n_purge_threads;
 
+/* the number of threads applying the redo log in crash recovery */
+extern ulong srv_recovery_apply_threads;
+
 /* the number of pages to purge in one batch */
 extern ulong srv_purge_batch_size;
 
@@ -1139,6 +1161,13 @@ struct export_var_t{
 	ulint innodb_log_waits;			/*!< srv_log_waits */
 	ulint innodb_log_write_requests;	/*!< srv_log_write_requests */
 	ulint innodb_log_writes;		/*!< srv_log_writes */
+	ulint innodb_log_write_batches;		/*!< srv_stats.log_write_batches */
+	lsn_t innodb_log_write_batch_bytes;	/*!< srv_stats.log_write_batch_bytes */
+	ulint innodb_log_flush_batches;		/*!< srv_stats.log_flush_batches */
+	lsn_t innodb_log_flush_batch_bytes;	/*!< srv_stats.log_flush_batch_bytes */
+	ulint innodb_log_waiter_sleeps;		/*!< srv_stats.log_waiter_sleeps */
+	ulint innodb_recovery_pages_applied;	/*!< recv_n_pages_applied */
+	ulint innodb_recovery_apply_time;	/*!< recv_apply_time_ms */
 	lsn_t innodb_os_log_written;		/*!< srv_os_log_written */
 	lsn_t innodb_lsn_current;
 	lsn_t innodb_lsn_flushed;
@@ -0,0 +1,99 @@
+/*****************************************************************************
+
+Copyright (c) 2019, Percona Inc. All Rights Reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 51 Franklin
+Street, Fifth Floor, Boston, MA 02110-1301, USA
+
+*****************************************************************************/
+
+/**************************************************//**
+@file include/srv0sst.h
+Copy of the tablespaces and the redo log for native state snapshot transfer
+
+The data files are copied page by page while the server keeps running, so
+the copy is fuzzy. The redo log is copied from the latest checkpoint at the
+start of the copy, together with the log file headers as they were then,
+up to the end of the log when the server is locked at the end of the copy.
+The joiner starts up on the copied files and its crash recovery applies the
+log written during the copy.
+
+The log not yet copied is protected from being overwritten with
+log_sst_lsn, the same way as the log not yet read by changed page tracking.
+
+If the joiner has the data files of an earlier copy from this server, only
+the pages changed since then on either server are copied, as found in the
+changed page bitmaps of both. Files which the joiner does not have are
+copied in full.
+*******************************************************/
+
+#ifndef srv0sst_h
+#define srv0sst_h
+
+#include "univ.i"
+
+#ifdef WITH_WSREP
+
+class Wsrep_sst_sink;
+class Wsrep_sst_base;
+
+/** Start the copy: remember the latest checkpoint, start retaining the log
+written after it, send the log file headers and make the list of the data
+files to copy.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the log file headers to
+@param[in]	base	data files of the joiner, or NULL
+@return DB_SUCCESS or error code */
+dberr_t
+srv_sst_backup_begin(
+	Wsrep_sst_sink*		sink,
+	uint			stream,
+	const Wsrep_sst_base*	base);
+
+/** Copy data files until all of them are copied. Called concurrently
+for every data stream.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the pages to
+@return DB_SUCCESS or error code */
+dberr_t
+srv_sst_backup_copy(
+	Wsrep_sst_sink*	sink,
+	uint		stream);
+
+/** Copy the redo log written to the log files so far.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the log to
+@return DB_SUCCESS or error code */
+dberr_t
+srv_sst_backup_redo(
+	Wsrep_sst_sink*	sink,
+	uint		stream);
+
+/** Finish the copy while no more transactions can commit: copy the
+tablespaces created and the pages allocated since they were copied,
+the final sizes of the data files and the rest of the redo log. Release
+the copy state.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the rest to
+@param[in]	abort	only release the copy state
+@param[out]	lsn	end of the copied redo log, or NULL
+@return DB_SUCCESS or error code */
+dberr_t
+srv_sst_backup_end(
+	Wsrep_sst_sink*	sink,
+	uint		stream,
+	bool		abort,
+	ulonglong*	lsn);
+
+#endif /* WITH_WSREP */
+
+#endif /* srv0sst_h */
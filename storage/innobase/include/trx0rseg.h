@@ -255,6 +255,14 @@ struct trx_rseg_t {
 					this page is placed */
 #define TRX_RSEG_UNDO_SLOTS	(8 + FLST_BASE_NODE_SIZE + FSEG_HEADER_SIZE)
 					/* Undo log segment slots */
+#ifdef WITH_WSREP
+#define TRX_RSEG_WSREP_XID_INFO	(TRX_RSEG_UNDO_SLOTS			\
+				 + TRX_RSEG_N_SLOTS * TRX_RSEG_SLOT_SIZE)
+					/* WSREP XID of the last transaction
+					committed using this rollback segment,
+					same layout as TRX_SYS_WSREP_XID_INFO
+					in the trx sys header */
+#endif /* WITH_WSREP */
 /*-------------------------------------------------------------*/
 
 #ifndef UNIV_NONINL
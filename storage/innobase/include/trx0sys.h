@@ -305,8 +305,35 @@ trx_sys_update_wsrep_checkpoint(
         bool            recovery = false);
                                      /*!< in: running recovery */
 
+/** Update WSREP checkpoint XID of a committing transaction in the header
+of its rollback segment. Checkpoints in rollback segment headers are only
+valid together with the sys header checkpoint of the same UUID, so nothing
+is written if the UUID of the XID differs from the last persisted one.
+@param[in]	xid		WSREP XID
+@param[in]	rseg		redo rollback segment of the transaction,
+				its mutex must be owned
+@param[in]	recovery	committing a recovered transaction
+@param[in,out]	mtr		mini-transaction of the commit
+@return false if the checkpoint must be written to the sys header */
+bool
+trx_rseg_update_wsrep_checkpoint(
+	const XID*	xid,
+	trx_rseg_t*	rseg,
+	bool		recovery,
+	mtr_t*		mtr);
+
+/** Move the WSREP checkpoint XID of a rollback segment header to the sys
+header if it is later than the one there. Called before the rollback
+segment header is re-created by undo tablespace truncation, which would
+lose the checkpoint.
+@param[in]	rseg	redo rollback segment */
+void
+trx_rseg_fold_wsrep_checkpoint(
+	trx_rseg_t*	rseg);
+
 void
-/** Read WSREP checkpoint XID from sys header. */
+/** Read WSREP checkpoint XID, the latest one of the sys header and
+rollback segment headers. */
 trx_sys_read_wsrep_checkpoint(
         XID* xid); /*!< out: WSREP XID */
 #endif /* WITH_WSREP */
@@ -785,6 +785,15 @@ struct trx_lock_t {
 					transaction as a victim in deadlock
 					resolution, it sets this to true.
 					Protected by trx->mutex. */
+#ifdef WITH_WSREP
+	bool		wsrep_bf_victim;/*!< set when a brute force
+					transaction has started to abort
+					this one, so that further conflicts
+					with it need not look at its THD
+					again. Set holding lock_sys->mutex,
+					cleared by trx_init() when the
+					transaction has released its locks */
+#endif /* WITH_WSREP */
 	time_t		wait_started;	/*!< lock wait started at this time,
 					protected only by lock_sys->mutex */
 
@@ -1468,6 +1477,16 @@ struct trx_t {
 	section to record successful commit-recovery of the said
 	transaction. */
 	XID*		wsrep_recover_xid;
+
+	/* time the transaction started, for the time lost when it is
+	aborted by a conflict, see wsrep_conflict_stats.h */
+	ib_time_monotonic_us_t	wsrep_start_time_us;
+
+	/* BF abort lost by the transaction, to be accounted when it rolls
+	back; protected by the trx mutex, table id is 0 if there is none */
+	table_id_t		wsrep_conflict_table_id;
+	index_id_t		wsrep_conflict_index_id;
+	ulonglong		wsrep_conflict_key_hash;
 #endif /* WITH_WSREP */
 };
 
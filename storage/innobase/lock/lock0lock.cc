@@ -62,6 +62,8 @@ Created 5/7/1996 Heikki Tuuri
 extern my_bool wsrep_debug;
 extern my_bool wsrep_log_conflicts;
 #include <wsrep_mysqld.h>
+#include <wsrep_conflict_stats.h>
+#include <wsrep_conflict_log.h>
 #endif /* WITH_WSREP */
 
 /* Flag to enable/disable deadlock detector. */
@@ -1261,14 +1263,231 @@ lock_rec_other_has_expl_req(
 #endif /* UNIV_DEBUG */
 
 #ifdef WITH_WSREP
+/** Account a conflict lost by a transaction, see wsrep_conflict_stats.h.
+Must not be called under lock_sys->mutex.
+@param[in]	victim		transaction which lost the conflict
+@param[in]	table		table of the conflict
+@param[in]	index		index of the conflict, or NULL
+@param[in]	kind		kind of the conflict
+@param[in]	key_hash	hash of the key of the conflict, or 0 */
+static
+void
+lock_wsrep_account_conflict(
+	const trx_t*		victim,
+	const dict_table_t*	table,
+	const dict_index_t*	index,
+	wsrep_conflict_kind	kind,
+	ulonglong		key_hash)
+{
+	char	db[MAX_DB_UTF8_LEN];
+	char	tbl[MAX_TABLE_UTF8_LEN];
+
+	dict_fs2utf8(table->name.m_name, db, sizeof(db), tbl, sizeof(tbl));
+
+	ib_time_monotonic_us_t	now = ut_time_monotonic_us();
+	ulonglong		time = now > victim->wsrep_start_time_us
+		? now - victim->wsrep_start_time_us : 0;
+
+	const char*	index_name = NULL;
+
+	if (index != NULL) {
+		index_name = index->name;
+	}
+
+	wsrep_conflict_stats_add(db, tbl, index_name, kind, key_hash,
+				 victim->undo_no, time);
+}
+
+/** Hash the unique fields of a locked record.
+@param[in]	block		page of the record
+@param[in]	heap_no		heap number of the record
+@param[in]	index		index of the record
+@return hash of the key, or 0 for the page infimum and supremum */
+static
+ulonglong
+lock_wsrep_key_hash(
+	const buf_block_t*	block,
+	ulint			heap_no,
+	const dict_index_t*	index)
+{
+	if (heap_no == PAGE_HEAP_NO_INFIMUM
+	    || heap_no == PAGE_HEAP_NO_SUPREMUM) {
+		return(0);
+	}
+
+	const rec_t*	rec = page_find_rec_with_heap_no(block->frame, heap_no);
+
+	if (rec == NULL) {
+		return(0);
+	}
+
+	mem_heap_t*	heap = NULL;
+	ulint		offsets_[REC_OFFS_NORMAL_SIZE];
+	ulint		n_unique = dict_index_get_n_unique_in_tree(index);
+
+	rec_offs_init(offsets_);
+
+	const ulint*	offsets = rec_get_offsets(
+		rec, index, offsets_, n_unique, &heap);
+
+	ulonglong	hash = rec_fold(rec, offsets, n_unique, 0, index->id);
+
+	if (heap != NULL) {
+		mem_heap_free(heap);
+	}
+
+	/* 0 means no key */
+	return(hash ? hash : 1);
+}
+
+/** Remember the BF abort of a transaction, so that the transaction
+accounts it when it rolls back. Only the ids are recorded here, the names
+are looked up by lock_wsrep_account_conflicts().
+@param[in,out]	victim		transaction which lost the conflict
+@param[in]	table		table of the conflict
+@param[in]	index		index of the conflict, or NULL
+@param[in]	key_hash	hash of the key of the conflict, or 0 */
+static
+void
+lock_wsrep_note_bf_abort(
+	trx_t*			victim,
+	const dict_table_t*	table,
+	const dict_index_t*	index,
+	ulonglong		key_hash)
+{
+	ut_ad(lock_mutex_own());
+	ut_ad(trx_mutex_own(victim));
+
+	if (victim->wsrep_conflict_table_id == 0) {
+		victim->wsrep_conflict_table_id = table->id;
+		victim->wsrep_conflict_index_id = index ? index->id : 0;
+		victim->wsrep_conflict_key_hash = key_hash;
+	}
+}
+
+/** Account the conflict a transaction lost before it rolls back.
+@param[in,out]	trx		transaction to roll back
+@param[in]	cert_failure	whether it failed certification */
+void
+lock_wsrep_account_conflicts(
+	trx_t*	trx,
+	bool	cert_failure)
+{
+	ut_ad(!lock_mutex_own());
+
+	if (cert_failure) {
+		/* the provider does not tell which key failed, account it
+		to every table the transaction changed */
+		for (trx_mod_tables_t::const_iterator it
+			     = trx->mod_tables.begin();
+		     it != trx->mod_tables.end(); ++it) {
+
+			lock_wsrep_account_conflict(
+				trx, *it, NULL, WSREP_CONFLICT_CERT_FAILURE,
+				0);
+		}
+	}
+
+	trx_mutex_enter(trx);
+	table_id_t const	table_id = trx->wsrep_conflict_table_id;
+	index_id_t const	index_id = trx->wsrep_conflict_index_id;
+	ulonglong const		key_hash = trx->wsrep_conflict_key_hash;
+	trx->wsrep_conflict_table_id = 0;
+	trx_mutex_exit(trx);
+
+	if (table_id == 0) {
+		return;
+	}
+
+	/* the transaction still holds its locks, so the table is there */
+	dict_table_t*	table = dict_table_open_on_id(
+		table_id, FALSE, DICT_TABLE_OP_NORMAL);
+
+	if (table == NULL) {
+		return;
+	}
+
+	const dict_index_t*	index = NULL;
+
+	for (index = dict_table_get_first_index(table);
+	     index_id != 0 && index != NULL && index->id != index_id;
+	     index = dict_table_get_next_index(index)) {
+	}
+
+	if (index_id == 0 || index != NULL) {
+		lock_wsrep_account_conflict(
+			trx, table, index_id != 0 ? index : NULL,
+			WSREP_CONFLICT_BF_ABORT, key_hash);
+	}
+
+	dict_table_close(table, FALSE, FALSE);
+}
+
+/** Print the locks of a brute force conflict to the error log. The
+report is written by a background thread, so that lock_sys->mutex is not
+held while the error log is written.
+@param[in]	trx		transaction requesting the lock
+@param[in]	lock		conflicting lock
+@param[in]	bf_this		whether trx is brute force
+@param[in]	bf_other	whether the holder of lock is brute force */
+static
+void
+wsrep_print_conflict(
+	const trx_t*	trx,
+	const lock_t*	lock,
+	bool		bf_this,
+	bool		bf_other)
+{
+	char*	buf = NULL;
+	size_t	len = 0;
+	FILE*	mem = open_memstream(&buf, &len);
+	FILE*	file = mem != NULL ? mem : stderr;
+
+	fputs(bf_this
+	      ? "\n*** Priority TRANSACTION:\n"
+	      : "\n*** Victim TRANSACTION:\n", file);
+	wsrep_trx_print_locking(file, trx, 3000);
+
+	fputs(bf_other
+	      ? "\n*** Priority TRANSACTION:\n"
+	      : "\n*** Victim TRANSACTION:\n", file);
+	wsrep_trx_print_locking(file, lock->trx, 3000);
+
+	fputs("*** WAITING FOR THIS LOCK TO BE GRANTED:\n", file);
+
+	if (lock_get_type(lock) == LOCK_REC) {
+		lock_rec_print(file, lock);
+	} else {
+		lock_table_print(file, lock);
+	}
+
+	if (mem != NULL) {
+		fclose(mem);
+		wsrep_conflict_log(buf, len);
+		free(buf);
+	}
+}
+
+/** BF abort the holder of a conflicting lock, if trx may do it.
+@param[in]	trx	transaction requesting the lock
+@param[in]	lock	conflicting lock
+@param[in]	block	page of the record, or NULL for a table lock
+@param[in]	heap_no	heap number of the record, or ULINT_UNDEFINED */
 static void 
-wsrep_kill_victim(const trx_t * const trx, const lock_t *lock) {
+wsrep_kill_victim(const trx_t * const trx, const lock_t *lock,
+		  const buf_block_t* block, ulint heap_no) {
         ut_ad(lock_mutex_own());
         ut_ad(trx_mutex_own(lock->trx));
 
 	/* quit for native mysql */
 	if (!wsrep_on(trx->mysql_thd)) return;
 
+	/* A victim is aborted once. Another brute force conflict with it
+	neither needs to look at the THDs nor to wake it up again; if it
+	waits for a lock, RecLock::lock_add() cancels the wait when the
+	brute force lock is queued behind it. */
+	if (lock->trx->lock.wsrep_bf_victim) return;
+
 	my_bool bf_this  = wsrep_thd_is_BF(trx->mysql_thd, FALSE);
 	my_bool bf_other = wsrep_thd_is_BF(lock->trx->mysql_thd, TRUE);
 
@@ -1283,31 +1502,27 @@ wsrep_kill_victim(const trx_t * const trx, const lock_t *lock) {
 			is in the queue*/
 		} else if (lock->trx != trx) {
 			if (wsrep_log_conflicts) {
-				if (bf_this)
-					fputs("\n*** Priority TRANSACTION:\n", 
-					      stderr);
-				else
-					fputs("\n*** Victim TRANSACTION:\n", 
-					      stderr);
-				wsrep_trx_print_locking(stderr, trx, 3000);
-
-				if (bf_other)
-					fputs("\n*** Priority TRANSACTION:\n", 
-					      stderr);
-				else
-					fputs("\n*** Victim TRANSACTION:\n", 
-					      stderr);
-				wsrep_trx_print_locking(stderr, lock->trx, 3000);
-
-				fputs("*** WAITING FOR THIS LOCK TO BE GRANTED:\n",
-				      stderr);
-
-				if (lock_get_type(lock) == LOCK_REC) {
-					lock_rec_print(stderr, lock);
+				wsrep_print_conflict(trx, lock, bf_this,
+						     bf_other);
+			}
+			if (wsrep_thd_conflict_state(
+				lock->trx->mysql_thd, FALSE) == NO_CONFLICT) {
+
+				if (lock_get_type_low(lock) == LOCK_REC) {
+					lock_wsrep_note_bf_abort(
+						lock->trx, lock->index->table,
+						lock->index,
+						lock_wsrep_key_hash(
+							block, heap_no,
+							lock->index));
 				} else {
-					lock_table_print(stderr, lock);
+					lock_wsrep_note_bf_abort(
+						lock->trx,
+						lock->un_member.tab_lock.table,
+						NULL, 0);
 				}
 			}
+
 			wsrep_innobase_kill_one_trx(trx->mysql_thd,
 				(const trx_t*) trx, lock->trx, TRUE);
 		}
@@ -1346,7 +1561,7 @@ lock_rec_other_has_conflicting(
 		if (lock_rec_has_to_wait(TRUE, trx, mode, lock, is_supremum)) {
 			if (wsrep_on(trx->mysql_thd)) {
 				trx_mutex_enter(lock->trx);
-				wsrep_kill_victim(trx, lock);
+				wsrep_kill_victim(trx, lock, block, heap_no);
 				trx_mutex_exit(lock->trx);
                         }
 #else
@@ -4385,7 +4600,8 @@ lock_table_other_has_incompatible(
 				if (wsrep_debug) 
 					ib::info() << "WSREP: table lock abort";
 				trx_mutex_enter(lock->trx);
-				wsrep_kill_victim((trx_t *)trx, (lock_t *)lock);
+				wsrep_kill_victim((trx_t *)trx, (lock_t *)lock,
+						  NULL, ULINT_UNDEFINED);
 				trx_mutex_exit(lock->trx);
 			}
 #endif /* WITH_WSREP */
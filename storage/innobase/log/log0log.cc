@@ -104,6 +104,12 @@ log_t*	log_sys	= NULL;
 /** Whether to generate and require checksums on the redo log pages */
 my_bool	innodb_log_checksums;
 
+#ifdef WITH_WSREP
+/** Start of the redo log not yet copied by native SST, 0 if no SST is
+running. Protected by log_sys->mutex. */
+lsn_t	log_sst_lsn	= 0;
+#endif /* WITH_WSREP */
+
 /** Pointer to the log checksum calculation function */
 log_checksum_func_t log_checksum_algorithm_ptr;
 
@@ -151,6 +157,11 @@ extern "C"
 os_thread_ret_t
 DECLARE_THREAD(log_scrub_thread)(void*);
 
+/** Whether the log writer and flusher threads serve log_wait_up_to() */
+static volatile bool	log_writer_threads_active;
+/** Number of the log writer and flusher threads running */
+ulint			log_writer_n_threads;
+
 
 /******************************************************//**
 Completes a checkpoint write i/o to a log file. */
@@ -159,6 +170,12 @@ void
 log_io_complete_checkpoint(void);
 /*============================*/
 
+/** Wait until all strings with space reserved by log_buffer_reserve()
+have been copied to the log buffer. */
+static
+void
+log_buffer_wait_for_copies();
+
 #ifndef UNIV_HOTBACKUP
 /****************************************************************//**
 Returns the oldest modified block lsn in the pool, or log_sys->lsn if none
@@ -187,7 +204,8 @@ log_buf_pool_get_oldest_modification(void)
 /****************************************************************//**
 Checks if the log groups have a big enough margin of free space in
 so that a new log entry can be written without overwriting log data
-that is not read by the changed page bitmap thread.
+that is not read by the changed page bitmap thread, or not yet copied
+by native SST.
 @return true if there is not enough free space. */
 static
 bool
@@ -199,13 +217,23 @@ log_check_tracking_margin(
 	lsn_t	tracked_lsn;
 	lsn_t	tracked_lsn_age;
 
+#ifdef WITH_WSREP
+	if (!srv_track_changed_pages && !log_sst_lsn) {
+#else
 	if (!srv_track_changed_pages) {
+#endif /* WITH_WSREP */
 		return false;
 	}
 
 	ut_ad(mutex_own(&(log_sys->mutex)));
 
-	tracked_lsn = log_get_tracked_lsn();
+	tracked_lsn = srv_track_changed_pages
+		? log_get_tracked_lsn() : LSN_MAX;
+#ifdef WITH_WSREP
+	if (log_sst_lsn && log_sst_lsn < tracked_lsn) {
+		tracked_lsn = log_sst_lsn;
+	}
+#endif /* WITH_WSREP */
 	tracked_lsn_age = log_sys->lsn - tracked_lsn;
 
 	/* The overwrite would happen when log_sys->log_group_capacity is
@@ -253,6 +281,10 @@ log_buffer_extend(
 
 	log_sys->is_extending = true;
 
+	/* No more space is reserved while extending, but the copies to
+	the space reserved before must be complete before it is moved. */
+	log_buffer_wait_for_copies();
+
 	while (ut_calc_align_down(log_sys->buf_free,
 				  OS_FILE_LOG_BLOCK_SIZE)
 	       != ut_calc_align_down(log_sys->buf_next_to_write,
@@ -539,6 +571,147 @@ part_loop:
 	srv_stats.log_write_requests.inc();
 }
 
+/** Reserve space for a string in the log buffer without copying the string.
+The headers of the log blocks of the space are set up as by log_write_low().
+The caller must copy the string with log_buffer_copy() and then call
+log_buffer_copy_complete(); it may release the log mutex in between, as the
+log buffer is not written to the log files before all copies are complete.
+@param[in]	str_len	string length
+@return offset of the string in log_sys->buf */
+ulint
+log_buffer_reserve(
+	ulint	str_len)
+{
+	log_t*	log	= log_sys;
+	ulint	offset	= log->buf_free;
+	ulint	len;
+	ulint	data_len;
+	byte*	log_block;
+
+	ut_ad(log_mutex_own());
+	ut_ad(!recv_no_log_write);
+
+	while (str_len > 0) {
+		data_len = (log->buf_free % OS_FILE_LOG_BLOCK_SIZE) + str_len;
+
+		if (data_len <= OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+			len = str_len;
+		} else {
+			data_len = OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE;
+
+			len = OS_FILE_LOG_BLOCK_SIZE
+				- (log->buf_free % OS_FILE_LOG_BLOCK_SIZE)
+				- LOG_BLOCK_TRL_SIZE;
+		}
+
+		str_len -= len;
+
+		log_block = static_cast<byte*>(
+			ut_align_down(
+				log->buf + log->buf_free,
+				OS_FILE_LOG_BLOCK_SIZE));
+
+		log_block_set_data_len(log_block, data_len);
+
+		if (data_len == OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+			log_block_set_data_len(log_block,
+					       OS_FILE_LOG_BLOCK_SIZE);
+			log_block_set_checkpoint_no(
+				log_block, log_sys->next_checkpoint_no);
+			len += LOG_BLOCK_HDR_SIZE + LOG_BLOCK_TRL_SIZE;
+
+			log->lsn += len;
+
+			log_block_init(log_block + OS_FILE_LOG_BLOCK_SIZE,
+				       log->lsn);
+		} else {
+			log->lsn += len;
+		}
+
+		log->buf_free += len;
+
+		ut_ad(log->buf_free <= log->buf_size);
+	}
+
+	os_atomic_increment_ulint(&log->n_pending_copies, 1);
+
+	srv_stats.log_write_requests.inc();
+
+	return(offset);
+}
+
+/** Copy a string to the space reserved by log_buffer_reserve().
+@param[in,out]	buf	log_sys->buf when the space was reserved
+@param[in,out]	offset	offset of the string in buf; advanced past it
+@param[in]	str	string
+@param[in]	str_len	string length */
+void
+log_buffer_copy(
+	byte*		buf,
+	ulint*		offset,
+	const byte*	str,
+	ulint		str_len)
+{
+	while (str_len > 0) {
+		ulint	len = OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE
+			- *offset % OS_FILE_LOG_BLOCK_SIZE;
+
+		if (len > str_len) {
+			len = str_len;
+		}
+
+		ut_memcpy(buf + *offset, str, len);
+
+		str += len;
+		str_len -= len;
+		*offset += len;
+
+		if (*offset % OS_FILE_LOG_BLOCK_SIZE
+		    == OS_FILE_LOG_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+			/* Skip the trailer of the full block and the
+			header of the next one */
+			*offset += LOG_BLOCK_TRL_SIZE + LOG_BLOCK_HDR_SIZE;
+		}
+	}
+}
+
+/** Note that a string has been copied to the space reserved by
+log_buffer_reserve(). */
+void
+log_buffer_copy_complete()
+{
+	/* The barrier of the atomic operation makes the copy visible
+	to the thread that sees the count drop. */
+	ut_ad(log_sys->n_pending_copies > 0);
+	os_atomic_decrement_ulint(&log_sys->n_pending_copies, 1);
+}
+
+/** Wait until all strings with space reserved by log_buffer_reserve()
+have been copied to the log buffer. The caller holds the log mutex, so
+no more space is reserved meanwhile. */
+static
+void
+log_buffer_wait_for_copies()
+{
+	ut_ad(log_mutex_own());
+
+	for (ulint i = 0;; ++i) {
+		os_rmb;
+		if (*static_cast<volatile ulint*>(
+			    &log_sys->n_pending_copies) == 0) {
+			break;
+		}
+
+		if (i < srv_n_spin_wait_rounds) {
+			ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
+		} else {
+			os_thread_yield();
+		}
+	}
+
+	os_rmb;
+}
+
 /************************************************************//**
 Closes the log.
 @return lsn */
@@ -903,6 +1076,7 @@ log_init(void)
 		ut_align(log_sys->buf_ptr, MAX_SRV_LOG_WRITE_AHEAD_SIZE));
 
 	log_sys->first_in_use = true;
+	log_sys->n_pending_copies = 0;
 
 	log_sys->max_buf_free = log_sys->buf_size / LOG_BUF_FLUSH_RATIO
 		- LOG_BUF_FLUSH_MARGIN;
@@ -1577,6 +1751,36 @@ loop:
 	}
 }
 
+/** Wake up the threads waiting in log_wait_up_to() for an lsn which
+write_lsn or flushed_to_disk_lsn has passed.
+@param[in]	events	log_sys->write_events or log_sys->flush_events
+@param[in]	old_lsn	value of the lsn before it advanced
+@param[in]	new_lsn	value of the lsn now */
+static
+void
+log_wake_waiters(
+	os_event_t*	events,
+	lsn_t		old_lsn,
+	lsn_t		new_lsn)
+{
+	if (!log_writer_threads_active || new_lsn <= old_lsn) {
+		return;
+	}
+
+	/* A thread waits on the event of the log block of its lsn */
+	lsn_t	first = old_lsn / OS_FILE_LOG_BLOCK_SIZE;
+	lsn_t	last = new_lsn / OS_FILE_LOG_BLOCK_SIZE;
+
+	if (last - first >= LOG_WAIT_EVENTS) {
+		first = 0;
+		last = LOG_WAIT_EVENTS - 1;
+	}
+
+	for (lsn_t i = first; i <= last; ++i) {
+		os_event_set(events[i % LOG_WAIT_EVENTS]);
+	}
+}
+
 /** Flush the log has been written to the log file. */
 static
 void
@@ -1591,8 +1795,19 @@ log_write_flush_to_disk_low()
 #endif
 	if (do_flush) {
 		log_group_t*	group = UT_LIST_GET_FIRST(log_sys->log_groups);
+		const lsn_t	flushed_lsn = log_sys->flushed_to_disk_lsn;
+
 		fil_flush(group->space_id);
 		log_sys->flushed_to_disk_lsn = log_sys->current_flush_lsn;
+
+		if (log_sys->flushed_to_disk_lsn > flushed_lsn) {
+			srv_stats.log_flush_batches.inc();
+			srv_stats.log_flush_batch_bytes.add(
+				log_sys->flushed_to_disk_lsn - flushed_lsn);
+		}
+
+		log_wake_waiters(log_sys->flush_events, flushed_lsn,
+				 log_sys->flushed_to_disk_lsn);
 	}
 
 	log_sys->n_pending_flushes--;
@@ -1731,6 +1946,11 @@ loop:
 	}
 
 	log_mutex_enter();
+
+	/* Strings copied to the log buffer without the log mutex must be
+	complete before the buffer is written or switched. */
+	log_buffer_wait_for_copies();
+
 	if (!flush_to_disk
 	    && log_sys->buf_free == log_sys->buf_next_to_write) {
 		/* Nothing to write and no flush to disk requested */
@@ -1828,15 +2048,27 @@ loop:
 
 	srv_stats.log_padded.add(pad_size);
 
+	const lsn_t	old_write_lsn = log_sys->write_lsn;
+
 	log_sys->write_lsn = write_lsn;
 
+	srv_stats.log_write_batches.inc();
+	srv_stats.log_write_batch_bytes.add(write_lsn - old_write_lsn);
+
+	log_wake_waiters(log_sys->write_events, old_write_lsn, write_lsn);
+
 #ifndef _WIN32
 	if (srv_unix_file_flush_method == SRV_UNIX_O_DSYNC
 	    || srv_unix_file_flush_method == SRV_UNIX_ALL_O_DIRECT) {
 		/* O_SYNC and ALL_O_DIRECT mean the OS did not buffer the log
 		file at all: so we have also flushed to disk what we have
 		written */
+		const lsn_t	flushed_lsn = log_sys->flushed_to_disk_lsn;
+
 		log_sys->flushed_to_disk_lsn = log_sys->write_lsn;
+
+		log_wake_waiters(log_sys->flush_events, flushed_lsn,
+				 log_sys->write_lsn);
 	}
 #endif /* !_WIN32 */
 
@@ -1858,6 +2090,186 @@ log_buffer_flush_to_disk(
 	log_write_up_to(log_get_lsn(), sync);
 }
 
+/** Check if the log has been written, or also flushed to disk, up to an lsn.
+@param[in]	lsn		log sequence number
+@param[in]	flush_to_disk	whether to check flushed_to_disk_lsn
+@return whether the log has been written or flushed up to lsn */
+static inline
+bool
+log_is_written_up_to(
+	lsn_t	lsn,
+	bool	flush_to_disk)
+{
+	os_rmb;
+	return(flush_to_disk
+	       ? log_sys->flushed_to_disk_lsn >= lsn
+	       : log_sys->write_lsn >= lsn);
+}
+
+/** Wait until the log has been written, and optionally flushed to disk, up
+to an lsn. With innodb_log_writer_threads the log writer and flusher threads
+do the write and flush while the caller spins briefly and then sleeps until
+the lsn is reached, otherwise the caller does it by log_write_up_to().
+@param[in]	lsn		log sequence number that should be written
+@param[in]	flush_to_disk	whether the written log should also
+be flushed to the file system */
+void
+log_wait_up_to(
+	lsn_t	lsn,
+	bool	flush_to_disk)
+{
+	if (!log_writer_threads_active) {
+		log_write_up_to(lsn, flush_to_disk);
+		return;
+	}
+
+	if (log_is_written_up_to(lsn, flush_to_disk)) {
+		return;
+	}
+
+	if (flush_to_disk) {
+		log_sys->flush_requested = true;
+		os_wmb;
+	}
+
+	os_event_set(log_sys->writer_event);
+
+	for (ulint i = 0; i < srv_n_spin_wait_rounds; ++i) {
+		ut_delay(ut_rnd_interval(0, srv_spin_wait_delay));
+
+		if (log_is_written_up_to(lsn, flush_to_disk)) {
+			return;
+		}
+	}
+
+	os_event_t	event = (flush_to_disk
+				 ? log_sys->flush_events
+				 : log_sys->write_events)[
+		(lsn / OS_FILE_LOG_BLOCK_SIZE) % LOG_WAIT_EVENTS];
+
+	srv_stats.log_waiter_sleeps.inc();
+
+	for (;;) {
+		int64_t	sig_count = os_event_reset(event);
+
+		if (log_is_written_up_to(lsn, flush_to_disk)) {
+			return;
+		}
+
+		if (!log_writer_threads_active) {
+			/* The threads are exiting at shutdown */
+			log_write_up_to(lsn, flush_to_disk);
+			return;
+		}
+
+		os_event_wait_time_low(event, 100000, sig_count);
+	}
+}
+
+/** This is the log writer thread. It writes the log buffer to the log files
+when the lsn advances past write_lsn and wakes up the log flusher thread
+when a flush to disk has been requested, so that the next write overlaps
+with the flush.
+@return this function does not return, it calls os_thread_exit() */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(log_writer_thread)(void*)
+{
+	ut_ad(!srv_read_only_mode);
+
+	while (srv_shutdown_state < SRV_SHUTDOWN_FLUSH_PHASE) {
+		int64_t	sig_count = os_event_reset(log_sys->writer_event);
+
+		os_rmb;
+		const bool	flush = log_sys->flush_requested;
+
+		if (flush) {
+			log_sys->flush_requested = false;
+			os_wmb;
+		}
+
+		const lsn_t	lsn = log_get_lsn();
+
+		if (lsn > log_sys->write_lsn) {
+			log_write_up_to(lsn, false);
+		}
+
+		if (flush) {
+			os_event_set(log_sys->flusher_event);
+		}
+
+		if (lsn == log_get_lsn()) {
+			os_event_wait_time_low(
+				log_sys->writer_event, 100000, sig_count);
+		}
+	}
+
+	log_writer_threads_active = false;
+
+	os_event_set(log_sys->flusher_event);
+
+	os_atomic_decrement_ulint(&log_writer_n_threads, 1);
+
+	os_thread_exit();
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/** This is the log flusher thread. It flushes to disk the log written by
+the log writer thread when woken up by it.
+@return this function does not return, it calls os_thread_exit() */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(log_flusher_thread)(void*)
+{
+	ut_ad(!srv_read_only_mode);
+
+	while (srv_shutdown_state < SRV_SHUTDOWN_FLUSH_PHASE) {
+		int64_t	sig_count = os_event_reset(log_sys->flusher_event);
+
+		os_rmb;
+		const lsn_t	lsn = log_sys->write_lsn;
+
+		if (lsn > log_sys->flushed_to_disk_lsn) {
+			log_write_up_to(lsn, true);
+		} else {
+			os_event_wait_time_low(
+				log_sys->flusher_event, 100000, sig_count);
+		}
+	}
+
+	log_writer_threads_active = false;
+
+	os_atomic_decrement_ulint(&log_writer_n_threads, 1);
+
+	os_thread_exit();
+
+	OS_THREAD_DUMMY_RETURN;
+}
+
+/** Start the log writer and flusher threads. */
+void
+log_writer_threads_start()
+{
+	ut_ad(!srv_read_only_mode);
+	ut_ad(!log_writer_threads_active);
+
+	log_sys->writer_event = os_event_create("log_writer_event");
+	log_sys->flusher_event = os_event_create("log_flusher_event");
+
+	for (ulint i = 0; i < LOG_WAIT_EVENTS; ++i) {
+		log_sys->write_events[i] = os_event_create(0);
+		log_sys->flush_events[i] = os_event_create(0);
+	}
+
+	log_writer_n_threads = 2;
+	log_writer_threads_active = true;
+	os_wmb;
+
+	os_thread_create(log_writer_thread, NULL, NULL);
+	os_thread_create(log_flusher_thread, NULL, NULL);
+}
+
 /****************************************************************//**
 This functions writes the log buffer to the log file and if 'flush'
 is set it forces a flush of the log file as well. This is meant to be
@@ -2663,7 +3075,8 @@ loop:
 	const ulint	n_flush	= log_sys->n_pending_flushes;
 	log_mutex_exit();
 
-	if (log_scrub_thread_active || n_write != 0 || n_flush != 0) {
+	if (log_scrub_thread_active || log_writer_n_threads != 0
+	    || n_write != 0 || n_flush != 0) {
 		if (srv_print_verbose_log && count > 600) {
 			ib::info() << "Pending checkpoint_writes: " << n_write
 				<< ". Pending log flush writes: " << n_flush;
@@ -3008,6 +3421,18 @@ log_shutdown(void)
 		os_event_destroy(log_scrub_event);
 	}
 
+	if (log_sys->writer_event != NULL) {
+		ut_ad(log_writer_n_threads == 0);
+
+		os_event_destroy(log_sys->writer_event);
+		os_event_destroy(log_sys->flusher_event);
+
+		for (ulint i = 0; i < LOG_WAIT_EVENTS; ++i) {
+			os_event_destroy(log_sys->write_events[i]);
+			os_event_destroy(log_sys->flush_events[i]);
+		}
+	}
+
 	recv_sys_close();
 }
 
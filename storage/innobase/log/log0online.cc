@@ -175,25 +175,20 @@ log_online_compare_bmp_keys(
 }
 
 /****************************************************************//**
-Set a bit for tracked page in the bitmap. Expand the bitmap tree as
-necessary. */
+Find the bitmap block for tracked page. Expand the bitmap tree as
+necessary.
+@return bitmap block */
 static
-void
-log_online_set_page_bit(
-/*====================*/
+byte*
+log_online_get_bitmap_block(
+/*========================*/
 	ulint	space,	/*!<in: log record space id */
 	ulint	page_no)/*!<in: log record page id */
 {
 	ut_ad(mutex_own(&log_bmp_sys_mutex));
 
-	ut_a(space != ULINT_UNDEFINED);
-	ut_a(page_no != ULINT_UNDEFINED);
-
 	ulint block_start_page = page_no / MODIFIED_PAGE_BLOCK_ID_COUNT
 		* MODIFIED_PAGE_BLOCK_ID_COUNT;
-	ulint block_pos = block_start_page ? (page_no % block_start_page / 8)
-		: (page_no / 8);
-	uint bit_pos = page_no % 8;
 
 	byte search_page[MODIFIED_PAGE_BLOCK_SIZE];
 	mach_write_to_4(search_page + MODIFIED_PAGE_SPACE_ID, space);
@@ -229,6 +224,29 @@ log_online_set_page_bit(
 		rbt_add_preallocated_node(log_bmp_sys->modified_pages,
 					  &tree_search_pos, new_node);
 	}
+	return(page_ptr);
+}
+
+/****************************************************************//**
+Set a bit for tracked page in the bitmap. Expand the bitmap tree as
+necessary. */
+static
+void
+log_online_set_page_bit(
+/*====================*/
+	ulint	space,	/*!<in: log record space id */
+	ulint	page_no)/*!<in: log record page id */
+{
+	ut_a(space != ULINT_UNDEFINED);
+	ut_a(page_no != ULINT_UNDEFINED);
+
+	ulint block_start_page = page_no / MODIFIED_PAGE_BLOCK_ID_COUNT
+		* MODIFIED_PAGE_BLOCK_ID_COUNT;
+	ulint block_pos = block_start_page ? (page_no % block_start_page / 8)
+		: (page_no / 8);
+	uint bit_pos = page_no % 8;
+
+	byte* page_ptr = log_online_get_bitmap_block(space, page_no);
 	page_ptr[MODIFIED_PAGE_BLOCK_BITMAP + block_pos] |= (1U << bit_pos);
 }
 
@@ -1213,6 +1231,12 @@ log_online_write_bitmap(void)
 		}
 	}
 
+	/* An interval without changed pages is written as an empty block, so
+	that readers can tell it from an interval which was not tracked */
+	if (rbt_empty(log_bmp_sys->modified_pages)) {
+		log_online_get_bitmap_block(0, 0);
+	}
+
 	ib_rbt_node_t *bmp_tree_node
 		= (ib_rbt_node_t *)rbt_first(log_bmp_sys->modified_pages);
 	const ib_rbt_node_t * const last_bmp_tree_node
@@ -1340,7 +1364,7 @@ log_online_diagnose_inconsistent_dir(
 }
 
 /*********************************************************************//**
-List the bitmap files in srv_data_home and setup their range that contains the
+List the bitmap files in a directory and setup their range that contains the
 specified LSN interval.  This range, if non-empty, will start with a file that
 has the greatest LSN equal to or less than the start LSN and will include all
 the files up to the one with the greatest LSN less than the end LSN.  Caller
@@ -1357,6 +1381,8 @@ log_online_setup_bitmap_file_range(
 /*===============================*/
 	log_online_bitmap_file_range_t	*bitmap_files,	/*!<in/out: bitmap file
 							range */
+	const char			*dir,		/*!<in: directory of
+							the files */
 	lsn_t				range_start,	/*!<in: start LSN */
 	lsn_t				range_end)	/*!<in: end LSN */
 {
@@ -1373,15 +1399,15 @@ log_online_setup_bitmap_file_range(
 
 	/* 1st pass: size the info array */
 
-	bitmap_dir = os_file_opendir(srv_data_home, false);
+	bitmap_dir = os_file_opendir(dir, false);
 	if (UNIV_UNLIKELY(!bitmap_dir)) {
 
 		ib::error() << "Failed to open bitmap directory \'"
-			    << srv_data_home << "\'";
+			    << dir << "\'";
 		return false;
 	}
 
-	while (!os_file_readdir_next_file(srv_data_home, bitmap_dir,
+	while (!os_file_readdir_next_file(dir, bitmap_dir,
 					  &bitmap_dir_file_info)) {
 
 		ulong	file_seq_num;
@@ -1427,7 +1453,7 @@ log_online_setup_bitmap_file_range(
 
 		os_file_get_last_error(true);
 		ib::error() << "Cannot close \'"
-			    << srv_data_home << "\'";
+			    << dir << "\'";
 		return false;
 	}
 
@@ -1443,11 +1469,11 @@ log_online_setup_bitmap_file_range(
 
 	/* 2nd pass: get the file names in the file_seq_num order */
 
-	bitmap_dir = os_file_opendir(srv_data_home, false);
+	bitmap_dir = os_file_opendir(dir, false);
 	if (UNIV_UNLIKELY(!bitmap_dir)) {
 
 		ib::error() << "Failed to open bitmap directory \'"
-			    << srv_data_home << "\'";
+			    << dir << "\'";
 		return false;
 	}
 
@@ -1457,7 +1483,7 @@ log_online_setup_bitmap_file_range(
 			   * sizeof(bitmap_files->files[0]),
 			   mem_key_log_online_iterator_files));
 
-	while (!os_file_readdir_next_file(srv_data_home, bitmap_dir,
+	while (!os_file_readdir_next_file(dir, bitmap_dir,
 					  &bitmap_dir_file_info)) {
 
 		ulong	file_seq_num;
@@ -1497,7 +1523,7 @@ log_online_setup_bitmap_file_range(
 
 		os_file_get_last_error(true);
 		ib::error() << "Cannot close \'"
-			    << srv_data_home << "\'";
+			    << dir << "\'";
 		free(bitmap_files->files);
 		return false;
 	}
@@ -1538,27 +1564,27 @@ static
 bool
 log_online_open_bitmap_file_read_only(
 /*==================================*/
+	const char*			dir,		/*!<in: directory of
+							the file */
 	const char*			name,		/*!<in: bitmap file
-							name without directory,
-							which is assumed to be
-							srv_data_home */
+							name without directory */
 	log_online_bitmap_file_t*	bitmap_file)	/*!<out: opened bitmap
 							file */
 {
 	bool	success	= false;
-	size_t  srv_data_home_len;
+	size_t  dir_len;
 
 	ut_ad(name[0] != '\0');
 
-	srv_data_home_len = strlen(srv_data_home);
-	if (srv_data_home_len
-			&& srv_data_home[srv_data_home_len-1]
+	dir_len = strlen(dir);
+	if (dir_len
+			&& dir[dir_len-1]
 			!= SRV_PATH_SEPARATOR) {
 		ut_snprintf(bitmap_file->name, sizeof(bitmap_file->name), "%s%c%s",
-				srv_data_home, SRV_PATH_SEPARATOR, name);
+				dir, SRV_PATH_SEPARATOR, name);
 	} else {
 		ut_snprintf(bitmap_file->name, sizeof(bitmap_file->name), "%s%s",
-				srv_data_home, name);
+				dir, name);
 	}
 	bitmap_file->file
 		= os_file_create_simple_no_error_handling(innodb_bmp_file_key,
@@ -1652,10 +1678,13 @@ log_online_bitmap_iterator_init(
 /*============================*/
 	log_bitmap_iterator_t	*i,	/*!<in/out:  iterator */
 	lsn_t			min_lsn,/*!< in: start LSN */
-	lsn_t			max_lsn)/*!< in: end LSN */
+	lsn_t			max_lsn,/*!< in: end LSN */
+	const char*		dir)	/*!< in: directory of the bitmap
+					files, NULL for srv_data_home */
 {
 	ut_a(i);
 
+	i->dir = dir != NULL ? dir : srv_data_home;
 	i->max_lsn = max_lsn;
 
 	if (UNIV_UNLIKELY(min_lsn > max_lsn)) {
@@ -1669,8 +1698,8 @@ log_online_bitmap_iterator_init(
 		return true;
 	}
 
-	if (!log_online_setup_bitmap_file_range(&i->in_files, min_lsn,
-		max_lsn)) {
+	if (!log_online_setup_bitmap_file_range(&i->in_files, i->dir,
+						min_lsn, max_lsn)) {
 
 		i->failed = true;
 		return false;
@@ -1689,7 +1718,7 @@ log_online_bitmap_iterator_init(
 
 	/* Open the 1st bitmap file */
 	if (UNIV_UNLIKELY(!log_online_open_bitmap_file_read_only(
-				i->in_files.files[i->in_i].name,
+				i->dir, i->in_files.files[i->in_i].name,
 				&i->in))) {
 
 		i->in_i = i->in_files.count;
@@ -1810,7 +1839,7 @@ log_online_bitmap_iterator_next(
 			}
 
 			success = log_online_open_bitmap_file_read_only(
-					i->in_files.files[i->in_i].name,
+					i->dir, i->in_files.files[i->in_i].name,
 					&i->in);
 			if (UNIV_UNLIKELY(!success)) {
 
@@ -1878,7 +1907,8 @@ log_online_purge_changed_page_bitmaps(
 		}
 	}
 
-	if (!log_online_setup_bitmap_file_range(&bitmap_files, 0, LSN_MAX)) {
+	if (!log_online_setup_bitmap_file_range(&bitmap_files, srv_data_home,
+						0, LSN_MAX)) {
 		if (log_bmp_sys_inited) {
 			mutex_exit(&log_bmp_sys_mutex);
 		}
@@ -158,6 +158,12 @@ This is the default value. If the actual size of the buffer pool is
 larger than 10 MB we'll set this value to 512. */
 ulint	recv_n_pool_free_frames;
 
+/** Number of pages the redo log was applied to by recovery */
+ulint	recv_n_pages_applied;
+
+/** Time recovery spent applying the redo log, in milliseconds */
+ulint	recv_apply_time_ms;
+
 /** The maximum lsn we see for a page during the recovery process. If this
 is bigger than the lsn we are able to scan up to, that is an indication that
 the recovery failed and the database may be corrupt. */
@@ -2604,53 +2610,29 @@ recv_read_in_area(
 	return(n);
 }
 
-/*******************************************************************//**
-Empties the hash table of stored log records, applying them to appropriate
-pages. */
+/** Apply the hashed log records of the cells i of recv_sys->addr_hash
+for which i % recv_sys->n_apply_parts == part.
+@param[in]	part		partition of the hash table
+@param[in]	print_progress	whether to print the progress in percent */
+static
 void
-recv_apply_hashed_log_recs(
-/*=======================*/
-	ibool	allow_ibuf)	/*!< in: if TRUE, also ibuf operations are
-				allowed during the application; if FALSE,
-				no ibuf operations are allowed, and after
-				the application all file pages are flushed to
-				disk and invalidated in buffer pool: this
-				alternative means that no new log records
-				can be generated during the application;
-				the caller must in this case own the log
-				mutex */
+recv_apply_hashed_log_recs_part(
+	ulint	part,
+	bool	print_progress)
 {
-	recv_addr_t* recv_addr;
-	ulint	i;
-	ibool	has_printed	= FALSE;
-	mtr_t	mtr;
-loop:
+	recv_addr_t*	recv_addr;
+	const ulint	n_cells = hash_get_n_cells(recv_sys->addr_hash);
+	const ulint	n_parts = recv_sys->n_apply_parts;
+	mtr_t		mtr;
+
 	mutex_enter(&(recv_sys->mutex));
 
-	if (recv_sys->apply_batch_on) {
-		bool abort = recv_sys->found_corrupt_log;
-		mutex_exit(&(recv_sys->mutex));
+	for (ulint i = part; i < n_cells; i += n_parts) {
 
-		if (abort) {
-			return;
+		if (recv_sys->found_corrupt_log) {
+			break;
 		}
 
-		os_thread_sleep(500000);
-
-		goto loop;
-	}
-
-	ut_ad(!allow_ibuf == log_mutex_own());
-
-	if (!allow_ibuf) {
-		recv_no_ibuf_operations = true;
-	}
-
-	recv_sys->apply_log_recs = TRUE;
-	recv_sys->apply_batch_on = TRUE;
-
-	for (i = 0; i < hash_get_n_cells(recv_sys->addr_hash); i++) {
-
 		for (recv_addr = static_cast<recv_addr_t*>(
 				HASH_GET_FIRST(recv_sys->addr_hash, i));
 		     recv_addr != 0;
@@ -2682,15 +2664,6 @@ loop:
 			ut_ad(found);
 
 			if (recv_addr->state == RECV_NOT_PROCESSED) {
-				if (!has_printed) {
-					ib::info() << "Starting an apply batch"
-						" of log records"
-						" to the database...";
-					fputs("InnoDB: Progress in percent: ",
-					      stderr);
-					has_printed = TRUE;
-				}
-
 				mutex_exit(&(recv_sys->mutex));
 
 				if (buf_page_peek(page_id)) {
@@ -2715,22 +2688,63 @@ loop:
 			}
 		}
 
-		if (has_printed
-		    && (i * 100) / hash_get_n_cells(recv_sys->addr_hash)
-		    != ((i + 1) * 100)
-		    / hash_get_n_cells(recv_sys->addr_hash)) {
+		if (print_progress
+		    && (i * 100) / n_cells != ((i + n_parts) * 100) / n_cells) {
 
-			fprintf(stderr, "%lu ", (ulong)
-				((i * 100)
-				 / hash_get_n_cells(recv_sys->addr_hash)));
+			fprintf(stderr, "%lu ", (ulong) ((i * 100) / n_cells));
 		}
 	}
 
-	/* Wait until all the pages have been processed */
+	mutex_exit(&(recv_sys->mutex));
+}
+
+/** This is a recovery apply thread. It applies the log records of a
+partition of recv_sys->addr_hash in parallel with the thread running
+recv_apply_hashed_log_recs(), which applies partition 0.
+@param[in]	arg	partition number
+@return this function does not return, it calls os_thread_exit() */
+extern "C"
+os_thread_ret_t
+DECLARE_THREAD(recv_apply_thread)(
+	void*	arg)
+{
+	recv_apply_hashed_log_recs_part(reinterpret_cast<ulint>(arg), false);
+
+	mutex_enter(&(recv_sys->mutex));
+	ut_ad(recv_sys->n_apply_threads > 0);
+	recv_sys->n_apply_threads--;
+	mutex_exit(&(recv_sys->mutex));
 
-	while (recv_sys->n_addrs != 0) {
-                bool abort = recv_sys->found_corrupt_log;
+	os_thread_exit();
+
+	OS_THREAD_DUMMY_RETURN;
+}
 
+/*******************************************************************//**
+Empties the hash table of stored log records, applying them to appropriate
+pages. The hash table is partitioned by cell between
+innodb_recovery_apply_threads threads: the calling thread and
+recovery apply threads. Pages not in the buffer pool are read in and
+the log records applied to them by the i/o-handler threads. */
+void
+recv_apply_hashed_log_recs(
+/*=======================*/
+	ibool	allow_ibuf)	/*!< in: if TRUE, also ibuf operations are
+				allowed during the application; if FALSE,
+				no ibuf operations are allowed, and after
+				the application all file pages are flushed to
+				disk and invalidated in buffer pool: this
+				alternative means that no new log records
+				can be generated during the application;
+				the caller must in this case own the log
+				mutex */
+{
+	ibool	has_printed	= FALSE;
+loop:
+	mutex_enter(&(recv_sys->mutex));
+
+	if (recv_sys->apply_batch_on) {
+		bool abort = recv_sys->found_corrupt_log;
 		mutex_exit(&(recv_sys->mutex));
 
 		if (abort) {
@@ -2739,14 +2753,82 @@ loop:
 
 		os_thread_sleep(500000);
 
-		mutex_enter(&(recv_sys->mutex));
+		goto loop;
+	}
+
+	ut_ad(!allow_ibuf == log_mutex_own());
+
+	if (!allow_ibuf) {
+		recv_no_ibuf_operations = true;
+	}
+
+	recv_sys->apply_log_recs = TRUE;
+	recv_sys->apply_batch_on = TRUE;
+
+	const ulint	n_pages = recv_sys->n_addrs;
+	const ib_time_monotonic_ms_t	start_time = ut_time_monotonic_ms();
+
+	/* Small batches are not worth starting threads for */
+	recv_sys->n_apply_parts = n_pages < 1024
+		? 1 : ut_max(ulint(srv_recovery_apply_threads), ulint(1));
+	recv_sys->n_apply_threads = recv_sys->n_apply_parts - 1;
+
+	if (n_pages != 0) {
+		ib::info() << "Starting an apply batch of log records"
+			" to " << n_pages << " pages of the database"
+			" in " << recv_sys->n_apply_parts << " threads...";
+		fputs("InnoDB: Progress in percent: ", stderr);
+		has_printed = TRUE;
+	}
+
+	mutex_exit(&(recv_sys->mutex));
+
+	for (ulint i = 1; i < recv_sys->n_apply_parts; i++) {
+		os_thread_create(recv_apply_thread,
+				 reinterpret_cast<void*>(i), NULL);
 	}
 
+	recv_apply_hashed_log_recs_part(0, has_printed);
+
 	if (has_printed) {
 
 		fprintf(stderr, "\n");
 	}
 
+	mutex_enter(&(recv_sys->mutex));
+
+	/* Wait until all the pages have been processed */
+
+	for (ulint count = 0;
+	     recv_sys->n_apply_threads != 0 || recv_sys->n_addrs != 0;
+	     count++) {
+		bool abort = recv_sys->found_corrupt_log
+			&& recv_sys->n_apply_threads == 0;
+		const ulint	n_left = recv_sys->n_addrs;
+
+		mutex_exit(&(recv_sys->mutex));
+
+		if (abort) {
+			return;
+		}
+
+		if (count % 20 == 19) {
+			ib::info() << "Applied the log records to "
+				<< n_pages - n_left << " of "
+				<< n_pages << " pages";
+		}
+
+		os_thread_sleep(500000);
+
+		mutex_enter(&(recv_sys->mutex));
+	}
+
+	const ulint	apply_time = static_cast<ulint>(
+		ut_time_monotonic_ms() - start_time);
+
+	recv_n_pages_applied += n_pages;
+	recv_apply_time_ms += apply_time;
+
 	if (!allow_ibuf) {
 
 		/* Flush all the file pages to disk and invalidate them in
@@ -2778,7 +2860,10 @@ loop:
 	recv_sys_empty_hash();
 
 	if (has_printed) {
-		ib::info() << "Apply batch completed";
+		ib::info() << "Apply batch completed: " << n_pages
+			<< " pages in " << apply_time << " ms ("
+			<< n_pages * 1000 / ut_max(apply_time, ulint(1))
+			<< " pages/s)";
 	}
 
 	mutex_exit(&(recv_sys->mutex));
@@ -399,7 +399,8 @@ public:
 	@param[in,out]	mtr	mini-transaction */
 	explicit Command(mtr_t* mtr)
 		:
-		m_locks_released()
+		m_locks_released(),
+		m_log_buf()
 	{
 		init(mtr);
 	}
@@ -436,6 +437,11 @@ public:
 	@param[in]	len	number of bytes to write */
 	void finish_write(ulint len);
 
+	/** Copy the redo log records to the space reserved for them by
+	finish_write(), if it did not copy them. Does not need the log
+	mutex. */
+	void copy_log();
+
 private:
 	/** Prepare to write the mini-transaction log to the redo log buffer.
 	@return number of bytes to write in finish_write() */
@@ -456,6 +462,13 @@ private:
 
 	/** End lsn of the possible log entry for this mtr */
 	lsn_t			m_end_lsn;
+
+	/** Log buffer of the space reserved by finish_write() for the
+	redo log records, or NULL if they were copied there */
+	byte*			m_log_buf;
+
+	/** Offset of the reserved space in m_log_buf */
+	ulint			m_log_offset;
 };
 
 /** Check if a mini-transaction is dirtying a clean page.
@@ -483,6 +496,30 @@ struct mtr_write_log_t {
 	}
 };
 
+/** Copy the redo log records to the space reserved by log_buffer_reserve() */
+struct mtr_copy_log_t {
+	mtr_copy_log_t(byte* buf, ulint offset)
+		:
+		m_buf(buf),
+		m_offset(offset)
+	{}
+
+	/** Copy a block to the redo log buffer.
+	@return whether the copying should continue */
+	bool operator()(const mtr_buf_t::block_t* block)
+	{
+		log_buffer_copy(m_buf, &m_offset, block->begin(),
+				block->used());
+		return(true);
+	}
+
+	/** Log buffer the space was reserved in */
+	byte*	m_buf;
+
+	/** Offset to copy the next block to */
+	ulint	m_offset;
+};
+
 /** Append records to the system-wide redo log buffer.
 @param[in]	log	redo log records */
 void
@@ -637,6 +674,7 @@ mtr_t::commit_checkpoint(
 
 	Command	cmd(this);
 	cmd.finish_write(m_impl.m_log.size());
+	cmd.copy_log();
 	cmd.release_resources();
 
 	if (write_mlog_checkpoint) {
@@ -911,15 +949,34 @@ mtr_t::Command::finish_write(
 		}
 	}
 
-	/* Open the database log for log_write_low */
+	/* Open the database log and reserve the space for the records,
+	which are copied by copy_log() after the log mutex is released. */
 	m_start_lsn = log_reserve_and_open(len);
 
-	mtr_write_log_t	write_log;
-	m_impl->m_log.for_each_block(write_log);
+	m_log_buf = log_sys->buf;
+	m_log_offset = log_buffer_reserve(len);
 
 	m_end_lsn = log_close();
 }
 
+/** Copy the redo log records to the space reserved for them by
+finish_write(), if it did not copy them. */
+void
+mtr_t::Command::copy_log()
+{
+	if (m_log_buf == NULL) {
+		return;
+	}
+
+	mtr_copy_log_t	copy_log(m_log_buf, m_log_offset);
+
+	m_impl->m_log.for_each_block(copy_log);
+
+	log_buffer_copy_complete();
+
+	m_log_buf = NULL;
+}
+
 /** Release the latches and blocks acquired by this mini-transaction */
 void
 mtr_t::Command::release_all()
@@ -984,6 +1041,12 @@ mtr_t::Command::execute()
 		log_flush_order_mutex_exit();
 	}
 
+	/* Copy the records while other mini-transactions reserve log
+	space and insert into the flush list. The flush list order only
+	depends on m_start_lsn, and neither the log buffer nor the pages
+	are written before the copy completes, see log_write_up_to(). */
+	copy_log();
+
 	release_latches();
 
 	release_resources();
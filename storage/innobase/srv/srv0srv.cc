@@ -270,6 +270,7 @@ uint		srv_flush_log_at_timeout = 1;
 ulong		srv_page_size = UNIV_PAGE_SIZE_DEF;
 ulong		srv_page_size_shift = UNIV_PAGE_SIZE_SHIFT_DEF;
 ulong		srv_log_write_ahead_size = 0;
+my_bool		srv_log_writer_threads;
 
 page_size_t	univ_page_size(0, 0, false);
 
@@ -433,6 +434,9 @@ my_bool	srv_master_thread_priority	= FALSE;
 /* The number of purge threads to use.*/
 ulong	srv_n_purge_threads = 4;
 
+/* the number of threads applying the redo log in crash recovery */
+ulong	srv_recovery_apply_threads = 1;
+
 /* the number of pages to purge in one batch */
 ulong	srv_purge_batch_size = 20;
 
@@ -1782,6 +1786,22 @@ srv_export_innodb_status(void)
 
 	export_vars.innodb_log_writes = srv_stats.log_writes;
 
+	export_vars.innodb_log_write_batches = srv_stats.log_write_batches;
+
+	export_vars.innodb_log_write_batch_bytes =
+		srv_stats.log_write_batch_bytes;
+
+	export_vars.innodb_log_flush_batches = srv_stats.log_flush_batches;
+
+	export_vars.innodb_log_flush_batch_bytes =
+		srv_stats.log_flush_batch_bytes;
+
+	export_vars.innodb_log_waiter_sleeps = srv_stats.log_waiter_sleeps;
+
+	export_vars.innodb_recovery_pages_applied = recv_n_pages_applied;
+
+	export_vars.innodb_recovery_apply_time = recv_apply_time_ms;
+
 	export_vars.innodb_dblwr_pages_written =
 		srv_stats.dblwr_pages_written;
 
@@ -0,0 +1,972 @@
+/*****************************************************************************
+
+Copyright (c) 2019, Percona Inc. All Rights Reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 51 Franklin
+Street, Fifth Floor, Boston, MA 02110-1301, USA
+
+*****************************************************************************/
+
+/**************************************************//**
+@file srv/srv0sst.cc
+Copy of the tablespaces and the redo log for native state snapshot transfer
+*******************************************************/
+
+#include "ha_prototypes.h"
+
+#include "srv0sst.h"
+
+#ifdef WITH_WSREP
+
+#include "buf0buf.h"
+#include "buf0dblwr.h"
+#include "buf0dump.h"
+#include "fil0fil.h"
+#include "fsp0fsp.h"
+#include "log0log.h"
+#include "log0online.h"
+#include "os0atomic.h"
+#include "os0file.h"
+#include "os0thread.h"
+#include "srv0srv.h"
+#include "ut0new.h"
+#include "handler.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/** Size of the parts the data files are split into, the parts are copied
+by the data streams in parallel */
+static const ulint	SRV_SST_CHUNK_SIZE = 64 << 20;
+
+/** Size of a single read */
+static const ulint	SRV_SST_READ_SIZE = 1 << 20;
+
+/** How many times a page which fails checksum verification is read again,
+it can be torn by a concurrent write */
+static const ulint	SRV_SST_READ_RETRIES = 10;
+
+/** Part of a data file to copy */
+struct srv_sst_chunk_t {
+	/** tablespace id */
+	ulint		space_id;
+	/** tablespace flags */
+	ulint		flags;
+	/** whether to verify page checksums */
+	bool		verify;
+	/** file name as the file is opened with */
+	std::string	path;
+	/** number of the first page of the file in the tablespace */
+	ulint		node_start;
+	/** first page to copy, relative to the file */
+	ulint		start;
+	/** page after the last one to copy, relative to the file */
+	ulint		end;
+	/** whether this is the end of the last file of the tablespace, which
+	is copied up to the size of the tablespace when it gets there; end is
+	set to where the copy stopped */
+	bool		last;
+};
+
+typedef std::vector<srv_sst_chunk_t, ut_allocator<srv_sst_chunk_t> >
+	srv_sst_chunks_t;
+
+typedef std::set<ulint, std::less<ulint>, ut_allocator<ulint> >
+	srv_sst_spaces_t;
+
+/** Page numbers of a tablespace */
+typedef std::set<ulint, std::less<ulint>, ut_allocator<ulint> >
+	srv_sst_pages_t;
+
+/** Changed pages of every tablespace */
+typedef std::map<ulint, srv_sst_pages_t, std::less<ulint>,
+		 ut_allocator<std::pair<const ulint, srv_sst_pages_t> > >
+	srv_sst_changed_t;
+
+/** State of the copy */
+struct srv_sst_t {
+	/** parts of the data files to copy */
+	srv_sst_chunks_t	chunks;
+	/** next part to copy, incremented atomically */
+	ulint			next_chunk;
+	/** tablespaces which chunks were made for */
+	srv_sst_spaces_t	spaces;
+	/** redo log copied up to this lsn, block aligned */
+	lsn_t			copied_lsn;
+	/** set when a data stream fails, so that the others stop */
+	volatile bool		failed;
+	/** unaligned redo log read buffer */
+	byte*			redo_buf_ptr;
+	/** redo log read buffer */
+	byte*			redo_buf;
+};
+
+/** The copy in progress, NULL if none */
+static srv_sst_t*	srv_sst = NULL;
+
+/** I/O request to read the files as they are stored, the joiner gets
+encrypted and compressed pages as they are */
+static const IORequest	srv_sst_read_request(
+	IORequest::READ | IORequest::IGNORE_MISSING
+	| IORequest::NO_ENCRYPTION | IORequest::NO_COMPRESSION);
+
+static const IORequest	srv_sst_log_read_request(
+	IORequest::LOG | IORequest::READ | IORequest::NO_ENCRYPTION);
+
+/** Make name of a redo log file.
+@param[out]	name	file name
+@param[in]	len	size of name
+@param[in]	file_no	log file number */
+static
+void
+srv_sst_log_file_name(
+	char*	name,
+	ulint	len,
+	ulint	file_no)
+{
+	size_t	dirlen = strlen(srv_log_group_home_dir);
+
+	ut_snprintf(name, len, "%s%s%s%lu", srv_log_group_home_dir,
+		    dirlen && srv_log_group_home_dir[dirlen - 1]
+		    != OS_PATH_SEPARATOR ? "/" : "",
+		    ib_logfile_basename, file_no);
+}
+
+/** List the files of the tablespaces which are not in the copy yet, and
+add the tablespaces to it.
+@param[out]	files	one entry per file, covering all of it
+@param[in,out]	spaces	tablespaces which are in the copy */
+static
+void
+srv_sst_list_files(
+	srv_sst_chunks_t&	files,
+	srv_sst_spaces_t&	spaces)
+{
+	fil_system_enter();
+
+	for (fil_space_t* space = UT_LIST_GET_FIRST(fil_system->space_list);
+	     space != NULL;
+	     space = UT_LIST_GET_NEXT(space_list, space)) {
+
+		if (space->purpose != FIL_TYPE_TABLESPACE
+		    || space->is_stopping()
+		    || !spaces.insert(space->id).second) {
+			continue;
+		}
+
+		srv_sst_chunk_t	file;
+
+		file.space_id = space->id;
+		file.flags = space->flags;
+		/* encrypted and compressed pages are sent as they are
+		stored, their checksums are not verified */
+		file.verify = space->encryption_type == Encryption::NONE
+			&& space->crypt_data == NULL
+			&& space->compression_type == Compression::NONE
+			&& !FSP_FLAGS_GET_ENCRYPTION(space->flags);
+		file.node_start = 0;
+
+		for (fil_node_t* node = UT_LIST_GET_FIRST(space->chain);
+		     node != NULL;
+		     node = UT_LIST_GET_NEXT(chain, node)) {
+
+			file.path = node->name;
+			file.start = 0;
+			file.end = node->size;
+			file.last = UT_LIST_GET_NEXT(chain, node) == NULL;
+
+			files.push_back(file);
+
+			file.node_start += node->size;
+		}
+	}
+
+	fil_system_exit();
+
+	for (srv_sst_chunks_t::iterator it = files.begin();
+	     it != files.end(); ++it) {
+
+		if (it->last) {
+			/* the size of a single-table tablespace is not
+			known until it is opened */
+			ulint	size = fil_space_get_size(it->space_id);
+
+			it->end = size > it->node_start
+				? size - it->node_start : 0;
+		}
+	}
+}
+
+/** Add the parts copying a range of pages of a file to the copy.
+@param[in,out]	chunks	parts of the data files to copy
+@param[in]	file	the file
+@param[in]	start	first page to copy, relative to the file
+@param[in]	end	page after the last one to copy
+@param[in]	last	whether the last part copies the pages allocated
+			after end too */
+static
+void
+srv_sst_add_range(
+	srv_sst_chunks_t&	chunks,
+	const srv_sst_chunk_t&	file,
+	ulint			start,
+	ulint			end,
+	bool			last)
+{
+	srv_sst_chunk_t	chunk = file;
+	const ulint	chunk_pages = SRV_SST_CHUNK_SIZE
+		/ page_size_t(chunk.flags).physical();
+
+	chunk.last = false;
+
+	for (chunk.start = start; chunk.start + chunk_pages < end;
+	     chunk.start += chunk_pages) {
+
+		chunk.end = chunk.start + chunk_pages;
+		chunks.push_back(chunk);
+	}
+
+	chunk.end = end;
+	chunk.last = last;
+	chunks.push_back(chunk);
+}
+
+/** Add the tablespaces which are not in the copy yet to it.
+@param[in,out]	chunks	parts of the data files to copy
+@param[in,out]	spaces	tablespaces which are in the copy
+@param[in]	base	data files of the joiner, or NULL
+@param[in]	changed	pages changed since base, NULL to copy the
+			files in full
+@return number of the files which are copied in full */
+static
+ulint
+srv_sst_add_spaces(
+	srv_sst_chunks_t&		chunks,
+	srv_sst_spaces_t&		spaces,
+	const Wsrep_sst_base*		base,
+	const srv_sst_changed_t*	changed)
+{
+	srv_sst_chunks_t	files;
+	ulint			n_full = 0;
+
+	srv_sst_list_files(files, spaces);
+
+	for (srv_sst_chunks_t::const_iterator it = files.begin();
+	     it != files.end(); ++it) {
+
+		const srv_sst_chunk_t&	file = *it;
+
+		if (changed == NULL
+		    || !base->has_file(file.path.c_str(), file.space_id)) {
+
+			srv_sst_add_range(chunks, file, 0, file.end,
+					  file.last);
+			n_full++;
+			continue;
+		}
+
+		srv_sst_changed_t::const_iterator	space
+			= changed->find(file.space_id);
+
+		if (space != changed->end()) {
+			const srv_sst_pages_t&		pages = space->second;
+			srv_sst_pages_t::const_iterator	page
+				= pages.lower_bound(file.node_start);
+
+			/* copy the changed pages in runs of adjacent ones */
+			while (page != pages.end()
+			       && *page < file.node_start + file.end) {
+
+				ulint	start = *page - file.node_start;
+				ulint	end = start + 1;
+
+				while (++page != pages.end()
+				       && *page == file.node_start + end) {
+					end++;
+				}
+
+				srv_sst_add_range(chunks, file, start,
+						  ut_min(end, file.end), false);
+			}
+		}
+
+		if (file.last) {
+			srv_sst_add_range(chunks, file, file.end, file.end,
+					  true);
+		}
+	}
+
+	return(n_full);
+}
+
+/** Read the pages changed in an lsn range from changed page bitmaps.
+@param[in]	dir		directory of the bitmap files
+@param[in]	start_lsn	start of the range
+@param[in]	end_lsn		end of the range
+@param[in,out]	changed		changed pages to add to
+@return false if the bitmaps do not cover the whole range */
+static
+bool
+srv_sst_read_bitmaps(
+	const char*		dir,
+	lsn_t			start_lsn,
+	lsn_t			end_lsn,
+	srv_sst_changed_t&	changed)
+{
+	if (start_lsn >= end_lsn) {
+		return(true);
+	}
+
+	log_bitmap_iterator_t	i;
+
+	if (!log_online_bitmap_iterator_init(&i, start_lsn, end_lsn, dir)) {
+		return(false);
+	}
+
+	/* Every tracked interval is written as a run of blocks, and the
+	runs must follow each other from start_lsn to end_lsn. */
+	lsn_t	covered_lsn = 0;
+	bool	gap = false;
+
+	while (!gap && log_online_bitmap_iterator_next(&i)) {
+		lsn_t	run_start = LOG_BITMAP_ITERATOR_START_LSN(i);
+		lsn_t	run_end = LOG_BITMAP_ITERATOR_END_LSN(i);
+
+		if (run_end <= start_lsn) {
+			continue;
+		}
+
+		if (run_end != covered_lsn) {
+			gap = covered_lsn == 0
+				? run_start > start_lsn
+				: run_start != covered_lsn;
+			covered_lsn = run_end;
+		}
+
+		if (LOG_BITMAP_ITERATOR_PAGE_CHANGED(i)) {
+			changed[LOG_BITMAP_ITERATOR_SPACE_ID(i)].insert(
+				LOG_BITMAP_ITERATOR_PAGE_NUM(i));
+		}
+	}
+
+	bool	failed = i.failed;
+
+	log_online_bitmap_iterator_release(&i);
+
+	return(!gap && !failed && covered_lsn >= end_lsn);
+}
+
+/** Find the pages to copy for an incremental copy: the pages changed on
+the donor since the base lsn up to the checkpoint the redo log is copied
+from, the pages the joiner changed after the base lsn, which have to be
+reverted, and the doublewrite buffer, which is not redo logged.
+@param[in]	base		data files of the joiner
+@param[in]	checkpoint_lsn	checkpoint the redo log is copied from
+@param[out]	changed		pages to copy
+@return false if the files have to be copied in full */
+static
+bool
+srv_sst_read_changed(
+	const Wsrep_sst_base*	base,
+	lsn_t			checkpoint_lsn,
+	srv_sst_changed_t&	changed)
+{
+	if (!srv_track_changed_pages) {
+		ib::info() << "Native SST: changed page tracking is"
+			" disabled, copying the data files in full";
+		return(false);
+	}
+
+	if (base->lsn == 0 || base->lsn > checkpoint_lsn
+	    || base->lsn > base->joiner_lsn
+	    || (base->lsn < base->joiner_lsn && base->bitmap_dir == NULL)) {
+		ib::info() << "Native SST: the data files of the joiner at "
+			<< base->lsn << " can not be used, copying them in"
+			" full";
+		return(false);
+	}
+
+	/* track the changes up to the checkpoint now */
+	os_event_reset(srv_checkpoint_completed_event);
+	log_online_follow_redo_log();
+
+	if (log_get_tracked_lsn() < checkpoint_lsn) {
+		ib::info() << "Native SST: changed pages are tracked up to "
+			<< log_get_tracked_lsn() << " only, copying the data"
+			" files in full";
+		return(false);
+	}
+
+	if (!srv_sst_read_bitmaps(srv_data_home, base->lsn, checkpoint_lsn,
+				  changed)
+	    || !srv_sst_read_bitmaps(base->bitmap_dir, base->lsn,
+				     base->joiner_lsn, changed)) {
+		ib::info() << "Native SST: changed page bitmaps do not cover"
+			" the changes since " << base->lsn << ", copying the"
+			" data files in full";
+		return(false);
+	}
+
+	if (buf_dblwr != NULL) {
+		srv_sst_pages_t&	pages = changed[TRX_SYS_SPACE];
+
+		for (ulint i = 0; i < TRX_SYS_DOUBLEWRITE_BLOCK_SIZE; i++) {
+			pages.insert(buf_dblwr->block1 + i);
+			pages.insert(buf_dblwr->block2 + i);
+		}
+	}
+
+	return(true);
+}
+
+/** Read one page again until it passes checksum verification.
+@param[in]	chunk		part of the file which is copied
+@param[in]	page_size	page size
+@param[in]	page_no		page number, relative to the file
+@param[in,out]	page		page frame
+@return DB_SUCCESS or error code */
+static
+dberr_t
+srv_sst_reread_page(
+	const srv_sst_chunk_t&	chunk,
+	const page_size_t&	page_size,
+	ulint			page_no,
+	byte*			page)
+{
+	const page_id_t	page_id(chunk.space_id, chunk.node_start + page_no);
+	const bool	skip = fsp_is_checksum_disabled(chunk.space_id);
+
+	for (ulint i = 0; i < SRV_SST_READ_RETRIES; i++) {
+
+		if (!buf_page_is_corrupted(false, page, page_size, skip)) {
+			return(DB_SUCCESS);
+		}
+
+		os_thread_sleep(10000);
+
+		dberr_t	err = fil_io(srv_sst_read_request, true, page_id,
+				     page_size, 0, page_size.physical(),
+				     page, NULL);
+		if (err != DB_SUCCESS) {
+			return(err);
+		}
+	}
+
+	if (!buf_page_is_corrupted(false, page, page_size, skip)) {
+		return(DB_SUCCESS);
+	}
+
+	ib::error() << "Native SST: page " << page_id << " of "
+		<< chunk.path << " failed checksum verification";
+
+	return(DB_CORRUPTION);
+}
+
+/** Copy part of a data file.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the pages to
+@param[in,out]	chunk	part of the file to copy
+@param[in]	buf	read buffer of SRV_SST_READ_SIZE bytes
+@return DB_SUCCESS or error code */
+static
+dberr_t
+srv_sst_copy_chunk(
+	Wsrep_sst_sink*		sink,
+	uint			stream,
+	srv_sst_chunk_t&	chunk,
+	byte*			buf)
+{
+	const page_size_t	page_size(chunk.flags);
+	const ulint		physical = page_size.physical();
+	const ulint		n_read = SRV_SST_READ_SIZE / physical;
+	ulint			page_no = chunk.start;
+
+	while (!srv_sst->failed) {
+		ulint	end = chunk.end;
+
+		if (chunk.last) {
+			/* copy the pages allocated in the meantime too */
+			ulint	size = fil_space_get_size(chunk.space_id);
+
+			end = size > chunk.node_start
+				? size - chunk.node_start : 0;
+		}
+
+		if (page_no >= end) {
+			break;
+		}
+
+		ulint	n = ut_min(end - page_no, n_read);
+
+		dberr_t	err = fil_io(srv_sst_read_request, true,
+				     page_id_t(chunk.space_id,
+					       chunk.node_start + page_no),
+				     page_size, 0, n * physical, buf, NULL);
+
+		if (err != DB_SUCCESS) {
+			/* The tablespace was dropped or truncated, the
+			joiner does the same when it applies the log. */
+			break;
+		}
+
+		for (ulint i = 0; chunk.verify && i < n; i++) {
+			err = srv_sst_reread_page(chunk, page_size,
+						  page_no + i,
+						  buf + i * physical);
+			if (err != DB_SUCCESS) {
+				return(err);
+			}
+		}
+
+		if (sink->write(stream, chunk.path.c_str(),
+				static_cast<ulonglong>(page_no) * physical,
+				buf, n * physical)) {
+			return(DB_ERROR);
+		}
+
+		page_no += n;
+	}
+
+	if (chunk.last) {
+		chunk.end = page_no;
+	}
+
+	return(DB_SUCCESS);
+}
+
+/** Copy the redo log up to an lsn.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the log to
+@param[in]	end_lsn	copy up to this lsn
+@return DB_SUCCESS or error code */
+static
+dberr_t
+srv_sst_copy_redo_low(
+	Wsrep_sst_sink*	sink,
+	uint		stream,
+	lsn_t		end_lsn)
+{
+	log_group_t*	group = UT_LIST_GET_FIRST(log_sys->log_groups);
+	lsn_t		start_lsn = srv_sst->copied_lsn;
+
+	/* The last block is incomplete, it is copied again once it is
+	written in full, or at the end of the copy. */
+	end_lsn = ut_uint64_align_up(end_lsn, OS_FILE_LOG_BLOCK_SIZE);
+
+	while (start_lsn < end_lsn) {
+
+		log_mutex_enter();
+		lsn_t	offset = log_group_calc_lsn_offset(start_lsn, group);
+		log_mutex_exit();
+
+		ulint	len = static_cast<ulint>(ut_min(
+			ut_min(end_lsn - start_lsn,
+			       static_cast<lsn_t>(SRV_SST_READ_SIZE)),
+			group->file_size - offset % group->file_size));
+
+		fil_io(srv_sst_log_read_request, true,
+		       page_id_t(group->space_id,
+				 static_cast<ulint>(
+					 offset / univ_page_size.physical())),
+		       univ_page_size,
+		       static_cast<ulint>(offset % univ_page_size.physical()),
+		       len, srv_sst->redo_buf, NULL);
+
+		/* log_sst_lsn stops the log from wrapping over what was not
+		copied, unless the server had no choice */
+		log_mutex_enter();
+		bool	overwritten = log_sys->lsn - start_lsn
+			> log_group_get_capacity(group);
+		log_mutex_exit();
+
+		if (overwritten) {
+			ib::error() << "Native SST: redo log at " << start_lsn
+				<< " was overwritten before it was copied."
+				" Consider increasing innodb_log_file_size.";
+			return(DB_ERROR);
+		}
+
+		char	name[OS_FILE_MAX_PATH];
+
+		srv_sst_log_file_name(name, sizeof(name),
+				      static_cast<ulint>(
+					      offset / group->file_size));
+
+		if (sink->write(stream, name, offset % group->file_size,
+				srv_sst->redo_buf, len)) {
+			return(DB_ERROR);
+		}
+
+		start_lsn += len;
+	}
+
+	return(DB_SUCCESS);
+}
+
+/** Send a fresh buffer pool dump, for the joiner to load before it joins
+the cluster. Failing to dump does not fail the copy, the joiner only starts
+with a cold buffer pool then.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the dump to
+@return DB_SUCCESS or error code */
+static
+dberr_t
+srv_sst_send_buf_dump(
+	Wsrep_sst_sink*	sink,
+	uint		stream)
+{
+	if (strchr(srv_buf_dump_filename, OS_PATH_SEPARATOR) != NULL
+	    || strchr(srv_buf_dump_filename, '/') != NULL) {
+		ib::info() << "Native SST: not sending the buffer pool dump,"
+			" innodb_buffer_pool_filename is not a file name.";
+		return(DB_SUCCESS);
+	}
+
+	char	path[OS_FILE_MAX_PATH];
+
+	if (!buf_dump_to_file(".sst", path)) {
+		ib::warn() << "Native SST: could not dump the buffer pool,"
+			" the joiner will start with a cold buffer pool.";
+		return(DB_SUCCESS);
+	}
+
+	FILE*	f = fopen(path, "r");
+
+	if (f == NULL) {
+		ib::warn() << "Native SST: cannot open '" << path << "': "
+			<< strerror(errno);
+		unlink(path);
+		return(DB_SUCCESS);
+	}
+
+	char	name[OS_FILE_MAX_PATH];
+	dberr_t	err = DB_SUCCESS;
+
+	ut_snprintf(name, sizeof(name), "./%s", srv_buf_dump_filename);
+
+	fseek(f, 0, SEEK_END);
+	const long	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	if (size < 0 || sink->file(stream, name, size)) {
+		err = DB_ERROR;
+	}
+
+	for (ulint offset = 0; err == DB_SUCCESS; ) {
+		size_t	len = fread(srv_sst->redo_buf, 1, SRV_SST_READ_SIZE, f);
+
+		if (len == 0) {
+			break;
+		}
+
+		if (sink->write(stream, name, offset, srv_sst->redo_buf,
+				len)) {
+			err = DB_ERROR;
+		}
+
+		offset += len;
+	}
+
+	fclose(f);
+	unlink(path);
+
+	return(err);
+}
+
+/** Start the copy: remember the latest checkpoint, start retaining the log
+written after it, send the log file headers and make the list of the data
+files to copy.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the log file headers to
+@param[in]	base	data files of the joiner, or NULL
+@return DB_SUCCESS or error code */
+dberr_t
+srv_sst_backup_begin(
+	Wsrep_sst_sink*		sink,
+	uint			stream,
+	const Wsrep_sst_base*	base)
+{
+	if (srv_read_only_mode) {
+		ib::error() << "Native SST can not be donated in read-only"
+			" mode.";
+		return(DB_READ_ONLY);
+	}
+
+	if (srv_sst != NULL) {
+		ib::error() << "Native SST is already in progress.";
+		return(DB_ERROR);
+	}
+
+	srv_sst = UT_NEW_NOKEY(srv_sst_t());
+	srv_sst->next_chunk = 0;
+	srv_sst->failed = false;
+	srv_sst->redo_buf_ptr = static_cast<byte*>(
+		ut_malloc_nokey(SRV_SST_READ_SIZE + UNIV_PAGE_SIZE));
+	srv_sst->redo_buf = static_cast<byte*>(
+		ut_align(srv_sst->redo_buf_ptr, UNIV_PAGE_SIZE));
+
+	log_group_t*	group = UT_LIST_GET_FIRST(log_sys->log_groups);
+
+	log_mutex_enter();
+	lsn_t	checkpoint_lsn = log_sys->last_checkpoint_lsn;
+	srv_sst->copied_lsn = ut_uint64_align_down(checkpoint_lsn,
+						   OS_FILE_LOG_BLOCK_SIZE);
+	log_sst_lsn = srv_sst->copied_lsn;
+	log_mutex_exit();
+
+	ib::info() << "Native SST: copying redo log from checkpoint "
+		<< checkpoint_lsn;
+
+	srv_sst_changed_t	changed;
+	bool			incremental = base != NULL
+		&& srv_sst_read_changed(base, checkpoint_lsn, changed);
+
+	dberr_t	err = DB_SUCCESS;
+
+	if (sink->begin(stream, incremental ? base->lsn : 0)) {
+		err = DB_ERROR;
+	}
+
+	/* No checkpoint is written while the headers are read, so that the
+	latest checkpoint in them is complete and not older than
+	checkpoint_lsn. */
+	rw_lock_s_lock(&log_sys->checkpoint_lock);
+
+	for (ulint i = 0; i < group->n_files && err == DB_SUCCESS; i++) {
+		const lsn_t	offset = i * group->file_size;
+		char		name[OS_FILE_MAX_PATH];
+
+		fil_io(srv_sst_log_read_request, true,
+		       page_id_t(group->space_id,
+				 static_cast<ulint>(
+					 offset / univ_page_size.physical())),
+		       univ_page_size, 0, LOG_FILE_HDR_SIZE,
+		       srv_sst->redo_buf, NULL);
+
+		srv_sst_log_file_name(name, sizeof(name), i);
+
+		if (sink->file(stream, name, group->file_size)
+		    || sink->write(stream, name, 0, srv_sst->redo_buf,
+				   LOG_FILE_HDR_SIZE)) {
+			err = DB_ERROR;
+		}
+	}
+
+	rw_lock_s_unlock(&log_sys->checkpoint_lock);
+
+	if (err == DB_SUCCESS) {
+		err = srv_sst_send_buf_dump(sink, stream);
+	}
+
+	if (err != DB_SUCCESS) {
+		srv_sst_backup_end(sink, stream, true, NULL);
+		return(err);
+	}
+
+	ulint	n_full = srv_sst_add_spaces(srv_sst->chunks, srv_sst->spaces,
+					    base,
+					    incremental ? &changed : NULL);
+
+	if (incremental) {
+		ib::info() << "Native SST: copying the pages changed since "
+			<< base->lsn << " of " << srv_sst->spaces.size()
+			<< " tablespaces in " << srv_sst->chunks.size()
+			<< " parts, " << n_full << " files in full";
+	} else {
+		ib::info() << "Native SST: copying " << srv_sst->spaces.size()
+			<< " tablespaces in " << srv_sst->chunks.size()
+			<< " parts";
+	}
+
+	return(DB_SUCCESS);
+}
+
+/** Copy data files until all of them are copied. Called concurrently
+for every data stream.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the pages to
+@return DB_SUCCESS or error code */
+dberr_t
+srv_sst_backup_copy(
+	Wsrep_sst_sink*	sink,
+	uint		stream)
+{
+	ut_a(srv_sst != NULL);
+
+	byte*	buf_ptr = static_cast<byte*>(
+		ut_malloc_nokey(SRV_SST_READ_SIZE + UNIV_PAGE_SIZE));
+	byte*	buf = static_cast<byte*>(ut_align(buf_ptr, UNIV_PAGE_SIZE));
+	dberr_t	err = DB_SUCCESS;
+
+	while (!srv_sst->failed) {
+		ulint	i = os_atomic_increment_ulint(
+			&srv_sst->next_chunk, 1) - 1;
+
+		if (i >= srv_sst->chunks.size()) {
+			break;
+		}
+
+		err = srv_sst_copy_chunk(sink, stream, srv_sst->chunks[i],
+					 buf);
+
+		if (err != DB_SUCCESS) {
+			srv_sst->failed = true;
+			break;
+		}
+	}
+
+	ut_free(buf_ptr);
+
+	return(srv_sst->failed && err == DB_SUCCESS ? DB_ERROR : err);
+}
+
+/** Copy the redo log written to the log files so far.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the log to
+@return DB_SUCCESS or error code */
+dberr_t
+srv_sst_backup_redo(
+	Wsrep_sst_sink*	sink,
+	uint		stream)
+{
+	ut_a(srv_sst != NULL);
+
+	log_write_mutex_enter();
+	lsn_t	write_lsn = log_sys->write_lsn;
+	log_write_mutex_exit();
+
+	dberr_t	err = srv_sst_copy_redo_low(sink, stream, write_lsn);
+
+	if (err == DB_SUCCESS) {
+		/* the block with write_lsn may still be written to */
+		srv_sst->copied_lsn = ut_uint64_align_down(
+			write_lsn, OS_FILE_LOG_BLOCK_SIZE);
+
+		log_mutex_enter();
+		log_sst_lsn = srv_sst->copied_lsn;
+		log_mutex_exit();
+	}
+
+	return(err);
+}
+
+/** Send the final size of every data file, so that the joiner can tell
+the files which are in the copy and truncate the files which shrank.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the sizes to
+@return DB_SUCCESS or error code */
+static
+dberr_t
+srv_sst_send_sizes(
+	Wsrep_sst_sink*	sink,
+	uint		stream)
+{
+	srv_sst_chunks_t	files;
+	srv_sst_spaces_t	spaces;
+
+	srv_sst_list_files(files, spaces);
+
+	for (srv_sst_chunks_t::const_iterator it = files.begin();
+	     it != files.end(); ++it) {
+
+		if (sink->file(stream, it->path.c_str(),
+			       static_cast<ulonglong>(it->end)
+			       * page_size_t(it->flags).physical())) {
+			return(DB_ERROR);
+		}
+	}
+
+	return(DB_SUCCESS);
+}
+
+/** Finish the copy while no more transactions can commit: copy the
+tablespaces created and the pages allocated since they were copied,
+the final sizes of the data files and the rest of the redo log. Release
+the copy state.
+@param[in,out]	sink	destination of the files
+@param[in]	stream	stream to send the rest to
+@param[in]	abort	only release the copy state
+@param[out]	lsn	end of the copied redo log, or NULL
+@return DB_SUCCESS or error code */
+dberr_t
+srv_sst_backup_end(
+	Wsrep_sst_sink*	sink,
+	uint		stream,
+	bool		abort,
+	ulonglong*	lsn)
+{
+	if (srv_sst == NULL) {
+		return(DB_SUCCESS);
+	}
+
+	dberr_t	err = DB_SUCCESS;
+
+	if (!abort) {
+		srv_sst_chunks_t	rest;
+
+		for (srv_sst_chunks_t::iterator it = srv_sst->chunks.begin();
+		     it != srv_sst->chunks.end(); ++it) {
+
+			if (it->last) {
+				it->start = it->end;
+				rest.push_back(*it);
+			}
+		}
+
+		srv_sst_add_spaces(rest, srv_sst->spaces, NULL, NULL);
+
+		srv_sst->chunks.swap(rest);
+		srv_sst->next_chunk = 0;
+
+		err = srv_sst_backup_copy(sink, stream);
+
+		if (err == DB_SUCCESS) {
+			err = srv_sst_send_sizes(sink, stream);
+		}
+
+		if (err == DB_SUCCESS) {
+			log_buffer_flush_to_disk();
+
+			err = srv_sst_backup_redo(sink, stream);
+		}
+
+		if (err == DB_SUCCESS) {
+			/* Nothing may be written to the log files while
+			the last block is read. */
+			log_write_mutex_enter();
+			lsn_t	end_lsn = log_sys->write_lsn;
+			err = srv_sst_copy_redo_low(sink, stream, end_lsn);
+			log_write_mutex_exit();
+
+			ib::info() << "Native SST: copied redo log up to "
+				<< end_lsn;
+
+			if (lsn != NULL) {
+				*lsn = end_lsn;
+			}
+		}
+	}
+
+	log_mutex_enter();
+	log_sst_lsn = 0;
+	log_mutex_exit();
+
+	ut_free(srv_sst->redo_buf_ptr);
+	UT_DELETE(srv_sst);
+	srv_sst = NULL;
+
+	return(err);
+}
+
+#endif /* WITH_WSREP */
@@ -2905,6 +2905,10 @@ files_checked:
 
 			srv_start_state_set(SRV_START_STATE_MONITOR);
 		}
+
+		if (srv_log_writer_threads) {
+			log_writer_threads_start();
+		}
 	}
 
 	/* wake main loop of page cleaner up */
@@ -3080,6 +3084,10 @@ files_checked:
 			srv_buffer_pool_load_at_startup = FALSE;
 		}
 
+		if (srv_buffer_pool_load_at_startup) {
+			buf_load_start();
+		}
+
 		/* Create the buffer pool dump/load thread */
 		os_thread_create(buf_dump_thread, NULL, NULL);
 
@@ -1142,6 +1142,15 @@ trx_purge_initiate_truncate(
 			ib::info() << "ib_undo_trunc_before_checkpoint";
 			DBUG_SUICIDE(););
 
+#ifdef WITH_WSREP
+	/* Truncate re-creates the rollback segment headers without their
+	WSREP checkpoint, keep it in the sys header. The checkpoint below
+	makes it durable before the headers are wiped. */
+	for (ulint i = 0; i < undo_trunc->rsegs_size(); ++i) {
+		trx_rseg_fold_wsrep_checkpoint(undo_trunc->get_ith_rseg(i));
+	}
+#endif /* WITH_WSREP */
+
 	/* After truncate if server crashes then redo logging done for this
 	undo tablespace might not stand valid as tablespace has been
 	truncated. */
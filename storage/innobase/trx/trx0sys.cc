@@ -324,8 +324,11 @@ trx_sys_print_mysql_binlog_offset(void)
 
 #ifdef WITH_WSREP
 
+/** Last WSREP checkpoint in memory, protected by trx_sys_wsrep_mutex.
+Commits using different rollback segments update it concurrently. */
 static long long trx_sys_cur_xid_seqno = -1;
 static unsigned char trx_sys_cur_xid_uuid[16];
+static OSMutex trx_sys_wsrep_mutex;
 
 long long read_wsrep_xid_seqno(const XID* xid)
 {
@@ -342,6 +345,114 @@ void read_wsrep_xid_uuid(const XID* xid, unsigned char* buf)
 }
 
 
+/** Check that the WSREP checkpoint advances to the given XID and remember
+it as the last persisted one. The caller must hold trx_sys_wsrep_mutex.
+@param[in]	xid		WSREP XID
+@param[in]	recovery	committing a recovered transaction
+@return false if the checkpoint must not be moved to xid */
+static
+bool
+trx_sys_wsrep_checkpoint_advance(
+	const XID*	xid,
+	bool		recovery)
+{
+	unsigned char	xid_uuid[16];
+	long long	xid_seqno = read_wsrep_xid_seqno(xid);
+	read_wsrep_xid_uuid(xid, xid_uuid);
+
+	if (memcmp(xid_uuid, trx_sys_cur_xid_uuid, 16)) {
+		memcpy(trx_sys_cur_xid_uuid, xid_uuid, 16);
+		trx_sys_cur_xid_seqno = xid_seqno;
+		return(true);
+	}
+
+	if (recovery) {
+		/* When recovery happens prepare transactions
+		are revived based on undo-log entries in InnoDB.
+		This order may not match with the commit order
+		logged to binlog.
+		Sequence matching is not needed for MySQL
+		as standalone. Aim is to just ensure that all
+		prepare stage transaction are marked as committed.
+		But in PXC the commit order of recover transaction
+		should be same as it would be if transaction are running
+		normally or we need to ensure that only the latest seen
+		xid is updated and persisted as wsrep recover position
+		co-ordinates. */
+		if (xid_seqno <= trx_sys_cur_xid_seqno) {
+			return(false);
+		}
+	} else {
+		/* Check that seqno is monotonically increasing */
+		ut_ad(xid_seqno > trx_sys_cur_xid_seqno);
+	}
+
+	trx_sys_cur_xid_seqno = xid_seqno;
+	return(true);
+}
+
+/** Write WSREP XID to a checkpoint field.
+@param[in,out]	xid_info	TRX_SYS_WSREP_XID_INFO field
+@param[in]	xid		WSREP XID
+@param[in,out]	mtr		mini-transaction */
+static
+void
+trx_wsrep_xid_write(
+	byte*		xid_info,
+	const XID*	xid,
+	mtr_t*		mtr)
+{
+	ut_a(xid->get_format_id() == -1 || wsrep_is_wsrep_xid(xid));
+
+	if (mach_read_from_4(xid_info + TRX_SYS_WSREP_XID_MAGIC_N_FLD)
+	    != TRX_SYS_WSREP_XID_MAGIC_N) {
+		mlog_write_ulint(xid_info + TRX_SYS_WSREP_XID_MAGIC_N_FLD,
+				 TRX_SYS_WSREP_XID_MAGIC_N,
+				 MLOG_4BYTES, mtr);
+	}
+
+	mlog_write_ulint(xid_info + TRX_SYS_WSREP_XID_FORMAT,
+			 (int)xid->get_format_id(),
+			 MLOG_4BYTES, mtr);
+	mlog_write_ulint(xid_info + TRX_SYS_WSREP_XID_GTRID_LEN,
+			 (int)xid->get_gtrid_length(),
+			 MLOG_4BYTES, mtr);
+	mlog_write_ulint(xid_info + TRX_SYS_WSREP_XID_BQUAL_LEN,
+			 (int)xid->get_bqual_length(),
+			 MLOG_4BYTES, mtr);
+	mlog_write_string(xid_info + TRX_SYS_WSREP_XID_DATA,
+			  (const unsigned char*) xid->get_data(),
+			  XIDDATASIZE, mtr);
+}
+
+/** Read WSREP XID from a checkpoint field.
+@param[in]	xid_info	TRX_SYS_WSREP_XID_INFO field
+@param[out]	xid		WSREP XID
+@return false if the field was never written */
+static
+bool
+trx_wsrep_xid_read(
+	const byte*	xid_info,
+	XID*		xid)
+{
+	if (mach_read_from_4(xid_info + TRX_SYS_WSREP_XID_MAGIC_N_FLD)
+	    != TRX_SYS_WSREP_XID_MAGIC_N) {
+		return(false);
+	}
+
+	/* Make sure we first load it to int32_t so the sign bit is preserved.*/
+	int32_t format_id = mach_read_from_4(xid_info
+					     + TRX_SYS_WSREP_XID_FORMAT);
+	xid->set_format_id(format_id);
+	xid->set_gtrid_length(mach_read_from_4(xid_info
+					       + TRX_SYS_WSREP_XID_GTRID_LEN));
+	xid->set_bqual_length(mach_read_from_4(xid_info
+					       + TRX_SYS_WSREP_XID_BQUAL_LEN));
+	xid->set_data(xid_info + TRX_SYS_WSREP_XID_DATA, XIDDATASIZE);
+
+	return(true);
+}
+
 void
 trx_sys_update_wsrep_checkpoint(
         const XID*      xid,        /*!< in: transaction XID */
@@ -349,78 +460,149 @@ trx_sys_update_wsrep_checkpoint(
         mtr_t*          mtr,        /*!< in: mtr */
         bool            recovery)   /*!< in: running recovery */
 {
+	ut_ad(xid && mtr && sys_header);
+
+	trx_sys_wsrep_mutex.enter();
+	bool	advance = trx_sys_wsrep_checkpoint_advance(xid, recovery);
+	trx_sys_wsrep_mutex.exit();
+
+	if (advance) {
+		trx_wsrep_xid_write(sys_header + TRX_SYS_WSREP_XID_INFO,
+				    xid, mtr);
+	}
+}
+
+bool
+trx_rseg_update_wsrep_checkpoint(
+	const XID*	xid,
+	trx_rseg_t*	rseg,
+	bool		recovery,
+	mtr_t*		mtr)
+{
+	ut_ad(mutex_own(&rseg->mutex));
+	ut_ad(!trx_sys_is_noredo_rseg_slot(rseg->id));
 
-#ifndef UNIV_DEBUG
-        if (recovery)
-#endif /* !UNIV_DEBUG */
-        {
-            /* Check that seqno is monotonically increasing */
-            unsigned char xid_uuid[16];
-            long long xid_seqno = read_wsrep_xid_seqno(xid);
-            read_wsrep_xid_uuid(xid, xid_uuid);
-            if (!memcmp(xid_uuid, trx_sys_cur_xid_uuid, 8))
-            {
-                if (recovery)
-                {
-                    /* When recovery happens prepare transactions
-                    are revived based on undo-log entries in InnoDB.
-                    This order may not match with the commit order
-                    logged to binlog.
-                    Sequence matching is not needed for MySQL
-                    as standalone. Aim is to just ensure that all
-                    prepare stage transaction are marked as committed.
-                    But in PXC the commit order of recover transaction
-                    should be same as it would be if transaction are running
-                    normally or we need to ensure that only the latest seen
-                    xid is updated and persisted as wsrep recover position
-                    co-ordinates. */
-                    if (xid_seqno > trx_sys_cur_xid_seqno)
-                        trx_sys_cur_xid_seqno = xid_seqno;
-                    else
-                        return;
-                }
-                else
-                {
-                    ut_ad(xid_seqno > trx_sys_cur_xid_seqno);
-                    trx_sys_cur_xid_seqno = xid_seqno;
-                }
-            }
-            else
-            {
-                memcpy(trx_sys_cur_xid_uuid, xid_uuid, 16);
-                trx_sys_cur_xid_seqno = xid_seqno;
-            }
-        }
-
-        ut_ad(xid && mtr && sys_header);
-        ut_a(xid->get_format_id() == -1 || wsrep_is_wsrep_xid(xid));
-
-        if (mach_read_from_4(sys_header + TRX_SYS_WSREP_XID_INFO
-                             + TRX_SYS_WSREP_XID_MAGIC_N_FLD)
-            != TRX_SYS_WSREP_XID_MAGIC_N) {
-                mlog_write_ulint(sys_header + TRX_SYS_WSREP_XID_INFO
-                                 + TRX_SYS_WSREP_XID_MAGIC_N_FLD,
-                                 TRX_SYS_WSREP_XID_MAGIC_N,
-                                 MLOG_4BYTES, mtr);
-        }
-
-        mlog_write_ulint(sys_header + TRX_SYS_WSREP_XID_INFO
-                         + TRX_SYS_WSREP_XID_FORMAT,
-                         (int)xid->get_format_id(),
-                         MLOG_4BYTES, mtr);
-        mlog_write_ulint(sys_header + TRX_SYS_WSREP_XID_INFO
-                         + TRX_SYS_WSREP_XID_GTRID_LEN,
-                         (int)xid->get_gtrid_length(),
-                         MLOG_4BYTES, mtr);
-        mlog_write_ulint(sys_header + TRX_SYS_WSREP_XID_INFO
-                         + TRX_SYS_WSREP_XID_BQUAL_LEN,
-                         (int)xid->get_bqual_length(),
-                         MLOG_4BYTES, mtr);
-        mlog_write_string(sys_header + TRX_SYS_WSREP_XID_INFO
-                          + TRX_SYS_WSREP_XID_DATA,
-                          (const unsigned char*) xid->get_data(),
-                          XIDDATASIZE, mtr);
+	unsigned char	xid_uuid[16];
+	read_wsrep_xid_uuid(xid, xid_uuid);
+
+	/* New UUID must reach the sys header first, otherwise
+	trx_sys_read_wsrep_checkpoint() would ignore the rollback segment
+	checkpoint. */
+	trx_sys_wsrep_mutex.enter();
+
+	if (memcmp(xid_uuid, trx_sys_cur_xid_uuid, 16)) {
+		trx_sys_wsrep_mutex.exit();
+		return(false);
+	}
 
+	bool	advance = trx_sys_wsrep_checkpoint_advance(xid, recovery);
+	trx_sys_wsrep_mutex.exit();
+
+	if (advance) {
+		trx_rsegf_t*	rseg_header = trx_rsegf_get(
+			rseg->space, rseg->page_no, rseg->page_size, mtr);
+
+		trx_wsrep_xid_write(rseg_header + TRX_RSEG_WSREP_XID_INFO,
+				    xid, mtr);
+	}
+
+	return(true);
+}
+
+void
+trx_rseg_fold_wsrep_checkpoint(
+	trx_rseg_t*	rseg)
+{
+	ut_ad(!trx_sys_is_noredo_rseg_slot(rseg->id));
+
+	mtr_t	mtr;
+	XID	rseg_xid;
+	XID	sys_xid;
+
+	mutex_enter(&rseg->mutex);
+	mtr_start(&mtr);
+
+	trx_sysf_t*	sys_header = trx_sysf_get(&mtr);
+
+	if (trx_wsrep_xid_read(
+		    trx_rsegf_get(rseg->space, rseg->page_no,
+				  rseg->page_size, &mtr)
+		    + TRX_RSEG_WSREP_XID_INFO, &rseg_xid)
+	    && wsrep_is_wsrep_xid(&rseg_xid)
+	    && trx_wsrep_xid_read(sys_header + TRX_SYS_WSREP_XID_INFO,
+				  &sys_xid)
+	    && wsrep_is_wsrep_xid(&sys_xid)) {
+
+		unsigned char	rseg_uuid[16];
+		unsigned char	sys_uuid[16];
+		read_wsrep_xid_uuid(&rseg_xid, rseg_uuid);
+		read_wsrep_xid_uuid(&sys_xid, sys_uuid);
+
+		/* Not through trx_sys_wsrep_checkpoint_advance(): the
+		checkpoint in memory is already at the rollback segment
+		one, only the sys header is behind. */
+		if (!memcmp(rseg_uuid, sys_uuid, 16)
+		    && read_wsrep_xid_seqno(&rseg_xid)
+		       > read_wsrep_xid_seqno(&sys_xid)) {
+
+			trx_wsrep_xid_write(
+				sys_header + TRX_SYS_WSREP_XID_INFO,
+				&rseg_xid, &mtr);
+		}
+	}
+
+	mtr_commit(&mtr);
+	mutex_exit(&rseg->mutex);
+}
+
+/** Replace xid with the latest checkpoint found in the rollback segment
+headers that has the same UUID.
+@param[in,out]	xid	WSREP XID read from the sys header */
+static
+void
+trx_rseg_read_wsrep_checkpoint(
+	XID*	xid)
+{
+	unsigned char	uuid[16];
+	read_wsrep_xid_uuid(xid, uuid);
+	long long	max_seqno = read_wsrep_xid_seqno(xid);
+
+	for (ulint i = 0; i < TRX_SYS_N_RSEGS; ++i) {
+		trx_rseg_t*	rseg = trx_sys->rseg_array[i];
+
+		if (rseg == NULL || trx_sys_is_noredo_rseg_slot(i)) {
+			continue;
+		}
+
+		mtr_t	mtr;
+		XID	rseg_xid;
+		bool	found;
+
+		mutex_enter(&rseg->mutex);
+		mtr_start(&mtr);
+
+		found = trx_wsrep_xid_read(
+			trx_rsegf_get(rseg->space, rseg->page_no,
+				      rseg->page_size, &mtr)
+			+ TRX_RSEG_WSREP_XID_INFO, &rseg_xid);
+
+		mtr_commit(&mtr);
+		mutex_exit(&rseg->mutex);
+
+		if (!found || !wsrep_is_wsrep_xid(&rseg_xid)) {
+			continue;
+		}
+
+		unsigned char	rseg_uuid[16];
+		read_wsrep_xid_uuid(&rseg_xid, rseg_uuid);
+
+		if (!memcmp(rseg_uuid, uuid, 16)
+		    && read_wsrep_xid_seqno(&rseg_xid) > max_seqno) {
+
+			max_seqno = read_wsrep_xid_seqno(&rseg_xid);
+			*xid = rseg_xid;
+		}
+	}
 }
 
 void
@@ -429,7 +611,6 @@ trx_sys_read_wsrep_checkpoint(XID* xid)
 {
 	trx_sysf_t* sys_header;
 	mtr_t	    mtr;
-	ulint       magic;
 
 	ut_ad(xid);
 
@@ -437,35 +618,28 @@ trx_sys_read_wsrep_checkpoint(XID* xid)
 
 	sys_header = trx_sysf_get(&mtr);
 
-	if ((magic = mach_read_from_4(sys_header + TRX_SYS_WSREP_XID_INFO
-		+ TRX_SYS_WSREP_XID_MAGIC_N_FLD))
-		!= TRX_SYS_WSREP_XID_MAGIC_N) {
+	if (!trx_wsrep_xid_read(sys_header + TRX_SYS_WSREP_XID_INFO, xid)) {
 
 		memset(static_cast<void*>(xid), 0, sizeof(*xid));
 		xid->set_format_id(-1);
 		trx_sys_update_wsrep_checkpoint(xid, sys_header, &mtr);
 		mtr_commit(&mtr);
 		return;
-
 	}
 
-	/* Make sure we first load it to int32_t so the sign bit is preserved.*/
-	int32_t format_id = mach_read_from_4(sys_header + TRX_SYS_WSREP_XID_INFO
-					     + TRX_SYS_WSREP_XID_FORMAT);
-	xid->set_format_id(format_id);
-
-	xid->set_gtrid_length(mach_read_from_4(sys_header
-				+ TRX_SYS_WSREP_XID_INFO
-				+ TRX_SYS_WSREP_XID_GTRID_LEN));
-
-	xid->set_bqual_length(mach_read_from_4(sys_header
-				+ TRX_SYS_WSREP_XID_INFO
-				+ TRX_SYS_WSREP_XID_BQUAL_LEN));
+	mtr_commit(&mtr);
 
-	xid->set_data(sys_header + TRX_SYS_WSREP_XID_INFO
-			+ TRX_SYS_WSREP_XID_DATA, XIDDATASIZE);
+	/* Commits persist the checkpoint in the header of the rollback
+	segment they use, see trx_write_serialisation_history() */
+	if (wsrep_is_wsrep_xid(xid)) {
+		trx_rseg_read_wsrep_checkpoint(xid);
 
-	mtr_commit(&mtr);
+		/* commits continue from the recovered checkpoint */
+		trx_sys_wsrep_mutex.enter();
+		read_wsrep_xid_uuid(xid, trx_sys_cur_xid_uuid);
+		trx_sys_cur_xid_seqno = read_wsrep_xid_seqno(xid);
+		trx_sys_wsrep_mutex.exit();
+	}
 }
 
 #endif /* WITH_WSREP */
@@ -714,6 +888,10 @@ trx_sys_create(void)
 
 	mutex_create(LATCH_ID_TRX_SYS, &trx_sys->mutex);
 
+#ifdef WITH_WSREP
+	trx_sys_wsrep_mutex.init();
+#endif /* WITH_WSREP */
+
 	UT_LIST_INIT(trx_sys->serialisation_list, &trx_t::no_list);
 	UT_LIST_INIT(trx_sys->rw_trx_list, &trx_t::trx_list);
 	UT_LIST_INIT(trx_sys->mysql_trx_list, &trx_t::mysql_trx_list);
@@ -1393,6 +1571,10 @@ trx_sys_close(void)
 	/* We used placement new to create this mutex. Call the destructor. */
 	mutex_free(&trx_sys->mutex);
 
+#ifdef WITH_WSREP
+	trx_sys_wsrep_mutex.destroy();
+#endif /* WITH_WSREP */
+
 	trx_sys->rw_trx_ids.~trx_ids_t();
 
 	trx_sys->rw_trx_set.~TrxIdSet();
@@ -205,6 +205,9 @@ trx_init(
 	trx->lock.rec_cached = 0;
 
 	trx->lock.table_cached = 0;
+#ifdef WITH_WSREP
+	trx->lock.wsrep_bf_victim = false;
+#endif /* WITH_WSREP */
 	trx->error_index = NULL;
 
 	trx->stats.set(false);
@@ -510,6 +513,7 @@ trx_create_low()
 #ifdef WITH_WSREP
 	trx->wsrep_event = NULL;
 	trx->wsrep_recover_xid = NULL;
+	trx->wsrep_conflict_table_id = 0;
 #endif /* WITH_WSREP */
 
 	return(trx);
@@ -1528,6 +1532,11 @@ trx_start_low(
 		trx->start_time = ut_time();
 	}
 
+#ifdef WITH_WSREP
+	trx->wsrep_start_time_us = ut_time_monotonic_us();
+	trx->wsrep_conflict_table_id = 0;
+#endif /* WITH_WSREP */
+
 	ut_a(trx->error_state == DB_SUCCESS);
 
 	MONITOR_INC(MONITOR_TRX_ACTIVE);
@@ -1623,7 +1632,22 @@ trx_write_serialisation_history(
 	mtr_t*		mtr)	/*!< in/out: mini-transaction */
 {
 #ifdef WITH_WSREP
-        trx_sysf_t* sys_header;
+	trx_sysf_t*	sys_header = NULL;
+	const XID*	wsrep_xid = NULL;
+	bool		wsrep_recovery = false;
+
+	/* Latest MySQL wsrep XID to persist with the commit.
+	If given transaction is marked for replay then avoid updating
+	the xid while the trx is being rolled back. */
+	if (wsrep_is_wsrep_xid(trx->xid)
+	    && wsrep_safe_to_persist_xid(trx->mysql_thd)) {
+		wsrep_xid = trx->xid;
+	} else if (trx->wsrep_recover_xid
+		   && wsrep_is_wsrep_xid(trx->wsrep_recover_xid)) {
+		wsrep_xid = trx->wsrep_recover_xid;
+		wsrep_recovery = true;
+	}
+	trx->wsrep_recover_xid = NULL;
 #endif /* WITH_WSREP */
 	/* Change the undo log segment states from TRX_UNDO_ACTIVE to some
 	other state: these modifications to the file data structure define
@@ -1731,6 +1755,17 @@ trx_write_serialisation_history(
 		}
 	}
 
+#ifdef WITH_WSREP
+	/* Persist wsrep XID in the header of the rollback segment the
+	transaction used, so that concurrent commits do not all latch the
+	trx sys header page. */
+	if (wsrep_xid != NULL && own_redo_rseg_mutex
+	    && trx_rseg_update_wsrep_checkpoint(
+		    wsrep_xid, trx->rsegs.m_redo.rseg, wsrep_recovery, mtr)) {
+		wsrep_xid = NULL;
+	}
+#endif /* WITH_WSREP */
+
 	if (own_redo_rseg_mutex) {
 		mutex_exit(&trx->rsegs.m_redo.rseg->mutex);
 		own_redo_rseg_mutex = false;
@@ -1747,22 +1782,13 @@ trx_write_serialisation_history(
 #ifdef WITH_WSREP
 	DBUG_EXECUTE_IF("crash_before_trx_commit_in_memory",
 			{ sleep(3); DBUG_SUICIDE(); });
-        sys_header = trx_sysf_get(mtr);
-	/* Update latest MySQL wsrep XID in trx sys header.
-	If given transaction is marked for replay then avoid updating
-	the xid while the trx is being rolled back. */
-        if (wsrep_is_wsrep_xid(trx->xid)
-	    && wsrep_safe_to_persist_xid(trx->mysql_thd))
-        {
-            trx_sys_update_wsrep_checkpoint(trx->xid, sys_header, mtr);
-        }
-	else if (trx->wsrep_recover_xid
-		 && wsrep_is_wsrep_xid(trx->wsrep_recover_xid))
-	{
+	/* Transaction without redo rollback segment or first commit
+	with new cluster UUID: update wsrep XID in trx sys header. */
+	if (wsrep_xid != NULL) {
+		sys_header = trx_sysf_get(mtr);
 		trx_sys_update_wsrep_checkpoint(
-				trx->wsrep_recover_xid, sys_header, mtr, true);
+			wsrep_xid, sys_header, mtr, wsrep_recovery);
 	}
-	trx->wsrep_recover_xid = NULL;
 #endif /* WITH_WSREP */
 
 	/* Update the latest MySQL binlog name and offset info
@@ -1772,6 +1798,11 @@ trx_write_serialisation_history(
 	if (trx->mysql_log_file_name != NULL
 	    && trx->mysql_log_file_name[0] != '\0') {
 
+#ifdef WITH_WSREP
+		if (sys_header == NULL) {
+			sys_header = trx_sysf_get(mtr);
+		}
+#endif /* WITH_WSREP */
 		trx_sys_update_mysql_binlog_offset(
 			trx->mysql_log_file_name,
 			trx->mysql_log_offset,
@@ -1887,7 +1918,7 @@ trx_flush_log_if_needed_low(
 		/* fall through */
 	case 1:
 		/* Write the log and optionally flush it to disk */
-		log_write_up_to(lsn, flush);
+		log_wait_up_to(lsn, flush);
 		return;
 	case 0:
 		/* Do nothing */
@@ -2640,7 +2671,7 @@ trx_commit_complete_for_mysql(
 	trx-1 commits successfully and reaches this point where-in it just
 	need to flush the REDO log. (Note: real data changes are already
 	FLUSHED as part of trx_prepare so what is pending to FLUSH is update
-	undo log state and sys_header modification that persist WSREPXID).
+	undo log state and rseg header modification that persist WSREPXID).
 	Say trx-1 now leaves the CommitMonitor and now is waiting to
 	initiate the flush action.
 
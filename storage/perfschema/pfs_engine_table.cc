@@ -107,6 +107,9 @@
 #ifdef WITH_WSREP
 /* Galera replication perfschema tables. */
 #include "table_pxc_cluster_view.h"
+#include "table_pxc_applier_threads.h"
+#include "table_pxc_conflicts_by_index.h"
+#include "table_pxc_conflict_hot_keys.h"
 #endif /* WITH_WSREP */
 
 #include "table_prepared_stmt_instances.h"
@@ -326,6 +329,9 @@ static PFS_engine_table_share *all_shares[]=
 
 #ifdef WITH_WSREP
   &table_pxc_cluster_view::m_share,
+  &table_pxc_applier_threads::m_share,
+  &table_pxc_conflicts_by_index::m_share,
+  &table_pxc_conflict_hot_keys::m_share,
 #endif /* WITH_WSREP */
 
   &table_prepared_stmt_instances::m_share,
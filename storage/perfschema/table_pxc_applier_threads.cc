@@ -0,0 +1,194 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file storage/perfschema/table_pxc_applier_threads.cc
+  Table PXC_APPLIER_THREADS (implementation).
+*/
+
+#include "my_global.h"
+#include "table_pxc_applier_threads.h"
+#include "pfs_instr_class.h"
+#include "pfs_column_types.h"
+#include "pfs_column_values.h"
+#include "pfs_global.h"
+
+/* accounting is kept in microseconds, timer columns are in picoseconds */
+#define MICROSEC_TO_PICOSEC 1000000ULL
+
+THR_LOCK table_pxc_applier_threads::m_table_lock;
+
+static const TABLE_FIELD_TYPE field_types[]=
+{
+  {
+    { C_STRING_WITH_LEN("PROCESSLIST_ID") },
+    { C_STRING_WITH_LEN("bigint(20)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("STATE") },
+    { C_STRING_WITH_LEN("enum('IDLE','APPLYING','COMMIT_ORDER_WAIT')") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("WRITE_SETS_APPLIED") },
+    { C_STRING_WITH_LEN("bigint(20)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("BUSY_TIME") },
+    { C_STRING_WITH_LEN("bigint(20)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("IDLE_TIME") },
+    { C_STRING_WITH_LEN("bigint(20)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("COMMIT_ORDER_WAIT_TIME") },
+    { C_STRING_WITH_LEN("bigint(20)") },
+    { NULL, 0}
+  }
+};
+
+TABLE_FIELD_DEF
+table_pxc_applier_threads::m_field_def=
+{ 6, field_types };
+
+PFS_engine_table_share
+table_pxc_applier_threads::m_share=
+{
+  { C_STRING_WITH_LEN("pxc_applier_threads") },
+  &pfs_readonly_acl,
+  table_pxc_applier_threads::create,
+  NULL, /* write_row */
+  NULL, /* delete all rows */
+  table_pxc_applier_threads::get_row_count,
+  sizeof(PFS_simple_index),
+  &m_table_lock,
+  &m_field_def,
+  false, /* checked */
+  false  /* perpetual */
+};
+
+PFS_engine_table*
+table_pxc_applier_threads::create(void)
+{
+  return new table_pxc_applier_threads();
+}
+
+table_pxc_applier_threads::table_pxc_applier_threads()
+  : PFS_engine_table(&m_share, &m_pos),
+    m_row_exists(false), m_pos(0), m_next_pos(0), m_entries_count(0)
+{}
+
+table_pxc_applier_threads::~table_pxc_applier_threads()
+{}
+
+void table_pxc_applier_threads::reset_position(void)
+{
+  m_pos.m_index= 0;
+  m_next_pos.m_index= 0;
+}
+
+ha_rows table_pxc_applier_threads::get_row_count(void)
+{
+  return wsrep_pool_size();
+}
+
+int table_pxc_applier_threads::rnd_init(bool scan)
+{
+  m_entries_count= static_cast<uint>(
+    wsrep_pool_applier_stats(m_entries, PXC_APPLIER_THREADS_MAX));
+  return 0;
+}
+
+int table_pxc_applier_threads::rnd_next(void)
+{
+  for (m_pos.set_at(&m_next_pos);
+       m_pos.m_index < m_entries_count;
+       m_pos.next())
+  {
+    make_row(m_pos.m_index);
+    m_next_pos.set_after(&m_pos);
+    return 0;
+  }
+
+  return HA_ERR_END_OF_FILE;
+}
+
+int
+table_pxc_applier_threads::rnd_pos(const void *pos)
+{
+  set_position(pos);
+  if (m_pos.m_index >= m_entries_count)
+    return HA_ERR_RECORD_DELETED;
+
+  make_row(m_pos.m_index);
+  return 0;
+}
+
+void table_pxc_applier_threads::make_row(uint index)
+{
+  m_row= m_entries[index];
+  m_row_exists= true;
+}
+
+int table_pxc_applier_threads
+::read_row_values(TABLE *table,
+                  unsigned char *buf,
+                  Field **fields,
+                  bool read_all)
+{
+  Field *f;
+
+  if (unlikely(! m_row_exists))
+    return HA_ERR_RECORD_DELETED;
+
+  DBUG_ASSERT(table->s->null_bytes == 1);
+  buf[0]= 0;
+
+  for (; (f= *fields) ; fields++)
+  {
+    if (read_all || bitmap_is_set(table->read_set, f->field_index))
+    {
+      switch(f->field_index)
+      {
+      case 0: /** processlist_id */
+        set_field_ulonglong(f, m_row.thread_id);
+        break;
+      case 1: /** state */
+        set_field_enum(f, m_row.state + 1);
+        break;
+      case 2: /** write_sets_applied */
+        set_field_ulonglong(f, m_row.applied);
+        break;
+      case 3: /** busy_time */
+        set_field_ulonglong(f, m_row.busy_time * MICROSEC_TO_PICOSEC);
+        break;
+      case 4: /** idle_time */
+        set_field_ulonglong(f, m_row.idle_time * MICROSEC_TO_PICOSEC);
+        break;
+      case 5: /** commit_order_wait_time */
+        set_field_ulonglong(f, m_row.commit_wait_time * MICROSEC_TO_PICOSEC);
+        break;
+      default:
+        DBUG_ASSERT(false);
+      }
+    }
+  }
+  return 0;
+}
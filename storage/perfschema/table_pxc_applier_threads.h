@@ -0,0 +1,89 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#ifndef TABLE_PXC_APPLIER_THREADS_H
+#define TABLE_PXC_APPLIER_THREADS_H
+
+/**
+  @file storage/perfschema/table_pxc_applier_threads.h
+  Table PXC_APPLIER_THREADS (declarations).
+*/
+
+#include "pfs_column_types.h"
+#include "pfs_engine_table.h"
+#include "table_helper.h"
+#include "wsrep_pool.h"
+
+/**
+  @addtogroup Performance_schema_tables
+  @{
+*/
+
+/** Upper bound of wsrep_slave_threads and wsrep_slave_threads_max. */
+#define PXC_APPLIER_THREADS_MAX 512
+
+/** Table PERFORMANCE_SCHEMA.PXC_APPLIER_THREADS. */
+class table_pxc_applier_threads : public PFS_engine_table
+{
+private:
+  void make_row(uint index);
+  /** Table share lock. */
+  static THR_LOCK m_table_lock;
+  /** Fields definition. */
+  static TABLE_FIELD_DEF m_field_def;
+  /** True if the current row exists. */
+  bool m_row_exists;
+  /** Current row */
+  wsrep_applier_stats_row m_row;
+  /** Current position. */
+  PFS_simple_index m_pos;
+  /** Next position. */
+  PFS_simple_index m_next_pos;
+  /** Applier threads accounting, fetched when the scan starts. */
+  wsrep_applier_stats_row m_entries[PXC_APPLIER_THREADS_MAX];
+  /** Number of fetched entries. */
+  uint m_entries_count;
+
+protected:
+  /**
+    Read the current row values.
+    @param table            Table handle
+    @param buf              row buffer
+    @param fields           Table fields
+    @param read_all         true if all columns are read.
+  */
+
+  virtual int read_row_values(TABLE *table,
+                              unsigned char *buf,
+                              Field **fields,
+                              bool read_all);
+
+  table_pxc_applier_threads();
+
+public:
+  ~table_pxc_applier_threads();
+
+  /** Table share. */
+  static PFS_engine_table_share m_share;
+  static PFS_engine_table* create();
+  static ha_rows get_row_count();
+  virtual int rnd_init(bool scan);
+  virtual int rnd_next();
+  virtual int rnd_pos(const void *pos);
+  virtual void reset_position(void);
+};
+
+/** @} */
+#endif
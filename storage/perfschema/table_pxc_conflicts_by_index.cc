@@ -0,0 +1,207 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file storage/perfschema/table_pxc_conflicts_by_index.cc
+  Table PXC_CONFLICTS_BY_INDEX (implementation).
+*/
+
+#include "my_global.h"
+#include "table_pxc_conflicts_by_index.h"
+#include "pfs_instr_class.h"
+#include "pfs_column_types.h"
+#include "pfs_column_values.h"
+#include "pfs_global.h"
+
+/* accounting is kept in microseconds, timer columns are in picoseconds */
+#define MICROSEC_TO_PICOSEC 1000000ULL
+
+THR_LOCK table_pxc_conflicts_by_index::m_table_lock;
+
+static const TABLE_FIELD_TYPE field_types[]=
+{
+  {
+    { C_STRING_WITH_LEN("OBJECT_SCHEMA") },
+    { C_STRING_WITH_LEN("varchar(64)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("OBJECT_NAME") },
+    { C_STRING_WITH_LEN("varchar(64)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("INDEX_NAME") },
+    { C_STRING_WITH_LEN("varchar(64)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("CERT_FAILURES") },
+    { C_STRING_WITH_LEN("bigint(20)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("BF_ABORTS") },
+    { C_STRING_WITH_LEN("bigint(20)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("ROWS_WASTED") },
+    { C_STRING_WITH_LEN("bigint(20)") },
+    { NULL, 0}
+  },
+  {
+    { C_STRING_WITH_LEN("TIME_WASTED") },
+    { C_STRING_WITH_LEN("bigint(20)") },
+    { NULL, 0}
+  }
+};
+
+TABLE_FIELD_DEF
+table_pxc_conflicts_by_index::m_field_def=
+{ 7, field_types };
+
+PFS_engine_table_share
+table_pxc_conflicts_by_index::m_share=
+{
+  { C_STRING_WITH_LEN("pxc_conflicts_by_index") },
+  &pfs_truncatable_acl,
+  table_pxc_conflicts_by_index::create,
+  NULL, /* write_row */
+  table_pxc_conflicts_by_index::delete_all_rows,
+  table_pxc_conflicts_by_index::get_row_count,
+  sizeof(PFS_simple_index),
+  &m_table_lock,
+  &m_field_def,
+  false, /* checked */
+  false  /* perpetual */
+};
+
+PFS_engine_table*
+table_pxc_conflicts_by_index::create(void)
+{
+  return new table_pxc_conflicts_by_index();
+}
+
+table_pxc_conflicts_by_index::table_pxc_conflicts_by_index()
+  : PFS_engine_table(&m_share, &m_pos),
+    m_row_exists(false), m_pos(0), m_next_pos(0)
+{}
+
+int
+table_pxc_conflicts_by_index::delete_all_rows(void)
+{
+  wsrep_conflict_stats_reset();
+  return 0;
+}
+
+table_pxc_conflicts_by_index::~table_pxc_conflicts_by_index()
+{}
+
+void table_pxc_conflicts_by_index::reset_position(void)
+{
+  m_pos.m_index= 0;
+  m_next_pos.m_index= 0;
+}
+
+ha_rows table_pxc_conflicts_by_index::get_row_count(void)
+{
+  return wsrep_conflict_stats_object_count();
+}
+
+int table_pxc_conflicts_by_index::rnd_init(bool scan)
+{
+  return 0;
+}
+
+int table_pxc_conflicts_by_index::rnd_next(void)
+{
+  m_pos.set_at(&m_next_pos);
+  if (make_row(m_pos.m_index))
+  {
+    m_next_pos.set_after(&m_pos);
+    return 0;
+  }
+
+  return HA_ERR_END_OF_FILE;
+}
+
+int
+table_pxc_conflicts_by_index::rnd_pos(const void *pos)
+{
+  set_position(pos);
+  if (!make_row(m_pos.m_index))
+    return HA_ERR_RECORD_DELETED;
+
+  return 0;
+}
+
+bool table_pxc_conflicts_by_index::make_row(uint index)
+{
+  m_row_exists= wsrep_conflict_stats_object(index, &m_row);
+  return m_row_exists;
+}
+
+int table_pxc_conflicts_by_index
+::read_row_values(TABLE *table,
+                  unsigned char *buf,
+                  Field **fields,
+                  bool read_all)
+{
+  Field *f;
+
+  if (unlikely(! m_row_exists))
+    return HA_ERR_RECORD_DELETED;
+
+  DBUG_ASSERT(table->s->null_bytes == 1);
+  buf[0]= 0;
+
+  for (; (f= *fields) ; fields++)
+  {
+    if (read_all || bitmap_is_set(table->read_set, f->field_index))
+    {
+      switch(f->field_index)
+      {
+      case 0: /** object_schema */
+        set_field_varchar_utf8(f, m_row.db, strlen(m_row.db));
+        break;
+      case 1: /** object_name */
+        set_field_varchar_utf8(f, m_row.table, strlen(m_row.table));
+        break;
+      case 2: /** index_name */
+        if (m_row.index[0])
+          set_field_varchar_utf8(f, m_row.index, strlen(m_row.index));
+        else
+          f->set_null();
+        break;
+      case 3: /** cert_failures */
+        set_field_ulonglong(f, m_row.cert_failures);
+        break;
+      case 4: /** bf_aborts */
+        set_field_ulonglong(f, m_row.bf_aborts);
+        break;
+      case 5: /** rows_wasted */
+        set_field_ulonglong(f, m_row.rows_wasted);
+        break;
+      case 6: /** time_wasted */
+        set_field_ulonglong(f, m_row.time_wasted * MICROSEC_TO_PICOSEC);
+        break;
+      default:
+        DBUG_ASSERT(false);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,126 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+
+#include "thread_utils.h"
+#include "wsrep_conflict_log.h"
+#include "mysql/psi/mysql_thread.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace wsrep_conflict_log_unittest {
+
+#if !defined(DBUG_OFF)
+// There is no point in benchmarking anything in debug mode.
+const size_t num_iterations= 1ULL;
+#else
+// Set this so that each test case takes a few seconds.
+// And set it back to a small value before pushing!!
+// const size_t num_iterations= 1000ULL;
+const size_t num_iterations= 2ULL;
+#endif
+
+const int num_threads= 8;
+
+/*
+  Applier and local threads reporting conflicts while holding a shared
+  mutex, which stands in for lock_sys->mutex. Compares writing reports to
+  the error log in place with handing them to the conflict log writer.
+  Run with stderr redirected, e.g. 2>/dev/null.
+*/
+static mysql_mutex_t LOCK_bench;
+
+static const char report[]=
+  "WSREP: cluster conflict due to high priority abort for threads:\n"
+  "WSREP: Winning thread:\n"
+  "   THD: 12, mode: applier, state: executing, conflict: no conflict, "
+  "seqno: 1234567\n"
+  "   SQL: UPDATE t1 SET f2 = f2 + 1 WHERE f1 = 100\n"
+  "WSREP: Victim thread:\n"
+  "   THD: 34, mode: local, state: executing, conflict: no conflict, "
+  "seqno: -1\n"
+  "   SQL: UPDATE t1 SET f2 = f2 - 1 WHERE f1 = 100\n";
+
+class Reporter : public thread::Thread
+{
+public:
+  explicit Reporter(bool queued) : m_queued(queued) {}
+
+  virtual void run()
+  {
+    for (size_t ix= 0; ix < num_iterations * 1000; ++ix)
+    {
+      mysql_mutex_lock(&LOCK_bench);
+      if (m_queued)
+        wsrep_conflict_log(report, sizeof(report) - 1);
+      else
+      {
+        fwrite(report, 1, sizeof(report) - 1, stderr);
+        fflush(stderr);
+      }
+      mysql_mutex_unlock(&LOCK_bench);
+    }
+  }
+
+private:
+  bool m_queued;
+};
+
+class WsrepConflictLogBench : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    mysql_mutex_init(0, &LOCK_bench, MY_MUTEX_INIT_FAST);
+    wsrep_conflict_log_init();
+  }
+
+  virtual void TearDown()
+  {
+    wsrep_conflict_log_deinit();
+    mysql_mutex_destroy(&LOCK_bench);
+  }
+
+  void run(bool queued)
+  {
+    Reporter *reporters[num_threads];
+    for (int i= 0; i < num_threads; ++i)
+    {
+      reporters[i]= new Reporter(queued);
+      reporters[i]->start();
+    }
+    for (int i= 0; i < num_threads; ++i)
+    {
+      reporters[i]->join();
+      delete reporters[i];
+    }
+  }
+};
+
+TEST_F(WsrepConflictLogBench, DISABLED_Direct)
+{
+  run(false);
+}
+
+TEST_F(WsrepConflictLogBench, DISABLED_Queued)
+{
+  run(true);
+}
+
+}
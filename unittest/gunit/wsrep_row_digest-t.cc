@@ -0,0 +1,237 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+
+#include "wsrep_row_digest.h"
+#include "my_md5.h"
+
+#include <vector>
+
+namespace wsrep_row_digest_unittest {
+
+#if !defined(DBUG_OFF)
+// There is no point in benchmarking anything in debug mode.
+const size_t num_iterations= 1ULL;
+#else
+// Set this so that each test case takes a few seconds.
+// And set it back to a small value before pushing!!
+// const size_t num_iterations= 1000000ULL;
+const size_t num_iterations= 2ULL;
+#endif
+
+/*
+  Simplified row image: a sequence of fields laid out back to back the way
+  they are in a MySQL record. Fixed width fields can be hashed in runs,
+  variable length ones (VARCHAR payload, BLOB) are hashed one by one.
+*/
+struct Test_field
+{
+  size_t offset;
+  size_t len;
+  bool   fixed;
+  bool   is_null;
+};
+
+class Test_row
+{
+public:
+  void add(size_t len, bool fixed, bool is_null= false)
+  {
+    Test_field f= { m_data.size(), len, fixed, is_null };
+    m_fields.push_back(f);
+    for (size_t i= 0; i < len; ++i)
+      m_data.push_back(static_cast<uchar>(m_data.size() * 31 + 7));
+  }
+
+  /* Leave len bytes which do not belong to any field */
+  void skip(size_t len)
+  {
+    m_data.resize(m_data.size() + len);
+  }
+
+  uchar *data() { return &m_data[0]; }
+
+  void digest(ulong algorithm, uchar *out) const
+  {
+    wsp::row_digest ctx(algorithm);
+    for (size_t i= 0; i < m_fields.size(); ++i)
+    {
+      const Test_field &f= m_fields[i];
+      ctx.add_field(f.is_null ? NULL : &m_data[0] + f.offset, f.len, f.fixed);
+    }
+    ctx.final(out);
+  }
+
+  std::vector<Test_field> m_fields;
+  std::vector<uchar> m_data;
+};
+
+/* Row of a typical log table: integers, timestamps and a few strings */
+static void make_mixed_row(Test_row *row)
+{
+  for (int i= 0; i < 6; ++i)
+    row->add(8, true);
+  row->add(4, true, true);
+  row->add(64, false);
+  row->add(4, true);
+  row->add(255, false);
+  row->add(5, true);
+}
+
+TEST(WsrepRowDigest, Md5Compatible)
+{
+  Test_row row;
+  make_mixed_row(&row);
+
+  uchar expected[WSREP_ROW_DIGEST_LEN];
+  char null_byte= 0;
+  char true_byte= 1;
+  void *ctx= wsrep_md5_init();
+  for (size_t i= 0; i < row.m_fields.size(); ++i)
+  {
+    const Test_field &f= row.m_fields[i];
+    if (f.is_null)
+      wsrep_md5_update(ctx, &null_byte, 1);
+    else
+    {
+      wsrep_md5_update(ctx, &true_byte, 1);
+      wsrep_md5_update(ctx, (char*)row.data() + f.offset,
+                       static_cast<int>(f.len));
+    }
+  }
+  wsrep_compute_md5_hash((char*)expected, ctx);
+
+  uchar digest[WSREP_ROW_DIGEST_LEN];
+  row.digest(WSREP_ROW_DIGEST_MD5, digest);
+  EXPECT_EQ(0, memcmp(expected, digest, sizeof(digest)));
+}
+
+TEST(WsrepRowDigest, XxhashSensitivity)
+{
+  Test_row row;
+  make_mixed_row(&row);
+
+  uchar digest1[WSREP_ROW_DIGEST_LEN];
+  uchar digest2[WSREP_ROW_DIGEST_LEN];
+  row.digest(WSREP_ROW_DIGEST_XXHASH, digest1);
+  row.digest(WSREP_ROW_DIGEST_XXHASH, digest2);
+  EXPECT_EQ(0, memcmp(digest1, digest2, sizeof(digest1)));
+
+  // Changed value in a fixed width run
+  row.data()[row.m_fields[3].offset]^= 1;
+  row.digest(WSREP_ROW_DIGEST_XXHASH, digest2);
+  EXPECT_NE(0, memcmp(digest1, digest2, sizeof(digest1)));
+  row.data()[row.m_fields[3].offset]^= 1;
+
+  // Same bytes, but one of the fields is NULL now
+  row.m_fields[2].is_null= true;
+  row.digest(WSREP_ROW_DIGEST_XXHASH, digest2);
+  EXPECT_NE(0, memcmp(digest1, digest2, sizeof(digest1)));
+  row.m_fields[2].is_null= false;
+
+  // Byte moved across the boundary of two variable length fields
+  Test_row strings;
+  strings.add(10, false);
+  strings.add(10, false);
+  strings.digest(WSREP_ROW_DIGEST_XXHASH, digest1);
+  strings.m_fields[0].len--;
+  strings.m_fields[1].offset--;
+  strings.m_fields[1].len++;
+  strings.digest(WSREP_ROW_DIGEST_XXHASH, digest2);
+  EXPECT_NE(0, memcmp(digest1, digest2, sizeof(digest1)));
+}
+
+TEST(WsrepRowDigest, XxhashRunsMatchSeparateFields)
+{
+  Test_row row;
+  make_mixed_row(&row);
+
+  uchar digest1[WSREP_ROW_DIGEST_LEN];
+  row.digest(WSREP_ROW_DIGEST_XXHASH, digest1);
+
+  // Same values, but no two fields adjacent, so no runs are formed
+  Test_row spread;
+  for (size_t i= 0; i < row.m_fields.size(); ++i)
+  {
+    const Test_field &f= row.m_fields[i];
+    spread.skip(1);
+    spread.add(f.len, f.fixed, f.is_null);
+    memcpy(spread.data() + spread.m_fields.back().offset,
+           row.data() + f.offset, f.len);
+  }
+
+  uchar digest2[WSREP_ROW_DIGEST_LEN];
+  spread.digest(WSREP_ROW_DIGEST_XXHASH, digest2);
+  EXPECT_EQ(0, memcmp(digest1, digest2, sizeof(digest1)));
+}
+
+/*
+  Throughput benchmark across column mixes, compare the time of the
+  Md5 and Xxhash test instances. Disabled by default, run them with
+  --gtest_also_run_disabled_tests.
+*/
+enum Column_mix { FIXED_ONLY, MIXED, BLOB };
+
+class WsrepRowDigestBench : public ::testing::TestWithParam<Column_mix>
+{
+protected:
+  virtual void SetUp()
+  {
+    switch (GetParam())
+    {
+    case FIXED_ONLY:
+      for (int i= 0; i < 32; ++i)
+        m_row.add(i % 2 ? 4 : 8, true);
+      break;
+    case MIXED:
+      make_mixed_row(&m_row);
+      break;
+    case BLOB:
+      m_row.add(8, true);
+      m_row.add(4, true);
+      m_row.add(16384, false);
+      break;
+    }
+  }
+
+  void run(ulong algorithm)
+  {
+    uchar digest[WSREP_ROW_DIGEST_LEN];
+    for (size_t ix= 0; ix < num_iterations * 1000; ++ix)
+      m_row.digest(algorithm, digest);
+  }
+
+  Test_row m_row;
+};
+
+Column_mix column_mixes[]= { FIXED_ONLY, MIXED, BLOB };
+
+INSTANTIATE_TEST_CASE_P(Digest, WsrepRowDigestBench,
+                        ::testing::ValuesIn(column_mixes));
+
+TEST_P(WsrepRowDigestBench, DISABLED_Md5)
+{
+  run(WSREP_ROW_DIGEST_MD5);
+}
+
+TEST_P(WsrepRowDigestBench, DISABLED_Xxhash)
+{
+  run(WSREP_ROW_DIGEST_XXHASH);
+}
+
+}
@@ -0,0 +1,146 @@
+/* Copyright (c) 2019 Percona LLC and/or its affiliates. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+
+#include "wsrep_sst_native.h"
+
+#include <errno.h>
+#include <string>
+
+namespace wsrep_sst_native_unittest {
+
+const char secret[]= "0123456789abcdef0123456789abcdef";
+
+class Native_addr_test : public ::testing::Test
+{
+protected:
+  int parse(const std::string &addr)
+  {
+    host[0]= port[0]= parsed_secret[0]= '\0';
+    ssl= false;
+    return wsrep_sst_native_parse_addr(addr.c_str(), host, sizeof(host),
+                                       port, sizeof(port), parsed_secret,
+                                       &ssl);
+  }
+
+  char host[256];
+  char port[16];
+  char parsed_secret[WSREP_SST_NATIVE_SECRET_LEN + 1];
+  bool ssl;
+};
+
+TEST_F(Native_addr_test, HostPortSecret)
+{
+  EXPECT_EQ(0, parse(std::string("10.0.0.1:4445/") + secret));
+  EXPECT_STREQ("10.0.0.1", host);
+  EXPECT_STREQ("4445", port);
+  EXPECT_STREQ(secret, parsed_secret);
+  EXPECT_FALSE(ssl);
+}
+
+TEST_F(Native_addr_test, DefaultPort)
+{
+  EXPECT_EQ(0, parse(std::string("node1/") + secret));
+  EXPECT_STREQ("node1", host);
+  EXPECT_STREQ("4444", port);
+  EXPECT_STREQ(secret, parsed_secret);
+}
+
+TEST_F(Native_addr_test, Ipv6Ssl)
+{
+  EXPECT_EQ(0, parse(std::string("[::1]:5000/") + secret + "/ssl"));
+  EXPECT_STREQ("::1", host);
+  EXPECT_STREQ("5000", port);
+  EXPECT_STREQ(secret, parsed_secret);
+  EXPECT_TRUE(ssl);
+}
+
+TEST_F(Native_addr_test, Invalid)
+{
+  // the secret is required
+  EXPECT_EQ(EINVAL, parse("10.0.0.1:4444"));
+  EXPECT_EQ(EINVAL, parse("10.0.0.1:4444/"));
+  EXPECT_EQ(EINVAL, parse("10.0.0.1:4444/0123456789abcdef"));
+  EXPECT_EQ(EINVAL, parse(std::string("10.0.0.1:4444/") + secret + "0"));
+  EXPECT_EQ(EINVAL, parse(std::string("10.0.0.1:4444/") + secret + "/tls"));
+  EXPECT_EQ(EINVAL, parse(std::string("10.0.0.1:/") + secret));
+  EXPECT_EQ(EINVAL, parse(std::string(":4444/") + secret));
+}
+
+TEST(Native_hello_test, RoundTrip)
+{
+  uchar hello[WSREP_SST_NATIVE_HELLO_LEN];
+  wsrep_sst_native_make_hello(hello, secret, 3, 5, WSREP_SST_NATIVE_BYPASS);
+
+  uint no= 0, n_streams= 0, flags= 0;
+  EXPECT_EQ(0, wsrep_sst_native_check_hello(hello, secret, &no, &n_streams,
+                                            &flags));
+  EXPECT_EQ(3U, no);
+  EXPECT_EQ(5U, n_streams);
+  EXPECT_EQ(uint(WSREP_SST_NATIVE_BYPASS), flags);
+}
+
+TEST(Native_hello_test, WrongSecret)
+{
+  uchar hello[WSREP_SST_NATIVE_HELLO_LEN];
+  wsrep_sst_native_make_hello(hello, secret, 0, 1, 0);
+
+  std::string other(secret);
+  other[WSREP_SST_NATIVE_SECRET_LEN - 1]= '0';
+
+  uint no, n_streams, flags;
+  EXPECT_EQ(EACCES, wsrep_sst_native_check_hello(hello, other.c_str(), &no,
+                                                 &n_streams, &flags));
+}
+
+TEST(Native_hello_test, WrongMagicOrVersion)
+{
+  uchar hello[WSREP_SST_NATIVE_HELLO_LEN];
+  uint no, n_streams, flags;
+
+  wsrep_sst_native_make_hello(hello, secret, 0, 1, 0);
+  hello[0]= 'X';
+  EXPECT_EQ(EACCES, wsrep_sst_native_check_hello(hello, secret, &no,
+                                                 &n_streams, &flags));
+
+  wsrep_sst_native_make_hello(hello, secret, 0, 1, 0);
+  hello[4]= WSREP_SST_NATIVE_VERSION - 1;
+  EXPECT_EQ(EACCES, wsrep_sst_native_check_hello(hello, secret, &no,
+                                                 &n_streams, &flags));
+}
+
+TEST(Native_hello_test, InvalidStreams)
+{
+  uchar hello[WSREP_SST_NATIVE_HELLO_LEN];
+  uint no, n_streams, flags;
+
+  wsrep_sst_native_make_hello(hello, secret, 2, 2, 0);
+  EXPECT_EQ(EPROTO, wsrep_sst_native_check_hello(hello, secret, &no,
+                                                 &n_streams, &flags));
+
+  wsrep_sst_native_make_hello(hello, secret, 0, 0, 0);
+  EXPECT_EQ(EPROTO, wsrep_sst_native_check_hello(hello, secret, &no,
+                                                 &n_streams, &flags));
+
+  wsrep_sst_native_make_hello(hello, secret, 0,
+                              WSREP_SST_NATIVE_MAX_STREAMS + 2, 0);
+  EXPECT_EQ(EPROTO, wsrep_sst_native_check_hello(hello, secret, &no,
+                                                 &n_streams, &flags));
+}
+
+}